@@ -11,11 +11,26 @@
 //=============================================================================
 
 #include <remus/client/Client.h>
+#include <remus/common/MD5Hash.h>
 
+#include <remus/proto/JobBatch.h>
+#include <remus/proto/JobUpload.h>
+#include <remus/proto/JobWait.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
+#include <remus/proto/ResultStream.h>
 
 #include <remus/proto/zmqHelper.h>
+
+#include <boost/make_shared.hpp>
+#include <boost/uuid/nil_generator.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <set>
 #include <sstream>
 
 namespace remus{
@@ -26,17 +41,159 @@ namespace client{
 namespace detail{
 struct ZmqManagement
 {
+  //a dealer so that many requests can be in flight. Each request carries
+  //its id in the req header frame, and the server echoes it back
   zmq::socket_t Server;
+  boost::uint64_t NextRequestId;
+  std::map< boost::uint64_t, boost::shared_ptr<PendingRequest> > Pending;
+
+  //the jobs each subscribe request is still waiting on statuses for, and
+  //who to call with them. The server pushes statuses with the id of the
+  //request that subscribed
+  struct Subscription
+  {
+    Client::StatusCallback Callback;
+    std::set<boost::uuids::uuid> Jobs;
+  };
+  std::map< boost::uint64_t, Subscription > Subscriptions;
+  std::size_t NumSubscribedJobs;
+
+  //the results being streamed to us, by the id of the request that opened
+  //the stream. The server sends each chunk with that id
+  struct Stream
+  {
+    Stream(const remus::proto::Job& job, const ResultSink& sink,
+           boost::uint32_t window):
+      Job(job), Sink(sink), Received(0), Taken(0), Window(window),
+      Complete(false)
+    {}
+
+    remus::proto::Job Job;
+    ResultSink Sink;
+    //the bytes written to the sink, and the chunks taken since we last
+    //granted the server credit
+    boost::uint64_t Received;
+    boost::uint32_t Taken;
+    boost::uint32_t Window;
+    bool Complete;
+  };
+  std::map< boost::uint64_t, boost::shared_ptr<Stream> > Streams;
 
   ZmqManagement(const remus::client::ServerConnection &conn):
-    Server(*(conn.context()), ZMQ_REQ)
+    Server(*(conn.context()), ZMQ_DEALER),
+    NextRequestId(0),
+    Pending(),
+    Subscriptions(),
+    NumSubscribedJobs(0),
+    Streams()
   {}
 };
+
+//------------------------------------------------------------------------------
+std::size_t process_replies(Client* client, int timeoutMillisec)
+{
+  return client->processReplies(timeoutMillisec);
+}
+}
+
+namespace {
+
+//------------------------------------------------------------------------------
+bool to_bool(const remus::proto::Response& response)
+{
+  std::istringstream buffer(response.data());
+  bool value = false;
+  buffer >> value;
+  return value;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirementsSet
+to_requirements(const remus::proto::Response& response)
+{
+  std::istringstream buffer(response.data());
+  remus::proto::JobRequirementsSet set;
+  buffer >> set;
+  return set;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job to_job(const remus::proto::Response& response)
+{
+  return remus::proto::to_Job(response.data());
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobUploadReply to_upload_reply(
+                                    const remus::proto::Response& response)
+{
+  const std::string data = response.data();
+  return remus::proto::to_JobUploadReply(data.data(),data.size());
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus to_status(const remus::proto::Response& response)
+{
+  return remus::proto::to_JobStatus(response.data());
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job> to_jobs(const remus::proto::Response& response)
+{
+  const std::string data = response.data();
+  return remus::proto::to_JobBatch(data.data(),data.size()).Jobs;
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobStatus>
+to_statuses(const remus::proto::Response& response)
+{
+  const std::string data = response.data();
+  return remus::proto::to_JobStatusBatch(data.data(),data.size()).Statuses;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobResult to_result(const remus::proto::Response& response)
+{
+  return remus::proto::to_JobResult(response.data());
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobResult
+to_waited_result(const remus::proto::Response& response)
+{
+  //a finished job has its result attached to its status
+  if(response.hasAttachment())
+    {
+    return remus::proto::to_JobResult(response.attachmentData(),
+                                      response.attachmentSize());
+    }
+  return remus::proto::JobResult(to_status(response).id());
+}
+
+//------------------------------------------------------------------------------
+remus::proto::ServerStats to_stats(const remus::proto::Response& response)
+{
+  return remus::proto::to_ServerStats(response.data());
+}
+
+//------------------------------------------------------------------------------
+template<typename T>
+remus::client::Future<T>
+make_future(remus::client::Client* client,
+            typename remus::client::detail::FutureState<T>::Decoder decoder,
+            boost::shared_ptr< remus::client::detail::FutureState<T> >& state)
+{
+  state = boost::make_shared< remus::client::detail::FutureState<T> >(decoder);
+  return remus::client::Future<T>(client, state);
+}
+
 }
 
 //------------------------------------------------------------------------------
 Client::Client(const remus::client::ServerConnection &conn):
   ConnectionInfo(conn),
+  Format(remus::proto::WireFormat::Text),
   Zmq( new detail::ZmqManagement(conn) )
 {
   zmq::connectToAddress(this->Zmq->Server,conn.endpoint());
@@ -54,106 +211,717 @@ const remus::client::ServerConnection& Client::connection() const
 }
 
 //------------------------------------------------------------------------------
-bool Client::canMesh(const remus::common::MeshIOType& meshtypes)
+void Client::wireFormat(remus::proto::WireFormat::Type format)
 {
-  remus::proto::Message j(meshtypes, remus::CAN_MESH);
-  j.send(&this->Zmq->Server);
+  this->Format = format;
+}
 
-  remus::proto::Response response(&this->Zmq->Server);
-  std::istringstream buffer(response.data());
+//------------------------------------------------------------------------------
+remus::proto::WireFormat::Type Client::wireFormat() const
+{
+  return this->Format;
+}
 
-  bool serverCanMesh;
-  buffer >> serverCanMesh;
-  return serverCanMesh;
+//------------------------------------------------------------------------------
+bool Client::canMesh(const remus::common::MeshIOType& meshtypes)
+{
+  return this->canMeshAsync(meshtypes).get();
 }
 
 //------------------------------------------------------------------------------
 bool Client::canMesh(const remus::proto::JobRequirements& reqs)
 {
-  std::ostringstream input_buffer;
-  input_buffer << reqs;
-  remus::proto::Message j(reqs.meshTypes(),
-                          remus::CAN_MESH_REQUIREMENTS,
-                          input_buffer.str() );
-  j.send(&this->Zmq->Server);
-
-  remus::proto::Response response(&this->Zmq->Server);
-  std::istringstream output_buffer(response.data());
-
-  bool serverCanMesh;
-  output_buffer >> serverCanMesh;
-  return serverCanMesh;
+  return this->canMeshAsync(reqs).get();
 }
 
 //------------------------------------------------------------------------------
 remus::proto::JobRequirementsSet
 Client::retrieveRequirements( const remus::common::MeshIOType& meshtypes)
 {
-  remus::proto::Message j(meshtypes, remus::MESH_REQUIREMENTS);
-  j.send(&this->Zmq->Server);
+  return this->retrieveRequirementsAsync(meshtypes).get();
+}
 
-  remus::proto::Response response(&this->Zmq->Server);
+//------------------------------------------------------------------------------
+remus::proto::Job
+Client::submitJob(const remus::proto::JobSubmission& submission)
+{
+  return this->submitJobAsync(submission).get();
+}
 
-  std::istringstream buffer(response.data());
+//------------------------------------------------------------------------------
+remus::proto::Job
+Client::uploadJob(const remus::proto::JobSubmission& submission,
+                  std::size_t chunkSize,
+                  unsigned int window)
+{
+  typedef remus::proto::JobSubmission::const_iterator ContentIterator;
+  const remus::proto::Job invalid(boost::uuids::nil_uuid(),
+                                  remus::common::MeshIOType());
 
-  remus::proto::JobRequirementsSet set;
-  buffer >> set;
-  return set;
+  chunkSize = std::max<std::size_t>(chunkSize, 1);
+  window = std::max(window, 1u);
+  std::vector<char> buffer;
+
+  //describe the contents by the size and hash of their data, the data of
+  //a file content is the contents of the file, which is read once here
+  //to hash it
+  remus::proto::JobUpload upload(submission.requirements());
+  for(ContentIterator i = submission.begin(); i != submission.end(); ++i)
+    {
+    boost::uint64_t size = i->second.dataSize();
+    std::string hash;
+    if(i->second.sourceType() == remus::common::ContentSource::File)
+      {
+      std::ifstream file(std::string(i->second.data(),i->second.dataSize())
+                                                              .c_str(),
+                         std::ios::in | std::ios::binary);
+      if(!file)
+        {
+        return invalid;
+        }
+      remus::common::MD5Hasher hasher;
+      buffer.resize(chunkSize);
+      size = 0;
+      while(file.read(&buffer[0], static_cast<std::streamsize>(chunkSize)) ||
+            file.gcount() > 0)
+        {
+        hasher.append(&buffer[0], static_cast<std::size_t>(file.gcount()));
+        size += static_cast<boost::uint64_t>(file.gcount());
+        }
+      hash = hasher.finish();
+      }
+    else
+      {
+      hash = i->second.hash();
+      }
+    upload.add( remus::proto::JobUpload::Entry(i->first,
+                                               i->second.formatType(),
+                                               i->second.tag(),
+                                               size,
+                                               hash) );
+    }
+
+  //the server tells us which contents it doesn't already have the data of
+  boost::shared_ptr< detail::FutureState<remus::proto::JobUploadReply> > state;
+  Future<remus::proto::JobUploadReply> future =
+        make_future<remus::proto::JobUploadReply>(this, to_upload_reply, state);
+  remus::proto::Message begin(submission.type(),
+                              remus::UPLOAD_JOB,
+                              remus::proto::to_wire(upload, this->Format));
+  this->sendRequest(begin, state);
+  const remus::proto::JobUploadReply reply = future.get();
+  const remus::proto::Job job = reply.job();
+  if(!job.valid())
+    {
+    return invalid;
+    }
+  const std::set<std::string> missing(reply.missing().begin(),
+                                      reply.missing().end());
+
+  //send the chunks of the missing contents, waiting on the oldest chunk
+  //to be accepted before sending more once the window is full. The server
+  //drops the upload at the first chunk it doesn't accept
+  std::deque< Future<bool> > inFlight;
+  bool accepted = true;
+  std::size_t entry = 0;
+  for(ContentIterator i = submission.begin();
+      accepted && i != submission.end(); ++i, ++entry)
+    {
+    if(missing.count(i->first) == 0)
+      {
+      continue;
+      }
+
+    std::ifstream file;
+    if(i->second.sourceType() == remus::common::ContentSource::File)
+      {
+      file.open(std::string(i->second.data(),i->second.dataSize()).c_str(),
+                std::ios::in | std::ios::binary);
+      }
+
+    const boost::uint64_t size = upload.entries()[entry].Size;
+    boost::uint64_t offset = 0;
+    while(accepted && offset < size)
+      {
+      const std::size_t length = static_cast<std::size_t>(
+                  std::min<boost::uint64_t>(chunkSize, size - offset));
+      const char* data = i->second.data() + offset;
+      if(file.is_open())
+        {
+        buffer.resize(length);
+        if(!file.read(&buffer[0], static_cast<std::streamsize>(length)))
+          {
+          //the file shrank since we described it
+          accepted = false;
+          break;
+          }
+        data = &buffer[0];
+        }
+
+      zmq::message_t wire;
+      zmq::to_wire(remus::proto::JobUploadChunk(job.id(), i->first, offset,
+                                                data, length),
+                   this->Format, wire);
+      remus::proto::Message chunk(job.type(),
+                                  remus::UPLOAD_JOB_CHUNK,
+                                  wire);
+      boost::shared_ptr< detail::FutureState<bool> > chunkState;
+      inFlight.push_back( make_future<bool>(this, to_bool, chunkState) );
+      this->sendRequest(chunk, chunkState);
+      offset += length;
+
+      if(inFlight.size() >= window)
+        {
+        accepted = inFlight.front().get();
+        inFlight.pop_front();
+        }
+      }
+    }
+
+  //the server queues the job when it accepts the last chunk
+  while(!inFlight.empty())
+    {
+    accepted = inFlight.front().get() && accepted;
+    inFlight.pop_front();
+    }
+  return accepted ? job : invalid;
 }
 
 //------------------------------------------------------------------------------
-remus::proto::Job
-Client::submitJob(const remus::proto::JobSubmission& submission)
+remus::proto::JobStatus Client::jobStatus(const remus::proto::Job& job)
+{
+  return this->jobStatusAsync(job).get();
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job>
+Client::submitJobs(const std::vector<remus::proto::JobSubmission>& submissions)
+{
+  return this->submitJobsAsync(submissions).get();
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobStatus>
+Client::jobStatus(const std::vector<remus::proto::Job>& jobs)
+{
+  return this->jobStatusAsync(jobs).get();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobResult Client::retrieveResults(const remus::proto::Job& job)
+{
+  return this->retrieveResultsAsync(job).get();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus Client::terminate(const remus::proto::Job& job)
+{
+  return this->terminateAsync(job).get();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::ServerStats Client::serverStats()
+{
+  return this->serverStatsAsync().get();
+}
+
+//------------------------------------------------------------------------------
+Future<bool> Client::canMeshAsync(const remus::common::MeshIOType& meshtypes)
+{
+  boost::shared_ptr< detail::FutureState<bool> > state;
+  Future<bool> future = make_future<bool>(this, to_bool, state);
+
+  remus::proto::Message j(meshtypes, remus::CAN_MESH);
+  this->sendRequest(j, state);
+  return future;
+}
+
+//------------------------------------------------------------------------------
+Future<bool> Client::canMeshAsync(const remus::proto::JobRequirements& reqs)
+{
+  boost::shared_ptr< detail::FutureState<bool> > state;
+  Future<bool> future = make_future<bool>(this, to_bool, state);
+
+  zmq::message_t data;
+  zmq::to_wire(reqs, this->Format, data);
+  remus::proto::Message j(reqs.meshTypes(),
+                          remus::CAN_MESH_REQUIREMENTS,
+                          data);
+  this->sendRequest(j, state);
+  return future;
+}
+
+//------------------------------------------------------------------------------
+Future<remus::proto::JobRequirementsSet>
+Client::retrieveRequirementsAsync( const remus::common::MeshIOType& meshtypes)
 {
-  std::ostringstream buffer;
-  buffer << submission;
+  typedef remus::proto::JobRequirementsSet T;
+  boost::shared_ptr< detail::FutureState<T> > state;
+  Future<T> future = make_future<T>(this, to_requirements, state);
+
+  remus::proto::Message j(meshtypes, remus::MESH_REQUIREMENTS);
+  this->sendRequest(j, state);
+  return future;
+}
+
+//------------------------------------------------------------------------------
+Future<remus::proto::Job>
+Client::submitJobAsync(const remus::proto::JobSubmission& submission)
+{
+  boost::shared_ptr< detail::FutureState<remus::proto::Job> > state;
+  Future<remus::proto::Job> future =
+                        make_future<remus::proto::Job>(this, to_job, state);
+
+  //encode the submission straight into the message we send
+  zmq::message_t data;
+  zmq::to_wire(submission, this->Format, data);
   remus::proto::Message j(submission.type(),
                            remus::MAKE_MESH,
-                           buffer.str());
-  j.send(&this->Zmq->Server);
-
-  remus::proto::Response response(&this->Zmq->Server);
-  const std::string job = response.data();
-  return remus::proto::to_Job(job);
+                           data);
+  this->sendRequest(j, state);
+  return future;
 }
 
 //------------------------------------------------------------------------------
-remus::proto::JobStatus Client::jobStatus(const remus::proto::Job& job)
+Future<remus::proto::JobStatus>
+Client::jobStatusAsync(const remus::proto::Job& job)
 {
+  boost::shared_ptr< detail::FutureState<remus::proto::JobStatus> > state;
+  Future<remus::proto::JobStatus> future =
+              make_future<remus::proto::JobStatus>(this, to_status, state);
+
   remus::proto::Message j(job.type(),
                           remus::MESH_STATUS,
-                          remus::proto::to_string(job));
-  j.send(&this->Zmq->Server);
+                          remus::proto::to_wire(job, this->Format));
+  this->sendRequest(j, state);
+  return future;
+}
+
+//------------------------------------------------------------------------------
+Future< std::vector<remus::proto::Job> >
+Client::submitJobsAsync(
+                  const std::vector<remus::proto::JobSubmission>& submissions)
+{
+  typedef std::vector<remus::proto::Job> T;
+  boost::shared_ptr< detail::FutureState<T> > state;
+  Future<T> future = make_future<T>(this, to_jobs, state);
 
-  remus::proto::Response response(&this->Zmq->Server);
-  const std::string status = response.data();
-  return remus::proto::to_JobStatus(status);
+  //the whole batch is sent as a single message
+  zmq::message_t data;
+  zmq::to_wire(remus::proto::JobSubmissionBatch(submissions),
+               this->Format, data);
+  remus::proto::Message j(remus::common::MeshIOType(),
+                          remus::MAKE_MESH_BATCH,
+                          data);
+  this->sendRequest(j, state);
+  return future;
 }
 
 //------------------------------------------------------------------------------
-remus::proto::JobResult Client::retrieveResults(const remus::proto::Job& job)
+Future< std::vector<remus::proto::JobStatus> >
+Client::jobStatusAsync(const std::vector<remus::proto::Job>& jobs)
+{
+  typedef std::vector<remus::proto::JobStatus> T;
+  boost::shared_ptr< detail::FutureState<T> > state;
+  Future<T> future = make_future<T>(this, to_statuses, state);
+
+  zmq::message_t data;
+  zmq::to_wire(remus::proto::JobBatch(jobs), this->Format, data);
+  remus::proto::Message j(remus::common::MeshIOType(),
+                          remus::MESH_STATUS_BATCH,
+                          data);
+  this->sendRequest(j, state);
+  return future;
+}
+
+//------------------------------------------------------------------------------
+Future<remus::proto::JobResult>
+Client::retrieveResultsAsync(const remus::proto::Job& job)
 {
+  boost::shared_ptr< detail::FutureState<remus::proto::JobResult> > state;
+  Future<remus::proto::JobResult> future =
+              make_future<remus::proto::JobResult>(this, to_result, state);
+
   remus::proto::Message j(job.type(),
                           remus::RETRIEVE_MESH,
-                          remus::proto::to_string(job));
-  j.send(&this->Zmq->Server);
-
-  remus::proto::Response response(&this->Zmq->Server);
-  const std::string result = response.data();
-  return remus::proto::to_JobResult(result);
+                          remus::proto::to_wire(job, this->Format));
+  this->sendRequest(j, state);
+  return future;
 }
 
 //------------------------------------------------------------------------------
-remus::proto::JobStatus Client::terminate(const remus::proto::Job& job)
+Future<remus::proto::JobStatus>
+Client::terminateAsync(const remus::proto::Job& job)
 {
+  boost::shared_ptr< detail::FutureState<remus::proto::JobStatus> > state;
+  Future<remus::proto::JobStatus> future =
+              make_future<remus::proto::JobStatus>(this, to_status, state);
+
   remus::proto::Message j(job.type(),
                           remus::TERMINATE_JOB,
-                          remus::proto::to_string(job));
+                          remus::proto::to_wire(job, this->Format));
+  this->sendRequest(j, state);
+  return future;
+}
+
+//------------------------------------------------------------------------------
+Future<remus::proto::ServerStats> Client::serverStatsAsync()
+{
+  boost::shared_ptr< detail::FutureState<remus::proto::ServerStats> > state;
+  Future<remus::proto::ServerStats> future =
+              make_future<remus::proto::ServerStats>(this, to_stats, state);
+
+  //the request carries an empty snapshot so the server knows which
+  //wire format to answer in
+  remus::proto::Message j(remus::common::MeshIOType(),
+                          remus::SERVER_STATS,
+                          remus::proto::to_wire(remus::proto::ServerStats(),
+                                                this->Format));
+  this->sendRequest(j, state);
+  return future;
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobStatus>
+Client::subscribe(const std::vector<remus::proto::Job>& jobs,
+                  const StatusCallback& callback)
+{
+  return this->subscribeAsync(jobs, callback).get();
+}
+
+//------------------------------------------------------------------------------
+Future< std::vector<remus::proto::JobStatus> >
+Client::subscribeAsync(const std::vector<remus::proto::Job>& jobs,
+                       const StatusCallback& callback)
+{
+  typedef std::vector<remus::proto::JobStatus> T;
+  boost::shared_ptr< detail::FutureState<T> > state;
+  Future<T> future = make_future<T>(this, to_statuses, state);
+
+  zmq::message_t data;
+  zmq::to_wire(remus::proto::JobBatch(jobs), this->Format, data);
+  remus::proto::Message j(remus::common::MeshIOType(),
+                          remus::SUBSCRIBE_JOB_STATUS,
+                          data);
+  const boost::uint64_t id = this->sendRequest(j, state);
+
+  //until the reply tells us otherwise, presume every job was subscribed to
+  detail::ZmqManagement::Subscription& subscription =
+                                            this->Zmq->Subscriptions[id];
+  subscription.Callback = callback;
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    subscription.Jobs.insert(jobs[i].id());
+    }
+  this->Zmq->NumSubscribedJobs += subscription.Jobs.size();
+  if(subscription.Jobs.empty())
+    {
+    this->Zmq->Subscriptions.erase(id);
+    }
+  return future;
+}
+
+//------------------------------------------------------------------------------
+std::size_t Client::subscribedJobs() const
+{
+  return this->Zmq->NumSubscribedJobs;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus Client::waitForJob(const remus::proto::Job& job,
+                                           int timeoutMillisec)
+{
+  return this->waitForJobAsync(job, timeoutMillisec).get();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobResult Client::waitForResult(const remus::proto::Job& job,
+                                              int timeoutMillisec)
+{
+  return this->waitForResultAsync(job, timeoutMillisec).get();
+}
+
+//------------------------------------------------------------------------------
+Future<remus::proto::JobStatus>
+Client::waitForJobAsync(const remus::proto::Job& job, int timeoutMillisec)
+{
+  boost::shared_ptr< detail::FutureState<remus::proto::JobStatus> > state;
+  Future<remus::proto::JobStatus> future =
+              make_future<remus::proto::JobStatus>(this, to_status, state);
+
+  const remus::proto::JobWait wait(job,
+            static_cast<boost::uint32_t>(std::max(timeoutMillisec, 0)),
+            false);
+  remus::proto::Message j(job.type(),
+                          remus::WAIT_FOR_JOB,
+                          remus::proto::to_wire(wait, this->Format));
+  this->sendRequest(j, state);
+  return future;
+}
+
+//------------------------------------------------------------------------------
+Future<remus::proto::JobResult>
+Client::waitForResultAsync(const remus::proto::Job& job, int timeoutMillisec)
+{
+  boost::shared_ptr< detail::FutureState<remus::proto::JobResult> > state;
+  Future<remus::proto::JobResult> future =
+        make_future<remus::proto::JobResult>(this, to_waited_result, state);
+
+  const remus::proto::JobWait wait(job,
+            static_cast<boost::uint32_t>(std::max(timeoutMillisec, 0)),
+            true);
+  remus::proto::Message j(job.type(),
+                          remus::WAIT_FOR_JOB,
+                          remus::proto::to_wire(wait, this->Format));
+  this->sendRequest(j, state);
+  return future;
+}
+
+//------------------------------------------------------------------------------
+bool Client::streamResults(const remus::proto::Job& job,
+                           const ResultSink& sink,
+                           std::size_t chunkSize,
+                           unsigned int window)
+{
+  if(!sink)
+    {
+    return false;
+    }
+
+  //the server clamps the chunk size to what it is willing to send
+  const boost::uint32_t size = static_cast<boost::uint32_t>(
+                    std::min<std::size_t>(std::max<std::size_t>(chunkSize, 1),
+                                          0xFFFFFFFFu));
+  const boost::uint32_t credits = std::max(window, 1u);
+
+  remus::proto::Message j(job.type(),
+                          remus::STREAM_RESULT,
+                          remus::proto::to_wire(
+                            remus::proto::ResultStreamRequest(job, size,
+                                                              credits),
+                            this->Format));
+  //the chunks aren't a reply to resolve a future with, so nothing is
+  //pending on the request
+  const boost::uint64_t id =
+        this->sendRequest(j, boost::shared_ptr<detail::PendingRequest>());
+
+  boost::shared_ptr<detail::ZmqManagement::Stream> stream =
+        boost::make_shared<detail::ZmqManagement::Stream>(job, sink, credits);
+  this->Zmq->Streams[id] = stream;
+  while(this->Zmq->Streams.count(id) > 0)
+    {
+    this->processReplies(-1);
+    }
+  return stream->Complete;
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t Client::sendRequest(remus::proto::Message& request,
+                       const boost::shared_ptr<detail::PendingRequest>& pending)
+{
+  const boost::uint64_t id = this->Zmq->NextRequestId++;
+  request.requestId(std::string(reinterpret_cast<const char*>(&id),
+                                sizeof(id)));
+
+  if(pending)
+    {
+    this->Zmq->Pending[id] = pending;
+    }
+  request.send(&this->Zmq->Server);
+  return id;
+}
+
+//------------------------------------------------------------------------------
+std::size_t Client::processReplies(int timeoutMillisec)
+{
+  std::size_t processed = 0;
+  while(!this->Zmq->Pending.empty() || !this->Zmq->Subscriptions.empty() ||
+        !this->Zmq->Streams.empty())
+    {
+    zmq::pollitem_t item = { this->Zmq->Server, 0, ZMQ_POLLIN, 0 };
+    zmq::poll(&item, 1, timeoutMillisec);
+    if(!(item.revents & ZMQ_POLLIN))
+      {
+      if(timeoutMillisec < 0)
+        { continue; }
+      break;
+      }
+
+    remus::proto::Response response(&this->Zmq->Server);
+
+    //servers that don't echo the request id answer each request in order,
+    //so their replies belong to the oldest request in flight
+    typedef std::map< boost::uint64_t,
+                      boost::shared_ptr<detail::PendingRequest> > PendingMap;
+    PendingMap::iterator i = this->Zmq->Pending.begin();
+    boost::uint64_t id = 0;
+    const bool haveId =
+                  response.requestId().size() == sizeof(boost::uint64_t);
+    if(haveId)
+      {
+      std::memcpy(&id, response.requestId().data(), sizeof(id));
+      i = this->Zmq->Pending.find(id);
+      }
+
+    //the reply to a subscribe request and the statuses pushed after it
+    //both update the subscription
+    if(haveId && this->Zmq->Subscriptions.count(id) > 0)
+      {
+      this->updateSubscription(id, response, i != this->Zmq->Pending.end());
+      if(i == this->Zmq->Pending.end())
+        {
+        ++processed;
+        }
+      }
+
+    //chunks of a streamed result carry the id of the request that opened
+    //the stream
+    if(haveId && this->Zmq->Streams.count(id) > 0)
+      {
+      this->updateStream(id, response);
+      ++processed;
+      }
+
+    if(i != this->Zmq->Pending.end())
+      {
+      //remove the request before resolving it, as the callbacks can send
+      //new requests or read replies themselves
+      boost::shared_ptr<detail::PendingRequest> pending = i->second;
+      this->Zmq->Pending.erase(i);
+      pending->resolve(response);
+      ++processed;
+      }
+
+    //we only wait on the first reply, after that we read what has arrived
+    timeoutMillisec = 0;
+    }
+  return processed;
+}
+
+//------------------------------------------------------------------------------
+void Client::updateSubscription(boost::uint64_t id,
+                                const remus::proto::Response& response,
+                                bool isReply)
+{
+  typedef std::map< boost::uint64_t,
+                    detail::ZmqManagement::Subscription > SubscriptionMap;
+  SubscriptionMap::iterator s = this->Zmq->Subscriptions.find(id);
+  const std::string data = response.data();
+  const std::vector<remus::proto::JobStatus> statuses =
+        remus::proto::to_JobStatusBatch(data.data(),data.size()).Statuses;
+
+  std::set<boost::uuids::uuid>& jobs = s->second.Jobs;
+  this->Zmq->NumSubscribedJobs -= jobs.size();
+
+  //the reply holds the status of the jobs when we subscribed, which the
+  //caller gets from the future. The server only subscribed to the jobs
+  //that can still change
+  std::vector<remus::proto::JobStatus> changed;
+  if(isReply)
+    {
+    jobs.clear();
+    for(std::size_t i=0; i < statuses.size(); ++i)
+      {
+      if(statuses[i].good())
+        {
+        jobs.insert(statuses[i].id());
+        }
+      }
+    }
+  else
+    {
+    for(std::size_t i=0; i < statuses.size(); ++i)
+      {
+      if(jobs.count(statuses[i].id()) > 0)
+        {
+        changed.push_back(statuses[i]);
+        if(!statuses[i].good())
+          {
+          jobs.erase(statuses[i].id());
+          }
+        }
+      }
+    }
+  this->Zmq->NumSubscribedJobs += jobs.size();
+
+  //the callback can subscribe or read replies itself, so we are done with
+  //the subscription before calling it
+  const StatusCallback callback = s->second.Callback;
+  if(s->second.Jobs.empty())
+    {
+    this->Zmq->Subscriptions.erase(s);
+    }
+  for(std::size_t i=0; i < changed.size(); ++i)
+    {
+    if(callback)
+      {
+      callback(changed[i]);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void Client::updateStream(boost::uint64_t id,
+                          const remus::proto::Response& response)
+{
+  boost::shared_ptr<detail::ZmqManagement::Stream> stream =
+                                                  this->Zmq->Streams[id];
+  const remus::proto::ResultChunk chunk =
+                              remus::proto::to_ResultChunk(response.data());
+
+  //chunks arrive in order, anything else means the stream is broken. The
+  //server answers a job without a result with a chunk that has no data
+  //attached, while an empty result is a single empty chunk
+  const bool inOrder = response.hasAttachment() &&
+                       chunk.offset() == stream->Received;
+  if(!inOrder ||
+     (response.attachmentSize() > 0 &&
+      !stream->Sink(response.attachmentData(), response.attachmentSize())))
+    {
+    //the server has nothing more to send when the job had no result
+    if(response.hasAttachment())
+      {
+      this->creditStream(id, stream->Job, 0);
+      }
+    this->Zmq->Streams.erase(id);
+    return;
+    }
+
+  stream->Received += response.attachmentSize();
+  if(stream->Received >= chunk.totalSize())
+    {
+    stream->Complete = true;
+    this->Zmq->Streams.erase(id);
+    return;
+    }
+
+  //grant credit in batches so we don't send a request for every chunk,
+  //while keeping enough in flight that the server doesn't stall
+  ++stream->Taken;
+  if(stream->Taken >= std::max(stream->Window / 2, 1u))
+    {
+    this->creditStream(id, stream->Job, stream->Taken);
+    stream->Taken = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+void Client::creditStream(boost::uint64_t id, const remus::proto::Job& job,
+                          boost::uint32_t credits)
+{
+  remus::proto::Message j(job.type(),
+                          remus::STREAM_RESULT,
+                          remus::proto::to_wire(
+                            remus::proto::ResultStreamRequest(job, 0, credits),
+                            this->Format));
+  j.requestId(std::string(reinterpret_cast<const char*>(&id), sizeof(id)));
   j.send(&this->Zmq->Server);
+}
 
-  remus::proto::Response response(&this->Zmq->Server);
-  const std::string status = response.data();
-  return remus::proto::to_JobStatus(status);
+//------------------------------------------------------------------------------
+std::size_t Client::pendingRequests() const
+{
+  return this->Zmq->Pending.size();
 }
 
 }
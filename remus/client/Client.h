@@ -15,9 +15,14 @@
 
 #include <string>
 #include <set>
+#include <vector>
 
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <remus/client/Future.h>
+#include <remus/client/ResultSink.h>
 #include <remus/client/ServerConnection.h>
 
 #include <remus/proto/Job.h>
@@ -25,6 +30,8 @@
 #include <remus/proto/JobResult.h>
 #include <remus/proto/JobStatus.h>
 #include <remus/proto/JobSubmission.h>
+#include <remus/proto/ServerStats.h>
+#include <remus/proto/WireFormat.h>
 
 //included for export symbols
 #include <remus/client/ClientExports.h>
@@ -32,7 +39,12 @@
 //The client class is used to submit meshing jobs to a remus server.
 //The class also allows you to query on the state of a given job and
 //to retrieve the results of the job when it is finished.
+//
+//Every request has an Async form that sends the request and returns a
+//Future without waiting on the server, so that many requests can be in
+//flight at once. The blocking methods wait on the future for you.
 namespace remus{
+namespace proto{ class Message; class Response; }
 namespace client{
 
 namespace detail { struct ZmqManagement; }
@@ -52,6 +64,12 @@ public:
   //remus server
   const remus::client::ServerConnection& connection() const;
 
+  //Set the encoding the client sends its requests with. The server answers
+  //in the encoding of each request, so only switch to Binary when talking
+  //to a server that understands it. Text is the default.
+  void wireFormat(remus::proto::WireFormat::Type format);
+  remus::proto::WireFormat::Type wireFormat() const;
+
   //Submit a request to the server to see if the server supports
   //the requested input and output mesh types
   bool canMesh(const remus::common::MeshIOType& meshtypes);
@@ -70,9 +88,35 @@ public:
   //a JobRequirements component
   remus::proto::Job submitJob(const remus::proto::JobSubmission& submission);
 
+  //Submit a job to the server the same as submitJob, but upload the data
+  //of its contents in chunks of chunkSize bytes instead of as a single
+  //message. At most window chunks are in flight at once, so only that much
+  //of the submission is held encoded at a time. The data of a content that
+  //is a FileHandle is read from the file it names a chunk at a time, so the
+  //worker is given the contents of the file rather than its path. The
+  //server only queues the job once all of the data has arrived. Returns an
+  //invalid job if the upload fails, such as when a file can't be read.
+  //
+  //Each content is described by the MD5 hash of its data first, and the
+  //data of contents the server already holds from earlier uploads isn't
+  //sent again
+  remus::proto::Job uploadJob(const remus::proto::JobSubmission& submission,
+                              std::size_t chunkSize = 1048576,
+                              unsigned int window = 4);
+
   //Given a remus Job object returns the status of the job
   remus::proto::JobStatus jobStatus(const remus::proto::Job& job);
 
+  //Submit many jobs with a single request to the server. The jobs are
+  //returned in the same order as the submissions
+  std::vector<remus::proto::Job>
+  submitJobs(const std::vector<remus::proto::JobSubmission>& submissions);
+
+  //Query the status of many jobs with a single request to the server.
+  //The statuses are returned in the same order as the jobs
+  std::vector<remus::proto::JobStatus>
+  jobStatus(const std::vector<remus::proto::Job>& jobs);
+
   //Return job result of of a give job
   remus::proto::JobResult retrieveResults(const remus::proto::Job& job);
 
@@ -82,6 +126,84 @@ public:
   //this will be unable to kill the job.
   remus::proto::JobStatus terminate(const remus::proto::Job& job);
 
+  //returns a snapshot of the counters the server keeps on its jobs,
+  //workers and results, see remus::proto::ServerStats
+  remus::proto::ServerStats serverStats();
+
+  //Ask the server to push the status of each job to us whenever it changes,
+  //instead of polling jobStatus. Returns the current status of each job.
+  //Pushed statuses are read by processReplies, which calls callback with
+  //each of them. A job stays subscribed until it finishes, fails, expires
+  //or is terminated, jobs that already have are not subscribed to
+  typedef boost::function<void (const remus::proto::JobStatus&)>
+          StatusCallback;
+  std::vector<remus::proto::JobStatus>
+  subscribe(const std::vector<remus::proto::Job>& jobs,
+            const StatusCallback& callback);
+
+  //the number of jobs we are waiting on pushed statuses for
+  std::size_t subscribedJobs() const;
+
+  //Wait until the job has finished, failed or expired, or until
+  //timeoutMillisec has passed, and return its status. The server holds
+  //the reply instead of us polling jobStatus, so we hear about the job as
+  //soon as it is done
+  remus::proto::JobStatus waitForJob(const remus::proto::Job& job,
+                                     int timeoutMillisec);
+
+  //the same as waitForJob, but a job that finishes has its result sent
+  //with the reply, the same as calling retrieveResults. Returns an empty
+  //result if the job didn't finish before the timeout
+  remus::proto::JobResult waitForResult(const remus::proto::Job& job,
+                                        int timeoutMillisec);
+
+  //Stream the result data of a finished job into sink, chunkSize bytes at
+  //a time, instead of receiving the whole result in one message like
+  //retrieveResults. The server sends at most window chunks before we have
+  //taken them, so only that much of the result is ever in flight. Like
+  //retrieveResults the job is removed from the server once all of the
+  //data has been sent. Returns true if the whole result was written to
+  //sink, and false if the job has no result or the sink stopped the
+  //stream. The sink shouldn't call back into the client
+  bool streamResults(const remus::proto::Job& job,
+                     const ResultSink& sink,
+                     std::size_t chunkSize = 1048576,
+                     unsigned int window = 4);
+
+  //the non blocking forms of the requests above
+  Future<bool> canMeshAsync(const remus::common::MeshIOType& meshtypes);
+  Future<bool> canMeshAsync(const remus::proto::JobRequirements& requirements);
+  Future<remus::proto::JobRequirementsSet>
+  retrieveRequirementsAsync( const remus::common::MeshIOType& meshtypes );
+  Future<remus::proto::Job>
+  submitJobAsync(const remus::proto::JobSubmission& submission);
+  Future<remus::proto::JobStatus> jobStatusAsync(const remus::proto::Job& job);
+  Future< std::vector<remus::proto::Job> >
+  submitJobsAsync(const std::vector<remus::proto::JobSubmission>& submissions);
+  Future< std::vector<remus::proto::JobStatus> >
+  jobStatusAsync(const std::vector<remus::proto::Job>& jobs);
+  Future<remus::proto::JobResult>
+  retrieveResultsAsync(const remus::proto::Job& job);
+  Future<remus::proto::JobStatus> terminateAsync(const remus::proto::Job& job);
+  Future<remus::proto::ServerStats> serverStatsAsync();
+  Future< std::vector<remus::proto::JobStatus> >
+  subscribeAsync(const std::vector<remus::proto::Job>& jobs,
+                 const StatusCallback& callback);
+  Future<remus::proto::JobStatus>
+  waitForJobAsync(const remus::proto::Job& job, int timeoutMillisec);
+  Future<remus::proto::JobResult>
+  waitForResultAsync(const remus::proto::Job& job, int timeoutMillisec);
+
+  //read the replies, pushed statuses and result chunks that have arrived
+  //from the server, resolving futures and calling callbacks and sinks. Waits up to timeoutMillisec
+  //for the first one, -1 waits until one arrives. Returns the number read,
+  //and returns right away when no requests are in flight and no jobs are
+  //subscribed to
+  std::size_t processReplies(int timeoutMillisec = 0);
+
+  //the number of requests that are waiting on a reply
+  std::size_t pendingRequests() const;
+
 protected:
   remus::client::ServerConnection ConnectionInfo;
 private:
@@ -89,6 +211,29 @@ private:
   Client(const Client&);
   void operator=(const Client&);
 
+  //send the request, and hold onto pending until its reply arrives.
+  //Returns the id the request was sent with
+  boost::uint64_t sendRequest(remus::proto::Message& request,
+                     const boost::shared_ptr<detail::PendingRequest>& pending);
+
+  //apply the reply to a subscribe request, or statuses pushed after it, to
+  //the subscription made by the request with the given id
+  void updateSubscription(boost::uint64_t id,
+                          const remus::proto::Response& response,
+                          bool isReply);
+
+  //write a chunk of a streamed result to its sink, and grant the server
+  //credit for the chunks we have taken
+  void updateStream(boost::uint64_t id,
+                    const remus::proto::Response& response);
+
+  //grant the stream opened by the request with the given id more credits,
+  //granting none closes the stream
+  void creditStream(boost::uint64_t id, const remus::proto::Job& job,
+                    boost::uint32_t credits);
+
+  remus::proto::WireFormat::Type Format;
+
   boost::scoped_ptr<detail::ZmqManagement> Zmq;
 };
 
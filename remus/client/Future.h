@@ -0,0 +1,164 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_client_Future_h
+#define remus_client_Future_h
+
+#include <cstddef>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/function.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+
+//included for export symbols
+#include <remus/client/ClientExports.h>
+
+namespace remus{
+namespace proto{ class Response; }
+namespace client{
+
+class Client;
+
+namespace detail{
+
+//reads the replies that have arrived for the client, waiting up to
+//timeoutMillisec for the first one. A timeout of -1 waits until a reply
+//arrives. Returns the number of replies read, see Client::processReplies
+REMUSCLIENT_EXPORT std::size_t process_replies(Client* client,
+                                               int timeoutMillisec);
+
+//a request that has been sent to the server and is waiting on a reply
+class PendingRequest
+{
+public:
+  virtual ~PendingRequest() {}
+  virtual void resolve(const remus::proto::Response& response) = 0;
+};
+
+template<typename T>
+class FutureState : public PendingRequest
+{
+public:
+  typedef T (*Decoder)(const remus::proto::Response&);
+  typedef boost::function<void (const T&)> Callback;
+
+  explicit FutureState(Decoder decoder):
+    Decode(decoder),
+    Value(),
+    Callbacks()
+  {}
+
+  void resolve(const remus::proto::Response& response)
+  {
+    this->Value = this->Decode(response);
+
+    //callbacks are allowed to send new requests, so take ownership of the
+    //list before calling them
+    std::vector<Callback> callbacks;
+    callbacks.swap(this->Callbacks);
+    for(std::size_t i=0; i < callbacks.size(); ++i)
+      {
+      callbacks[i](*this->Value);
+      }
+  }
+
+  void onReady(const Callback& callback)
+  {
+    if(this->Value)
+      { callback(*this->Value); }
+    else
+      { this->Callbacks.push_back(callback); }
+  }
+
+  Decoder Decode;
+  boost::optional<T> Value;
+  std::vector<Callback> Callbacks;
+};
+
+}
+
+//The reply to a request that a client sent without waiting on the answer.
+//Replies are only read when the client is asked to, either by calling
+//get or wait on a future, or by calling Client::processReplies. A future
+//must not outlive the client that made it.
+template<typename T>
+class Future
+{
+public:
+  Future():
+    Owner(NULL),
+    State()
+  {}
+
+  Future(Client* owner,
+         const boost::shared_ptr< detail::FutureState<T> >& state):
+    Owner(owner),
+    State(state)
+  {}
+
+  //returns true if the future belongs to a request
+  bool valid() const { return !!this->State; }
+
+  //returns true if the reply to the request has been read
+  bool ready() const { return this->State && this->State->Value; }
+
+  //wait up to timeoutMillisec for the reply, returns true if it arrived.
+  //Replies to other requests that arrive first are read as well.
+  bool wait(int timeoutMillisec) const
+  {
+    namespace pt = boost::posix_time;
+    const pt::ptime deadline = pt::microsec_clock::local_time() +
+                               pt::milliseconds(timeoutMillisec);
+    while(this->valid() && !this->ready())
+      {
+      const long remaining =
+        (deadline - pt::microsec_clock::local_time()).total_milliseconds();
+      if(remaining <= 0 ||
+         detail::process_replies(this->Owner,static_cast<int>(remaining)) == 0)
+        {
+        break;
+        }
+      }
+    return this->ready();
+  }
+
+  //block until the reply arrives and return it. The future must be valid
+  const T& get() const
+  {
+    while(!this->ready())
+      {
+      detail::process_replies(this->Owner,-1);
+      }
+    return *this->State->Value;
+  }
+
+  //call callback with the reply once it has been read, or right away if
+  //it already has been
+  void onReady(const boost::function<void (const T&)>& callback) const
+  {
+    if(this->State)
+      {
+      this->State->onReady(callback);
+      }
+  }
+
+private:
+  Client* Owner;
+  boost::shared_ptr< detail::FutureState<T> > State;
+};
+
+}
+}
+
+#endif
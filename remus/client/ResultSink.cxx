@@ -0,0 +1,119 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/client/ResultSink.h>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+  #include <io.h>
+#else
+  #include <unistd.h>
+#endif
+
+namespace remus{
+namespace client{
+
+namespace {
+
+//------------------------------------------------------------------------------
+struct FileDescriptorSink
+{
+  explicit FileDescriptorSink(int fd): FileDescriptor(fd) {}
+
+  bool operator()(const char* data, std::size_t size) const
+  {
+    //write can take less than all of the data, so keep going until it
+    //has all been written
+    while(size > 0)
+      {
+#ifdef _WIN32
+      const int written = ::_write(this->FileDescriptor, data,
+                                   static_cast<unsigned int>(size));
+#else
+      const ssize_t written = ::write(this->FileDescriptor, data, size);
+#endif
+      if(written < 0 && errno == EINTR)
+        {
+        continue;
+        }
+      if(written <= 0)
+        {
+        return false;
+        }
+      data += written;
+      size -= static_cast<std::size_t>(written);
+      }
+    return true;
+  }
+
+  int FileDescriptor;
+};
+
+//------------------------------------------------------------------------------
+struct BufferSink
+{
+  BufferSink(char* buffer, std::size_t capacity, std::size_t* size):
+    Buffer(buffer),
+    Capacity(capacity),
+    Size(size),
+    Position( boost::make_shared<std::size_t>(0) )
+  {
+    if(this->Size)
+      {
+      *this->Size = 0;
+      }
+  }
+
+  bool operator()(const char* data, std::size_t size) const
+  {
+    if(size > this->Capacity - *this->Position)
+      {
+      return false;
+      }
+    std::memcpy(this->Buffer + *this->Position, data, size);
+    *this->Position += size;
+    if(this->Size)
+      {
+      *this->Size = *this->Position;
+      }
+    return true;
+  }
+
+  char* Buffer;
+  std::size_t Capacity;
+  std::size_t* Size;
+  //shared since the sink is copied into the function holding it
+  boost::shared_ptr<std::size_t> Position;
+};
+
+}
+
+//------------------------------------------------------------------------------
+ResultSink make_FileDescriptorSink(int fd)
+{
+  return ResultSink( FileDescriptorSink(fd) );
+}
+
+//------------------------------------------------------------------------------
+ResultSink make_BufferSink(char* buffer, std::size_t capacity,
+                           std::size_t* size)
+{
+  return ResultSink( BufferSink(buffer, capacity, size) );
+}
+
+}
+}
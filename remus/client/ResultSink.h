@@ -0,0 +1,46 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_client_ResultSink_h
+#define remus_client_ResultSink_h
+
+#include <cstddef>
+
+#include <boost/function.hpp>
+
+//included for export symbols
+#include <remus/client/ClientExports.h>
+
+namespace remus{
+namespace client{
+
+//Where the data of a result streamed with Client::streamResults is
+//written. It is called with each chunk of the data in order, and returning
+//false stops the stream. Any callable can be a sink, the functions below
+//make sinks for the common destinations.
+typedef boost::function<bool (const char* data, std::size_t size)> ResultSink;
+
+//a sink that writes the data to an open file descriptor, which the caller
+//still owns
+REMUSCLIENT_EXPORT ResultSink make_FileDescriptorSink(int fd);
+
+//a sink that copies the data into a buffer of capacity bytes, which must
+//outlive the stream. The stream is stopped if the data doesn't fit, and
+//the number of bytes copied is kept in size when given
+REMUSCLIENT_EXPORT ResultSink make_BufferSink(char* buffer,
+                                              std::size_t capacity,
+                                              std::size_t* size = NULL);
+
+}
+}
+
+#endif
@@ -14,9 +14,15 @@
 #include <remus/client/Client.h>
 #include <remus/testing/Testing.h>
 
+#include <remus/proto/Message.h>
+#include <remus/proto/Response.h>
 #include <remus/proto/zmqHelper.h>
 
+#include <boost/make_shared.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+
 #include <string>
+#include <vector>
 
 namespace {
 
@@ -135,6 +141,121 @@ void verify_server_connection_tcp()
   REMUS_ASSERT( (remote_tcp_client.connection().isLocalEndpoint()==false) );
 }
 
+//counts the status replies that a callback was called with
+struct StatusCounter
+{
+  int* Count;
+  explicit StatusCounter(int* count): Count(count) {}
+  void operator()(const remus::proto::JobStatus&) const { ++(*this->Count); }
+};
+
+//answers each request like the server does, echoing the request id, or
+//leaving it empty like a server that doesn't know about request ids
+void reply_with_status(zmq::socket_t& socket,
+                       const zmq::SocketIdentity& client,
+                       const remus::proto::Message& request,
+                       bool echoRequestId)
+{
+  const remus::proto::Job job =
+                remus::proto::to_Job(request.data(), request.dataSize());
+  remus::proto::Response response(client);
+  if(echoRequestId)
+    {
+    response.requestId(request.requestId());
+    }
+  response.setServiceType(request.serviceType());
+  response.setData(
+      remus::proto::to_string(remus::proto::JobStatus(job.id(),
+                                                      remus::IN_PROGRESS)));
+  response.send(&socket);
+}
+
+void verify_pipelined_requests()
+{
+  zmq::socketInfo<zmq::proto::inproc> inproc_info("pipelined_inproc");
+  remus::client::ServerConnection conn =
+         remus::client::make_ServerConnection(inproc_info.endpoint());
+
+  zmq::socket_t server( *(conn.context()), ZMQ_ROUTER );
+  zmq::bindToAddress(server, inproc_info);
+
+  remus::client::Client client(conn);
+
+  //send every request before the server reads any of them
+  const std::size_t numRequests = 8;
+  const remus::common::MeshIOType mtype =
+      remus::common::make_MeshIOType(remus::meshtypes::Model(),
+                                     remus::meshtypes::Mesh3D());
+  boost::uuids::random_generator generator;
+  std::vector<remus::proto::Job> jobs;
+  std::vector< remus::client::Future<remus::proto::JobStatus> > futures;
+  int callbacks = 0;
+  for(std::size_t i=0; i < numRequests; ++i)
+    {
+    jobs.push_back( remus::proto::Job(generator(), mtype) );
+    futures.push_back( client.jobStatusAsync(jobs.back()) );
+    futures.back().onReady( StatusCounter(&callbacks) );
+    REMUS_ASSERT( (futures.back().valid()) );
+    REMUS_ASSERT( (!futures.back().ready()) );
+    }
+  REMUS_ASSERT( (client.pendingRequests() == numRequests) );
+  REMUS_ASSERT( (client.processReplies(0) == 0) );
+
+  //read all the requests, and answer them in reverse order
+  std::vector<zmq::SocketIdentity> identities;
+  std::vector< boost::shared_ptr<remus::proto::Message> > requests;
+  for(std::size_t i=0; i < numRequests; ++i)
+    {
+    identities.push_back( zmq::address_recv(server) );
+    requests.push_back( boost::make_shared<remus::proto::Message>(&server) );
+    REMUS_ASSERT( (requests.back()->isValid()) );
+    REMUS_ASSERT( (requests.back()->requestId().size() > 0) );
+    }
+  for(std::size_t i=numRequests; i > 0; --i)
+    {
+    reply_with_status(server, identities[i-1], *requests[i-1], true);
+    }
+
+  //every future gets the reply to its own request
+  for(std::size_t i=0; i < numRequests; ++i)
+    {
+    REMUS_ASSERT( (futures[i].wait(5000)) );
+    REMUS_ASSERT( (futures[i].get().id() == jobs[i].id()) );
+    REMUS_ASSERT( (futures[i].get().status() == remus::IN_PROGRESS) );
+    }
+  REMUS_ASSERT( (client.pendingRequests() == 0) );
+  REMUS_ASSERT( (callbacks == static_cast<int>(numRequests)) );
+
+  //a callback added after the reply is called right away
+  futures[0].onReady( StatusCounter(&callbacks) );
+  REMUS_ASSERT( (callbacks == static_cast<int>(numRequests) + 1) );
+
+  //replies without a request id go to the oldest request in flight
+  remus::client::Future<remus::proto::JobStatus> first =
+                                            client.jobStatusAsync(jobs[0]);
+  remus::client::Future<remus::proto::JobStatus> second =
+                                            client.jobStatusAsync(jobs[1]);
+  for(std::size_t i=0; i < 2; ++i)
+    {
+    zmq::SocketIdentity identity = zmq::address_recv(server);
+    remus::proto::Message request(&server);
+    reply_with_status(server, identity, request, false);
+    }
+  REMUS_ASSERT( (first.get().id() == jobs[0].id()) );
+  REMUS_ASSERT( (second.get().id() == jobs[1].id()) );
+
+  //once the reply is read there is nothing left for processReplies
+  remus::client::Future<remus::proto::JobStatus> async =
+                                            client.jobStatusAsync(jobs[2]);
+  {
+  zmq::SocketIdentity identity = zmq::address_recv(server);
+  remus::proto::Message request(&server);
+  reply_with_status(server, identity, request, true);
+  }
+  REMUS_ASSERT( (async.wait(5000)) );
+  REMUS_ASSERT( (client.processReplies(100) == 0) );
+}
+
 } //namespace
 
 
@@ -145,5 +266,6 @@ int UnitTestClient(int, char *[])
   verify_server_connection_ipc();
   #endif
   verify_server_connection_tcp();
+  verify_pipelined_requests();
   return 0;
 }
@@ -0,0 +1,53 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#ifndef remus_commmon_CpuTime_h
+#define remus_commmon_CpuTime_h
+
+#include <boost/cstdint.hpp>
+
+#ifndef _WIN32
+  #include <time.h>
+#else
+//see SleepFor.h for why we need WIN32_LEAN_AND_MEAN
+# ifndef WIN32_LEAN_AND_MEAN
+#   define WIN32_LEAN_AND_MEAN
+# endif
+  #include <windows.h>
+#endif
+
+namespace remus {
+namespace common {
+
+//returns the user and system cpu time the calling thread has used, in
+//microseconds
+inline static boost::int64_t ThreadCpuTimeInMicrosec()
+{
+  #ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    //filetimes count in 100 nanosecond intervals
+    return static_cast<boost::int64_t>((k.QuadPart + u.QuadPart) / 10);
+  #else
+    timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return static_cast<boost::int64_t>(t.tv_sec) * 1000000 + t.tv_nsec / 1000;
+  #endif
+}
+
+}
+}
+#endif
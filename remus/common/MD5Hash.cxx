@@ -47,5 +47,36 @@ std::string MD5Hash(const char* data, std::size_t length)
   return to_hash(data,length);
 }
 
+struct MD5Hasher::InternalImpl
+{
+  sysToolsMD5* Hasher;
+};
+
+MD5Hasher::MD5Hasher():
+  Implementation(new InternalImpl())
+{
+  this->Implementation->Hasher = sysToolsMD5_New();
+  sysToolsMD5_Initialize(this->Implementation->Hasher);
+}
+
+MD5Hasher::~MD5Hasher()
+{
+  sysToolsMD5_Delete(this->Implementation->Hasher);
+  delete this->Implementation;
+}
+
+void MD5Hasher::append(const char* data, std::size_t length)
+{
+  sysToolsMD5_Append(this->Implementation->Hasher,
+                     reinterpret_cast<const unsigned char*>(data), length);
+}
+
+std::string MD5Hasher::finish()
+{
+  char hash[32];
+  sysToolsMD5_FinalizeHex(this->Implementation->Hasher, hash);
+  return std::string(hash,32);
+}
+
 }
 }
@@ -30,6 +30,29 @@ std::string MD5Hash(const std::string& data);
 REMUSCOMMON_EXPORT
 std::string MD5Hash(const char* data, std::size_t length);
 
+//computes the same hash as MD5Hash, from data that is given a piece at a
+//time, so data that is too large to hold in memory at once can be hashed
+class REMUSCOMMON_EXPORT MD5Hasher
+{
+public:
+  MD5Hasher();
+  ~MD5Hasher();
+
+  void append(const char* data, std::size_t length);
+
+  //the hash of all the data appended so far, after which nothing more
+  //can be appended
+  std::string finish();
+
+private:
+  //the hasher doesn't support copy or move semantics
+  MD5Hasher(const MD5Hasher&);
+  void operator=(const MD5Hasher&);
+
+  struct InternalImpl;
+  InternalImpl* Implementation;
+};
+
 }
 }
 
@@ -50,6 +50,12 @@ struct MeshIOType
     this->CombinedType += in.id(); //now set the lower 16 bits to the value in
     }
 
+  //construct from the combined value returned by type(), needed to
+  //decode the object from the binary wire encoding
+  explicit MeshIOType(boost::uint32_t combined):
+    CombinedType(combined)
+    {}
+
   boost::uint32_t type() const { return CombinedType; }
 
   boost::uint16_t inputType() const
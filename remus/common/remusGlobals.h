@@ -41,7 +41,15 @@ static const std::string INVALID_MSG = "INVALID_MSG";
      ServiceTypeMacro(TERMINATE_JOB, 6, "TERMINATE JOB"), \
      ServiceTypeMacro(TERMINATE_WORKER, 7, "TERMINATE WORKER"), \
      ServiceTypeMacro(CAN_MESH_REQUIREMENTS, 8, "CAN MESH REQUIREMENTS"), \
-     ServiceTypeMacro(MESH_REQUIREMENTS, 9, "MESH REQUIREMENTS")
+     ServiceTypeMacro(MESH_REQUIREMENTS, 9, "MESH REQUIREMENTS"), \
+     ServiceTypeMacro(SERVER_STATS, 10, "SERVER STATS"), \
+     ServiceTypeMacro(MAKE_MESH_BATCH, 11, "MAKE MESH BATCH"), \
+     ServiceTypeMacro(MESH_STATUS_BATCH, 12, "MESH STATUS BATCH"), \
+     ServiceTypeMacro(SUBSCRIBE_JOB_STATUS, 13, "SUBSCRIBE JOB STATUS"), \
+     ServiceTypeMacro(WAIT_FOR_JOB, 14, "WAIT FOR JOB"), \
+     ServiceTypeMacro(STREAM_RESULT, 15, "STREAM RESULT"), \
+     ServiceTypeMacro(UPLOAD_JOB, 16, "UPLOAD JOB"), \
+     ServiceTypeMacro(UPLOAD_JOB_CHUNK, 17, "UPLOAD JOB CHUNK")
 
 //------------------------------------------------------------------------------
 enum SERVICE_TYPE
@@ -95,7 +103,7 @@ inline std::string to_string(remus::SERVICE_TYPE t)
 //------------------------------------------------------------------------------
 inline remus::SERVICE_TYPE to_serviceType(const std::string& t)
 {
-  for(int i=1; i <=9; i++)
+  for(int i=1; i <=17; i++)
     {
     remus::SERVICE_TYPE mt=static_cast<remus::SERVICE_TYPE>(i);
     if (remus::to_string(mt) == t)
@@ -10,6 +10,7 @@
 //
 //=============================================================================
 
+#include <algorithm>
 #include <string>
 
 #include <remus/common/MD5Hash.h>
@@ -58,6 +59,18 @@ int UnitTestMD5Hash(int, char *[])
   REMUS_ASSERT( (remus::common::MD5Hash(binary_junk) ==
                  remus::common::MD5Hash(bstorage)) );
 
+  //hashing a piece at a time gets the same hash as hashing it all at once
+  remus::common::MD5Hasher hasher;
+  for(std::size_t i=0; i < binary_junk.size(); i += 100000)
+    {
+    hasher.append(binary_junk.data() + i,
+                  std::min<std::size_t>(100000, binary_junk.size() - i));
+    }
+  REMUS_ASSERT( (hasher.finish() == remus::common::MD5Hash(binary_junk)) );
+
+  remus::common::MD5Hasher emptyHasher;
+  REMUS_ASSERT( (emptyHasher.finish() == empty_storage_hash) );
+
   REMUS_ASSERT( (empty_storage_hash.size() == 32) );
   REMUS_ASSERT( (remus::common::MD5Hash(bstorage).size() == 32) );
 
@@ -30,6 +30,7 @@
 #endif
 
 #include <remus/common/MeshIOType.h>
+#include <remus/proto/binaryHelpers.h>
 
 //The remus::proto::Job class
 // Holds the Id and Type of a submitted job.
@@ -57,6 +58,19 @@ public:
   //get the mesh type of the job
   const remus::common::MeshIOType& type() const { return Type; }
 
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const
+  {
+    buffer.putUInt32(this->Type.type());
+    buffer.putUUID(this->Id);
+  }
+
+  explicit Job(remus::internal::BinaryReader& buffer):
+  Type(buffer.getUInt32())
+  {
+    this->Id = buffer.getUUID();
+  }
+
 private:
   boost::uuids::uuid Id;
   remus::common::MeshIOType Type;
@@ -77,6 +91,17 @@ inline std::string to_string(const remus::proto::Job& job)
 //------------------------------------------------------------------------------
 inline remus::proto::Job to_Job(const std::string& msg)
 {
+  if(remus::internal::is_binary(msg.data(),msg.size()))
+    {
+    remus::internal::BinaryReader buffer(msg.data(),msg.size());
+    const remus::proto::Job decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::Job(boost::uuids::uuid(),
+                               remus::common::MeshIOType());
+      }
+    return decoded;
+    }
   //convert a job detail from a string, used as a hack to serialize
   std::istringstream buffer(msg);
 
@@ -92,6 +117,17 @@ inline remus::proto::Job to_Job(const std::string& msg)
 //------------------------------------------------------------------------------
 inline remus::proto::Job to_Job(const char* data, std::size_t size)
 {
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    const remus::proto::Job decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::Job(boost::uuids::uuid(),
+                               remus::common::MeshIOType());
+      }
+    return decoded;
+    }
   //convert a job from a string, used as a hack to serialize
   std::string temp(data,size);
   return to_Job( temp );
@@ -0,0 +1,266 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/JobBatch.h>
+
+#include <remus/proto/conversionHelpers.h>
+
+#include <boost/uuid/nil_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+namespace remus {
+namespace proto {
+
+//------------------------------------------------------------------------------
+JobSubmissionBatch::JobSubmissionBatch():
+  Submissions()
+{
+}
+
+//------------------------------------------------------------------------------
+JobSubmissionBatch::JobSubmissionBatch(const ContainerType& submissions):
+  Submissions(submissions)
+{
+}
+
+//------------------------------------------------------------------------------
+void JobSubmissionBatch::serialize(std::ostream& buffer) const
+{
+  buffer << this->Submissions.size() << std::endl;
+  for(std::size_t i=0; i < this->Submissions.size(); ++i)
+    {
+    buffer << this->Submissions[i] << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------
+JobSubmissionBatch::JobSubmissionBatch(std::istream& buffer):
+  Submissions()
+{
+  std::size_t count = 0;
+  buffer >> count;
+  for(std::size_t i=0; i < count && buffer.good(); ++i)
+    {
+    remus::proto::JobSubmission submission;
+    buffer >> submission;
+    this->Submissions.push_back(submission);
+    }
+}
+
+//------------------------------------------------------------------------------
+void JobSubmissionBatch::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUInt64(this->Submissions.size());
+  for(std::size_t i=0; i < this->Submissions.size(); ++i)
+    {
+    this->Submissions[i].serialize(buffer);
+    }
+}
+
+//------------------------------------------------------------------------------
+JobSubmissionBatch::JobSubmissionBatch(remus::internal::BinaryReader& buffer):
+  Submissions()
+{
+  const boost::uint64_t count = buffer.getUInt64();
+  for(boost::uint64_t i=0; i < count && buffer.good(); ++i)
+    {
+    this->Submissions.push_back( remus::proto::JobSubmission(buffer) );
+    }
+}
+
+//------------------------------------------------------------------------------
+JobBatch::JobBatch():
+  Jobs()
+{
+}
+
+//------------------------------------------------------------------------------
+JobBatch::JobBatch(const ContainerType& jobs):
+  Jobs(jobs)
+{
+}
+
+//------------------------------------------------------------------------------
+void JobBatch::serialize(std::ostream& buffer) const
+{
+  buffer << this->Jobs.size() << std::endl;
+  for(std::size_t i=0; i < this->Jobs.size(); ++i)
+    {
+    buffer << this->Jobs[i].type() << std::endl;
+    buffer << this->Jobs[i].id() << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------
+JobBatch::JobBatch(std::istream& buffer):
+  Jobs()
+{
+  std::size_t count = 0;
+  buffer >> count;
+  for(std::size_t i=0; i < count && buffer.good(); ++i)
+    {
+    remus::common::MeshIOType type;
+    boost::uuids::uuid id;
+    buffer >> type;
+    buffer >> id;
+    this->Jobs.push_back( remus::proto::Job(id,type) );
+    }
+}
+
+//------------------------------------------------------------------------------
+void JobBatch::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUInt64(this->Jobs.size());
+  for(std::size_t i=0; i < this->Jobs.size(); ++i)
+    {
+    this->Jobs[i].serialize(buffer);
+    }
+}
+
+//------------------------------------------------------------------------------
+JobBatch::JobBatch(remus::internal::BinaryReader& buffer):
+  Jobs()
+{
+  const boost::uint64_t count = buffer.getUInt64();
+  for(boost::uint64_t i=0; i < count && buffer.good(); ++i)
+    {
+    this->Jobs.push_back( remus::proto::Job(buffer) );
+    }
+}
+
+//------------------------------------------------------------------------------
+JobStatusBatch::JobStatusBatch():
+  Statuses()
+{
+}
+
+//------------------------------------------------------------------------------
+JobStatusBatch::JobStatusBatch(const ContainerType& statuses):
+  Statuses(statuses)
+{
+}
+
+//------------------------------------------------------------------------------
+void JobStatusBatch::serialize(std::ostream& buffer) const
+{
+  buffer << this->Statuses.size() << std::endl;
+  for(std::size_t i=0; i < this->Statuses.size(); ++i)
+    {
+    buffer << this->Statuses[i] << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------
+JobStatusBatch::JobStatusBatch(std::istream& buffer):
+  Statuses()
+{
+  std::size_t count = 0;
+  buffer >> count;
+  for(std::size_t i=0; i < count && buffer.good(); ++i)
+    {
+    remus::proto::JobStatus status(boost::uuids::nil_uuid(),
+                                   remus::INVALID_STATUS);
+    buffer >> status;
+    this->Statuses.push_back(status);
+    }
+}
+
+//------------------------------------------------------------------------------
+void JobStatusBatch::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUInt64(this->Statuses.size());
+  for(std::size_t i=0; i < this->Statuses.size(); ++i)
+    {
+    this->Statuses[i].serialize(buffer);
+    }
+}
+
+//------------------------------------------------------------------------------
+JobStatusBatch::JobStatusBatch(remus::internal::BinaryReader& buffer):
+  Statuses()
+{
+  const boost::uint64_t count = buffer.getUInt64();
+  for(boost::uint64_t i=0; i < count && buffer.good(); ++i)
+    {
+    this->Statuses.push_back( remus::proto::JobStatus(buffer) );
+    }
+}
+
+//------------------------------------------------------------------------------
+JobSubmissionBatch to_JobSubmissionBatch(const char* data, std::size_t size,
+                                    const boost::shared_ptr<const void>& owner)
+{
+  JobSubmissionBatch batch;
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size,owner);
+    JobSubmissionBatch decoded(buffer);
+    if(buffer.good())
+      {
+      batch = decoded;
+      }
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,size,owner);
+    std::istream buffer(&memory);
+    buffer >> batch;
+    }
+  return batch;
+}
+
+//------------------------------------------------------------------------------
+JobBatch to_JobBatch(const char* data, std::size_t size)
+{
+  JobBatch batch;
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    JobBatch decoded(buffer);
+    if(buffer.good())
+      {
+      batch = decoded;
+      }
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,size);
+    std::istream buffer(&memory);
+    buffer >> batch;
+    }
+  return batch;
+}
+
+//------------------------------------------------------------------------------
+JobStatusBatch to_JobStatusBatch(const char* data, std::size_t size)
+{
+  JobStatusBatch batch;
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    JobStatusBatch decoded(buffer);
+    if(buffer.good())
+      {
+      batch = decoded;
+      }
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,size);
+    std::istream buffer(&memory);
+    buffer >> batch;
+    }
+  return batch;
+}
+
+}
+}
@@ -0,0 +1,180 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_JobBatch_h
+#define remus_proto_JobBatch_h
+
+#include <sstream>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <remus/proto/Job.h>
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/JobSubmission.h>
+#include <remus/proto/binaryHelpers.h>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+//Collections of jobs that are sent to the server in a single message, so
+//that many jobs can be submitted or queried with one request and answered
+//with one response. Each batch is answered with a batch of the same length
+//and in the same order.
+namespace remus {
+namespace proto {
+
+//------------------------------------------------------------------------------
+//many submissions to queue at once, answered with a JobBatch
+class REMUSPROTO_EXPORT JobSubmissionBatch
+{
+public:
+  typedef std::vector<remus::proto::JobSubmission> ContainerType;
+
+  JobSubmissionBatch();
+  explicit JobSubmissionBatch(const ContainerType& submissions);
+
+  ContainerType Submissions;
+
+  friend std::ostream& operator<<(std::ostream &os,
+                                  const JobSubmissionBatch &batch)
+    { batch.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is,
+                                  JobSubmissionBatch &batch)
+    { batch = JobSubmissionBatch(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobSubmissionBatch(remus::internal::BinaryReader& buffer);
+
+private:
+  void serialize(std::ostream& buffer) const;
+  explicit JobSubmissionBatch(std::istream& buffer);
+};
+
+//------------------------------------------------------------------------------
+//many jobs, either the jobs a JobSubmissionBatch queued or the jobs to
+//query the status of, which is answered with a JobStatusBatch
+class REMUSPROTO_EXPORT JobBatch
+{
+public:
+  typedef std::vector<remus::proto::Job> ContainerType;
+
+  JobBatch();
+  explicit JobBatch(const ContainerType& jobs);
+
+  ContainerType Jobs;
+
+  friend std::ostream& operator<<(std::ostream &os, const JobBatch &batch)
+    { batch.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is, JobBatch &batch)
+    { batch = JobBatch(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobBatch(remus::internal::BinaryReader& buffer);
+
+private:
+  void serialize(std::ostream& buffer) const;
+  explicit JobBatch(std::istream& buffer);
+};
+
+//------------------------------------------------------------------------------
+//the status of each job in a JobBatch
+class REMUSPROTO_EXPORT JobStatusBatch
+{
+public:
+  typedef std::vector<remus::proto::JobStatus> ContainerType;
+
+  JobStatusBatch();
+  explicit JobStatusBatch(const ContainerType& statuses);
+
+  ContainerType Statuses;
+
+  friend std::ostream& operator<<(std::ostream &os,
+                                  const JobStatusBatch &batch)
+    { batch.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is, JobStatusBatch &batch)
+    { batch = JobStatusBatch(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobStatusBatch(remus::internal::BinaryReader& buffer);
+
+private:
+  void serialize(std::ostream& buffer) const;
+  explicit JobStatusBatch(std::istream& buffer);
+};
+
+//------------------------------------------------------------------------------
+inline std::string to_string(const remus::proto::JobSubmissionBatch& batch)
+{
+  std::ostringstream buffer;
+  buffer << batch;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+inline std::string to_string(const remus::proto::JobBatch& batch)
+{
+  std::ostringstream buffer;
+  buffer << batch;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+inline std::string to_string(const remus::proto::JobStatusBatch& batch)
+{
+  std::ostringstream buffer;
+  buffer << batch;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+//decode a batch of submissions whose content views into data instead of
+//copying it, see to_JobSubmission
+REMUSPROTO_EXPORT remus::proto::JobSubmissionBatch
+to_JobSubmissionBatch(const char* data, std::size_t size,
+                      const boost::shared_ptr<const void>& owner =
+                                            boost::shared_ptr<const void>());
+
+//------------------------------------------------------------------------------
+inline remus::proto::JobSubmissionBatch
+to_JobSubmissionBatch(const std::string& msg)
+{
+  return to_JobSubmissionBatch(msg.data(),msg.size());
+}
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT remus::proto::JobBatch
+to_JobBatch(const char* data, std::size_t size);
+
+//------------------------------------------------------------------------------
+inline remus::proto::JobBatch to_JobBatch(const std::string& msg)
+{
+  return to_JobBatch(msg.data(),msg.size());
+}
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT remus::proto::JobStatusBatch
+to_JobStatusBatch(const char* data, std::size_t size);
+
+//------------------------------------------------------------------------------
+inline remus::proto::JobStatusBatch to_JobStatusBatch(const std::string& msg)
+{
+  return to_JobStatusBatch(msg.data(),msg.size());
+}
+
+}
+}
+
+#endif
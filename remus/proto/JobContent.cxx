@@ -38,11 +38,25 @@ struct JobContent::InternalImpl
     Size(s),
     Data(d),
     Storage(),
+    Owner(),
     ShortHash(),
     FullHash()
   {
   }
 
+  //view into memory that the owner keeps alive
+  InternalImpl(const char* d, std::size_t s,
+               const boost::shared_ptr<const void>& owner,
+               const std::string& hash = std::string()):
+    Size(s),
+    Data(d),
+    Storage(),
+    Owner(owner),
+    ShortHash(),
+    FullHash(hash)
+  {
+  }
+
   std::size_t size() const { return Size; }
   const char* data() const { return Data; }
 
@@ -87,6 +101,8 @@ struct JobContent::InternalImpl
       }
     return this->FullHash;
   }
+
+  bool hasFullHash() const { return !this->FullHash.empty(); }
 private:
 
   //store the size of the data being held
@@ -98,6 +114,9 @@ private:
   //Storage is an optional allocation that is used when we need to copy data
   remus::common::ConditionalStorage Storage;
 
+  //Owner keeps the memory we view into alive, when we didn't copy it
+  boost::shared_ptr<const void> Owner;
+
   //MD5Hash of the data held by us.
   std::string ShortHash;
   std::string FullHash;
@@ -152,6 +171,35 @@ JobContent::JobContent(remus::common::ContentFormat::Type format,
 
 }
 
+//------------------------------------------------------------------------------
+JobContent::JobContent(remus::common::ContentFormat::Type format,
+                       const char* contents,
+                       std::size_t size,
+                       const boost::shared_ptr<const void>& owner):
+  SourceType(remus::common::ContentSource::Memory),
+  FormatType(format),
+  Tag(),
+  Implementation( boost::make_shared<InternalImpl>(contents,size,owner) )
+  //make_shared is significantly faster than using manual new
+{
+
+}
+
+//------------------------------------------------------------------------------
+JobContent::JobContent(remus::common::ContentFormat::Type format,
+                       const char* contents,
+                       std::size_t size,
+                       const boost::shared_ptr<const void>& owner,
+                       const std::string& hash):
+  SourceType(remus::common::ContentSource::Memory),
+  FormatType(format),
+  Tag(),
+  Implementation( boost::make_shared<InternalImpl>(contents,size,owner,hash) )
+  //make_shared is significantly faster than using manual new
+{
+
+}
+
 //------------------------------------------------------------------------------
 const char* JobContent::data() const
 {
@@ -164,6 +212,18 @@ std::size_t JobContent::dataSize() const
   return this->Implementation->size();
 }
 
+//------------------------------------------------------------------------------
+const std::string& JobContent::hash() const
+{
+  return this->Implementation->fullHash();
+}
+
+//------------------------------------------------------------------------------
+bool JobContent::hasHash() const
+{
+  return this->Implementation->hasFullHash();
+}
+
 //------------------------------------------------------------------------------
 bool JobContent::operator<(const JobContent& other) const
 {
@@ -229,8 +289,17 @@ JobContent::JobContent(std::istream& buffer)
   buffer >> tagSize;
   this->Tag = remus::internal::extractString(buffer,tagSize);
 
-  //read in the contents, todo do this with less temp objects and copies
+  //read in the contents, viewing into the received message when we can
   buffer >> contentsSize;
+  const char* view = NULL;
+  boost::shared_ptr<const void> owner;
+  if(remus::internal::extractView(buffer,contentsSize,view,owner))
+    {
+    this->Implementation =
+                boost::make_shared<InternalImpl>(view,contentsSize,owner);
+    return;
+    }
+
   std::vector<char> contents(contentsSize);
 
   //enables us to use less copies for faster read of large data
@@ -240,6 +309,39 @@ JobContent::JobContent(std::istream& buffer)
   this->Implementation = boost::make_shared<InternalImpl>(contents);
 }
 
+//------------------------------------------------------------------------------
+void JobContent::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUInt32(this->sourceType());
+  buffer.putUInt32(this->formatType());
+  buffer.putString(this->tag());
+  buffer.putBytes(this->Implementation->data(), this->Implementation->size());
+}
+
+//------------------------------------------------------------------------------
+JobContent::JobContent(remus::internal::BinaryReader& buffer)
+{
+  this->SourceType =
+        static_cast<remus::common::ContentSource::Type>(buffer.getUInt32());
+  this->FormatType =
+        static_cast<remus::common::ContentFormat::Type>(buffer.getUInt32());
+  this->Tag = buffer.getString();
+
+  //view into the received message when we can, otherwise copy the
+  //contents straight from the wire into our storage
+  const remus::internal::BinaryBytes contents = buffer.getBytes();
+  if(buffer.owner() && buffer.good())
+    {
+    this->Implementation = boost::make_shared<InternalImpl>(contents.data(),
+                                                            contents.size(),
+                                                            buffer.owner());
+    }
+  else
+    {
+    this->Implementation = boost::make_shared<InternalImpl>(contents);
+    }
+}
+
 
 }
 }
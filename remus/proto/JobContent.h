@@ -22,6 +22,9 @@
 #include <remus/common/ContentTypes.h>
 #include <remus/common/FileHandle.h>
 
+#include <remus/proto/binaryHelpers.h>
+#include <remus/proto/conversionHelpers.h>
+
 //included for export symbols
 #include <remus/proto/ProtoExports.h>
 
@@ -54,6 +57,22 @@ public:
              const char* contents,
              std::size_t size);
 
+  //pass in some Memory data to send to the worker without copying it.
+  //The owner keeps the contents alive, and is held by the content for as
+  //long as it exists
+  JobContent(remus::common::ContentFormat::Type format,
+             const char* contents,
+             std::size_t size,
+             const boost::shared_ptr<const void>& owner);
+
+  //as above, for data whose MD5 hash is already known, such as data that
+  //was checked against its hash when it arrived
+  JobContent(remus::common::ContentFormat::Type format,
+             const char* contents,
+             std::size_t size,
+             const boost::shared_ptr<const void>& owner,
+             const std::string& hash);
+
   //returns if the source of the content is memory or a file
   remus::common::ContentSource::Type sourceType() const
     { return this->SourceType; }
@@ -70,6 +89,13 @@ public:
   const char* data() const;
   std::size_t dataSize() const;
 
+  //the MD5 hash of the data, computed the first time it is asked for. The
+  //data of a content whose source is a file is the path of the file
+  const std::string& hash() const;
+
+  //returns true if the hash is already known, so asking for it is cheap
+  bool hasHash() const;
+
   ///implement a less than operator and equal operator so you
   //can use the class in containers and algorithms
   bool operator<(const JobContent& other) const;
@@ -81,6 +107,10 @@ public:
   friend std::istream& operator>>(std::istream &is, JobContent &content)
     { content = JobContent(is); return is; }
 
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobContent(remus::internal::BinaryReader& buffer);
+
 private:
   //serialize function
   void serialize(std::ostream& buffer) const;
@@ -124,17 +154,51 @@ inline std::string to_string(const remus::proto::JobContent& content)
 //------------------------------------------------------------------------------
 inline remus::proto::JobContent to_JobContent(const std::string& msg)
 {
+  if(remus::internal::is_binary(msg.data(),msg.size()))
+    {
+    remus::internal::BinaryReader buffer(msg.data(),msg.size());
+    const remus::proto::JobContent decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobContent();
+      }
+    return decoded;
+    }
   std::istringstream buffer(msg);
   remus::proto::JobContent content;
   buffer >> content;
   return content;
 }
 
+//------------------------------------------------------------------------------
+//decode content that views into data instead of copying it. The owner
+//must keep data alive and unchanged, and is held by the content for as
+//long as it exists
+inline remus::proto::JobContent to_JobContent(const char* data,
+                                   std::size_t size,
+                                   const boost::shared_ptr<const void>& owner)
+{
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size,owner);
+    const remus::proto::JobContent decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobContent();
+      }
+    return decoded;
+    }
+  remus::internal::MemoryStreamBuffer memory(data,size,owner);
+  std::istream buffer(&memory);
+  remus::proto::JobContent content;
+  buffer >> content;
+  return content;
+}
+
 //------------------------------------------------------------------------------
 inline remus::proto::JobContent to_JobContent(const char* data, std::size_t size)
 {
-  std::string temp(data,size);
-  return to_JobContent( temp );
+  return to_JobContent(data,size,boost::shared_ptr<const void>());
 }
 
 
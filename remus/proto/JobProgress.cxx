@@ -80,5 +80,19 @@ JobProgress::JobProgress(std::istream& buffer)
   this->Message = remus::internal::extractString(buffer,progressMessageLen);
 }
 
+//------------------------------------------------------------------------------
+void JobProgress::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUInt32(static_cast<boost::uint32_t>(this->value()));
+  buffer.putString(this->Message);
+}
+
+//------------------------------------------------------------------------------
+JobProgress::JobProgress(remus::internal::BinaryReader& buffer):
+  Value( static_cast<boost::int32_t>(buffer.getUInt32()) ),
+  Message( buffer.getString() )
+{
+}
+
 }
 }
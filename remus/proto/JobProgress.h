@@ -18,6 +18,7 @@
 #include <algorithm>
 
 #include <remus/common/remusGlobals.h>
+#include <remus/proto/binaryHelpers.h>
 
 //included for export symbols
 #include <remus/proto/ProtoExports.h>
@@ -65,6 +66,10 @@ public:
   friend std::istream& operator>>(std::istream &is, JobProgress &prog)
     { prog = JobProgress(is); return is; }
 
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobProgress(remus::internal::BinaryReader& buffer);
+
 private:
   //serialize function
   void serialize(std::ostream& buffer) const;
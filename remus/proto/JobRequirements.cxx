@@ -216,6 +216,32 @@ JobRequirements::JobRequirements(std::istream& buffer)
   this->Implementation = boost::make_shared<InternalImpl>(contents);
 }
 
+//------------------------------------------------------------------------------
+void JobRequirements::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUInt32(this->sourceType());
+  buffer.putUInt32(this->formatType());
+  buffer.putUInt32(this->meshTypes().type());
+  buffer.putString(this->workerName());
+  buffer.putString(this->tag());
+  buffer.putBytes(this->requirements(), this->requirementsSize());
+}
+
+//------------------------------------------------------------------------------
+JobRequirements::JobRequirements(remus::internal::BinaryReader& buffer)
+{
+  this->SourceType =
+        static_cast<remus::common::ContentSource::Type>(buffer.getUInt32());
+  this->FormatType =
+        static_cast<remus::common::ContentFormat::Type>(buffer.getUInt32());
+  this->MeshType = remus::common::MeshIOType(buffer.getUInt32());
+  this->WorkerName = buffer.getString();
+  this->Tag = buffer.getString();
+
+  //copy the requirements straight from the wire into our storage
+  this->Implementation = boost::make_shared<InternalImpl>(buffer.getBytes());
+}
+
 //------------------------------------------------------------------------------
 JobRequirementsSet::JobRequirementsSet():
 Container()
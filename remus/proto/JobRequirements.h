@@ -24,6 +24,8 @@
 #include <remus/common/FileHandle.h>
 #include <remus/common/MeshIOType.h>
 
+#include <remus/proto/binaryHelpers.h>
+
 //for export symbols
 #include <remus/proto/ProtoExports.h>
 
@@ -112,6 +114,10 @@ public:
                                   JobRequirements &reqs)
     { reqs = JobRequirements(is); return is; }
 
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobRequirements(remus::internal::BinaryReader& buffer);
+
 private:
   //The worker needs to be a friend to send lightweight representations
   //of the full requirements to the server. This is the easiest way to do so.
@@ -221,6 +227,16 @@ inline std::string to_string(const remus::proto::JobRequirements& reqs)
 inline remus::proto::JobRequirements
 to_JobRequirements(const std::string& msg)
 {
+  if(remus::internal::is_binary(msg.data(),msg.size()))
+    {
+    remus::internal::BinaryReader buffer(msg.data(),msg.size());
+    const remus::proto::JobRequirements decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobRequirements();
+      }
+    return decoded;
+    }
   std::istringstream buffer(msg);
   remus::proto::JobRequirements reqs;
   buffer >> reqs;
@@ -231,6 +247,16 @@ to_JobRequirements(const std::string& msg)
 inline remus::proto::JobRequirements
 to_JobRequirements(const char* data, int size)
 {
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    const remus::proto::JobRequirements decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobRequirements();
+      }
+    return decoded;
+    }
   std::string temp(size,char());
   std::copy( data, data+size, temp.begin() );
   return to_JobRequirements( temp );
@@ -92,5 +92,22 @@ JobResult::JobResult(std::istream& buffer)
   this->FormatType = static_cast<remus::common::ContentFormat::Type>(ftype);
 }
 
+//------------------------------------------------------------------------------
+void JobResult::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUUID(this->id());
+  buffer.putUInt32(this->formatType());
+  buffer.putString(this->Data);
+}
+
+//------------------------------------------------------------------------------
+JobResult::JobResult(remus::internal::BinaryReader& buffer):
+  JobId( buffer.getUUID() ),
+  FormatType( static_cast<remus::common::ContentFormat::Type>(
+                                                    buffer.getUInt32()) ),
+  Data( buffer.getString() )
+{
+}
+
 }
 }
\ No newline at end of file
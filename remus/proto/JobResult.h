@@ -22,6 +22,19 @@
 
 #include <boost/uuid/uuid.hpp>
 
+//suppress warnings inside boost headers for gcc and clang
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include <boost/uuid/uuid_io.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <remus/proto/binaryHelpers.h>
+#include <remus/proto/conversionHelpers.h>
+
 //included for export symbols
 #include <remus/proto/ProtoExports.h>
 
@@ -74,6 +87,10 @@ public:
                                   JobResult &submission)
     { submission = JobResult(is); return is; }
 
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobResult(remus::internal::BinaryReader& buffer);
+
 private:
   friend remus::proto::JobResult to_JobResult(const std::string& msg);
   //serialize function
@@ -114,6 +131,16 @@ inline std::string to_string(const remus::proto::JobResult& result)
 //------------------------------------------------------------------------------
 inline remus::proto::JobResult to_JobResult(const std::string& msg)
 {
+  if(remus::internal::is_binary(msg.data(),msg.size()))
+    {
+    remus::internal::BinaryReader buffer(msg.data(),msg.size());
+    const remus::proto::JobResult decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobResult(boost::uuids::uuid());
+      }
+    return decoded;
+    }
   //convert a job detail from a string, used as a hack to serialize
   std::istringstream buffer(msg);
   return remus::proto::JobResult(buffer);
@@ -123,10 +150,91 @@ inline remus::proto::JobResult to_JobResult(const std::string& msg)
 //------------------------------------------------------------------------------
 inline remus::proto::JobResult to_JobResult(const char* data, std::size_t size)
 {
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    const remus::proto::JobResult decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobResult(boost::uuids::uuid());
+      }
+    return decoded;
+    }
   std::string temp(data,size);
   return to_JobResult( temp );
 }
 
+//------------------------------------------------------------------------------
+//decode only the job id of an encoded JobResult, so the result can be kept
+//in its encoded form without reading the data
+inline boost::uuids::uuid to_JobResultId(const char* data, std::size_t size)
+{
+  boost::uuids::uuid id = boost::uuids::uuid();
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    id = buffer.getUUID();
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,size);
+    std::istream buffer(&memory);
+    buffer >> id;
+    }
+  return id;
+}
+
+//------------------------------------------------------------------------------
+//find the data of an encoded JobResult without copying it, so the result
+//can be sent in pieces. Returns false if the encoding is invalid
+inline bool view_JobResultData(const char* data, std::size_t size,
+                               remus::common::ContentFormat::Type& format,
+                               const char*& view, std::size_t& viewSize)
+{
+  int ftype = 0;
+  view = NULL;
+  viewSize = 0;
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    buffer.getUUID();
+    ftype = static_cast<int>(buffer.getUInt32());
+    const remus::internal::BinaryBytes bytes = buffer.getBytes();
+    if(!buffer.good())
+      {
+      return false;
+      }
+    view = bytes.data();
+    viewSize = bytes.size();
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,size);
+    std::istream buffer(&memory);
+    boost::uuids::uuid id;
+    std::size_t dataSize = 0;
+    buffer >> id;
+    buffer >> ftype;
+    buffer >> dataSize;
+    if(!buffer.good())
+      {
+      return false;
+      }
+    if(buffer.peek()=='\n')
+      {
+      buffer.get();
+      }
+    view = memory.take(dataSize);
+    if(!view)
+      {
+      return false;
+      }
+    viewSize = dataSize;
+    }
+  format = static_cast<remus::common::ContentFormat::Type>(ftype);
+  return true;
+}
+
 
 }
 }
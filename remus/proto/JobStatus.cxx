@@ -21,7 +21,8 @@ namespace proto {
 JobStatus::JobStatus(const boost::uuids::uuid& jid, remus::STATUS_TYPE statusType):
   JobId(jid),
   Status(statusType),
-  Progress(statusType)
+  Progress(statusType),
+  Timestamps()
 {
 }
 
@@ -32,7 +33,8 @@ JobStatus::JobStatus(const boost::uuids::uuid& jid,
                      const remus::proto::JobProgress& jprogress):
   JobId(jid),
   Status(remus::IN_PROGRESS),
-  Progress(jprogress)
+  Progress(jprogress),
+  Timestamps()
 {
 }
 
@@ -49,6 +51,7 @@ void JobStatus::serialize(std::ostream& buffer) const
   buffer << this->id() << std::endl;
   buffer << this->status() << std::endl;
   buffer << this->progress() << std::endl;
+  buffer << this->timestamps() << std::endl;
 }
 
 //------------------------------------------------------------------------------
@@ -58,9 +61,34 @@ JobStatus::JobStatus(std::istream& buffer)
   buffer >> this->JobId;
   buffer >> t;
   buffer >> this->Progress;
+  //statuses from peers that don't send timestamps leave them at zero
+  buffer >> this->Timestamps;
   this->Status = static_cast<remus::STATUS_TYPE>(t);
 }
 
+//------------------------------------------------------------------------------
+void JobStatus::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUUID(this->id());
+  buffer.putUInt32(this->status());
+  this->progress().serialize(buffer);
+  this->timestamps().serialize(buffer);
+}
+
+//------------------------------------------------------------------------------
+JobStatus::JobStatus(remus::internal::BinaryReader& buffer):
+  JobId( buffer.getUUID() ),
+  Status( static_cast<remus::STATUS_TYPE>(buffer.getUInt32()) ),
+  Progress( buffer ),
+  Timestamps()
+{
+  //statuses from peers that don't send timestamps leave them at zero
+  if(buffer.remaining() > 0)
+    {
+    this->Timestamps = remus::proto::JobTimestamps(buffer);
+    }
+}
+
 
 }
 }
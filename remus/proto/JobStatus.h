@@ -30,6 +30,7 @@
 
 #include <remus/common/remusGlobals.h>
 #include <remus/proto/JobProgress.h>
+#include <remus/proto/JobTimestamps.h>
 
 //included for export symbols
 #include <remus/proto/ProtoExports.h>
@@ -100,8 +101,18 @@ public:
   //get back the status flag type for this job
   remus::STATUS_TYPE status() const { return Status; }
 
+  //returns when the server saw the job reach each stage of its life,
+  //these are only filled in on statuses that come from the server
+  const remus::proto::JobTimestamps& timestamps() const
+    { return this->Timestamps; }
+
+  //update the timestamps of the status object
+  void updateTimestamps( const remus::proto::JobTimestamps& times )
+    { this->Timestamps = times; }
+
   //overload on the job status object to make it easier to detect when
-  //job status has been changed.
+  //job status has been changed. The timestamps aren't compared, so the
+  //status a worker sends equals the one the server hands back.
   bool operator ==(const JobStatus& b) const
   {
     return (this->JobId == b.JobId)   &&
@@ -121,6 +132,10 @@ public:
                                   JobStatus &status)
     { status = JobStatus(is); return is; }
 
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobStatus(remus::internal::BinaryReader& buffer);
+
 private:
   friend remus::proto::JobStatus to_JobStatus(const std::string& msg);
 
@@ -133,6 +148,7 @@ private:
   boost::uuids::uuid JobId;
   remus::STATUS_TYPE Status;
   remus::proto::JobProgress Progress;
+  remus::proto::JobTimestamps Timestamps;
 };
 
 //------------------------------------------------------------------------------
@@ -176,6 +192,17 @@ inline remus::proto::JobStatus make_FailedJobStatus(
 //------------------------------------------------------------------------------
 inline remus::proto::JobStatus to_JobStatus(const std::string& msg)
 {
+  if(remus::internal::is_binary(msg.data(),msg.size()))
+    {
+    remus::internal::BinaryReader buffer(msg.data(),msg.size());
+    const remus::proto::JobStatus decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobStatus(boost::uuids::uuid(),
+                                     remus::INVALID_STATUS);
+      }
+    return decoded;
+    }
   std::istringstream buffer(msg);
   return remus::proto::JobStatus(buffer);
 }
@@ -184,6 +211,17 @@ inline remus::proto::JobStatus to_JobStatus(const std::string& msg)
 //------------------------------------------------------------------------------
 inline remus::proto::JobStatus to_JobStatus(const char* data, std::size_t size)
 {
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    const remus::proto::JobStatus decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobStatus(boost::uuids::uuid(),
+                                     remus::INVALID_STATUS);
+      }
+    return decoded;
+    }
   //the data might contain null terminators which on windows
   //makes the data,size construct fail, so instead we use std::copy
   std::string temp(data,size);
@@ -23,7 +23,10 @@ namespace proto{
 JobSubmission::JobSubmission(  ):
   MeshType( ),
   Requirements( ),
-  Content()
+  Content(),
+  EncodedData(NULL),
+  EncodedSize(0),
+  EncodedOwner()
 {
 }
 
@@ -31,7 +34,10 @@ JobSubmission::JobSubmission(  ):
 JobSubmission::JobSubmission( const remus::proto::JobRequirements& reqs ):
   MeshType(reqs.meshTypes()),
   Requirements(reqs),
-  Content()
+  Content(),
+  EncodedData(NULL),
+  EncodedSize(0),
+  EncodedOwner()
 {
 }
 
@@ -40,7 +46,10 @@ JobSubmission::JobSubmission( const remus::proto::JobRequirements& reqs,
                               const remus::proto::JobContent& content ):
   MeshType(reqs.meshTypes()),
   Requirements(reqs),
-  Content( )
+  Content( ),
+  EncodedData(NULL),
+  EncodedSize(0),
+  EncodedOwner()
 {
   this->Content[this->default_key()]=content;
 }
@@ -50,7 +59,10 @@ JobSubmission::JobSubmission( const remus::proto::JobRequirements& reqs,
             const std::map<std::string,remus::proto::JobContent>& content ):
   MeshType(reqs.meshTypes()),
   Requirements(reqs),
-  Content(content)
+  Content(content),
+  EncodedData(NULL),
+  EncodedSize(0),
+  EncodedOwner()
 {
 }
 
@@ -100,7 +112,13 @@ void JobSubmission::serialize(std::ostream& buffer) const
 }
 
 //------------------------------------------------------------------------------
-JobSubmission::JobSubmission(std::istream& buffer)
+JobSubmission::JobSubmission(std::istream& buffer):
+  MeshType( ),
+  Requirements( ),
+  Content(),
+  EncodedData(NULL),
+  EncodedSize(0),
+  EncodedOwner()
 {
   std::size_t contentSize=0;
   buffer >> this->MeshType;
@@ -119,6 +137,38 @@ JobSubmission::JobSubmission(std::istream& buffer)
     }
 }
 
+//------------------------------------------------------------------------------
+void JobSubmission::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUInt32(this->MeshType.type());
+  this->Requirements.serialize(buffer);
+  buffer.putUInt64(this->Content.size());
+  for(JobSubmission::const_iterator i = this->begin();
+      i != this->end();
+      ++i)
+    {
+    buffer.putString(i->first);
+    i->second.serialize(buffer);
+    }
+}
+
+//------------------------------------------------------------------------------
+JobSubmission::JobSubmission(remus::internal::BinaryReader& buffer):
+  MeshType( buffer.getUInt32() ),
+  Requirements( buffer ),
+  Content(),
+  EncodedData(NULL),
+  EncodedSize(0),
+  EncodedOwner()
+{
+  const boost::uint64_t contentSize = buffer.getUInt64();
+  for(boost::uint64_t i = 0; i < contentSize && buffer.good(); ++i)
+    {
+    const std::string key = buffer.getString();
+    this->Content[key] = JobContent(buffer);
+    }
+}
+
 
 }
 }
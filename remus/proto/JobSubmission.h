@@ -18,6 +18,7 @@
 
 #include <remus/proto/JobContent.h>
 #include <remus/proto/JobRequirements.h>
+#include <remus/proto/conversionHelpers.h>
 
 #include <remus/proto/ProtoExports.h>
 
@@ -57,25 +58,25 @@ public:
   //add new content to the job submission. If the key is already in use
   //we will overwrite the job content with
   std::pair<iterator,bool> insert( const value_type& value )
-    { return this->Content.insert(value); }
+    { this->forgetEncoded(); return this->Content.insert(value); }
 
   template< class InputIt >
   void insert( InputIt first, InputIt last )
-    { return this->Content.insert(first,last); }
+    { this->forgetEncoded(); return this->Content.insert(first,last); }
 
   remus::proto::JobContent& operator[]( const std::string& key )
-    { return this->Content[key]; }
+    { this->forgetEncoded(); return this->Content[key]; }
 
-  iterator begin() { return this->Content.begin(); }
+  iterator begin() { this->forgetEncoded(); return this->Content.begin(); }
   const_iterator begin() const { return this->Content.begin(); }
 
-  iterator end( ) { return this->Content.end(); }
+  iterator end( ) { this->forgetEncoded(); return this->Content.end(); }
   const_iterator end( ) const { return this->Content.end(); }
 
   const_iterator find( const std::string& key ) const
     { return this->Content.find(key); }
   iterator find( const std::string& key )
-    { return this->Content.find(key); }
+    { this->forgetEncoded(); return this->Content.find(key); }
 
   std::size_t size() const { return this->Content.size(); }
 
@@ -86,6 +87,16 @@ public:
   const remus::proto::JobRequirements& requirements( ) const
     { return this->Requirements; }
 
+  //When the submission was decoded with an owner that keeps the received
+  //bytes alive, these are the encoded bytes it was decoded from, so they
+  //can be forwarded without encoding the submission again. Any non const
+  //access to the content forgets them.
+  bool hasEncoded() const { return this->EncodedOwner ? true : false; }
+  const char* encodedData() const { return this->EncodedData; }
+  std::size_t encodedSize() const { return this->EncodedSize; }
+  const boost::shared_ptr<const void>& encodedOwner() const
+    { return this->EncodedOwner; }
+
   //implement a less than operator and equal operator so you
   //can use the class in containers and algorithms
   bool operator<(const JobSubmission& other) const;
@@ -100,17 +111,37 @@ public:
                                   JobSubmission &submission)
     { submission = JobSubmission(is); return is; }
 
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobSubmission(remus::internal::BinaryReader& buffer);
+
 private:
+  friend remus::proto::JobSubmission to_JobSubmission(const char* data,
+                                  std::size_t length,
+                                  const boost::shared_ptr<const void>& owner);
+
   //serialize function
   void serialize(std::ostream& buffer) const;
 
   //deserialize constructor function
   explicit JobSubmission(std::istream& buffer);
 
+  void forgetEncoded()
+  {
+    this->EncodedData = NULL;
+    this->EncodedSize = 0;
+    this->EncodedOwner.reset();
+  }
+
   remus::common::MeshIOType MeshType;
   remus::proto::JobRequirements Requirements;
   ContainerType Content;
 
+  //the bytes we were decoded from, see hasEncoded
+  const char* EncodedData;
+  std::size_t EncodedSize;
+  boost::shared_ptr<const void> EncodedOwner;
+
 
 };
 
@@ -126,18 +157,60 @@ inline std::string to_string(const remus::proto::JobSubmission& sub)
 inline remus::proto::JobSubmission
 to_JobSubmission(const std::string& msg)
 {
+  if(remus::internal::is_binary(msg.data(),msg.size()))
+    {
+    remus::internal::BinaryReader buffer(msg.data(),msg.size());
+    const remus::proto::JobSubmission decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobSubmission();
+      }
+    return decoded;
+    }
   remus::proto::JobSubmission submission;
   std::istringstream buffer(msg);
   buffer >> submission;
   return submission;
 }
 
+//------------------------------------------------------------------------------
+//decode a submission whose content views into data instead of copying it.
+//The owner must keep data alive and unchanged, and is held by the content
+//of the submission for as long as any of it exists
+inline remus::proto::JobSubmission
+to_JobSubmission(const char* data, std::size_t length,
+                 const boost::shared_ptr<const void>& owner)
+{
+  remus::proto::JobSubmission submission;
+  if(remus::internal::is_binary(data,length))
+    {
+    remus::internal::BinaryReader buffer(data,length,owner);
+    remus::proto::JobSubmission decoded(buffer);
+    if(buffer.good())
+      {
+      submission = decoded;
+      }
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,length,owner);
+    std::istream buffer(&memory);
+    buffer >> submission;
+    }
+  if(owner)
+    {
+    submission.EncodedData = data;
+    submission.EncodedSize = length;
+    submission.EncodedOwner = owner;
+    }
+  return submission;
+}
+
 //------------------------------------------------------------------------------
 inline remus::proto::JobSubmission
 to_JobSubmission(const char* data, std::size_t length)
 {
-  std::string temp(data,length);
-  return to_JobSubmission( temp );
+  return to_JobSubmission(data,length,boost::shared_ptr<const void>());
 }
 
 }
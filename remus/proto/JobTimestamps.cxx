@@ -0,0 +1,105 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/JobTimestamps.h>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#elif defined(__APPLE__)
+  #include <mach/mach_time.h>
+#else
+  #include <time.h>
+#endif
+
+namespace remus {
+namespace proto {
+
+//------------------------------------------------------------------------------
+JobTimestamps::JobTimestamps():
+  Queued(0),
+  Dispatched(0),
+  FirstProgress(0),
+  Finished(0)
+{
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t JobTimestamps::now()
+{
+#if defined(_WIN32)
+  LARGE_INTEGER frequency, count;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&count);
+  return static_cast<boost::int64_t>(
+          (count.QuadPart / frequency.QuadPart) * 1000000 +
+          (count.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart);
+#elif defined(__APPLE__)
+  static mach_timebase_info_data_t timebase = { 0, 0 };
+  if(timebase.denom == 0)
+    {
+    mach_timebase_info(&timebase);
+    }
+  return static_cast<boost::int64_t>(
+          mach_absolute_time() * timebase.numer / timebase.denom / 1000);
+#else
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return static_cast<boost::int64_t>(t.tv_sec) * 1000000 + t.tv_nsec / 1000;
+#endif
+}
+
+//------------------------------------------------------------------------------
+void JobTimestamps::serialize(std::ostream& buffer) const
+{
+  buffer << this->Queued << std::endl;
+  buffer << this->Dispatched << std::endl;
+  buffer << this->FirstProgress << std::endl;
+  buffer << this->Finished << std::endl;
+}
+
+//------------------------------------------------------------------------------
+JobTimestamps::JobTimestamps(std::istream& buffer):
+  Queued(0),
+  Dispatched(0),
+  FirstProgress(0),
+  Finished(0)
+{
+  buffer >> this->Queued;
+  buffer >> this->Dispatched;
+  buffer >> this->FirstProgress;
+  buffer >> this->Finished;
+  if(buffer.fail())
+    {
+    *this = JobTimestamps();
+    }
+}
+
+//------------------------------------------------------------------------------
+void JobTimestamps::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUInt64(static_cast<boost::uint64_t>(this->Queued));
+  buffer.putUInt64(static_cast<boost::uint64_t>(this->Dispatched));
+  buffer.putUInt64(static_cast<boost::uint64_t>(this->FirstProgress));
+  buffer.putUInt64(static_cast<boost::uint64_t>(this->Finished));
+}
+
+//------------------------------------------------------------------------------
+JobTimestamps::JobTimestamps(remus::internal::BinaryReader& buffer):
+  Queued( static_cast<boost::int64_t>(buffer.getUInt64()) ),
+  Dispatched( static_cast<boost::int64_t>(buffer.getUInt64()) ),
+  FirstProgress( static_cast<boost::int64_t>(buffer.getUInt64()) ),
+  Finished( static_cast<boost::int64_t>(buffer.getUInt64()) )
+{
+}
+
+}
+}
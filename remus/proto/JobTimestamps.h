@@ -0,0 +1,89 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_JobTimestamps_h
+#define remus_proto_JobTimestamps_h
+
+#include <sstream>
+
+#include <boost/cstdint.hpp>
+
+#include <remus/proto/binaryHelpers.h>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+namespace remus {
+namespace proto {
+
+//When the server saw a job reach each stage of its life, in microseconds
+//of the server's monotonic clock. The clock starts at an arbitrary point,
+//so only the differences between the times mean anything. A time of zero
+//means the job hasn't reached that stage.
+class REMUSPROTO_EXPORT JobTimestamps
+{
+public:
+  JobTimestamps();
+
+  //when the job was queued by a client
+  boost::int64_t Queued;
+  //when the job was given to a worker
+  boost::int64_t Dispatched;
+  //when the worker first reported progress on the job
+  boost::int64_t FirstProgress;
+  //when the job finished, failed or expired
+  boost::int64_t Finished;
+
+  //microseconds the job waited to be given to a worker, and then for
+  //the worker to finish it, zero if the job hasn't got that far
+  boost::int64_t queueTime() const
+    { return (this->Queued && this->Dispatched) ?
+             this->Dispatched - this->Queued : 0; }
+  boost::int64_t executionTime() const
+    { return (this->Dispatched && this->Finished) ?
+             this->Finished - this->Dispatched : 0; }
+
+  //the current time of the monotonic clock the timestamps are taken from
+  static boost::int64_t now();
+
+  bool operator ==(const JobTimestamps& b) const
+  {
+    return this->Queued == b.Queued &&
+           this->Dispatched == b.Dispatched &&
+           this->FirstProgress == b.FirstProgress &&
+           this->Finished == b.Finished;
+  }
+  bool operator !=(const JobTimestamps& b) const
+    { return !(this->operator ==(b)); }
+
+  friend std::ostream& operator<<(std::ostream &os, const JobTimestamps &t)
+    { t.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is, JobTimestamps &t)
+    { t = JobTimestamps(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobTimestamps(remus::internal::BinaryReader& buffer);
+
+private:
+  //serialize function
+  void serialize(std::ostream& buffer) const;
+
+  //deserialize constructor function, data sent by peers that didn't
+  //have timestamps leaves them at zero
+  explicit JobTimestamps(std::istream& buffer);
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,385 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/JobUpload.h>
+
+#include <remus/proto/conversionHelpers.h>
+
+#include <boost/make_shared.hpp>
+#include <boost/uuid/nil_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+namespace remus {
+namespace proto {
+
+namespace {
+//------------------------------------------------------------------------------
+//copy data into memory the returned owner keeps alive
+boost::shared_ptr<const void> copy_data(const char*& data, std::size_t size)
+{
+  boost::shared_ptr< std::vector<char> > storage =
+                          boost::make_shared< std::vector<char> >(data,
+                                                                  data+size);
+  data = storage->empty() ? NULL : &(*storage)[0];
+  return storage;
+}
+}
+
+//------------------------------------------------------------------------------
+JobUpload::JobUpload():
+  Requirements(),
+  Entries()
+{
+}
+
+//------------------------------------------------------------------------------
+JobUpload::JobUpload(const remus::proto::JobRequirements& reqs):
+  Requirements(reqs),
+  Entries()
+{
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t JobUpload::totalSize() const
+{
+  boost::uint64_t size = 0;
+  for(std::size_t i=0; i < this->Entries.size(); ++i)
+    {
+    size += this->Entries[i].Size;
+    }
+  return size;
+}
+
+//------------------------------------------------------------------------------
+void JobUpload::serialize(std::ostream& buffer) const
+{
+  buffer << this->Requirements << std::endl;
+  buffer << this->Entries.size() << std::endl;
+  for(std::size_t i=0; i < this->Entries.size(); ++i)
+    {
+    const Entry& entry = this->Entries[i];
+    buffer << entry.Key.size() << std::endl;
+    remus::internal::writeString(buffer, entry.Key);
+    buffer << entry.FormatType << std::endl;
+    buffer << entry.Tag.size() << std::endl;
+    remus::internal::writeString(buffer, entry.Tag);
+    buffer << entry.Size << std::endl;
+    buffer << entry.Hash.size() << std::endl;
+    remus::internal::writeString(buffer, entry.Hash);
+    }
+}
+
+//------------------------------------------------------------------------------
+JobUpload::JobUpload(std::istream& buffer):
+  Requirements(),
+  Entries()
+{
+  std::size_t count = 0;
+  buffer >> this->Requirements;
+  buffer >> count;
+  for(std::size_t i=0; i < count && buffer.good(); ++i)
+    {
+    Entry entry;
+    std::size_t size = 0;
+    int ftype = 0;
+    buffer >> size;
+    entry.Key = remus::internal::extractString(buffer,size);
+    buffer >> ftype;
+    entry.FormatType = static_cast<remus::common::ContentFormat::Type>(ftype);
+    buffer >> size;
+    entry.Tag = remus::internal::extractString(buffer,size);
+    buffer >> entry.Size;
+    buffer >> size;
+    entry.Hash = remus::internal::extractString(buffer,size);
+    this->Entries.push_back(entry);
+    }
+}
+
+//------------------------------------------------------------------------------
+void JobUpload::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  this->Requirements.serialize(buffer);
+  buffer.putUInt64(this->Entries.size());
+  for(std::size_t i=0; i < this->Entries.size(); ++i)
+    {
+    const Entry& entry = this->Entries[i];
+    buffer.putString(entry.Key);
+    buffer.putUInt32(entry.FormatType);
+    buffer.putString(entry.Tag);
+    buffer.putUInt64(entry.Size);
+    buffer.putString(entry.Hash);
+    }
+}
+
+//------------------------------------------------------------------------------
+JobUpload::JobUpload(remus::internal::BinaryReader& buffer):
+  Requirements(buffer),
+  Entries()
+{
+  const boost::uint64_t count = buffer.getUInt64();
+  for(boost::uint64_t i=0; i < count && buffer.good(); ++i)
+    {
+    Entry entry;
+    entry.Key = buffer.getString();
+    entry.FormatType =
+          static_cast<remus::common::ContentFormat::Type>(buffer.getUInt32());
+    entry.Tag = buffer.getString();
+    entry.Size = buffer.getUInt64();
+    entry.Hash = buffer.getString();
+    this->Entries.push_back(entry);
+    }
+}
+
+//------------------------------------------------------------------------------
+JobUploadReply::JobUploadReply():
+  UploadedJob(boost::uuids::nil_uuid(), remus::common::MeshIOType()),
+  Missing()
+{
+}
+
+//------------------------------------------------------------------------------
+JobUploadReply::JobUploadReply(const remus::proto::Job& job):
+  UploadedJob(job),
+  Missing()
+{
+}
+
+//------------------------------------------------------------------------------
+void JobUploadReply::serialize(std::ostream& buffer) const
+{
+  buffer << this->UploadedJob.type() << std::endl;
+  buffer << this->UploadedJob.id() << std::endl;
+  buffer << this->Missing.size() << std::endl;
+  for(std::size_t i=0; i < this->Missing.size(); ++i)
+    {
+    buffer << this->Missing[i].size() << std::endl;
+    remus::internal::writeString(buffer, this->Missing[i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+JobUploadReply::JobUploadReply(std::istream& buffer):
+  UploadedJob(boost::uuids::nil_uuid(), remus::common::MeshIOType()),
+  Missing()
+{
+  remus::common::MeshIOType type;
+  boost::uuids::uuid id = boost::uuids::nil_uuid();
+  std::size_t count = 0;
+  buffer >> type;
+  buffer >> id;
+  buffer >> count;
+  for(std::size_t i=0; i < count && buffer.good(); ++i)
+    {
+    std::size_t size = 0;
+    buffer >> size;
+    this->Missing.push_back( remus::internal::extractString(buffer,size) );
+    }
+  this->UploadedJob = remus::proto::Job(id,type);
+}
+
+//------------------------------------------------------------------------------
+void JobUploadReply::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  this->UploadedJob.serialize(buffer);
+  buffer.putUInt64(this->Missing.size());
+  for(std::size_t i=0; i < this->Missing.size(); ++i)
+    {
+    buffer.putString(this->Missing[i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+JobUploadReply::JobUploadReply(remus::internal::BinaryReader& buffer):
+  UploadedJob(buffer),
+  Missing()
+{
+  const boost::uint64_t count = buffer.getUInt64();
+  for(boost::uint64_t i=0; i < count && buffer.good(); ++i)
+    {
+    this->Missing.push_back( buffer.getString() );
+    }
+}
+
+//------------------------------------------------------------------------------
+JobUploadChunk::JobUploadChunk():
+  UploadId(boost::uuids::nil_uuid()),
+  Key(),
+  Offset(0),
+  Data(NULL),
+  Size(0),
+  Owner()
+{
+}
+
+//------------------------------------------------------------------------------
+JobUploadChunk::JobUploadChunk(const boost::uuids::uuid& upload,
+                               const std::string& key,
+                               boost::uint64_t offset,
+                               const char* data,
+                               std::size_t size):
+  UploadId(upload),
+  Key(key),
+  Offset(offset),
+  Data(data),
+  Size(size),
+  Owner()
+{
+}
+
+//------------------------------------------------------------------------------
+bool JobUploadChunk::valid() const
+{
+  return !this->UploadId.is_nil();
+}
+
+//------------------------------------------------------------------------------
+void JobUploadChunk::serialize(std::ostream& buffer) const
+{
+  buffer << this->UploadId << std::endl;
+  buffer << this->Key.size() << std::endl;
+  remus::internal::writeString(buffer, this->Key);
+  buffer << this->Offset << std::endl;
+  buffer << this->Size << std::endl;
+  remus::internal::writeString(buffer, this->Data, this->Size);
+}
+
+//------------------------------------------------------------------------------
+JobUploadChunk::JobUploadChunk(std::istream& buffer):
+  UploadId(boost::uuids::nil_uuid()),
+  Key(),
+  Offset(0),
+  Data(NULL),
+  Size(0),
+  Owner()
+{
+  std::size_t keySize = 0;
+  buffer >> this->UploadId;
+  buffer >> keySize;
+  this->Key = remus::internal::extractString(buffer,keySize);
+  buffer >> this->Offset;
+  buffer >> this->Size;
+
+  //view into the received message when we can
+  if(remus::internal::extractView(buffer,this->Size,this->Data,this->Owner))
+    {
+    return;
+    }
+
+  boost::shared_ptr< std::vector<char> > storage =
+                  boost::make_shared< std::vector<char> >(this->Size);
+  remus::internal::extractVector(buffer,*storage);
+  this->Data = storage->empty() ? NULL : &(*storage)[0];
+  this->Owner = storage;
+}
+
+//------------------------------------------------------------------------------
+void JobUploadChunk::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUUID(this->UploadId);
+  buffer.putString(this->Key);
+  buffer.putUInt64(this->Offset);
+  buffer.putBytes(this->Data, this->Size);
+}
+
+//------------------------------------------------------------------------------
+JobUploadChunk::JobUploadChunk(remus::internal::BinaryReader& buffer):
+  UploadId( buffer.getUUID() ),
+  Key( buffer.getString() ),
+  Offset( buffer.getUInt64() ),
+  Data(NULL),
+  Size(0),
+  Owner()
+{
+  //view into the received message when we can, otherwise copy the
+  //data out of it
+  const remus::internal::BinaryBytes contents = buffer.getBytes();
+  this->Data = contents.data();
+  this->Size = contents.size();
+  if(buffer.owner() && buffer.good())
+    {
+    this->Owner = buffer.owner();
+    }
+  else
+    {
+    this->Owner = copy_data(this->Data, this->Size);
+    }
+}
+
+//------------------------------------------------------------------------------
+JobUpload to_JobUpload(const char* data, std::size_t size)
+{
+  JobUpload upload;
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    JobUpload decoded(buffer);
+    if(buffer.good())
+      {
+      upload = decoded;
+      }
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,size);
+    std::istream buffer(&memory);
+    buffer >> upload;
+    }
+  return upload;
+}
+
+//------------------------------------------------------------------------------
+JobUploadReply to_JobUploadReply(const char* data, std::size_t size)
+{
+  JobUploadReply reply;
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    JobUploadReply decoded(buffer);
+    if(buffer.good())
+      {
+      reply = decoded;
+      }
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,size);
+    std::istream buffer(&memory);
+    buffer >> reply;
+    }
+  return reply;
+}
+
+//------------------------------------------------------------------------------
+JobUploadChunk to_JobUploadChunk(const char* data, std::size_t size,
+                                 const boost::shared_ptr<const void>& owner)
+{
+  JobUploadChunk chunk;
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size,owner);
+    JobUploadChunk decoded(buffer);
+    if(buffer.good())
+      {
+      chunk = decoded;
+      }
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,size,owner);
+    std::istream buffer(&memory);
+    buffer >> chunk;
+    }
+  return chunk;
+}
+
+}
+}
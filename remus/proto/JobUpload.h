@@ -0,0 +1,269 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_JobUpload_h
+#define remus_proto_JobUpload_h
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <remus/common/ContentTypes.h>
+#include <remus/proto/Job.h>
+#include <remus/proto/JobRequirements.h>
+#include <remus/proto/binaryHelpers.h>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+//Messages used to upload a large JobSubmission to the server in chunks,
+//instead of sending it in a single message. The client first sends a
+//JobUpload that describes the contents of the submission without their
+//data, and the server answers with a JobUploadReply holding the job it
+//will queue once the data has arrived. The client then sends the data of
+//each content as JobUploadChunks, each of which the server acknowledges.
+//
+//A content described with the hash of its data only has to be uploaded
+//if the server hasn't been sent the same data before, the reply lists the
+//contents the server still needs.
+namespace remus {
+namespace proto {
+
+//------------------------------------------------------------------------------
+class REMUSPROTO_EXPORT JobUpload
+{
+public:
+  //describes a content of the submission, see JobContent
+  struct Entry
+  {
+    Entry():
+      Key(), FormatType(), Tag(), Size(0), Hash()
+      {}
+    Entry(const std::string& key,
+          remus::common::ContentFormat::Type format,
+          const std::string& tag,
+          boost::uint64_t size,
+          const std::string& hash = std::string()):
+      Key(key), FormatType(format), Tag(tag), Size(size), Hash(hash)
+      {}
+
+    bool operator==(const Entry& other) const
+      { return this->Key == other.Key &&
+               this->FormatType == other.FormatType &&
+               this->Tag == other.Tag &&
+               this->Size == other.Size &&
+               this->Hash == other.Hash; }
+
+    std::string Key;
+    remus::common::ContentFormat::Type FormatType;
+    std::string Tag;
+    boost::uint64_t Size;
+    //the MD5 hash of the data, see remus::common::MD5Hash. Empty when the
+    //data should always be uploaded
+    std::string Hash;
+  };
+  typedef std::vector<Entry> ContainerType;
+
+  //construct an invalid JobUpload. This constructor is designed
+  //to allows this class to be stored in containers.
+  JobUpload();
+
+  explicit JobUpload(const remus::proto::JobRequirements& reqs);
+
+  const remus::proto::JobRequirements& requirements() const
+    { return this->Requirements; }
+  const remus::common::MeshIOType& type() const
+    { return this->Requirements.meshTypes(); }
+
+  //describe a content that will be uploaded
+  void add(const Entry& entry) { this->Entries.push_back(entry); }
+  const ContainerType& entries() const { return this->Entries; }
+
+  //the number of bytes of content data to upload
+  boost::uint64_t totalSize() const;
+
+  friend std::ostream& operator<<(std::ostream &os, const JobUpload &upload)
+    { upload.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is, JobUpload &upload)
+    { upload = JobUpload(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobUpload(remus::internal::BinaryReader& buffer);
+
+private:
+  void serialize(std::ostream& buffer) const;
+  explicit JobUpload(std::istream& buffer);
+
+  remus::proto::JobRequirements Requirements;
+  ContainerType Entries;
+};
+
+//------------------------------------------------------------------------------
+//the answer to a JobUpload, with the job that will be queued and the keys
+//of the contents whose data must be uploaded
+class REMUSPROTO_EXPORT JobUploadReply
+{
+public:
+  //construct an invalid reply
+  JobUploadReply();
+
+  explicit JobUploadReply(const remus::proto::Job& job);
+
+  const remus::proto::Job& job() const { return this->UploadedJob; }
+
+  //the contents the server doesn't have the data of
+  void addMissing(const std::string& key) { this->Missing.push_back(key); }
+  const std::vector<std::string>& missing() const { return this->Missing; }
+
+  friend std::ostream& operator<<(std::ostream &os,
+                                  const JobUploadReply &reply)
+    { reply.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is, JobUploadReply &reply)
+    { reply = JobUploadReply(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobUploadReply(remus::internal::BinaryReader& buffer);
+
+private:
+  void serialize(std::ostream& buffer) const;
+  explicit JobUploadReply(std::istream& buffer);
+
+  remus::proto::Job UploadedJob;
+  std::vector<std::string> Missing;
+};
+
+//------------------------------------------------------------------------------
+//a piece of the data of a content of an upload, which belongs at offset
+//in the data of the content with the given key
+class REMUSPROTO_EXPORT JobUploadChunk
+{
+public:
+  //construct an invalid chunk
+  JobUploadChunk();
+
+  //a chunk that views into data without copying it, so data must outlive
+  //the chunk
+  JobUploadChunk(const boost::uuids::uuid& upload,
+                 const std::string& key,
+                 boost::uint64_t offset,
+                 const char* data,
+                 std::size_t size);
+
+  //the id of the job being uploaded
+  const boost::uuids::uuid& id() const { return this->UploadId; }
+  const std::string& key() const { return this->Key; }
+  boost::uint64_t offset() const { return this->Offset; }
+
+  const char* data() const { return this->Data; }
+  std::size_t dataSize() const { return this->Size; }
+
+  bool valid() const;
+
+  friend std::ostream& operator<<(std::ostream &os,
+                                  const JobUploadChunk &chunk)
+    { chunk.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is, JobUploadChunk &chunk)
+    { chunk = JobUploadChunk(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit JobUploadChunk(remus::internal::BinaryReader& buffer);
+
+private:
+  void serialize(std::ostream& buffer) const;
+  explicit JobUploadChunk(std::istream& buffer);
+
+  boost::uuids::uuid UploadId;
+  std::string Key;
+  boost::uint64_t Offset;
+
+  //points into the memory we were given, or memory that Owner keeps alive
+  const char* Data;
+  std::size_t Size;
+  boost::shared_ptr<const void> Owner;
+};
+
+//------------------------------------------------------------------------------
+inline std::string to_string(const remus::proto::JobUpload& upload)
+{
+  std::ostringstream buffer;
+  buffer << upload;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+inline std::string to_string(const remus::proto::JobUploadReply& reply)
+{
+  std::ostringstream buffer;
+  buffer << reply;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+inline std::string to_string(const remus::proto::JobUploadChunk& chunk)
+{
+  std::ostringstream buffer;
+  buffer << chunk;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT remus::proto::JobUpload
+to_JobUpload(const char* data, std::size_t size);
+
+//------------------------------------------------------------------------------
+inline remus::proto::JobUpload to_JobUpload(const std::string& msg)
+{
+  return to_JobUpload(msg.data(),msg.size());
+}
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT remus::proto::JobUploadReply
+to_JobUploadReply(const char* data, std::size_t size);
+
+//------------------------------------------------------------------------------
+inline remus::proto::JobUploadReply to_JobUploadReply(const std::string& msg)
+{
+  return to_JobUploadReply(msg.data(),msg.size());
+}
+
+//------------------------------------------------------------------------------
+//decode a chunk that views into data instead of copying it. The owner
+//must keep data alive and unchanged, and is held by the chunk for as long
+//as it exists. Without an owner the chunk data is copied
+REMUSPROTO_EXPORT remus::proto::JobUploadChunk
+to_JobUploadChunk(const char* data, std::size_t size,
+                  const boost::shared_ptr<const void>& owner);
+
+//------------------------------------------------------------------------------
+inline remus::proto::JobUploadChunk
+to_JobUploadChunk(const char* data, std::size_t size)
+{
+  return to_JobUploadChunk(data,size,boost::shared_ptr<const void>());
+}
+
+//------------------------------------------------------------------------------
+inline remus::proto::JobUploadChunk to_JobUploadChunk(const std::string& msg)
+{
+  return to_JobUploadChunk(msg.data(),msg.size());
+}
+
+}
+}
+
+#endif
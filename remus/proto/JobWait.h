@@ -0,0 +1,124 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_JobWait_h
+#define remus_proto_JobWait_h
+
+#include <string>
+#include <sstream>
+
+#include <boost/cstdint.hpp>
+
+#include <remus/proto/Job.h>
+#include <remus/proto/binaryHelpers.h>
+
+//The remus::proto::JobWait class
+// Asks the server to hold its reply until a job has finished, failed or
+// expired, or until the timeout has passed, and whether to send the
+// result of a finished job along with its status.
+
+namespace remus{
+namespace proto{
+class JobWait
+{
+public:
+
+  JobWait(const remus::proto::Job& job,
+          boost::uint32_t timeoutMillisec,
+          bool withResult):
+  WaitedJob(job),
+  Timeout(timeoutMillisec),
+  WithResult(withResult)
+  {
+  }
+
+  //get the job to wait on
+  const remus::proto::Job& job() const { return WaitedJob; }
+
+  //get how long the server may hold the reply, in milliseconds
+  boost::uint32_t timeout() const { return Timeout; }
+
+  //get if the result of a finished job is sent with its status
+  bool withResult() const { return WithResult; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const
+  {
+    this->WaitedJob.serialize(buffer);
+    buffer.putUInt32(this->Timeout);
+    buffer.putUInt8(this->WithResult ? 1 : 0);
+  }
+
+  explicit JobWait(remus::internal::BinaryReader& buffer):
+  WaitedJob(buffer)
+  {
+    this->Timeout = buffer.getUInt32();
+    this->WithResult = buffer.getUInt8() != 0;
+  }
+
+private:
+  remus::proto::Job WaitedJob;
+  boost::uint32_t Timeout;
+  bool WithResult;
+};
+
+//------------------------------------------------------------------------------
+inline std::string to_string(const remus::proto::JobWait& wait)
+{
+  //encoding is simple, contents newline separated
+  std::ostringstream buffer;
+  buffer << to_string(wait.job());
+  buffer << wait.timeout() << std::endl;
+  buffer << wait.withResult() << std::endl;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+inline remus::proto::JobWait to_JobWait(const char* data, std::size_t size)
+{
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    const remus::proto::JobWait decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::JobWait(
+        remus::proto::Job(boost::uuids::uuid(),remus::common::MeshIOType()),
+        0, false);
+      }
+    return decoded;
+    }
+  std::istringstream buffer(std::string(data,size));
+
+  remus::common::MeshIOType type;
+  boost::uuids::uuid id = boost::uuids::uuid();
+  boost::uint32_t timeout = 0;
+  bool withResult = false;
+
+  buffer >> type;
+  buffer >> id;
+  buffer >> timeout;
+  buffer >> withResult;
+  return remus::proto::JobWait(remus::proto::Job(id,type),
+                               timeout, withResult);
+}
+
+//------------------------------------------------------------------------------
+inline remus::proto::JobWait to_JobWait(const std::string& msg)
+{
+  return to_JobWait(msg.data(), msg.size());
+}
+
+}
+}
+
+#endif
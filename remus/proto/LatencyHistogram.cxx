@@ -0,0 +1,217 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/LatencyHistogram.h>
+
+#include <algorithm>
+
+namespace remus {
+namespace proto {
+
+//------------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram():
+  Count(0),
+  Total(0),
+  Max(0)
+{
+  std::fill(this->Counts, this->Counts + NumberOfBuckets, boost::uint64_t(0));
+}
+
+//------------------------------------------------------------------------------
+std::size_t LatencyHistogram::bucket(boost::uint64_t microseconds)
+{
+  //the first range holds the latencies below SubBuckets one per bucket,
+  //after that range r holds [2^(r+1), 2^(r+2)) split into SubBuckets
+  if(microseconds < SubBuckets)
+    {
+    return static_cast<std::size_t>(microseconds);
+    }
+
+  std::size_t msb = 0;
+  for(boost::uint64_t v = microseconds; v > 1; v >>= 1)
+    {
+    ++msb;
+    }
+
+  const std::size_t range = msb - 1;
+  if(range >= Ranges)
+    {
+    return NumberOfBuckets - 1;
+    }
+  const std::size_t sub =
+        static_cast<std::size_t>(microseconds >> (msb - 2)) % SubBuckets;
+  return range * SubBuckets + sub;
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t LatencyHistogram::bucketLowerBound(std::size_t index)
+{
+  const std::size_t range = index / SubBuckets;
+  const std::size_t sub = index % SubBuckets;
+  if(range == 0)
+    {
+    return sub;
+    }
+  const std::size_t msb = range + 1;
+  const boost::uint64_t width = boost::uint64_t(1) << (msb - 2);
+  return (boost::uint64_t(1) << msb) + sub * width;
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t LatencyHistogram::bucketUpperBound(std::size_t index)
+{
+  if(index + 1 >= NumberOfBuckets)
+    {
+    return ~boost::uint64_t(0);
+    }
+  return LatencyHistogram::bucketLowerBound(index + 1) - 1;
+}
+
+//------------------------------------------------------------------------------
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+  for(std::size_t i=0; i < NumberOfBuckets; ++i)
+    {
+    this->Counts[i] += other.Counts[i];
+    }
+  this->Count += other.Count;
+  this->Total += other.Total;
+  this->Max = std::max(this->Max, other.Max);
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t LatencyHistogram::percentile(double p) const
+{
+  if(this->Count == 0)
+    {
+    return 0;
+    }
+  p = std::min(std::max(p, 0.0), 100.0);
+
+  //the rank of the latency we want, counting from one
+  boost::uint64_t rank = static_cast<boost::uint64_t>(
+                        p / 100.0 * static_cast<double>(this->Count));
+  rank = std::max<boost::uint64_t>(rank, 1);
+
+  boost::uint64_t seen = 0;
+  for(std::size_t i=0; i < NumberOfBuckets; ++i)
+    {
+    seen += this->Counts[i];
+    if(seen >= rank)
+      {
+      //no latency was larger than the max, so never report past it
+      return std::min(LatencyHistogram::bucketUpperBound(i), this->Max);
+      }
+    }
+  return this->Max;
+}
+
+//------------------------------------------------------------------------------
+bool LatencyHistogram::operator ==(const LatencyHistogram& b) const
+{
+  return this->Count == b.Count && this->Total == b.Total &&
+         this->Max == b.Max &&
+         std::equal(this->Counts, this->Counts + NumberOfBuckets, b.Counts);
+}
+
+//------------------------------------------------------------------------------
+void LatencyHistogram::serialize(std::ostream& buffer) const
+{
+  std::size_t used = 0;
+  for(std::size_t i=0; i < NumberOfBuckets; ++i)
+    {
+    used += (this->Counts[i] > 0) ? 1 : 0;
+    }
+
+  buffer << this->Count << std::endl;
+  buffer << this->Total << std::endl;
+  buffer << this->Max << std::endl;
+  buffer << used << std::endl;
+  for(std::size_t i=0; i < NumberOfBuckets; ++i)
+    {
+    if(this->Counts[i] > 0)
+      {
+      buffer << i << " " << this->Counts[i] << std::endl;
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram(std::istream& buffer):
+  Count(0),
+  Total(0),
+  Max(0)
+{
+  std::fill(this->Counts, this->Counts + NumberOfBuckets, boost::uint64_t(0));
+
+  std::size_t used = 0;
+  buffer >> this->Count;
+  buffer >> this->Total;
+  buffer >> this->Max;
+  buffer >> used;
+  for(std::size_t i=0; i < used && buffer.good(); ++i)
+    {
+    std::size_t index = 0;
+    boost::uint64_t count = 0;
+    buffer >> index >> count;
+    if(index < NumberOfBuckets)
+      {
+      this->Counts[index] = count;
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void LatencyHistogram::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  boost::uint32_t used = 0;
+  for(std::size_t i=0; i < NumberOfBuckets; ++i)
+    {
+    used += (this->Counts[i] > 0) ? 1 : 0;
+    }
+
+  buffer.putUInt64(this->Count);
+  buffer.putUInt64(this->Total);
+  buffer.putUInt64(this->Max);
+  buffer.putUInt32(used);
+  for(std::size_t i=0; i < NumberOfBuckets; ++i)
+    {
+    if(this->Counts[i] > 0)
+      {
+      buffer.putUInt32(static_cast<boost::uint32_t>(i));
+      buffer.putUInt64(this->Counts[i]);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram(remus::internal::BinaryReader& buffer):
+  Count( buffer.getUInt64() ),
+  Total( buffer.getUInt64() ),
+  Max( buffer.getUInt64() )
+{
+  std::fill(this->Counts, this->Counts + NumberOfBuckets, boost::uint64_t(0));
+
+  const boost::uint32_t used = buffer.getUInt32();
+  for(boost::uint32_t i=0; i < used && buffer.good(); ++i)
+    {
+    const boost::uint32_t index = buffer.getUInt32();
+    const boost::uint64_t count = buffer.getUInt64();
+    if(index < NumberOfBuckets)
+      {
+      this->Counts[index] = count;
+      }
+    }
+}
+
+}
+}
@@ -0,0 +1,107 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_LatencyHistogram_h
+#define remus_proto_LatencyHistogram_h
+
+#include <string>
+#include <sstream>
+
+#include <boost/cstdint.hpp>
+
+#include <remus/proto/binaryHelpers.h>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+namespace remus {
+namespace proto {
+
+//A histogram of latencies in microseconds with a fixed set of buckets, so
+//recording a latency is a couple of shifts and an increment and never
+//allocates. Every power of two is split into four equal buckets, so a
+//latency is known to within 25% up to about nine minutes, and anything
+//longer is counted in the last bucket.
+class REMUSPROTO_EXPORT LatencyHistogram
+{
+public:
+  enum { SubBuckets = 4, Ranges = 28, NumberOfBuckets = SubBuckets * Ranges };
+
+  LatencyHistogram();
+
+  void record(boost::uint64_t microseconds)
+    {
+    ++this->Counts[LatencyHistogram::bucket(microseconds)];
+    ++this->Count;
+    this->Total += microseconds;
+    this->Max = (microseconds > this->Max) ? microseconds : this->Max;
+    }
+
+  //add the latencies recorded by another histogram to this one
+  void merge(const LatencyHistogram& other);
+
+  //the number of latencies recorded, and their sum and largest value
+  boost::uint64_t count() const { return this->Count; }
+  boost::uint64_t total() const { return this->Total; }
+  boost::uint64_t maximum() const { return this->Max; }
+
+  double mean() const
+    {
+    return (this->Count > 0) ?
+           static_cast<double>(this->Total) / this->Count : 0.0;
+    }
+
+  //returns the largest latency of the bucket that holds the given
+  //percentile, between 0 and 100, of the recorded latencies
+  boost::uint64_t percentile(double p) const;
+
+  //the number of latencies recorded in a bucket
+  boost::uint64_t bucketCount(std::size_t index) const
+    { return this->Counts[index]; }
+
+  //the bucket a latency is recorded in, and the range of latencies
+  //each bucket holds
+  static std::size_t bucket(boost::uint64_t microseconds);
+  static boost::uint64_t bucketLowerBound(std::size_t index);
+  static boost::uint64_t bucketUpperBound(std::size_t index);
+
+  bool operator ==(const LatencyHistogram& b) const;
+  bool operator !=(const LatencyHistogram& b) const
+    { return !(this->operator ==(b)); }
+
+  friend std::ostream& operator<<(std::ostream &os,
+                                  const LatencyHistogram &hist)
+    { hist.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is, LatencyHistogram &hist)
+    { hist = LatencyHistogram(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit LatencyHistogram(remus::internal::BinaryReader& buffer);
+
+private:
+  //serialize function, only the buckets holding latencies are written
+  void serialize(std::ostream& buffer) const;
+
+  //deserialize constructor function
+  explicit LatencyHistogram(std::istream& buffer);
+
+  boost::uint64_t Counts[NumberOfBuckets];
+  boost::uint64_t Count;
+  boost::uint64_t Total;
+  boost::uint64_t Max;
+};
+
+}
+}
+
+#endif
@@ -44,6 +44,18 @@ Message::Message(remus::common::MeshIOType mtype, SERVICE_TYPE stype,
   memcpy(this->Storage->data(),mdata,size);
 }
 
+//----------------------------------------------------------------------------
+//takes the contents of the data message without copying them
+Message::Message(remus::common::MeshIOType mtype, SERVICE_TYPE stype,
+                 zmq::message_t& mdata):
+  MType(mtype),
+  SType(stype),
+  ValidMsg(true),
+  Storage( boost::make_shared<zmq::message_t>() )
+{
+  this->Storage->move(&mdata);
+}
+
 //----------------------------------------------------------------------------
 //creates a job message with no data
 Message::Message(remus::common::MeshIOType mtype, SERVICE_TYPE stype):
@@ -59,7 +71,7 @@ Message::Message(remus::common::MeshIOType mtype, SERVICE_TYPE stype):
 Message::Message(zmq::socket_t* socket)
   {
   //we are receiving a multi part message
-  //frame 0: REQ header / attachReqHeader does this
+  //frame 0: REQ header / attachReqHeader does this, holds the request id
   //frame 1: Mesh Type
   //frame 2: Service Type
   //frame 3: Job Data //optional
@@ -68,7 +80,7 @@ Message::Message(zmq::socket_t* socket)
   socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
 
   //construct a job message from the socket
-  zmq::removeReqHeader(*socket);
+  this->RequestId = zmq::removeReqHeader(*socket);
 
   zmq::message_t meshIOType;
   zmq::recv_harder(*socket,&meshIOType);
@@ -104,6 +116,12 @@ std::size_t Message::dataSize() const
   return this->Storage ? this->Storage->size() : std::size_t(0);
 }
 
+//------------------------------------------------------------------------------
+boost::shared_ptr<const void> Message::dataOwner() const
+{
+  return this->Storage;
+}
+
 //------------------------------------------------------------------------------
 bool Message::send(zmq::socket_t *socket) const
 {
@@ -120,7 +138,7 @@ bool Message::sendNonBlocking(zmq::socket_t *socket) const
 bool Message::send_impl(zmq::socket_t *socket, int flags) const
 {
   //we are sending our selves as a multi part message
-  //frame 0: REQ header / attachReqHeader does this
+  //frame 0: REQ header / attachReqHeader does this, holds the request id
   //frame 1: Mesh Type
   //frame 2: Service Type
   //frame 3: Job Data //optional
@@ -129,7 +147,7 @@ bool Message::send_impl(zmq::socket_t *socket, int flags) const
     {
     return false;
     }
-  zmq::attachReqHeader(*socket);
+  zmq::attachReqHeader(*socket,this->RequestId);
 
   bool valid = true;
   zmq::message_t meshIOType(sizeof(this->MType));
@@ -13,6 +13,8 @@
 #ifndef remus_proto_Message_h
 #define remus_proto_Message_h
 
+#include <string>
+
 #include <boost/shared_ptr.hpp>
 
 #include <remus/common/MeshIOType.h>
@@ -44,6 +46,12 @@ public:
   Message(remus::common::MeshIOType mtype, SERVICE_TYPE stype,
           const char* data, int size);
 
+  //----------------------------------------------------------------------------
+  //pass in a zmq message that holds the already encoded data. The contents
+  //are moved into the job message without a copy, leaving data empty
+  Message(remus::common::MeshIOType mtype, SERVICE_TYPE stype,
+          zmq::message_t& data);
+
   //----------------------------------------------------------------------------
   //creates a job message with no data
   Message(remus::common::MeshIOType mtype, SERVICE_TYPE stype);
@@ -65,14 +73,26 @@ public:
   const char* data() const;
   std::size_t dataSize() const;
 
+  //returns a reference counted handle that keeps the memory returned by
+  //data() alive, so the data can be viewed without copying it. A message
+  //whose data is viewed must not be sent, as sending empties the data
+  boost::shared_ptr<const void> dataOwner() const;
+
   bool isValid() const { return ValidMsg; }
 
+  //An id sent in the req header frame so that a client with many requests
+  //in flight can match each response to its request. Empty when sent over
+  //a req socket, or by a client that has only one request at a time
+  void requestId(const std::string& id) { RequestId = id; }
+  const std::string& requestId() const { return RequestId; }
+
 private:
   bool send_impl(zmq::socket_t* socket, int flags = 0) const;
 
   remus::common::MeshIOType MType;
   remus::SERVICE_TYPE SType;
   bool ValidMsg; //tells if the message is valid, mainly used by the server
+  std::string RequestId;
 
   boost::shared_ptr<zmq::message_t> Storage;
 };
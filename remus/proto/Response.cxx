@@ -13,6 +13,8 @@
 
 #include <remus/proto/zmqHelper.h>
 
+#include <boost/make_shared.hpp>
+
 namespace remus{
 namespace proto{
 
@@ -20,7 +22,9 @@ namespace proto{
 Response::Response(const zmq::SocketIdentity& client):
   ClientAddress(client),
   SType(remus::INVALID_SERVICE),
-  Storage( new zmq::message_t() )
+  RequestId(),
+  Storage( new zmq::message_t() ),
+  Attachment()
   {
   }
 
@@ -28,15 +32,27 @@ Response::Response(const zmq::SocketIdentity& client):
 Response::Response(zmq::socket_t* socket):
   ClientAddress(),
   SType(remus::INVALID_SERVICE),
-  Storage( new zmq::message_t() )
+  RequestId(),
+  Storage( new zmq::message_t() ),
+  Attachment()
 {
-  zmq::removeReqHeader(*socket);
+  this->RequestId = zmq::removeReqHeader(*socket);
 
   zmq::message_t servType;
   zmq::recv_harder(*socket,&servType);
   this->SType = *(reinterpret_cast<SERVICE_TYPE*>(servType.data()));
 
   zmq::recv_harder(*socket,this->Storage.get());
+
+  //read the attachment if one was sent
+  zmq::more_t more;
+  size_t more_size = sizeof(more);
+  socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
+  if(more>0)
+    {
+    this->Attachment = boost::make_shared<zmq::message_t>();
+    zmq::recv_harder(*socket,this->Attachment.get());
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -51,6 +67,32 @@ void Response::setData(const std::string& t)
   memcpy(this->Storage->data(),t.data(),t.size());
   }
 
+//------------------------------------------------------------------------------
+void Response::setData(zmq::message_t& msg)
+  {
+  this->Storage->move(&msg);
+  }
+
+//------------------------------------------------------------------------------
+void Response::setAttachment(zmq::message_t& msg)
+  {
+  this->Attachment = boost::make_shared<zmq::message_t>();
+  this->Attachment->move(&msg);
+  }
+
+//------------------------------------------------------------------------------
+const char* Response::attachmentData() const
+{
+  return this->Attachment ? static_cast<char*>(this->Attachment->data())
+                          : NULL;
+}
+
+//------------------------------------------------------------------------------
+std::size_t Response::attachmentSize() const
+{
+  return this->Attachment ? this->Attachment->size() : std::size_t(0);
+}
+
 //------------------------------------------------------------------------------
 std::string Response::data() const
 {
@@ -68,9 +110,10 @@ bool Response::send(zmq::socket_t* socket) const
 
   //we are sending our selves as a multi part message
   //frame 0: client address we need to route too [optional]
-  //frame 1: fake rep spacer
+  //frame 1: fake rep spacer, holds the request id
   //frame 2: Service Type we are responding too
   //frame 3: data
+  //frame 4: attachment [optional]
   if(this->ClientAddress.size()>0)
     {
     zmq::message_t cAddress(this->ClientAddress.size());
@@ -78,13 +121,21 @@ bool Response::send(zmq::socket_t* socket) const
     zmq::send_harder(*socket,cAddress,ZMQ_SNDMORE);
     }
 
-  zmq::attachReqHeader(*socket);
+  zmq::attachReqHeader(*socket,this->RequestId);
 
   zmq::message_t service(sizeof(this->SType));
   memcpy(service.data(),&this->SType,sizeof(this->SType));
   zmq::send_harder(*socket,service,ZMQ_SNDMORE);
 
-  zmq::send_harder(*socket,*this->Storage.get());
+  if(this->Attachment)
+    {
+    zmq::send_harder(*socket,*this->Storage.get(),ZMQ_SNDMORE);
+    zmq::send_harder(*socket,*this->Attachment.get());
+    }
+  else
+    {
+    zmq::send_harder(*socket,*this->Storage.get());
+    }
   return true;
   }
 }
@@ -13,7 +13,10 @@
 #ifndef remus_proto_Response_h
 #define remus_proto_Response_h
 
+#include <string>
+
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <remus/common/MeshIOType.h>
 #include <remus/common/remusGlobals.h>
@@ -43,19 +46,43 @@ public:
   ~Response();
 
   void setData(const std::string& t);
+
+  //take the contents of an already encoded zmq message without a copy,
+  //leaving msg empty
+  void setData(zmq::message_t& msg);
   std::string data() const;
 
+  //An optional second data frame sent after the data. Only peers that
+  //know to read it can be sent one. The contents are moved into the
+  //response without a copy, leaving msg empty
+  void setAttachment(zmq::message_t& msg);
+  bool hasAttachment() const { return !!this->Attachment; }
+  const char* attachmentData() const;
+  std::size_t attachmentSize() const;
+
+  //returns a reference counted handle that keeps the memory returned by
+  //attachmentData() alive, so it can be viewed without copying it. A
+  //response whose attachment is viewed must not be sent
+  boost::shared_ptr<const void> attachmentOwner() const
+    { return this->Attachment; }
+
   //Set the service type that this response is responding too.
   //By default the service type is set to invalid if you don't specify one.
   void setServiceType(remus::SERVICE_TYPE type) { SType = type; }
   remus::SERVICE_TYPE serviceType() const { return SType; }
 
+  //The id of the request this is a response to, see Message::requestId
+  void requestId(const std::string& id) { RequestId = id; }
+  const std::string& requestId() const { return RequestId; }
+
   bool send(zmq::socket_t* socket) const;
 
 private:
   const zmq::SocketIdentity ClientAddress;
   remus::SERVICE_TYPE SType;
+  std::string RequestId;
   boost::scoped_ptr<zmq::message_t> Storage;
+  boost::shared_ptr<zmq::message_t> Attachment;
 
   //make copying not possible
   Response (const Response&);
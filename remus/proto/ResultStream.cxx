@@ -0,0 +1,186 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/ResultStream.h>
+
+#include <remus/proto/conversionHelpers.h>
+
+#include <boost/uuid/nil_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+namespace remus {
+namespace proto {
+
+//------------------------------------------------------------------------------
+ResultStreamRequest::ResultStreamRequest(const remus::proto::Job& job,
+                                         boost::uint32_t chunkSize,
+                                         boost::uint32_t credits):
+  StreamedJob(job),
+  ChunkSize(chunkSize),
+  Credits(credits)
+{
+}
+
+//------------------------------------------------------------------------------
+void ResultStreamRequest::serialize(std::ostream& buffer) const
+{
+  buffer << this->StreamedJob.type() << std::endl;
+  buffer << this->StreamedJob.id() << std::endl;
+  buffer << this->ChunkSize << std::endl;
+  buffer << this->Credits << std::endl;
+}
+
+//------------------------------------------------------------------------------
+ResultStreamRequest::ResultStreamRequest(std::istream& buffer):
+  StreamedJob(boost::uuids::nil_uuid(), remus::common::MeshIOType()),
+  ChunkSize(0),
+  Credits(0)
+{
+  remus::common::MeshIOType type;
+  boost::uuids::uuid id = boost::uuids::nil_uuid();
+  buffer >> type;
+  buffer >> id;
+  buffer >> this->ChunkSize;
+  buffer >> this->Credits;
+  this->StreamedJob = remus::proto::Job(id,type);
+}
+
+//------------------------------------------------------------------------------
+void ResultStreamRequest::serialize(
+                            remus::internal::BinaryWriter& buffer) const
+{
+  this->StreamedJob.serialize(buffer);
+  buffer.putUInt32(this->ChunkSize);
+  buffer.putUInt32(this->Credits);
+}
+
+//------------------------------------------------------------------------------
+ResultStreamRequest::ResultStreamRequest(
+                            remus::internal::BinaryReader& buffer):
+  StreamedJob(buffer),
+  ChunkSize(buffer.getUInt32()),
+  Credits(buffer.getUInt32())
+{
+}
+
+//------------------------------------------------------------------------------
+ResultChunk::ResultChunk(const boost::uuids::uuid& id):
+  JobId(id),
+  FormatType(),
+  TotalSize(0),
+  Offset(0)
+{
+}
+
+//------------------------------------------------------------------------------
+ResultChunk::ResultChunk(const boost::uuids::uuid& id,
+                         remus::common::ContentFormat::Type format,
+                         boost::uint64_t totalSize,
+                         boost::uint64_t offset):
+  JobId(id),
+  FormatType(format),
+  TotalSize(totalSize),
+  Offset(offset)
+{
+}
+
+//------------------------------------------------------------------------------
+void ResultChunk::serialize(std::ostream& buffer) const
+{
+  buffer << this->JobId << std::endl;
+  buffer << this->FormatType << std::endl;
+  buffer << this->TotalSize << std::endl;
+  buffer << this->Offset << std::endl;
+}
+
+//------------------------------------------------------------------------------
+ResultChunk::ResultChunk(std::istream& buffer):
+  JobId(boost::uuids::nil_uuid()),
+  FormatType(),
+  TotalSize(0),
+  Offset(0)
+{
+  int ftype = 0;
+  buffer >> this->JobId;
+  buffer >> ftype;
+  buffer >> this->TotalSize;
+  buffer >> this->Offset;
+  this->FormatType = static_cast<remus::common::ContentFormat::Type>(ftype);
+}
+
+//------------------------------------------------------------------------------
+void ResultChunk::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUUID(this->JobId);
+  buffer.putUInt32(this->FormatType);
+  buffer.putUInt64(this->TotalSize);
+  buffer.putUInt64(this->Offset);
+}
+
+//------------------------------------------------------------------------------
+ResultChunk::ResultChunk(remus::internal::BinaryReader& buffer):
+  JobId( buffer.getUUID() ),
+  FormatType( static_cast<remus::common::ContentFormat::Type>(
+                                                    buffer.getUInt32()) ),
+  TotalSize( buffer.getUInt64() ),
+  Offset( buffer.getUInt64() )
+{
+}
+
+//------------------------------------------------------------------------------
+ResultStreamRequest to_ResultStreamRequest(const char* data, std::size_t size)
+{
+  ResultStreamRequest request(
+      remus::proto::Job(boost::uuids::nil_uuid(), remus::common::MeshIOType()),
+      0, 0);
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    ResultStreamRequest decoded(buffer);
+    if(buffer.good())
+      {
+      request = decoded;
+      }
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,size);
+    std::istream buffer(&memory);
+    buffer >> request;
+    }
+  return request;
+}
+
+//------------------------------------------------------------------------------
+ResultChunk to_ResultChunk(const char* data, std::size_t size)
+{
+  ResultChunk chunk(boost::uuids::nil_uuid());
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    ResultChunk decoded(buffer);
+    if(buffer.good())
+      {
+      chunk = decoded;
+      }
+    }
+  else
+    {
+    remus::internal::MemoryStreamBuffer memory(data,size);
+    std::istream buffer(&memory);
+    buffer >> chunk;
+    }
+  return chunk;
+}
+
+}
+}
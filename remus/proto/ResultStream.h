@@ -0,0 +1,163 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_ResultStream_h
+#define remus_proto_ResultStream_h
+
+#include <sstream>
+
+#include <boost/cstdint.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <remus/common/ContentTypes.h>
+#include <remus/proto/Job.h>
+#include <remus/proto/binaryHelpers.h>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+//Messages used to stream the data of a large JobResult from the server in
+//chunks, instead of sending it in a single message. The client opens a
+//stream with a ResultStreamRequest, which grants the server credit to send
+//that many chunks. The server sends each chunk as a ResultChunk with the
+//chunk bytes attached, and stops when it is out of credit until the client
+//grants more by sending a ResultStreamRequest without a chunk size, with
+//the request id of the stream.
+namespace remus {
+namespace proto {
+
+//------------------------------------------------------------------------------
+class REMUSPROTO_EXPORT ResultStreamRequest
+{
+public:
+  //open a stream of the result of job, or when chunkSize is zero grant
+  //an open stream credits more chunks. Granting no credits closes the
+  //stream.
+  ResultStreamRequest(const remus::proto::Job& job,
+                      boost::uint32_t chunkSize,
+                      boost::uint32_t credits);
+
+  const remus::proto::Job& job() const { return this->StreamedJob; }
+
+  //the most bytes to send in each chunk
+  boost::uint32_t chunkSize() const { return this->ChunkSize; }
+
+  //the number of chunks the server may send before waiting for more
+  boost::uint32_t credits() const { return this->Credits; }
+
+  friend std::ostream& operator<<(std::ostream &os,
+                                  const ResultStreamRequest &request)
+    { request.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is,
+                                  ResultStreamRequest &request)
+    { request = ResultStreamRequest(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit ResultStreamRequest(remus::internal::BinaryReader& buffer);
+
+private:
+  void serialize(std::ostream& buffer) const;
+  explicit ResultStreamRequest(std::istream& buffer);
+
+  remus::proto::Job StreamedJob;
+  boost::uint32_t ChunkSize;
+  boost::uint32_t Credits;
+};
+
+//------------------------------------------------------------------------------
+//describes the bytes attached to a chunk of a streamed result
+class REMUSPROTO_EXPORT ResultChunk
+{
+public:
+  //a chunk of a job that has no result to stream
+  explicit ResultChunk(const boost::uuids::uuid& id);
+
+  ResultChunk(const boost::uuids::uuid& id,
+              remus::common::ContentFormat::Type format,
+              boost::uint64_t totalSize,
+              boost::uint64_t offset);
+
+  const boost::uuids::uuid& id() const { return this->JobId; }
+
+  //the format of the result data, see JobResult::formatType
+  remus::common::ContentFormat::Type formatType() const
+    { return this->FormatType; }
+
+  //the size of the whole result data, and where this chunk starts in it
+  boost::uint64_t totalSize() const { return this->TotalSize; }
+  boost::uint64_t offset() const { return this->Offset; }
+
+  //false when the job has no result to stream, or its result is empty.
+  //The chunks of a stream always have data attached, even when empty
+  bool valid() const { return this->TotalSize > 0; }
+
+  friend std::ostream& operator<<(std::ostream &os, const ResultChunk &chunk)
+    { chunk.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is, ResultChunk &chunk)
+    { chunk = ResultChunk(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit ResultChunk(remus::internal::BinaryReader& buffer);
+
+private:
+  void serialize(std::ostream& buffer) const;
+  explicit ResultChunk(std::istream& buffer);
+
+  boost::uuids::uuid JobId;
+  remus::common::ContentFormat::Type FormatType;
+  boost::uint64_t TotalSize;
+  boost::uint64_t Offset;
+};
+
+//------------------------------------------------------------------------------
+inline std::string to_string(const remus::proto::ResultStreamRequest& request)
+{
+  std::ostringstream buffer;
+  buffer << request;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+inline std::string to_string(const remus::proto::ResultChunk& chunk)
+{
+  std::ostringstream buffer;
+  buffer << chunk;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT remus::proto::ResultStreamRequest
+to_ResultStreamRequest(const char* data, std::size_t size);
+
+//------------------------------------------------------------------------------
+inline remus::proto::ResultStreamRequest
+to_ResultStreamRequest(const std::string& msg)
+{
+  return to_ResultStreamRequest(msg.data(),msg.size());
+}
+
+//------------------------------------------------------------------------------
+REMUSPROTO_EXPORT remus::proto::ResultChunk
+to_ResultChunk(const char* data, std::size_t size);
+
+//------------------------------------------------------------------------------
+inline remus::proto::ResultChunk to_ResultChunk(const std::string& msg)
+{
+  return to_ResultChunk(msg.data(),msg.size());
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,237 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/ServerStats.h>
+
+namespace remus {
+namespace proto {
+
+namespace {
+
+//every counter in the order it is serialized, new counters must be added
+//to the end so older peers can still read the ones they know about
+typedef boost::uint64_t ServerStats::* Counter;
+const Counter Counters[] = {
+  &ServerStats::JobsQueued,
+  &ServerStats::JobsWaitingForWorkers,
+  &ServerStats::JobsActive,
+  &ServerStats::JobsFinished,
+  &ServerStats::JobsFailed,
+  &ServerStats::JobsSubmittedTotal,
+  &ServerStats::JobsDispatchedTotal,
+  &ServerStats::JobsReclaimedTotal,
+  &ServerStats::Workers,
+  &ServerStats::WaitingWorkers,
+  &ServerStats::WorkerProcesses,
+  &ServerStats::MaxWorkerProcesses,
+  &ServerStats::ResultBytesInMemory,
+  &ServerStats::ResultBytesOnDisk,
+  &ServerStats::ResultBytesReclaimedTotal,
+  &ServerStats::Uptime,
+  &ServerStats::BrokerCpuTime
+};
+const std::size_t NumberOfCounters = sizeof(Counters) / sizeof(Counter);
+
+//------------------------------------------------------------------------------
+void write_latencies(std::ostream& buffer, const ServerStats::Latencies& l)
+{
+  buffer << l.size() << std::endl;
+  for(ServerStats::Latencies::const_iterator i=l.begin(); i != l.end(); ++i)
+    {
+    buffer << i->first << std::endl;
+    buffer << i->second;
+    }
+}
+
+//------------------------------------------------------------------------------
+ServerStats::Latencies read_latencies(std::istream& buffer)
+{
+  //text written by a server that didn't have latencies ends early,
+  //leaving the size unread
+  std::size_t size = 0;
+  buffer >> size;
+
+  ServerStats::Latencies l;
+  for(std::size_t i=0; i < size && buffer.good(); ++i)
+    {
+    int service = 0;
+    buffer >> service;
+    buffer >> l[static_cast<remus::SERVICE_TYPE>(service)];
+    }
+  return l;
+}
+
+//------------------------------------------------------------------------------
+void write_latencies(remus::internal::BinaryWriter& buffer,
+                     const ServerStats::Latencies& l)
+{
+  buffer.putUInt32(static_cast<boost::uint32_t>(l.size()));
+  for(ServerStats::Latencies::const_iterator i=l.begin(); i != l.end(); ++i)
+    {
+    buffer.putUInt32(static_cast<boost::uint32_t>(i->first));
+    i->second.serialize(buffer);
+    }
+}
+
+//------------------------------------------------------------------------------
+ServerStats::Latencies read_latencies(remus::internal::BinaryReader& buffer)
+{
+  ServerStats::Latencies l;
+  const boost::uint32_t size = buffer.getUInt32();
+  for(boost::uint32_t i=0; i < size && buffer.good(); ++i)
+    {
+    const remus::SERVICE_TYPE service =
+                    static_cast<remus::SERVICE_TYPE>(buffer.getUInt32());
+    l.insert(std::make_pair(service, LatencyHistogram(buffer)));
+    }
+  return l;
+}
+
+}
+
+//------------------------------------------------------------------------------
+ServerStats::ServerStats():
+  ClientLatencies(),
+  WorkerLatencies(),
+  JobQueueTimes(),
+  JobExecutionTimes(),
+  JobRetrievalWaitTimes()
+{
+  for(std::size_t i=0; i < NumberOfCounters; ++i)
+    {
+    this->*Counters[i] = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+double ServerStats::dispatchRate() const
+{
+  if(this->Uptime == 0)
+    {
+    return 0.0;
+    }
+  return static_cast<double>(this->JobsDispatchedTotal) * 1000.0 /
+         static_cast<double>(this->Uptime);
+}
+
+//------------------------------------------------------------------------------
+double ServerStats::brokerCpuUsage() const
+{
+  if(this->Uptime == 0)
+    {
+    return 0.0;
+    }
+  return static_cast<double>(this->BrokerCpuTime) /
+         (static_cast<double>(this->Uptime) * 1000.0);
+}
+
+//------------------------------------------------------------------------------
+bool ServerStats::operator ==(const ServerStats& b) const
+{
+  for(std::size_t i=0; i < NumberOfCounters; ++i)
+    {
+    if(this->*Counters[i] != b.*Counters[i])
+      {
+      return false;
+      }
+    }
+  return this->ClientLatencies == b.ClientLatencies &&
+         this->WorkerLatencies == b.WorkerLatencies &&
+         this->JobQueueTimes == b.JobQueueTimes &&
+         this->JobExecutionTimes == b.JobExecutionTimes &&
+         this->JobRetrievalWaitTimes == b.JobRetrievalWaitTimes;
+}
+
+//------------------------------------------------------------------------------
+void ServerStats::serialize(std::ostream& buffer) const
+{
+  buffer << NumberOfCounters << std::endl;
+  for(std::size_t i=0; i < NumberOfCounters; ++i)
+    {
+    buffer << this->*Counters[i] << std::endl;
+    }
+  write_latencies(buffer, this->ClientLatencies);
+  write_latencies(buffer, this->WorkerLatencies);
+  buffer << this->JobQueueTimes;
+  buffer << this->JobExecutionTimes;
+  buffer << this->JobRetrievalWaitTimes;
+}
+
+//------------------------------------------------------------------------------
+ServerStats::ServerStats(std::istream& buffer)
+{
+  //counters an older peer doesn't send stay zero, and counters from a
+  //newer peer that we don't know about are skipped
+  for(std::size_t i=0; i < NumberOfCounters; ++i)
+    {
+    this->*Counters[i] = 0;
+    }
+  std::size_t count = 0;
+  buffer >> count;
+  for(std::size_t i=0; i < count && buffer.good(); ++i)
+    {
+    boost::uint64_t value = 0;
+    buffer >> value;
+    if(i < NumberOfCounters)
+      {
+      this->*Counters[i] = value;
+      }
+    }
+  this->ClientLatencies = read_latencies(buffer);
+  this->WorkerLatencies = read_latencies(buffer);
+  buffer >> this->JobQueueTimes;
+  buffer >> this->JobExecutionTimes;
+  buffer >> this->JobRetrievalWaitTimes;
+}
+
+//------------------------------------------------------------------------------
+void ServerStats::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.putUInt32(static_cast<boost::uint32_t>(NumberOfCounters));
+  for(std::size_t i=0; i < NumberOfCounters; ++i)
+    {
+    buffer.putUInt64(this->*Counters[i]);
+    }
+  write_latencies(buffer, this->ClientLatencies);
+  write_latencies(buffer, this->WorkerLatencies);
+  this->JobQueueTimes.serialize(buffer);
+  this->JobExecutionTimes.serialize(buffer);
+  this->JobRetrievalWaitTimes.serialize(buffer);
+}
+
+//------------------------------------------------------------------------------
+ServerStats::ServerStats(remus::internal::BinaryReader& buffer)
+{
+  //counters an older peer doesn't send stay zero, and counters from a
+  //newer peer that we don't know about are skipped
+  for(std::size_t i=0; i < NumberOfCounters; ++i)
+    {
+    this->*Counters[i] = 0;
+    }
+  const boost::uint32_t count = buffer.getUInt32();
+  for(boost::uint32_t i=0; i < count && buffer.good(); ++i)
+    {
+    const boost::uint64_t value = buffer.getUInt64();
+    if(i < NumberOfCounters)
+      {
+      this->*Counters[i] = value;
+      }
+    }
+  this->ClientLatencies = read_latencies(buffer);
+  this->WorkerLatencies = read_latencies(buffer);
+  this->JobQueueTimes = LatencyHistogram(buffer);
+  this->JobExecutionTimes = LatencyHistogram(buffer);
+  this->JobRetrievalWaitTimes = LatencyHistogram(buffer);
+}
+
+}
+}
@@ -0,0 +1,164 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_ServerStats_h
+#define remus_proto_ServerStats_h
+
+#include <map>
+#include <string>
+#include <sstream>
+
+#include <boost/cstdint.hpp>
+
+#include <remus/common/remusGlobals.h>
+#include <remus/proto/binaryHelpers.h>
+#include <remus/proto/LatencyHistogram.h>
+
+//included for export symbols
+#include <remus/proto/ProtoExports.h>
+
+namespace remus {
+namespace proto {
+
+//A snapshot of the counters a server keeps on its jobs, workers and the
+//results it holds, returned by Client::serverStats. The counters ending in
+//Total only ever grow while the server runs, so the rate of something
+//happening is the difference of two snapshots divided by the difference
+//of their uptimes.
+class REMUSPROTO_EXPORT ServerStats
+{
+public:
+  ServerStats();
+
+  //jobs waiting in the queue for a worker to be found or created
+  boost::uint64_t JobsQueued;
+  //jobs in the queue that a worker has been requested for
+  boost::uint64_t JobsWaitingForWorkers;
+  //jobs given to a worker that haven't finished or failed
+  boost::uint64_t JobsActive;
+  //finished jobs whose results the server is holding
+  boost::uint64_t JobsFinished;
+  //failed or expired jobs the server is holding
+  boost::uint64_t JobsFailed;
+
+  //jobs the server has queued and given to workers since it started
+  boost::uint64_t JobsSubmittedTotal;
+  boost::uint64_t JobsDispatchedTotal;
+  //jobs removed because their time to live ran out since it started
+  boost::uint64_t JobsReclaimedTotal;
+
+  //workers connected to the server, and those waiting for a job
+  boost::uint64_t Workers;
+  boost::uint64_t WaitingWorkers;
+  //worker processes launched by the worker factory, and the most it
+  //is allowed to launch
+  boost::uint64_t WorkerProcesses;
+  boost::uint64_t MaxWorkerProcesses;
+
+  //bytes of results held in memory and spilled to disk
+  boost::uint64_t ResultBytesInMemory;
+  boost::uint64_t ResultBytesOnDisk;
+  //bytes of results removed because their time to live ran out
+  boost::uint64_t ResultBytesReclaimedTotal;
+
+  //milliseconds since the server started brokering
+  boost::uint64_t Uptime;
+
+  //microseconds of cpu time the brokering thread has used since it started
+  boost::uint64_t BrokerCpuTime;
+
+  //how long the server took, for each service type, from receiving a
+  //message to sending the reply to a client, or to finishing with a
+  //worker message, which have no reply. Only service types that have
+  //been seen are held
+  typedef std::map<remus::SERVICE_TYPE, LatencyHistogram> Latencies;
+  Latencies ClientLatencies;
+  Latencies WorkerLatencies;
+
+  //in microseconds, how long jobs waited to be given to a worker, how long
+  //workers took to finish or fail them, and how long finished jobs waited
+  //for their results to be retrieved. See JobTimestamps for the times of
+  //a single job
+  LatencyHistogram JobQueueTimes;
+  LatencyHistogram JobExecutionTimes;
+  LatencyHistogram JobRetrievalWaitTimes;
+
+  //the average number of jobs a second given to workers since the server
+  //started brokering
+  double dispatchRate() const;
+
+  //the fraction of a cpu the brokering thread has used since the server
+  //started brokering
+  double brokerCpuUsage() const;
+
+  bool operator ==(const ServerStats& b) const;
+  bool operator !=(const ServerStats& b) const
+    { return !(this->operator ==(b)); }
+
+  friend std::ostream& operator<<(std::ostream &os, const ServerStats &stats)
+    { stats.serialize(os); return os; }
+  friend std::istream& operator>>(std::istream &is, ServerStats &stats)
+    { stats = ServerStats(is); return is; }
+
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const;
+  explicit ServerStats(remus::internal::BinaryReader& buffer);
+
+private:
+  //serialize function
+  void serialize(std::ostream& buffer) const;
+
+  //deserialize constructor function
+  explicit ServerStats(std::istream& buffer);
+};
+
+//------------------------------------------------------------------------------
+inline std::string to_string(const remus::proto::ServerStats& stats)
+{
+  std::ostringstream buffer;
+  buffer << stats;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+inline remus::proto::ServerStats to_ServerStats(const char* data,
+                                                std::size_t size)
+{
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    const remus::proto::ServerStats decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::proto::ServerStats();
+      }
+    return decoded;
+    }
+  //the data might contain null terminators which on windows
+  //makes the data,size construct fail, so instead we use std::copy
+  const std::string temp(data,size);
+  std::istringstream buffer(temp);
+  remus::proto::ServerStats stats;
+  buffer >> stats;
+  return stats;
+}
+
+//------------------------------------------------------------------------------
+inline remus::proto::ServerStats to_ServerStats(const std::string& msg)
+{
+  return to_ServerStats(msg.data(), msg.size());
+}
+
+}
+}
+
+#endif
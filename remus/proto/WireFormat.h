@@ -0,0 +1,67 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_WireFormat_h
+#define remus_proto_WireFormat_h
+
+#include <string>
+
+#include <remus/proto/binaryHelpers.h>
+
+namespace remus {
+namespace proto {
+
+//The encodings that remus proto types can be sent over the wire with.
+//Text is the original newline separated encoding, Binary is the versioned
+//length prefixed little endian encoding described in binaryHelpers.h.
+//
+//Every to_<Type> function detects which encoding it was given, and the
+//server answers each request in the encoding the request used, so peers
+//that only speak Text keep working when others switch to Binary.
+struct WireFormat
+{
+  enum Type { Text = 0, Binary = 1 };
+};
+
+//------------------------------------------------------------------------------
+//returns the encoding of a received message
+inline remus::proto::WireFormat::Type wire_format(const char* data,
+                                                  std::size_t size)
+{
+  return remus::internal::is_binary(data,size) ? WireFormat::Binary
+                                               : WireFormat::Text;
+}
+
+//------------------------------------------------------------------------------
+//binary encode t into a string
+template<typename T>
+inline std::string to_binary(const T& t)
+{
+  const std::size_t size = remus::internal::binary_size(t);
+  std::string buffer(size,char());
+  remus::internal::write_binary(t, &buffer[0], size);
+  return buffer;
+}
+
+//------------------------------------------------------------------------------
+//encode t with the requested encoding into a string
+template<typename T>
+inline std::string to_wire(const T& t, remus::proto::WireFormat::Type format)
+{
+  return (format == WireFormat::Binary) ? remus::proto::to_binary(t)
+                                        : to_string(t);
+}
+
+}
+}
+
+#endif
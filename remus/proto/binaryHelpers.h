@@ -0,0 +1,274 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_binaryHelpers_h
+#define remus_proto_binaryHelpers_h
+
+#include <cstring>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/uuid/uuid.hpp>
+
+//The binary wire encoding of the remus proto types.
+//
+//Every binary encoded message starts with a fixed size header:
+// bytes 0-3: magic '\0' 'R' 'M' 'B', which can't start a text encoded message
+// byte 4: encoding version
+// bytes 5-12: length of the body in bytes
+//
+//All integers are little endian, strings and data blocks are written as
+//a 64bit length followed by the raw bytes, and uuids as their 16 raw bytes.
+//Nested types are written without a header.
+namespace remus {
+namespace internal
+{
+
+static const char BinaryMagic[4] = { '\0', 'R', 'M', 'B' };
+static const boost::uint8_t BinaryVersion = 1;
+static const std::size_t BinaryHeaderSize = 13;
+
+//------------------------------------------------------------------------------
+//returns true if the data starts with the header of the binary encoding
+inline bool is_binary(const char* data, std::size_t size)
+{
+  return data != NULL && size >= BinaryHeaderSize &&
+         std::memcmp(data, BinaryMagic, sizeof(BinaryMagic)) == 0;
+}
+
+//------------------------------------------------------------------------------
+//a non owning view of a block of bytes inside a binary message, supports
+//the .size() and .data() methods so it can be given to ConditionalStorage
+struct BinaryBytes
+{
+  BinaryBytes(): Data(NULL), Size(0) { }
+  BinaryBytes(const char* d, std::size_t s): Data(d), Size(s) { }
+
+  const char* data() const { return this->Data; }
+  std::size_t size() const { return this->Size; }
+  std::string str() const
+    { return (this->Size > 0) ? std::string(this->Data,this->Size)
+                              : std::string(); }
+
+  const char* Data;
+  std::size_t Size;
+};
+
+//------------------------------------------------------------------------------
+//Writes the binary encoding into a buffer that the caller has sized.
+//A writer constructed without a buffer only counts the bytes it would
+//write, which is how the callers size the buffer.
+class BinaryWriter
+{
+public:
+  BinaryWriter(): Buffer(NULL), Position(0) { }
+  explicit BinaryWriter(char* buffer): Buffer(buffer), Position(0) { }
+
+  //number of bytes written (or counted) so far
+  std::size_t size() const { return this->Position; }
+
+  void putHeader(std::size_t bodySize)
+  {
+    this->putRaw(BinaryMagic, sizeof(BinaryMagic));
+    this->putUInt8(BinaryVersion);
+    this->putUInt64(bodySize);
+  }
+
+  void putUInt8(boost::uint8_t v)
+  {
+    if(this->Buffer)
+      { this->Buffer[this->Position] = static_cast<char>(v); }
+    this->Position += 1;
+  }
+
+  void putUInt32(boost::uint32_t v)
+  {
+    if(this->Buffer)
+      {
+      for(std::size_t i=0; i < 4; ++i)
+        { this->Buffer[this->Position+i] = static_cast<char>(v >> (8*i)); }
+      }
+    this->Position += 4;
+  }
+
+  void putUInt64(boost::uint64_t v)
+  {
+    if(this->Buffer)
+      {
+      for(std::size_t i=0; i < 8; ++i)
+        { this->Buffer[this->Position+i] = static_cast<char>(v >> (8*i)); }
+      }
+    this->Position += 8;
+  }
+
+  void putRaw(const char* data, std::size_t size)
+  {
+    if(this->Buffer && size > 0)
+      { std::memcpy(this->Buffer+this->Position, data, size); }
+    this->Position += size;
+  }
+
+  //writes a 64bit length followed by the bytes
+  void putBytes(const char* data, std::size_t size)
+  {
+    this->putUInt64(size);
+    this->putRaw(data,size);
+  }
+
+  void putString(const std::string& str)
+    { this->putBytes(str.data(),str.size()); }
+
+  void putUUID(const boost::uuids::uuid& id)
+    { this->putRaw(reinterpret_cast<const char*>(id.data),id.size()); }
+
+private:
+  char* Buffer;
+  std::size_t Position;
+};
+
+//------------------------------------------------------------------------------
+//Reads the binary encoding from a buffer. The constructor consumes and
+//validates the header. Reading past the end of the body, or a header with
+//an unknown version, marks the reader as failed after which every read
+//returns zero or empty values.
+//
+//When given the owner of the buffer, types can keep views into the buffer
+//instead of copying out of it.
+class BinaryReader
+{
+public:
+  BinaryReader(const char* data, std::size_t size,
+               const boost::shared_ptr<const void>& owner =
+                                            boost::shared_ptr<const void>()):
+    Buffer(data),
+    Size(size),
+    Position(0),
+    Failed(!is_binary(data,size)),
+    Owner(owner)
+  {
+    if(!this->Failed)
+      {
+      this->Position = sizeof(BinaryMagic);
+      const boost::uint8_t version = this->getUInt8();
+      const boost::uint64_t bodySize = this->getUInt64();
+      this->Failed = (version == 0 || version > BinaryVersion ||
+                      bodySize > (this->Size - this->Position));
+      if(!this->Failed)
+        { this->Size = this->Position + static_cast<std::size_t>(bodySize); }
+      }
+  }
+
+  //returns false if the header was invalid or a read went past the end
+  bool good() const { return !this->Failed; }
+
+  //the number of bytes left to read
+  std::size_t remaining() const
+    { return this->Failed ? 0 : this->Size - this->Position; }
+
+  //the owner of the buffer, empty if views into the buffer can't be kept
+  const boost::shared_ptr<const void>& owner() const { return this->Owner; }
+
+  boost::uint8_t getUInt8()
+  {
+    const char* d = this->advance(1);
+    return d ? static_cast<boost::uint8_t>(*d) : 0;
+  }
+
+  boost::uint32_t getUInt32()
+  {
+    boost::uint32_t v = 0;
+    const unsigned char* d =
+              reinterpret_cast<const unsigned char*>(this->advance(4));
+    for(std::size_t i=0; d && i < 4; ++i)
+      { v |= static_cast<boost::uint32_t>(d[i]) << (8*i); }
+    return v;
+  }
+
+  boost::uint64_t getUInt64()
+  {
+    boost::uint64_t v = 0;
+    const unsigned char* d =
+              reinterpret_cast<const unsigned char*>(this->advance(8));
+    for(std::size_t i=0; d && i < 8; ++i)
+      { v |= static_cast<boost::uint64_t>(d[i]) << (8*i); }
+    return v;
+  }
+
+  //reads a 64bit length and returns a view of that many bytes in the buffer
+  BinaryBytes getBytes()
+  {
+    const boost::uint64_t size = this->getUInt64();
+    if(this->Failed || size > (this->Size - this->Position))
+      {
+      this->Failed = true;
+      return BinaryBytes();
+      }
+    const std::size_t s = static_cast<std::size_t>(size);
+    return BinaryBytes(this->advance(s),s);
+  }
+
+  std::string getString() { return this->getBytes().str(); }
+
+  boost::uuids::uuid getUUID()
+  {
+    boost::uuids::uuid id = boost::uuids::uuid();
+    const char* d = this->advance(id.size());
+    if(d)
+      { std::memcpy(id.data,d,id.size()); }
+    return id;
+  }
+
+private:
+  const char* advance(std::size_t count)
+  {
+    if(this->Failed || count > (this->Size - this->Position))
+      {
+      this->Failed = true;
+      return NULL;
+      }
+    const char* d = this->Buffer + this->Position;
+    this->Position += count;
+    return d;
+  }
+
+  const char* Buffer;
+  std::size_t Size;
+  std::size_t Position;
+  bool Failed;
+  boost::shared_ptr<const void> Owner;
+};
+
+//------------------------------------------------------------------------------
+//returns the number of bytes needed to binary encode t, including the header
+template<typename T>
+inline std::size_t binary_size(const T& t)
+{
+  BinaryWriter counter;
+  t.serialize(counter);
+  return BinaryHeaderSize + counter.size();
+}
+
+//------------------------------------------------------------------------------
+//binary encodes t into buffer, which must hold binary_size(t) bytes
+template<typename T>
+inline void write_binary(const T& t, char* buffer, std::size_t size)
+{
+  BinaryWriter writer(buffer);
+  writer.putHeader(size - BinaryHeaderSize);
+  t.serialize(writer);
+}
+
+}
+}
+
+#endif
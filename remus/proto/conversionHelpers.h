@@ -14,12 +14,77 @@
 #define remus_proto_conversionHelpers_h
 
 #include <string>
+#include <istream>
 #include <ostream>
+#include <streambuf>
 #include <vector>
 
+#include <boost/shared_ptr.hpp>
+
 namespace remus {
 namespace internal
 {
+//------------------------------------------------------------------------------
+//A read only stream buffer over memory it doesn't own, so that text encoded
+//messages can be parsed without first copying them into a string. When
+//given the owner of the memory, types can keep views into the memory
+//instead of copying out of it, see extractView.
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+  MemoryStreamBuffer(const char* data, std::size_t size,
+                     const boost::shared_ptr<const void>& owner =
+                                            boost::shared_ptr<const void>()):
+    Owner(owner)
+  {
+    //streambuf requires a non const pointer, we never write through it
+    char* d = const_cast<char*>(data);
+    this->setg(d, d, d+size);
+  }
+
+  const boost::shared_ptr<const void>& owner() const { return this->Owner; }
+
+  //returns a pointer to the next count bytes and consumes them, or NULL
+  //if there aren't that many bytes left
+  const char* take(std::size_t count)
+  {
+    if(count > static_cast<std::size_t>(this->egptr() - this->gptr()))
+      {
+      return NULL;
+      }
+    char* position = this->gptr();
+    this->setg(this->eback(), position+count, this->egptr());
+    return position;
+  }
+
+private:
+  boost::shared_ptr<const void> Owner;
+};
+
+//------------------------------------------------------------------------------
+//if the buffer reads from a MemoryStreamBuffer that knows the owner of
+//its memory, consume the next size bytes and return a view of them
+//and their owner. Otherwise nothing is consumed and false is returned.
+template<typename BufferType>
+inline bool extractView(BufferType& buffer, std::size_t size,
+                        const char*& view,
+                        boost::shared_ptr<const void>& owner)
+{
+  MemoryStreamBuffer* memory =
+                      dynamic_cast<MemoryStreamBuffer*>(buffer.rdbuf());
+  if(!memory || !memory->owner())
+    {
+    return false;
+    }
+  if(buffer.peek()=='\n')
+    {
+    buffer.get();
+    }
+  view = memory->take(size);
+  owner = memory->owner();
+  return view != NULL;
+}
+
 //------------------------------------------------------------------------------
 template<typename BufferType>
 inline void extractVector(BufferType& buffer, std::vector<char>& msg)
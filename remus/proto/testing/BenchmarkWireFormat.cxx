@@ -0,0 +1,163 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+//Reports the encode and decode throughput of the text and binary wire
+//formats for each of the proto types.
+//
+//Usage: BenchmarkWireFormat [payload size in bytes]
+
+#include <remus/proto/JobResult.h>
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/JobSubmission.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/proto/zmqHelper.h>
+#include <remus/worker/Job.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/uuid/random_generator.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+using namespace remus::common;
+using namespace remus::proto;
+
+typedef boost::posix_time::ptime Time;
+
+Time now() { return boost::posix_time::microsec_clock::local_time(); }
+
+double seconds_since(const Time& start)
+{
+  return static_cast<double>((now() - start).total_microseconds()) / 1.0e6;
+}
+
+//run the operation until at least a quarter second has passed, and
+//return the number of runs per second
+template<typename Operation>
+double runs_per_second(Operation op)
+{
+  std::size_t runs = 0;
+  double elapsed = 0;
+  const Time start = now();
+  while(elapsed < 0.25)
+    {
+    op();
+    ++runs;
+    elapsed = seconds_since(start);
+    }
+  return static_cast<double>(runs) / elapsed;
+}
+
+template<typename T>
+struct EncodeText
+{
+  const T& Value;
+  explicit EncodeText(const T& v): Value(v) { }
+  void operator()() const
+    {
+    zmq::message_t msg;
+    zmq::to_wire(Value, WireFormat::Text, msg);
+    }
+};
+
+template<typename T>
+struct EncodeBinary
+{
+  const T& Value;
+  explicit EncodeBinary(const T& v): Value(v) { }
+  void operator()() const
+    {
+    zmq::message_t msg;
+    zmq::to_wire(Value, WireFormat::Binary, msg);
+    }
+};
+
+template<typename T, T (*Decode)(const char*, std::size_t)>
+struct DecodeWith
+{
+  const std::string& Data;
+  explicit DecodeWith(const std::string& d): Data(d) { }
+  void operator()() const { Decode(Data.data(),Data.size()); }
+};
+
+JobRequirements decode_requirements(const char* data, std::size_t size)
+{
+  return to_JobRequirements(data,static_cast<int>(size));
+}
+
+remus::worker::Job decode_worker_job(const char* data, std::size_t size)
+{
+  return remus::worker::to_Job(data,static_cast<int>(size));
+}
+
+void report(const char* name, const char* format, std::size_t bytes,
+            double encodes, double decodes)
+{
+  const double mb = static_cast<double>(bytes) / (1024.0 * 1024.0);
+  std::printf("%-16s %-7s %12lu %12.1f %12.1f\n", name, format,
+              static_cast<unsigned long>(bytes), mb * encodes, mb * decodes);
+}
+
+template<typename T, T (*Decode)(const char*, std::size_t)>
+void benchmark(const char* name, const T& value)
+{
+  const std::string text = to_string(value);
+  report(name, "text", text.size(),
+         runs_per_second(EncodeText<T>(value)),
+         runs_per_second(DecodeWith<T,Decode>(text)));
+
+  const std::string binary = to_binary(value);
+  report(name, "binary", binary.size(),
+         runs_per_second(EncodeBinary<T>(value)),
+         runs_per_second(DecodeWith<T,Decode>(binary)));
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+  std::size_t payload = 16 * 1024 * 1024;
+  if(argc > 1)
+    {
+    payload = boost::lexical_cast<std::size_t>(argv[1]);
+    }
+
+  boost::uuids::random_generator generator;
+  const std::string data = remus::testing::BinaryDataGenerator(payload);
+
+  const JobRequirements reqs(ContentFormat::User,
+                             MeshIOType(remus::meshtypes::Edges(),
+                                        remus::meshtypes::Mesh2D()),
+                             "BenchmarkWorker",
+                             data);
+  const JobContent content = make_JobContent(data);
+  JobSubmission sub(make_JobRequirements(reqs.meshTypes(),"Worker",""));
+  sub["first"] = content;
+  sub["second"] = content;
+  const JobStatus status(generator(), JobProgress(50,"benchmarking"));
+  const JobResult result = make_JobResult(generator(), data);
+  const remus::worker::Job job(generator(), sub);
+
+  std::printf("%-16s %-7s %12s %12s %12s\n", "type", "format", "bytes",
+              "encode MB/s", "decode MB/s");
+  benchmark<JobContent, &to_JobContent>("JobContent", content);
+  benchmark<JobRequirements, &decode_requirements>("JobRequirements", reqs);
+  benchmark<JobSubmission, &to_JobSubmission>("JobSubmission", sub);
+  benchmark<JobStatus, &to_JobStatus>("JobStatus", status);
+  benchmark<JobResult, &to_JobResult>("JobResult", result);
+  benchmark<remus::worker::Job, &decode_worker_job>("worker::Job", job);
+  return 0;
+}
@@ -0,0 +1,139 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/JobBatch.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/make_shared.hpp>
+
+namespace {
+using namespace remus::proto;
+
+remus::common::MeshIOType make_types()
+{
+  return remus::common::MeshIOType(remus::meshtypes::Model(),
+                                   remus::meshtypes::Mesh3D());
+}
+
+JobSubmissionBatch make_submissions(std::size_t count)
+{
+  JobSubmissionBatch batch;
+  for(std::size_t i=0; i < count; ++i)
+    {
+    JobSubmission sub(make_JobRequirements(make_types(), "worker", "reqs"));
+    sub["data"] = make_JobContent( remus::testing::BinaryDataGenerator(64*i) );
+    sub["text"] = make_JobContent( std::string("a\nb") );
+    batch.Submissions.push_back(sub);
+    }
+  return batch;
+}
+
+JobBatch make_jobs(std::size_t count)
+{
+  JobBatch batch;
+  for(std::size_t i=0; i < count; ++i)
+    {
+    batch.Jobs.push_back( Job(remus::testing::UUIDGenerator(), make_types()) );
+    }
+  return batch;
+}
+
+JobStatusBatch make_statuses(const JobBatch& jobs)
+{
+  JobStatusBatch batch;
+  for(std::size_t i=0; i < jobs.Jobs.size(); ++i)
+    {
+    JobStatus status = make_JobStatus(jobs.Jobs[i].id(), static_cast<int>(i));
+    JobTimestamps times;
+    times.Queued = 10 + i;
+    times.Dispatched = 20 + i;
+    status.updateTimestamps(times);
+    batch.Statuses.push_back(status);
+    }
+  batch.Statuses.push_back(
+                  JobStatus(remus::testing::UUIDGenerator(), remus::FAILED) );
+  return batch;
+}
+
+void verify_submissions(std::size_t count)
+{
+  const JobSubmissionBatch to_wire = make_submissions(count);
+  const std::string encodings[2] = { to_string(to_wire),
+                                     to_binary(to_wire) };
+  for(int i=0; i < 2; ++i)
+    {
+    const JobSubmissionBatch copied = to_JobSubmissionBatch(encodings[i]);
+    REMUS_ASSERT( (copied.Submissions == to_wire.Submissions) );
+
+    //with an owner every submission views into the one buffer
+    boost::shared_ptr<std::string> data =
+                              boost::make_shared<std::string>(encodings[i]);
+    const char* begin = data->data();
+    const char* end = data->data() + data->size();
+    const JobSubmissionBatch viewed =
+              to_JobSubmissionBatch(data->data(), data->size(), data);
+    REMUS_ASSERT( (viewed.Submissions == to_wire.Submissions) );
+    for(std::size_t j=0; j < viewed.Submissions.size(); ++j)
+      {
+      JobSubmission sub = viewed.Submissions[j];
+      REMUS_ASSERT( (sub["text"].data() >= begin && sub["text"].data() < end) );
+      }
+    }
+}
+
+void verify_jobs_and_statuses(std::size_t count)
+{
+  const JobBatch jobs = make_jobs(count);
+  const JobStatusBatch statuses = make_statuses(jobs);
+
+  const std::string job_encodings[2] = { to_string(jobs), to_binary(jobs) };
+  const std::string status_encodings[2] = { to_string(statuses),
+                                            to_binary(statuses) };
+  for(int i=0; i < 2; ++i)
+    {
+    const JobBatch jobs_from_wire = to_JobBatch(job_encodings[i]);
+    REMUS_ASSERT( (jobs_from_wire.Jobs.size() == count) );
+    for(std::size_t j=0; j < count; ++j)
+      {
+      REMUS_ASSERT( (jobs_from_wire.Jobs[j].id() == jobs.Jobs[j].id()) );
+      REMUS_ASSERT( (jobs_from_wire.Jobs[j].type() == jobs.Jobs[j].type()) );
+      }
+
+    const JobStatusBatch statuses_from_wire =
+                                    to_JobStatusBatch(status_encodings[i]);
+    REMUS_ASSERT( (statuses_from_wire.Statuses == statuses.Statuses) );
+    for(std::size_t j=0; j < statuses.Statuses.size(); ++j)
+      {
+      REMUS_ASSERT( (statuses_from_wire.Statuses[j].timestamps() ==
+                     statuses.Statuses[j].timestamps()) );
+      }
+    }
+}
+
+}
+
+int UnitTestJobBatch(int, char *[])
+{
+  verify_submissions(0);
+  verify_submissions(1);
+  verify_submissions(16);
+
+  verify_jobs_and_statuses(0);
+  verify_jobs_and_statuses(1);
+  verify_jobs_and_statuses(64);
+
+  //garbage decodes to empty batches
+  REMUS_ASSERT( (to_JobBatch(std::string("garbage")).Jobs.empty()) );
+  REMUS_ASSERT( (to_JobStatusBatch(std::string()).Statuses.empty()) );
+  return 0;
+}
@@ -10,9 +10,12 @@
 //
 //=============================================================================
 
+#include <remus/common/MD5Hash.h>
 #include <remus/proto/JobContent.h>
 #include <remus/testing/Testing.h>
 
+#include <boost/make_shared.hpp>
+
 #include <algorithm>
 #include <vector>
 #include <set>
@@ -122,6 +125,21 @@ void verify_tag()
   REMUS_ASSERT( (test.tag() == "hello") );
 }
 
+void verify_hash()
+{
+  //the hash is of the data, whether it was copied or viewed
+  const std::string data = remus::testing::BinaryDataGenerator(10000);
+  boost::shared_ptr<std::string> owner =
+                                  boost::make_shared<std::string>(data);
+  const JobContent copied = make_JobContent(data);
+  const JobContent viewed(remus::common::ContentFormat::User,
+                          owner->data(), owner->size(), owner);
+  REMUS_ASSERT( (viewed.data() == owner->data()) );
+  REMUS_ASSERT( (copied.hash() == remus::common::MD5Hash(data)) );
+  REMUS_ASSERT( (viewed.hash() == copied.hash()) );
+  REMUS_ASSERT( (make_JobContent(std::string("other")).hash() !=
+                 copied.hash()) );
+}
 
 void verify_container_algorithm_support()
 {
@@ -263,6 +281,7 @@ int UnitTestJobContent(int, char *[])
 {
   verify_source_and_format();
   verify_tag();
+  verify_hash();
 
   verify_container_algorithm_support();
 
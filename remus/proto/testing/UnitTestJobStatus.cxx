@@ -12,6 +12,7 @@
 
 #include <boost/uuid/uuid.hpp>
 #include <remus/proto/JobStatus.h>
+#include <remus/proto/WireFormat.h>
 #include <remus/testing/Testing.h>
 
 namespace
@@ -220,6 +221,67 @@ void serialize_test()
   validate_serialization(e);
 }
 
+void timestamps_test()
+{
+  JobStatus a(make_id(), remus::FINISHED);
+  REMUS_ASSERT( (a.timestamps() == JobTimestamps()) );
+  REMUS_ASSERT( (a.timestamps().queueTime() == 0) );
+  REMUS_ASSERT( (a.timestamps().executionTime() == 0) );
+
+  JobTimestamps times;
+  times.Queued = 1000;
+  times.Dispatched = 1500;
+  times.FirstProgress = 1750;
+  times.Finished = 4000;
+  REMUS_ASSERT( (times.queueTime() == 500) );
+  REMUS_ASSERT( (times.executionTime() == 2500) );
+
+  //timestamps don't take part in comparing statuses
+  JobStatus b(a);
+  b.updateTimestamps(times);
+  REMUS_ASSERT( (b.timestamps() == times) );
+  REMUS_ASSERT( (a == b) );
+
+  const JobStatus from_text = to_JobStatus(to_string(b));
+  REMUS_ASSERT( (from_text == b) );
+  REMUS_ASSERT( (from_text.timestamps() == times) );
+
+  const JobStatus from_binary = to_JobStatus(to_binary(b));
+  REMUS_ASSERT( (from_binary == b) );
+  REMUS_ASSERT( (from_binary.timestamps() == times) );
+
+  //statuses written without timestamps still read, with no times
+  std::ostringstream old;
+  old << b.id() << std::endl;
+  old << b.status() << std::endl;
+  old << b.progress() << std::endl;
+  const JobStatus from_old = to_JobStatus(old.str());
+  REMUS_ASSERT( (from_old == b) );
+  REMUS_ASSERT( (from_old.timestamps() == JobTimestamps()) );
+
+  //and so do binary statuses, which end before the timestamps
+  std::string oldBinary = to_binary(b);
+  oldBinary.resize(oldBinary.size() - 4 * sizeof(boost::uint64_t));
+  remus::internal::BinaryWriter(&oldBinary[0]).putHeader(
+                      oldBinary.size() - remus::internal::BinaryHeaderSize);
+  const JobStatus from_old_binary = to_JobStatus(oldBinary);
+  REMUS_ASSERT( (from_old_binary.status() == remus::FINISHED) );
+  REMUS_ASSERT( (from_old_binary == b) );
+  REMUS_ASSERT( (from_old_binary.timestamps() == JobTimestamps()) );
+
+  //a status cut off inside its timestamps is still invalid
+  oldBinary = to_binary(b);
+  oldBinary.resize(oldBinary.size() - 4);
+  remus::internal::BinaryWriter(&oldBinary[0]).putHeader(
+                      oldBinary.size() - remus::internal::BinaryHeaderSize);
+  REMUS_ASSERT( (to_JobStatus(oldBinary).invalid()) );
+
+  //the monotonic clock never goes backwards
+  const boost::int64_t start = JobTimestamps::now();
+  REMUS_ASSERT( (start > 0) );
+  REMUS_ASSERT( (JobTimestamps::now() >= start) );
+}
+
 void valid_test()
 {
   JobStatus a(make_id(), remus::INVALID_STATUS);
@@ -294,6 +356,7 @@ int UnitTestJobStatus(int, char *[])
   mark_test();
   progress_test();
   serialize_test();
+  timestamps_test();
   valid_test();
   make_functions();
 
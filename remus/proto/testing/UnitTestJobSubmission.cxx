@@ -11,8 +11,11 @@
 //=============================================================================
 
 #include <remus/proto/JobSubmission.h>
+#include <remus/proto/WireFormat.h>
 #include <remus/testing/Testing.h>
 
+#include <boost/make_shared.hpp>
+
 namespace {
 using namespace remus::common;
 using namespace remus::proto;
@@ -270,6 +273,50 @@ void to_from_string_test()
   REMUS_ASSERT( (from_wire == to_wire) );
 }
 
+void zero_copy_test()
+{
+  JobSubmission to_wire(make_random_MeshReqs());
+  to_wire["a"] = make_JobContent( remus::testing::BinaryDataGenerator(4096) );
+  to_wire["b"] = make_JobContent( std::string("b\nb") );
+
+  const std::string encodings[2] = { to_string(to_wire),
+                                     to_binary(to_wire) };
+  for(int i=0; i < 2; ++i)
+    {
+    boost::shared_ptr<std::string> data =
+                              boost::make_shared<std::string>(encodings[i]);
+    const char* begin = data->data();
+    const char* end = data->data() + data->size();
+
+    //without an owner the content is copied out of the buffer
+    JobSubmission copied = to_JobSubmission(begin,data->size());
+    REMUS_ASSERT( (copied == to_wire) );
+    REMUS_ASSERT( (!copied.hasEncoded()) );
+    REMUS_ASSERT( (copied["a"].data() < begin || copied["a"].data() >= end) );
+
+    //with an owner the content views into the buffer and keeps it alive
+    JobSubmission viewed = to_JobSubmission(begin,data->size(),data);
+    REMUS_ASSERT( (viewed == to_wire) );
+
+    //it also remembers the bytes it came from so they can be forwarded,
+    //until the content is modified
+    REMUS_ASSERT( (viewed.hasEncoded()) );
+    REMUS_ASSERT( (viewed.encodedData() == begin) );
+    REMUS_ASSERT( (viewed.encodedSize() == data->size()) );
+    JobSubmission viewedCopy = viewed;
+    REMUS_ASSERT( (viewedCopy.hasEncoded()) );
+    viewedCopy["c"] = make_JobContent( std::string("c") );
+    REMUS_ASSERT( (!viewedCopy.hasEncoded()) );
+    REMUS_ASSERT( (viewed.hasEncoded()) );
+    REMUS_ASSERT( (viewed["a"].data() >= begin && viewed["a"].data() < end) );
+    REMUS_ASSERT( (viewed["b"].data() >= begin && viewed["b"].data() < end) );
+    REMUS_ASSERT( (viewed["b"].dataSize() == 3) );
+
+    REMUS_ASSERT( (data.use_count() > 1) );
+    data.reset();
+    REMUS_ASSERT( (viewed == to_wire) );
+    }
+}
 
 int UnitTestJobSubmission(int, char *[])
 {
@@ -277,6 +324,7 @@ int UnitTestJobSubmission(int, char *[])
   insert_test();
   serialize_operator_test();
   to_from_string_test();
+  zero_copy_test();
 
   return 0;
 }
\ No newline at end of file
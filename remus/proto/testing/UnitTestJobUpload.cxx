@@ -0,0 +1,111 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/MD5Hash.h>
+#include <remus/proto/JobUpload.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/make_shared.hpp>
+
+namespace {
+using namespace remus::proto;
+
+void verify_upload()
+{
+  const remus::common::MeshIOType types =
+        remus::common::make_MeshIOType(remus::meshtypes::Model(),
+                                       remus::meshtypes::Mesh3D());
+  JobUpload upload(make_JobRequirements(types, "worker", "reqs"));
+  upload.add( JobUpload::Entry("data", remus::common::ContentFormat::XML,
+                               "tag\nwith newline", 5000000000ULL) );
+  upload.add( JobUpload::Entry("empty", remus::common::ContentFormat::User,
+                               "", 0) );
+  upload.add( JobUpload::Entry("hashed", remus::common::ContentFormat::User,
+                               "", 1024,
+                               remus::common::MD5Hash(std::string("a"))) );
+  REMUS_ASSERT( (upload.totalSize() == 5000000000ULL + 1024) );
+
+  const std::string encodings[2] = { to_string(upload), to_binary(upload) };
+  for(int i=0; i < 2; ++i)
+    {
+    const JobUpload from_wire = to_JobUpload(encodings[i]);
+    REMUS_ASSERT( (from_wire.requirements() == upload.requirements()) );
+    REMUS_ASSERT( (from_wire.type() == types) );
+    REMUS_ASSERT( (from_wire.entries() == upload.entries()) );
+    REMUS_ASSERT( (from_wire.totalSize() == upload.totalSize()) );
+    }
+
+  REMUS_ASSERT( (to_JobUpload(std::string("garbage")).entries().empty()) );
+}
+
+void verify_reply()
+{
+  const Job job(remus::testing::UUIDGenerator(),
+                remus::common::make_MeshIOType(remus::meshtypes::Model(),
+                                               remus::meshtypes::Mesh3D()));
+  JobUploadReply reply(job);
+  reply.addMissing("data");
+  reply.addMissing("key with\nnewline");
+
+  const std::string encodings[2] = { to_string(reply), to_binary(reply) };
+  for(int i=0; i < 2; ++i)
+    {
+    const JobUploadReply from_wire = to_JobUploadReply(encodings[i]);
+    REMUS_ASSERT( (from_wire.job().id() == job.id()) );
+    REMUS_ASSERT( (from_wire.job().type() == job.type()) );
+    REMUS_ASSERT( (from_wire.missing() == reply.missing()) );
+    }
+
+  REMUS_ASSERT( (!JobUploadReply().job().valid()) );
+  REMUS_ASSERT( (!to_JobUploadReply(std::string()).job().valid()) );
+}
+
+void verify_chunk()
+{
+  const std::string data = remus::testing::BinaryDataGenerator(8192) + "\n";
+  const JobUploadChunk chunk(remus::testing::UUIDGenerator(), "data key",
+                             4000000000ULL, data.data(), data.size());
+  REMUS_ASSERT( (chunk.valid()) );
+
+  const std::string encodings[2] = { to_string(chunk), to_binary(chunk) };
+  for(int i=0; i < 2; ++i)
+    {
+    const JobUploadChunk copied = to_JobUploadChunk(encodings[i]);
+    REMUS_ASSERT( (copied.id() == chunk.id()) );
+    REMUS_ASSERT( (copied.key() == chunk.key()) );
+    REMUS_ASSERT( (copied.offset() == chunk.offset()) );
+    REMUS_ASSERT( (std::string(copied.data(),copied.dataSize()) == data) );
+
+    //with an owner the chunk views into the received bytes
+    boost::shared_ptr<std::string> received =
+                              boost::make_shared<std::string>(encodings[i]);
+    const JobUploadChunk viewed =
+          to_JobUploadChunk(received->data(), received->size(), received);
+    REMUS_ASSERT( (std::string(viewed.data(),viewed.dataSize()) == data) );
+    REMUS_ASSERT( (viewed.data() >= received->data() &&
+                   viewed.data() < received->data() + received->size()) );
+    }
+
+  REMUS_ASSERT( (!JobUploadChunk().valid()) );
+  REMUS_ASSERT( (!to_JobUploadChunk(std::string("garbage")).valid()) );
+}
+
+}
+
+int UnitTestJobUpload(int, char *[])
+{
+  verify_upload();
+  verify_reply();
+  verify_chunk();
+  return 0;
+}
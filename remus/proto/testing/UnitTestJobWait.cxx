@@ -0,0 +1,60 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/proto/JobWait.h>
+#include <remus/proto/WireFormat.h>
+
+#include <remus/testing/Testing.h>
+
+namespace
+{
+using namespace remus::proto;
+
+void validate_serialization(const JobWait& w)
+{
+  const std::string encodings[2] = { to_string(w), to_binary(w) };
+  for(int i=0; i < 2; ++i)
+    {
+    const JobWait from_string = to_JobWait(encodings[i]);
+    const JobWait from_c_string = to_JobWait(encodings[i].c_str(),
+                                             encodings[i].size());
+
+    REMUS_ASSERT( (from_string.job().id() == w.job().id()) );
+    REMUS_ASSERT( (from_string.job().type() == w.job().type()) );
+    REMUS_ASSERT( (from_string.timeout() == w.timeout()) );
+    REMUS_ASSERT( (from_string.withResult() == w.withResult()) );
+
+    REMUS_ASSERT( (from_c_string.job().id() == w.job().id()) );
+    REMUS_ASSERT( (from_c_string.timeout() == w.timeout()) );
+    REMUS_ASSERT( (from_c_string.withResult() == w.withResult()) );
+    }
+}
+
+}
+
+int UnitTestJobWait(int, char *[])
+{
+  remus::meshtypes::Model model;
+  remus::meshtypes::Mesh3D m3d;
+
+  Job job(remus::testing::UUIDGenerator(),
+          remus::common::MeshIOType(model,m3d));
+
+  validate_serialization( JobWait(job, 0, false) );
+  validate_serialization( JobWait(job, 250, true) );
+  validate_serialization( JobWait(job, 0xffffffff, false) );
+
+  //garbage decodes to a wait on an invalid job that doesn't wait
+  const JobWait garbage = to_JobWait(std::string("garbage"));
+  REMUS_ASSERT( (!garbage.job().valid()) );
+  REMUS_ASSERT( (garbage.timeout() == 0) );
+  return 0;
+}
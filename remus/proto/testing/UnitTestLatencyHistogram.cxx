@@ -0,0 +1,114 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/LatencyHistogram.h>
+#include <remus/proto/ServerStats.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/testing/Testing.h>
+
+namespace
+{
+using namespace remus::proto;
+
+void bucket_test()
+{
+  //small latencies have a bucket each
+  for(boost::uint64_t v=0; v < 8; ++v)
+    {
+    const std::size_t b = LatencyHistogram::bucket(v);
+    REMUS_ASSERT( (LatencyHistogram::bucketLowerBound(b) == v) );
+    REMUS_ASSERT( (LatencyHistogram::bucketUpperBound(b) == v) );
+    }
+
+  //every latency falls inside the range of its bucket, and the buckets
+  //are no wider than a quarter of their lower bound, up to the last range
+  //whose final bucket holds every larger latency
+  for(boost::uint64_t v=8; v < (boost::uint64_t(1) << 28); v = v * 3 / 2 + 1)
+    {
+    const std::size_t b = LatencyHistogram::bucket(v);
+    const boost::uint64_t lower = LatencyHistogram::bucketLowerBound(b);
+    const boost::uint64_t upper = LatencyHistogram::bucketUpperBound(b);
+    REMUS_ASSERT( (lower <= v && v <= upper) );
+    REMUS_ASSERT( ((upper - lower + 1) * 4 <= lower) );
+    }
+
+  //latencies past the last range are counted in the last bucket
+  REMUS_ASSERT( (LatencyHistogram::bucket(~boost::uint64_t(0)) ==
+                 LatencyHistogram::NumberOfBuckets - 1) );
+}
+
+void record_test()
+{
+  LatencyHistogram empty;
+  REMUS_ASSERT( (empty.count() == 0) );
+  REMUS_ASSERT( (empty.percentile(50) == 0) );
+
+  LatencyHistogram h;
+  for(boost::uint64_t v=1; v <= 100; ++v)
+    {
+    h.record(v * 100);
+    }
+  REMUS_ASSERT( (h.count() == 100) );
+  REMUS_ASSERT( (h.total() == 505000) );
+  REMUS_ASSERT( (h.maximum() == 10000) );
+  REMUS_ASSERT( (h.mean() == 5050.0) );
+
+  //percentiles are within the precision of the buckets
+  const boost::uint64_t p50 = h.percentile(50);
+  REMUS_ASSERT( (p50 >= 5000 && p50 <= 5000 * 5 / 4) );
+  const boost::uint64_t p99 = h.percentile(99);
+  REMUS_ASSERT( (p99 >= 9900 && p99 <= 10000) );
+  REMUS_ASSERT( (h.percentile(100) == 10000) );
+
+  LatencyHistogram merged;
+  merged.merge(h);
+  merged.merge(h);
+  REMUS_ASSERT( (merged.count() == 200) );
+  REMUS_ASSERT( (merged.percentile(50) == p50) );
+}
+
+void serialize_test()
+{
+  LatencyHistogram h;
+  h.record(3);
+  h.record(250);
+  h.record(250);
+  h.record(1000000);
+
+  ServerStats stats;
+  stats.JobsQueued = 4;
+  stats.ClientLatencies[remus::MAKE_MESH] = h;
+  stats.WorkerLatencies[remus::HEARTBEAT] = h;
+  stats.JobQueueTimes = h;
+  stats.JobExecutionTimes.record(5000);
+
+  const ServerStats from_text = to_ServerStats(to_string(stats));
+  REMUS_ASSERT( (from_text == stats) );
+  REMUS_ASSERT( (from_text.ClientLatencies.find(remus::MAKE_MESH)->second == h) );
+
+  const ServerStats from_binary = to_ServerStats(to_binary(stats));
+  REMUS_ASSERT( (from_binary == stats) );
+  REMUS_ASSERT( (from_binary.WorkerLatencies.find(remus::HEARTBEAT)->second == h) );
+  REMUS_ASSERT( (from_binary.JobQueueTimes == h) );
+  REMUS_ASSERT( (from_binary.JobExecutionTimes.count() == 1) );
+  REMUS_ASSERT( (from_binary.JobRetrievalWaitTimes.count() == 0) );
+}
+
+}
+
+int UnitTestLatencyHistogram(int, char *[])
+{
+  bucket_test();
+  record_test();
+  serialize_test();
+  return 0;
+}
@@ -0,0 +1,95 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/JobResult.h>
+#include <remus/proto/ResultStream.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/testing/Testing.h>
+
+namespace {
+using namespace remus::proto;
+
+void verify_request()
+{
+  const Job job(remus::testing::UUIDGenerator(),
+                remus::common::MeshIOType(remus::meshtypes::Model(),
+                                          remus::meshtypes::Mesh3D()));
+  const ResultStreamRequest request(job, 1048576, 4);
+  const std::string encodings[2] = { to_string(request),
+                                     to_binary(request) };
+  for(int i=0; i < 2; ++i)
+    {
+    const ResultStreamRequest from_wire = to_ResultStreamRequest(encodings[i]);
+    REMUS_ASSERT( (from_wire.job().id() == job.id()) );
+    REMUS_ASSERT( (from_wire.job().type() == job.type()) );
+    REMUS_ASSERT( (from_wire.chunkSize() == 1048576) );
+    REMUS_ASSERT( (from_wire.credits() == 4) );
+    }
+
+  const ResultStreamRequest garbage = to_ResultStreamRequest("garbage");
+  REMUS_ASSERT( (garbage.credits() == 0) );
+}
+
+void verify_chunk()
+{
+  const ResultChunk chunk(remus::testing::UUIDGenerator(),
+                          remus::common::ContentFormat::XML,
+                          5000000000ULL, 4000000000ULL);
+  const std::string encodings[2] = { to_string(chunk), to_binary(chunk) };
+  for(int i=0; i < 2; ++i)
+    {
+    const ResultChunk from_wire = to_ResultChunk(encodings[i]);
+    REMUS_ASSERT( (from_wire.id() == chunk.id()) );
+    REMUS_ASSERT( (from_wire.formatType() == chunk.formatType()) );
+    REMUS_ASSERT( (from_wire.totalSize() == chunk.totalSize()) );
+    REMUS_ASSERT( (from_wire.offset() == chunk.offset()) );
+    REMUS_ASSERT( (from_wire.valid()) );
+    }
+
+  //a job without a result has nothing to stream
+  const ResultChunk empty(chunk.id());
+  REMUS_ASSERT( (!to_ResultChunk(to_binary(empty)).valid()) );
+}
+
+void verify_result_view()
+{
+  const std::string data = remus::testing::BinaryDataGenerator(4096) + "\n";
+  const JobResult result = make_JobResult(remus::testing::UUIDGenerator(),
+                                          data,
+                                          remus::common::ContentFormat::BSON);
+  const std::string encodings[2] = { to_string(result), to_binary(result) };
+  for(int i=0; i < 2; ++i)
+    {
+    remus::common::ContentFormat::Type format;
+    const char* view = NULL;
+    std::size_t viewSize = 0;
+    REMUS_ASSERT( (view_JobResultData(encodings[i].data(),
+                                      encodings[i].size(),
+                                      format, view, viewSize)) );
+    REMUS_ASSERT( (format == remus::common::ContentFormat::BSON) );
+    REMUS_ASSERT( (std::string(view,viewSize) == data) );
+
+    //the view is into the encoding, not a copy of it
+    REMUS_ASSERT( (view >= encodings[i].data() &&
+                   view + viewSize <= encodings[i].data() + encodings[i].size()) );
+    }
+}
+
+}
+
+int UnitTestResultStream(int, char *[])
+{
+  verify_request();
+  verify_chunk();
+  verify_result_view();
+  return 0;
+}
@@ -0,0 +1,114 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/ServerStats.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/testing/Testing.h>
+
+namespace
+{
+using namespace remus::proto;
+
+ServerStats make_Stats()
+{
+  ServerStats stats;
+  stats.JobsQueued = 3;
+  stats.JobsWaitingForWorkers = 2;
+  stats.JobsActive = 4;
+  stats.JobsFinished = 5;
+  stats.JobsFailed = 1;
+  stats.JobsSubmittedTotal = 100;
+  stats.JobsDispatchedTotal = 97;
+  stats.JobsReclaimedTotal = 88;
+  stats.Workers = 6;
+  stats.WaitingWorkers = 2;
+  stats.WorkerProcesses = 4;
+  stats.MaxWorkerProcesses = 8;
+  stats.ResultBytesInMemory = 1024;
+  stats.ResultBytesOnDisk = (boost::uint64_t(1) << 40);
+  stats.ResultBytesReclaimedTotal = 4096;
+  stats.Uptime = 2000;
+  stats.BrokerCpuTime = 500000;
+  return stats;
+}
+
+void state_test()
+{
+  ServerStats empty;
+  REMUS_ASSERT( (empty.JobsQueued == 0) );
+  REMUS_ASSERT( (empty.Uptime == 0) );
+  REMUS_ASSERT( (empty.dispatchRate() == 0.0) );
+  REMUS_ASSERT( (empty.brokerCpuUsage() == 0.0) );
+
+  ServerStats stats = make_Stats();
+  REMUS_ASSERT( (stats != empty) );
+  REMUS_ASSERT( (stats.dispatchRate() == 48.5) );
+  REMUS_ASSERT( (stats.brokerCpuUsage() == 0.25) );
+}
+
+void serialize_test()
+{
+  const ServerStats stats = make_Stats();
+
+  const ServerStats from_text = to_ServerStats(to_string(stats));
+  REMUS_ASSERT( (from_text == stats) );
+
+  const std::string binary = to_binary(stats);
+  REMUS_ASSERT( (wire_format(binary.data(),binary.size()) ==
+                 WireFormat::Binary) );
+  const ServerStats from_binary = to_ServerStats(binary);
+  REMUS_ASSERT( (from_binary == stats) );
+
+  const ServerStats empty = to_ServerStats(to_wire(ServerStats(),
+                                                   WireFormat::Binary));
+  REMUS_ASSERT( (empty == ServerStats()) );
+}
+
+void older_peer_test()
+{
+  //a peer that knows fewer counters leaves the rest at zero
+  const std::string text("2\n7\n9\n");
+  const ServerStats stats = to_ServerStats(text);
+  REMUS_ASSERT( (stats.JobsQueued == 7) );
+  REMUS_ASSERT( (stats.JobsWaitingForWorkers == 9) );
+  REMUS_ASSERT( (stats.JobsActive == 0) );
+  REMUS_ASSERT( (stats.Uptime == 0) );
+}
+
+void bad_count_test()
+{
+  //a count larger than the counters sent stops at the end of the data
+  const std::string text("4000000000\n7\n");
+  const ServerStats stats = to_ServerStats(text);
+  REMUS_ASSERT( (stats.JobsQueued == 7) );
+  REMUS_ASSERT( (stats.JobsActive == 0) );
+
+  char body[12];
+  remus::internal::BinaryWriter writer(body);
+  writer.putUInt32(0xFFFFFFFF);
+  writer.putUInt64(7);
+  std::string binary(remus::internal::BinaryHeaderSize, char());
+  remus::internal::BinaryWriter(&binary[0]).putHeader(sizeof(body));
+  binary.append(body, sizeof(body));
+  REMUS_ASSERT( (to_ServerStats(binary) == ServerStats()) );
+}
+
+}
+
+int UnitTestServerStats(int, char *[])
+{
+  state_test();
+  serialize_test();
+  older_peer_test();
+  bad_count_test();
+  return 0;
+}
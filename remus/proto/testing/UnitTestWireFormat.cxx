@@ -0,0 +1,372 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/Job.h>
+#include <remus/proto/JobBatch.h>
+#include <remus/proto/JobResult.h>
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/JobSubmission.h>
+#include <remus/proto/JobUpload.h>
+#include <remus/proto/JobWait.h>
+#include <remus/proto/ResultStream.h>
+#include <remus/proto/ServerStats.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/proto/zmqHelper.h>
+#include <remus/worker/Job.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/uuid/random_generator.hpp>
+
+namespace {
+using namespace remus::common;
+using namespace remus::proto;
+
+boost::uuids::random_generator generator;
+
+JobRequirements make_Reqs()
+{
+  JobRequirements reqs(ContentFormat::XML,
+                       MeshIOType(remus::meshtypes::Edges(),
+                                  remus::meshtypes::Mesh2D()),
+                       "worker",
+                       remus::testing::BinaryDataGenerator(1024));
+  reqs.tag("tag");
+  return reqs;
+}
+
+JobSubmission make_Submission()
+{
+  JobSubmission sub(make_Reqs());
+  sub["binary"] = make_JobContent(remus::testing::BinaryDataGenerator(4096),
+                                  ContentFormat::BSON);
+  sub["text"] = make_JobContent(std::string("with\nnew\nlines\n"));
+  sub["file"] = make_JobContent(FileHandle("/tmp/file.txt"));
+  sub["empty"] = make_JobContent(std::string());
+  sub["text"].tag("a tag");
+  return sub;
+}
+
+//every strictly shorter version of a binary message, with the header
+//rewritten to match so that decoding runs out of data inside the body
+std::vector<std::string> truncations(const std::string& binary)
+{
+  std::vector<std::string> result;
+  for(std::size_t i=remus::internal::BinaryHeaderSize; i < binary.size(); ++i)
+    {
+    std::string shorter = binary.substr(0,i);
+    remus::internal::BinaryWriter writer(&shorter[0]);
+    writer.putHeader(i - remus::internal::BinaryHeaderSize);
+    result.push_back(shorter);
+    }
+  return result;
+}
+
+}
+
+void verify_little_endian()
+{
+  char buffer[12];
+  remus::internal::BinaryWriter writer(buffer);
+  writer.putUInt32(0x01020304);
+  writer.putUInt64(0x0102030405060708ULL);
+  REMUS_ASSERT( (writer.size() == 12) );
+  REMUS_ASSERT( (buffer[0] == 0x04 && buffer[3] == 0x01) );
+  REMUS_ASSERT( (buffer[4] == 0x08 && buffer[11] == 0x01) );
+
+  //a writer without a buffer only counts
+  remus::internal::BinaryWriter counter;
+  counter.putString("four");
+  REMUS_ASSERT( (counter.size() == 12) );
+}
+
+void verify_detection()
+{
+  JobSubmission sub = make_Submission();
+  const std::string text = to_string(sub);
+  const std::string binary = to_binary(sub);
+
+  REMUS_ASSERT( (wire_format(text.data(),text.size()) == WireFormat::Text) );
+  REMUS_ASSERT( (wire_format(binary.data(),binary.size()) ==
+                 WireFormat::Binary) );
+  REMUS_ASSERT( (wire_format(NULL,0) == WireFormat::Text) );
+
+  //both encodings decode through the same functions
+  REMUS_ASSERT( (to_JobSubmission(text) == sub) );
+  REMUS_ASSERT( (to_JobSubmission(binary) == sub) );
+  REMUS_ASSERT( (to_JobSubmission(binary.data(),binary.size()) == sub) );
+
+  REMUS_ASSERT( (to_wire(sub,WireFormat::Text) == text) );
+  REMUS_ASSERT( (to_wire(sub,WireFormat::Binary) == binary) );
+}
+
+void verify_round_trips()
+{
+  const JobRequirements reqs = make_Reqs();
+  const std::string breqs = to_binary(reqs);
+  REMUS_ASSERT( (breqs.size() == remus::internal::binary_size(reqs)) );
+  const JobRequirements reqs2 = to_JobRequirements(breqs);
+  REMUS_ASSERT( (reqs2 == reqs) );
+  REMUS_ASSERT( (reqs2.tag() == reqs.tag()) );
+  REMUS_ASSERT( (reqs2.workerName() == reqs.workerName()) );
+  REMUS_ASSERT( (reqs2.sourceType() == reqs.sourceType()) );
+
+  const JobContent content = make_JobContent(FileHandle("/tmp/a"));
+  REMUS_ASSERT( (to_JobContent(to_binary(content)) == content) );
+
+  const JobSubmission sub = make_Submission();
+  const JobSubmission sub2 = to_JobSubmission(to_binary(sub));
+  REMUS_ASSERT( (sub2 == sub) );
+  REMUS_ASSERT( (sub2.type() == sub.type()) );
+  REMUS_ASSERT( (sub2.find("text")->second.tag() == "a tag") );
+  REMUS_ASSERT( (sub2.find("empty")->second.dataSize() == 0) );
+
+  const JobStatus status(generator(),JobProgress(50,"half\nway"));
+  const JobStatus status2 = to_JobStatus(to_binary(status));
+  REMUS_ASSERT( (status2 == status) );
+
+  const JobStatus failed = make_FailedJobStatus(generator(),"failed");
+  REMUS_ASSERT( (to_JobStatus(to_binary(failed)) == failed) );
+
+  const JobResult result = make_JobResult(generator(),
+                                 remus::testing::BinaryDataGenerator(2048),
+                                 ContentFormat::BSON);
+  const JobResult result2 = to_JobResult(to_binary(result));
+  REMUS_ASSERT( (result2 == result) );
+  REMUS_ASSERT( (result2.data() == result.data()) );
+  REMUS_ASSERT( (result2.formatType() == result.formatType()) );
+
+  const Job job(generator(),sub.type());
+  const Job job2 = to_Job(to_binary(job));
+  REMUS_ASSERT( (job2.id() == job.id()) );
+  REMUS_ASSERT( (job2.type() == job.type()) );
+
+  const remus::worker::Job wjob(generator(),sub);
+  const std::string bwjob = to_binary(wjob);
+  const remus::worker::Job wjob2 =
+    remus::worker::to_Job(bwjob.data(),static_cast<int>(bwjob.size()));
+  REMUS_ASSERT( (wjob2.id() == wjob.id()) );
+  REMUS_ASSERT( (wjob2.submission() == wjob.submission()) );
+  REMUS_ASSERT( wjob2.valid() );
+}
+
+void verify_zmq_message()
+{
+  const JobSubmission sub = make_Submission();
+
+  //the message is sized to exactly hold the encoding
+  zmq::message_t msg;
+  zmq::to_wire(sub,WireFormat::Binary,msg);
+  REMUS_ASSERT( (msg.size() == remus::internal::binary_size(sub)) );
+  const JobSubmission sub2 =
+    to_JobSubmission(static_cast<const char*>(msg.data()),msg.size());
+  REMUS_ASSERT( (sub2 == sub) );
+
+  zmq::message_t text;
+  zmq::to_wire(sub,WireFormat::Text,text);
+  REMUS_ASSERT( (std::string(static_cast<const char*>(text.data()),
+                             text.size()) == to_string(sub)) );
+}
+
+void verify_bad_data()
+{
+  const JobResult result = make_JobResult(generator(),std::string("result"));
+  std::string binary = to_binary(result);
+
+  //truncated messages fail to decode instead of reading past the end
+  for(std::size_t i=remus::internal::BinaryHeaderSize; i < binary.size(); ++i)
+    {
+    remus::internal::BinaryReader reader(binary.data(),i);
+    JobResult bad(reader);
+    REMUS_ASSERT( !reader.good() );
+    REMUS_ASSERT( (bad.data().size() < result.data().size()) );
+    }
+
+  //a version newer than we understand is rejected
+  std::string newer = binary;
+  newer[4] = static_cast<char>(remus::internal::BinaryVersion + 1);
+  remus::internal::BinaryReader newerReader(newer.data(),newer.size());
+  REMUS_ASSERT( !newerReader.good() );
+
+  //a length that claims more data than there is is rejected
+  std::string longer = binary;
+  longer[5] = static_cast<char>(binary.size());
+  remus::internal::BinaryReader longerReader(longer.data(),longer.size());
+  REMUS_ASSERT( !longerReader.good() );
+
+  remus::internal::BinaryReader reader(binary.data(),binary.size());
+  JobResult good(reader);
+  REMUS_ASSERT( reader.good() );
+  REMUS_ASSERT( (good.data() == result.data()) );
+}
+
+void verify_truncated_messages()
+{
+  //each decoder returns its invalid or default object for a message whose
+  //body is cut short, instead of a partially decoded one
+  const JobSubmission sub = make_Submission();
+  const Job job(generator(),sub.type());
+  std::vector<std::string> t;
+
+  t = truncations(to_binary(make_Reqs()));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( (to_JobRequirements(t[i]) == JobRequirements()) );
+    REMUS_ASSERT( (to_JobRequirements(t[i].data(),
+                       static_cast<int>(t[i].size())) == JobRequirements()) );
+    }
+
+  t = truncations(to_binary(make_JobContent(std::string("content"))));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( (to_JobContent(t[i]) == JobContent()) );
+    REMUS_ASSERT( (to_JobContent(t[i].data(),t[i].size(),
+                       boost::shared_ptr<const void>()) == JobContent()) );
+    }
+
+  t = truncations(to_binary(sub));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( (to_JobSubmission(t[i]) == JobSubmission()) );
+    REMUS_ASSERT( (to_JobSubmission(t[i].data(),t[i].size()) ==
+                   JobSubmission()) );
+    }
+
+  t = truncations(to_binary(job));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( !to_Job(t[i]).valid() );
+    REMUS_ASSERT( !to_Job(t[i].data(),t[i].size()).valid() );
+    }
+
+  //a status that ends before its timestamps is a status from a peer that
+  //doesn't send them, so it is the one truncation that stays valid
+  const JobStatus status(generator(),remus::IN_PROGRESS);
+  const std::size_t withoutTimestamps =
+                      to_binary(status).size() - 4 * sizeof(boost::uint64_t);
+  t = truncations(to_binary(status));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    if(t[i].size() == withoutTimestamps)
+      {
+      REMUS_ASSERT( (to_JobStatus(t[i]) == status) );
+      continue;
+      }
+    REMUS_ASSERT( !to_JobStatus(t[i]).valid() );
+    REMUS_ASSERT( !to_JobStatus(t[i].data(),t[i].size()).valid() );
+    }
+
+  t = truncations(to_binary(make_JobResult(generator(),std::string("r"))));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( !to_JobResult(t[i]).valid() );
+    REMUS_ASSERT( !to_JobResult(t[i].data(),t[i].size()).valid() );
+    }
+
+  t = truncations(to_binary(JobWait(job,100,true)));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( !to_JobWait(t[i].data(),t[i].size()).job().valid() );
+    }
+
+  ServerStats stats;
+  stats.JobsQueued = 3;
+  t = truncations(to_binary(stats));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( (to_ServerStats(t[i].data(),t[i].size()).JobsQueued == 0) );
+    }
+
+  t = truncations(to_binary(JobSubmissionBatch(
+                    JobSubmissionBatch::ContainerType(2,sub))));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( to_JobSubmissionBatch(t[i]).Submissions.empty() );
+    }
+
+  t = truncations(to_binary(JobBatch(JobBatch::ContainerType(2,job))));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( to_JobBatch(t[i]).Jobs.empty() );
+    }
+
+  const std::string statuses = to_binary(JobStatusBatch(
+        JobStatusBatch::ContainerType(2,JobStatus(job.id(),remus::QUEUED))));
+  t = truncations(statuses);
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    if(t[i].size() == statuses.size() - 4 * sizeof(boost::uint64_t))
+      {
+      REMUS_ASSERT( (to_JobStatusBatch(t[i]).Statuses.size() == 2) );
+      continue;
+      }
+    REMUS_ASSERT( to_JobStatusBatch(t[i]).Statuses.empty() );
+    }
+
+  JobUpload upload(make_Reqs());
+  upload.add(JobUpload::Entry("key",ContentFormat::BSON,"tag",16,""));
+  t = truncations(to_binary(upload));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( to_JobUpload(t[i]).entries().empty() );
+    }
+
+  JobUploadReply reply(job);
+  reply.addMissing("key");
+  t = truncations(to_binary(reply));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( !to_JobUploadReply(t[i]).job().valid() );
+    }
+
+  const std::string data("chunk");
+  t = truncations(to_binary(JobUploadChunk(generator(),"key",0,
+                                           data.data(),data.size())));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( !to_JobUploadChunk(t[i]).valid() );
+    }
+
+  t = truncations(to_binary(ResultStreamRequest(job,1024,4)));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( !to_ResultStreamRequest(t[i]).job().valid() );
+    }
+
+  t = truncations(to_binary(ResultChunk(job.id(),ContentFormat::User,64,0)));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    REMUS_ASSERT( !to_ResultChunk(t[i]).valid() );
+    }
+
+  //a worker job also reports itself invalid when built from the reader
+  t = truncations(to_binary(remus::worker::Job(generator(),sub)));
+  for(std::size_t i=0; i < t.size(); ++i)
+    {
+    remus::internal::BinaryReader reader(t[i].data(),t[i].size());
+    REMUS_ASSERT( !remus::worker::Job(reader).valid() );
+    REMUS_ASSERT( !remus::worker::to_Job(t[i]).valid() );
+    REMUS_ASSERT( !remus::worker::to_Job(t[i].data(),
+                                  static_cast<int>(t[i].size())).valid() );
+    }
+}
+
+int UnitTestWireFormat(int, char *[])
+{
+  verify_little_endian();
+  verify_detection();
+  verify_round_trips();
+  verify_zmq_message();
+  verify_bad_data();
+  verify_truncated_messages();
+  return 0;
+}
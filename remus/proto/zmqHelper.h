@@ -17,10 +17,12 @@
 #include <cstddef>
 #include <sstream>
 #include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
 
 //We now provide our own zmq.hpp since it has been removed from zmq 3, and
 //made its own project
 #include <remus/proto/zmq.hpp>
+#include <remus/proto/WireFormat.h>
 #include <remus/proto/zmqSocketIdentity.h>
 #include <remus/proto/zmqSocketInfo.h>
 
@@ -138,10 +140,66 @@ inline bool recv_harder(zmq::socket_t& socket, zmq::message_t* message, int flag
   return recieved;
 }
 
+//returns true if the socket has a message that can be read
+//without blocking
+inline bool have_message(zmq::socket_t& socket)
+{
+  int events = 0;
+  std::size_t eventsSize = sizeof(events);
+  socket.getsockopt(ZMQ_EVENTS,&events,&eventsSize);
+  return (events & ZMQ_POLLIN) != 0;
+}
+
+//binary encode t directly into the message, which is resized to exactly
+//fit so the encoded data is never copied
+template<typename T>
+inline void to_binary(const T& t, zmq::message_t& message)
+{
+  const std::size_t size = remus::internal::binary_size(t);
+  message.rebuild(size);
+  remus::internal::write_binary(t, static_cast<char*>(message.data()), size);
+}
+
+//free function for view_message, releases the owner of the memory
+inline void release_view(void*, void* hint)
+{
+  delete static_cast< boost::shared_ptr<const void>* >(hint);
+}
+
+//make the message send the given memory without copying it. The message
+//holds a reference to the owner until zmq is done sending the memory
+inline void view_message(zmq::message_t& message,
+                         const char* data, std::size_t size,
+                         const boost::shared_ptr<const void>& owner)
+{
+  //zmq only reads from the memory, it just doesn't take a const pointer
+  message.rebuild(const_cast<char*>(data), size, &release_view,
+                  new boost::shared_ptr<const void>(owner));
+}
+
+//encode t with the given wire format into the message
+template<typename T>
+inline void to_wire(const T& t, remus::proto::WireFormat::Type format,
+                    zmq::message_t& message)
+{
+  if(format == remus::proto::WireFormat::Binary)
+    {
+    zmq::to_binary(t,message);
+    }
+  else
+    {
+    const std::string buffer = to_string(t);
+    message.rebuild(buffer.size());
+    std::copy(buffer.begin(), buffer.end(),
+              static_cast<char*>(message.data()));
+    }
+}
+
 //we presume that every message needs to be stripped
 //as we make everything act like a req/rep and pad
-//a null message on everything
-inline void removeReqHeader(zmq::socket_t& socket)
+//a null message on everything. Returns the contents of the header,
+//which a dealer uses to carry the id of the request it belongs to
+inline std::string removeReqHeader(zmq::socket_t& socket)
 {
   int socketType;
   std::size_t socketTypeSize = sizeof(socketType);
@@ -150,18 +208,25 @@ inline void removeReqHeader(zmq::socket_t& socket)
     {
     zmq::message_t reqHeader;
     socket.recv(&reqHeader);
+    return std::string(static_cast<const char*>(reqHeader.data()),
+                       reqHeader.size());
     }
+  return std::string();
 }
 
-//if we are not a req or rep socket make us look like one
- inline void attachReqHeader(zmq::socket_t& socket)
+//if we are not a req or rep socket make us look like one, a non empty
+//header lets the peer match the reply to its request
+inline void attachReqHeader(zmq::socket_t& socket,
+                            const std::string& header = std::string())
 {
   int socketType;
   std::size_t socketTypeSize = sizeof(socketType);
   socket.getsockopt(ZMQ_TYPE,&socketType,&socketTypeSize);
   if(socketType != ZMQ_REQ && socketType != ZMQ_REP)
     {
-    zmq::message_t reqHeader(0);
+    zmq::message_t reqHeader(header.size());
+    std::copy(header.begin(), header.end(),
+              static_cast<char*>(reqHeader.data()));
     socket.send(reqHeader,ZMQ_SNDMORE);
     }
 }
@@ -12,6 +12,8 @@
 #ifndef remus_proto_zmqSocketIdentity_h
 #define remus_proto_zmqSocketIdentity_h
 
+#include <boost/functional/hash.hpp>
+
 #include <algorithm>
 #include <cstddef>
 #include <string>
@@ -62,6 +64,12 @@ inline std::string to_string(const zmq::SocketIdentity& add)
   return std::string(add.data(),add.size());
 }
 
+//allows a SocketIdentity to be the key of boost unordered containers
+inline std::size_t hash_value(const zmq::SocketIdentity& add)
+{
+  return boost::hash_range(add.data(),add.data()+add.size());
+}
+
 }
 
 #endif // remus_proto_zmqSocketIdentity_h
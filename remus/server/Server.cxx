@@ -26,26 +26,44 @@
 #include <boost/uuid/uuid.hpp>
 
 #include <remus/proto/Job.h>
+#include <remus/proto/JobBatch.h>
 #include <remus/proto/JobResult.h>
 #include <remus/proto/JobStatus.h>
+#include <remus/proto/JobUpload.h>
+#include <remus/proto/JobWait.h>
 #include <remus/proto/JobRequirements.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
+#include <remus/proto/ResultStream.h>
+#include <remus/proto/ServerStats.h>
 #include <remus/proto/zmqSocketIdentity.h>
 #include <remus/proto/zmqHelper.h>
 
 #include <remus/worker/Job.h>
 
+#include <remus/common/CpuTime.h>
 #include <remus/common/PollingMonitor.h>
 
 #include <remus/server/detail/uuidHelper.h>
 #include <remus/server/detail/ActiveJobs.h>
+#include <remus/server/detail/JobJournal.h>
 #include <remus/server/detail/JobQueue.h>
+#include <remus/server/detail/JobSubscriptions.h>
+#include <remus/server/detail/JobUploads.h>
+#include <remus/server/detail/JobWaiters.h>
+#include <remus/server/detail/ResultCache.h>
+#include <remus/server/detail/ResultStreams.h>
 #include <remus/server/detail/SocketMonitor.h>
 #include <remus/server/detail/WorkerPool.h>
 
+#include <algorithm>
 #include <set>
+#include <cstring>
 #include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <vector>
 
 
 //initialize the static instance variable in signal catcher in the class
@@ -104,7 +122,8 @@ struct ThreadManagement
   ThreadManagement():
     BrokerThread( new boost::thread() ),
     BrokeringStatus(),
-    BrokerIsRunning(false)
+    BrokerIsRunning(false),
+    StartTime( boost::posix_time::microsec_clock::local_time() )
   {
   }
 
@@ -133,6 +152,10 @@ struct ThreadManagement
     launchThread = !this->BrokerIsRunning;
     if(launchThread)
       {
+      //mark that we are brokering before the thread starts, otherwise
+      //the thread can see the old state and exit straight away
+      this->BrokerIsRunning = true;
+      this->StartTime = boost::posix_time::microsec_clock::local_time();
       boost::scoped_ptr<boost::thread> bthread(
         new  boost::thread(&Server::Brokering, server, sigHandleState) );
       this->BrokerThread.swap(bthread);
@@ -144,12 +167,19 @@ struct ThreadManagement
   //want to cause a recursive lock in the same thread to happen
   if(launchThread)
     {
-    this->setIsBrokering(true);
+    this->BrokerStatusChanged.notify_all();
     }
 
   return this->isBrokering();
   }
 
+  //----------------------------------------------------------------------------
+  //when brokering was last started
+  const boost::posix_time::ptime& startTime() const
+  {
+  return this->StartTime;
+  }
+
   //----------------------------------------------------------------------------
   void stop()
   {
@@ -183,6 +213,7 @@ private:
   boost::mutex BrokeringStatus;
   boost::condition_variable BrokerStatusChanged;
   bool BrokerIsRunning;
+  boost::posix_time::ptime StartTime;
 
   //----------------------------------------------------------------------------
   void setIsBrokering(bool t)
@@ -201,13 +232,179 @@ struct ZmqManagement
   zmq::socket_t ClientQueries;
   zmq::socket_t WorkerQueries;
 
+  //max number of messages to read from each socket per poll
+  unsigned int MaxMessagesPerPoll;
+
+  //replies to clients that are waiting for the journal to be committed
+  struct PendingReply
+  {
+    PendingReply(const boost::shared_ptr<remus::proto::Response>& reply,
+                 remus::SERVICE_TYPE service,
+                 const boost::posix_time::ptime& received):
+      Reply(reply),
+      Service(service),
+      Received(received)
+      {}
+
+    boost::shared_ptr<remus::proto::Response> Reply;
+    remus::SERVICE_TYPE Service;
+    boost::posix_time::ptime Received;
+  };
+  std::vector<PendingReply> UncommittedReplies;
+
+  //statuses of subscribed jobs that changed outside of ActiveJobs, such
+  //as queued jobs that were terminated, waiting to be published
+  std::vector<remus::proto::JobStatus> StatusNotifications;
+
   //----------------------------------------------------------------------------
   ZmqManagement( const remus::server::ServerPorts& ports ):
     ClientQueries(*(ports.context()),ZMQ_ROUTER),
-    WorkerQueries(*(ports.context()),ZMQ_ROUTER)
+    WorkerQueries(*(ports.context()),ZMQ_ROUTER),
+    MaxMessagesPerPoll(64),
+    UncommittedReplies(),
+    StatusNotifications()
   {}
 };
 
+//------------------------------------------------------------------------------
+//latency histograms for each service type of the client and worker sockets,
+//recorded by the broker thread
+struct StatsManagement
+{
+  //larger than the largest service type, unknown service types are
+  //recorded as INVALID_SERVICE
+  enum { NumberOfServices = 32 };
+
+  remus::proto::LatencyHistogram ClientLatencies[NumberOfServices];
+  remus::proto::LatencyHistogram WorkerLatencies[NumberOfServices];
+
+  //how long jobs spend in each stage of their life, see JobTimestamps
+  remus::proto::LatencyHistogram JobQueueTimes;
+  remus::proto::LatencyHistogram JobExecutionTimes;
+  remus::proto::LatencyHistogram JobRetrievalWaitTimes;
+
+  //when the client message being handled was received
+  boost::posix_time::ptime MessageReceived;
+
+  //where to write a report when brokering stops
+  std::string ReportPath;
+
+  //the cpu time of the broker thread when it started brokering
+  boost::int64_t BrokerCpuStart;
+
+  //----------------------------------------------------------------------------
+  StatsManagement():
+    MessageReceived(),
+    ReportPath(),
+    BrokerCpuStart(0)
+  {}
+
+  //----------------------------------------------------------------------------
+  static boost::posix_time::ptime now()
+  {
+  return boost::posix_time::microsec_clock::universal_time();
+  }
+
+  //----------------------------------------------------------------------------
+  static void record(remus::proto::LatencyHistogram* latencies,
+                     remus::SERVICE_TYPE service,
+                     const boost::posix_time::ptime& received)
+  {
+  const int index = static_cast<int>(service);
+  const boost::int64_t elapsed = (now() - received).total_microseconds();
+  latencies[(index > 0 && index < NumberOfServices) ? index : 0].record(
+            static_cast<boost::uint64_t>(std::max<boost::int64_t>(0,elapsed)));
+  }
+
+  //----------------------------------------------------------------------------
+  void recordClient(remus::SERVICE_TYPE service,
+                    const boost::posix_time::ptime& received)
+  {
+  record(this->ClientLatencies, service, received);
+  }
+
+  //----------------------------------------------------------------------------
+  void recordWorker(remus::SERVICE_TYPE service,
+                    const boost::posix_time::ptime& received)
+  {
+  record(this->WorkerLatencies, service, received);
+  }
+
+  //----------------------------------------------------------------------------
+  //record the time from a job timestamp until now, jobs that never
+  //reached the stage have no timestamp and aren't recorded
+  static void recordSince(remus::proto::LatencyHistogram& latencies,
+                          boost::int64_t timestamp)
+  {
+  if(timestamp > 0)
+    {
+    const boost::int64_t elapsed =
+                      remus::proto::JobTimestamps::now() - timestamp;
+    latencies.record(
+            static_cast<boost::uint64_t>(std::max<boost::int64_t>(0,elapsed)));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  static void copy(const remus::proto::LatencyHistogram* latencies,
+                   remus::proto::ServerStats::Latencies& result)
+  {
+  for(int i=0; i < NumberOfServices; ++i)
+    {
+    if(latencies[i].count() > 0)
+      {
+      result[static_cast<remus::SERVICE_TYPE>(i)] = latencies[i];
+      }
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+void write_latencies(std::ostream& report, const std::string& socket,
+                     const remus::proto::ServerStats::Latencies& latencies)
+{
+  typedef remus::proto::ServerStats::Latencies::const_iterator It;
+  for(It i=latencies.begin(); i != latencies.end(); ++i)
+    {
+    const remus::proto::LatencyHistogram& h = i->second;
+    report << std::left << std::setw(7) << socket
+           << std::setw(22) << remus::to_string(i->first) << std::right
+           << std::setw(10) << h.count()
+           << std::setw(12) << static_cast<boost::uint64_t>(h.mean())
+           << std::setw(12) << h.percentile(50)
+           << std::setw(12) << h.percentile(90)
+           << std::setw(12) << h.percentile(99)
+           << std::setw(12) << h.maximum() << std::endl;
+    }
+}
+
+//------------------------------------------------------------------------------
+void write_statsReport(std::ostream& report,
+                       const remus::proto::ServerStats& stats)
+{
+  report << "uptime ms: " << stats.Uptime << std::endl;
+  report << "jobs submitted: " << stats.JobsSubmittedTotal << std::endl;
+  report << "jobs dispatched: " << stats.JobsDispatchedTotal << std::endl;
+  report << "jobs reclaimed: " << stats.JobsReclaimedTotal << std::endl;
+  report << "jobs held: " << stats.JobsQueued + stats.JobsWaitingForWorkers
+         << " queued, " << stats.JobsActive << " active, "
+         << stats.JobsFinished << " finished, "
+         << stats.JobsFailed << " failed" << std::endl;
+  report << "result bytes: " << stats.ResultBytesInMemory << " in memory, "
+         << stats.ResultBytesOnDisk << " on disk" << std::endl;
+  report << std::endl;
+  report << "latencies in microseconds" << std::endl;
+  report << std::left << std::setw(7) << "socket"
+         << std::setw(22) << "service" << std::right
+         << std::setw(10) << "count"
+         << std::setw(12) << "mean"
+         << std::setw(12) << "p50"
+         << std::setw(12) << "p90"
+         << std::setw(12) << "p99"
+         << std::setw(12) << "max" << std::endl;
+  write_latencies(report, "client", stats.ClientLatencies);
+  write_latencies(report, "worker", stats.WorkerLatencies);
+}
 
 }
 }
@@ -224,8 +421,15 @@ Server::Server():
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  Subscriptions( new remus::server::detail::JobSubscriptions() ),
+  Waiters( new remus::server::detail::JobWaiters() ),
+  ResultStreams( new remus::server::detail::ResultStreams() ),
+  Uploads( new remus::server::detail::JobUploads() ),
+  Memoized( new remus::server::detail::ResultCache() ),
+  Journal( new remus::server::detail::JobJournal() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
+  Stats( new detail::StatsManagement() ),
   WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() )
   {
   //attempts to bind to a tcp socket, with a prefered port number
@@ -243,8 +447,15 @@ Server::Server(const boost::shared_ptr<remus::server::WorkerFactory>& factory):
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  Subscriptions( new remus::server::detail::JobSubscriptions() ),
+  Waiters( new remus::server::detail::JobWaiters() ),
+  ResultStreams( new remus::server::detail::ResultStreams() ),
+  Uploads( new remus::server::detail::JobUploads() ),
+  Memoized( new remus::server::detail::ResultCache() ),
+  Journal( new remus::server::detail::JobJournal() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
+  Stats( new detail::StatsManagement() ),
   WorkerFactory( factory )
   {
   //attempts to bind to a tcp socket, with a prefered port number
@@ -262,8 +473,15 @@ Server::Server(const remus::server::ServerPorts& ports):
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  Subscriptions( new remus::server::detail::JobSubscriptions() ),
+  Waiters( new remus::server::detail::JobWaiters() ),
+  ResultStreams( new remus::server::detail::ResultStreams() ),
+  Uploads( new remus::server::detail::JobUploads() ),
+  Memoized( new remus::server::detail::ResultCache() ),
+  Journal( new remus::server::detail::JobJournal() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
+  Stats( new detail::StatsManagement() ),
   WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() )
   {
   //attempts to bind to a tcp socket, with a prefered port number
@@ -282,8 +500,43 @@ Server::Server(const remus::server::ServerPorts& ports,
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
   WorkerPool( new remus::server::detail::WorkerPool() ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  Subscriptions( new remus::server::detail::JobSubscriptions() ),
+  Waiters( new remus::server::detail::JobWaiters() ),
+  ResultStreams( new remus::server::detail::ResultStreams() ),
+  Uploads( new remus::server::detail::JobUploads() ),
+  Memoized( new remus::server::detail::ResultCache() ),
+  Journal( new remus::server::detail::JobJournal() ),
+  UUIDGenerator( new detail::UUIDManagement() ),
+  Thread( new detail::ThreadManagement() ),
+  Stats( new detail::StatsManagement() ),
+  WorkerFactory( factory )
+  {
+  //attempts to bind to a tcp socket, with a prefered port number
+  this->PortInfo.bindClient(&this->Zmq->ClientQueries);
+  this->PortInfo.bindWorker(&this->Zmq->WorkerQueries);
+  //give to the worker factory the endpoint information needed to connect to myself
+  this->WorkerFactory->addCommandLineArgument(this->PortInfo.worker().endpoint());
+  }
+
+//------------------------------------------------------------------------------
+Server::Server(const remus::server::ServerPorts& ports,
+               const boost::shared_ptr<remus::server::WorkerFactory>& factory,
+               const remus::server::JobJournaling& journaling):
+  PortInfo( ports ),
+  Zmq( new detail::ZmqManagement(ports) ),
+  QueuedJobs( new remus::server::detail::JobQueue() ),
+  SocketMonitor( new remus::server::detail::SocketMonitor() ),
+  WorkerPool( new remus::server::detail::WorkerPool() ),
+  ActiveJobs( new remus::server::detail::ActiveJobs () ),
+  Subscriptions( new remus::server::detail::JobSubscriptions() ),
+  Waiters( new remus::server::detail::JobWaiters() ),
+  ResultStreams( new remus::server::detail::ResultStreams() ),
+  Uploads( new remus::server::detail::JobUploads() ),
+  Memoized( new remus::server::detail::ResultCache() ),
+  Journal( new remus::server::detail::JobJournal() ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
+  Stats( new detail::StatsManagement() ),
   WorkerFactory( factory )
   {
   //attempts to bind to a tcp socket, with a prefered port number
@@ -291,6 +544,8 @@ Server::Server(const remus::server::ServerPorts& ports,
   this->PortInfo.bindWorker(&this->Zmq->WorkerQueries);
   //give to the worker factory the endpoint information needed to connect to myself
   this->WorkerFactory->addCommandLineArgument(this->PortInfo.worker().endpoint());
+
+  this->RecoverJournaledJobs(journaling);
   }
 
 //------------------------------------------------------------------------------
@@ -320,6 +575,120 @@ remus::server::PollingRates Server::pollingRates() const
   return remus::server::PollingRates(low,high);
 }
 
+//------------------------------------------------------------------------------
+void Server::messageBatchSize(const remus::server::MessageBatchSize& size)
+{
+  this->Zmq->MaxMessagesPerPoll = std::max(size.maxMessages(), 1u);
+}
+
+//------------------------------------------------------------------------------
+remus::server::MessageBatchSize Server::messageBatchSize() const
+{
+  return remus::server::MessageBatchSize(this->Zmq->MaxMessagesPerPoll);
+}
+
+//------------------------------------------------------------------------------
+void Server::resultStorage(const remus::server::ResultStorage& storage)
+{
+  this->ActiveJobs->results().scratchDirectory(storage.scratchDirectory());
+  this->ActiveJobs->results().memoryBudget(storage.memoryBudget());
+}
+
+//------------------------------------------------------------------------------
+remus::server::ResultStorage Server::resultStorage() const
+{
+  const detail::ResultStore& results = this->ActiveJobs->results();
+  return remus::server::ResultStorage(results.memoryBudget(),
+                                      results.scratchDirectory());
+}
+
+//------------------------------------------------------------------------------
+void Server::blobStorage(const remus::server::BlobStorage& storage)
+{
+  detail::BlobStore& blobs = this->Uploads->blobs();
+  blobs.scratchDirectory(storage.scratchDirectory());
+  blobs.diskBudget(storage.diskBudget());
+  blobs.memoryBudget(storage.memoryBudget());
+}
+
+//------------------------------------------------------------------------------
+remus::server::BlobStorage Server::blobStorage() const
+{
+  const detail::BlobStore& blobs = this->Uploads->blobs();
+  return remus::server::BlobStorage(blobs.memoryBudget(),
+                                    blobs.diskBudget(),
+                                    blobs.scratchDirectory());
+}
+
+//------------------------------------------------------------------------------
+void Server::resultMemoization(const remus::server::ResultMemoization& memo)
+{
+  this->Memoized->enabled(memo.enabled());
+  this->Memoized->capacity(memo.cacheSize());
+  this->Memoized->exclude(memo.excluded());
+}
+
+//------------------------------------------------------------------------------
+remus::server::ResultMemoization Server::resultMemoization() const
+{
+  remus::server::ResultMemoization memo(this->Memoized->enabled(),
+                                        this->Memoized->capacity());
+  typedef remus::proto::JobRequirementsSet::const_iterator it;
+  for(it i = this->Memoized->excluded().begin();
+      i != this->Memoized->excluded().end(); ++i)
+    {
+    memo.exclude(*i);
+    }
+  return memo;
+}
+
+//------------------------------------------------------------------------------
+void Server::jobTimeToLive(const remus::server::JobTimeToLive& ttl)
+{
+  this->ActiveJobs->timeToLive(remus::FINISHED, ttl.finished());
+  this->ActiveJobs->timeToLive(remus::FAILED, ttl.failed());
+  this->ActiveJobs->timeToLive(remus::EXPIRED, ttl.expired());
+}
+
+//------------------------------------------------------------------------------
+remus::server::JobTimeToLive Server::jobTimeToLive() const
+{
+  return remus::server::JobTimeToLive(
+                            this->ActiveJobs->timeToLive(remus::FINISHED),
+                            this->ActiveJobs->timeToLive(remus::FAILED),
+                            this->ActiveJobs->timeToLive(remus::EXPIRED));
+}
+
+//------------------------------------------------------------------------------
+bool Server::isJournaling() const
+{
+  return this->Journal->isOpen();
+}
+
+//------------------------------------------------------------------------------
+void Server::statsReport(const std::string& path)
+{
+  this->Stats->ReportPath = path;
+}
+
+//------------------------------------------------------------------------------
+std::string Server::statsReport() const
+{
+  return this->Stats->ReportPath;
+}
+
+//------------------------------------------------------------------------------
+void Server::heartbeatCheckInterval(boost::int64_t millisec)
+{
+  this->SocketMonitor->heartbeatCheckInterval(millisec);
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t Server::heartbeatCheckInterval() const
+{
+  return this->SocketMonitor->heartbeatCheckInterval();
+}
+
 //------------------------------------------------------------------------------
 bool Server::Brokering(Server::SignalHandling sh)
   {
@@ -341,26 +710,69 @@ bool Server::Brokering(Server::SignalHandling sh)
   //handle operating systems that throttle our polling.
   remus::common::PollingMonitor monitor = this->SocketMonitor->pollingMonitor();
 
+  //the cpu time of this thread is reported from here on
+  this->Stats->BrokerCpuStart = remus::common::ThreadCpuTimeInMicrosec();
+
   //keep track of current time since we last purged dead workers
-  //we want to clear every dead workers every 250ms.
+  //we want to clear every dead workers every check interval, which
+  //defaults to 250ms.
   boost::posix_time::ptime currentTime =
                             boost::posix_time::microsec_clock::local_time();
 
-  const boost::int64_t deadWorkersCheckInterval(250);
+  const boost::int64_t deadWorkersCheckInterval =
+                                this->SocketMonitor->heartbeatCheckInterval();
   boost::posix_time::ptime whenToCheckForDeadWorkers =
                       boost::posix_time::microsec_clock::local_time() +
                       boost::posix_time::milliseconds(deadWorkersCheckInterval);
 
+  //the number of messages to read from each socket per poll
+  const unsigned int maxMessagesPerPoll = this->Zmq->MaxMessagesPerPoll;
+
+  //the number of jobs past their time to live to remove per poll, kept
+  //small so a large number of jobs expiring at once doesn't stall the server
+  const std::size_t maxJobsCollectedPerPoll = 64;
+
+  //how long a result stream can wait on a client for more credit before
+  //we presume the client has gone away
+  const boost::posix_time::time_duration streamIdleTimeout =
+                                              boost::posix_time::minutes(5);
+
+  //how long an upload can go without a chunk before we presume the client
+  //has given up on it
+  const boost::posix_time::time_duration uploadIdleTimeout =
+                                              boost::posix_time::minutes(5);
+
   while (Thread->isBrokering())
     {
-    zmq::poll(&items[0], 2, static_cast<long>(monitor.current()) );
+    //wake up in time to answer the client whose wait runs out first
+    long pollTimeout = static_cast<long>(monitor.current());
+    if(!this->Waiters->empty())
+      {
+      const boost::posix_time::time_duration untilDeadline =
+                  this->Waiters->nextDeadline() -
+                  boost::posix_time::microsec_clock::local_time();
+      pollTimeout = std::max(0L, std::min(pollTimeout,
+                      static_cast<long>(untilDeadline.total_milliseconds()) + 1));
+      }
+    //don't wait at all when there are result chunks to send
+    if(this->ResultStreams->ready())
+      {
+      pollTimeout = 0;
+      }
+    zmq::poll(&items[0], 2, pollTimeout );
     monitor.pollOccurred();
 
     //update the current time
     currentTime = boost::posix_time::microsec_clock::local_time();
 
-    if (items[0].revents & ZMQ_POLLIN)
+    //drain each socket of pending messages, up to the batch size, so that
+    //a burst of messages is handled by a single matching pass
+    bool haveClientMessage = (items[0].revents & ZMQ_POLLIN) != 0;
+    for(unsigned int i=0; haveClientMessage && i < maxMessagesPerPoll; ++i)
       {
+      //latencies are measured from when we start reading the message
+      this->Stats->MessageReceived = detail::StatsManagement::now();
+
       //we need to strip the client address from the message
       zmq::SocketIdentity clientIdentity = zmq::address_recv(this->Zmq->ClientQueries);
 
@@ -368,9 +780,15 @@ bool Server::Brokering(Server::SignalHandling sh)
       //after the DetermineJobQueryResponse call
       remus::proto::Message message(&this->Zmq->ClientQueries);
       this->DetermineJobQueryResponse(clientIdentity,message); //NOTE: this will queue jobs
+
+      haveClientMessage = zmq::have_message(this->Zmq->ClientQueries);
       }
-    if (items[1].revents & ZMQ_POLLIN)
+
+    bool haveWorkerMessage = (items[1].revents & ZMQ_POLLIN) != 0;
+    for(unsigned int i=0; haveWorkerMessage && i < maxMessagesPerPoll; ++i)
       {
+      const boost::posix_time::ptime received = detail::StatsManagement::now();
+
       //a worker is registering
       //we need to strip the worker address from the message
       zmq::SocketIdentity workerIdentity = zmq::address_recv(this->Zmq->WorkerQueries);
@@ -378,34 +796,100 @@ bool Server::Brokering(Server::SignalHandling sh)
       //Note the contents of the message isn't valid
       //after the DetermineWorkerResponse call
       remus::proto::Message message(&this->Zmq->WorkerQueries);
+      const remus::SERVICE_TYPE service = message.serviceType();
       this->DetermineWorkerResponse(workerIdentity,message);
+      this->Stats->recordWorker(service, received);
       // std::cout << "w" << std::endl;
+
+      haveWorkerMessage = zmq::have_message(this->Zmq->WorkerQueries);
       }
 
-    //only purge dead workers every 250ms to reduce server load
+    //only purge dead workers every check interval to reduce server load
     if(whenToCheckForDeadWorkers <= currentTime)
       {
       // std::cout << "checking for dead workers" << std::endl;
+      //find the workers that have missed their heartbeat, or have died
+      //since we last checked
+      const remus::server::detail::SocketStateChanges changes =
+                                      this->SocketMonitor->checkHeartbeats();
+
       //mark all jobs whose worker haven't sent a heartbeat in time
       //as a job that failed.
-      this->ActiveJobs->markExpiredJobs((*this->SocketMonitor));
+      this->ActiveJobs->markExpiredJobs(changes);
+
+      //the jobs following a memoized job that expired expire with it
+      const std::vector<boost::uuids::uuid> leaders =
+                                              this->Memoized->leaders();
+      for(std::size_t i=0; i < leaders.size(); ++i)
+        {
+        this->updateFollowers(leaders[i]);
+        }
 
       //purge all pending workers with jobs that haven't sent a heartbeat
-      this->WorkerPool->purgeDeadWorkers((*this->SocketMonitor));
+      this->WorkerPool->purgeDeadWorkers(changes);
+
+      //remove any worker processes the factory created that have exited
+      this->WorkerFactory->updateWorkerCount();
+
+      //close the result streams of clients that have stopped reading them
+      this->ResultStreams->expire(currentTime - streamIdleTimeout);
+
+      //drop the uploads that clients have stopped sending chunks for
+      this->Uploads->expire(currentTime - uploadIdleTimeout);
+
+      //release the uploaded data that finished jobs no longer use
+      this->Uploads->blobs().collect();
+
+      //workers dying and worker processes exiting can only be found by
+      //polling, so reconsider every queued job now that we have checked.
+      //This also retries jobs the factory couldn't create a worker for
+      this->QueuedJobs->markAllRequirementsChanged();
 
       whenToCheckForDeadWorkers = currentTime +
                       boost::posix_time::milliseconds(deadWorkersCheckInterval);
       }
 
+    //remove jobs that clients haven't retrieved within their time to live
+    std::vector<boost::uuids::uuid> collected;
+    this->ActiveJobs->collectGarbage(currentTime, maxJobsCollectedPerPoll,
+                                     &collected);
+    for(std::size_t i=0; i < collected.size(); ++i)
+      {
+      this->Journal->removed(collected[i]);
+      }
+
     //see if we have a worker in the pool for the next job in the queue,
-    //otherwise as the factory to generat a new worker to handle that job
-    this->FindWorkerForQueuedJob();
+    //otherwise as the factory to generat a new worker to handle that job.
+    //We only do this when a job has been queued, a worker is ready for a
+    //job, or we have checked for dead workers, since nothing else can
+    //change what jobs can be matched
+    const bool needsMatching =
+                      this->QueuedJobs->changedRequirements().size() > 0 ||
+                      this->WorkerPool->changedRequirements().size() > 0;
+    if(needsMatching)
+      {
+      this->FindWorkerForQueuedJob();
+      }
+
+    //commit every change made this pass with a single write to the journal
+    this->CommitJournal();
+
+    //now that the changes are durable tell the subscribed clients
+    this->PublishStatusChanges();
+
+    this->SendResultChunks();
     }
 
   //this should only happen with interrupted threads be hit; lets make sure we close
   //down all workers.
   this->TerminateAllWorkers();
 
+  if(!this->Stats->ReportPath.empty())
+    {
+    std::ofstream report(this->Stats->ReportPath.c_str());
+    detail::write_statsReport(report, this->CollectStats());
+    }
+
   if(sh == CAPTURE)
     {
     this->StopCatchingSignals();
@@ -451,48 +935,105 @@ void Server::DetermineJobQueryResponse(const zmq::SocketIdentity& clientIdentity
   //msg.dump(std::cout);
   //server response is the general response message type
   //the client can than convert it to the expected type
-  remus::proto::Response response(clientIdentity);
+  boost::shared_ptr<remus::proto::Response> response =
+                    boost::make_shared<remus::proto::Response>(clientIdentity);
+  //echo the request id so a client with many requests in flight can
+  //match this response to the request it answers
+  response->requestId(msg.requestId());
   if(!msg.isValid())
     {
-    response.setServiceType(remus::INVALID_SERVICE);
-    response.setData( remus::INVALID_MSG );
-    response.send(&this->Zmq->ClientQueries);
+    response->setServiceType(remus::INVALID_SERVICE);
+    response->setData( remus::INVALID_MSG );
+    response->send(&this->Zmq->ClientQueries);
+    this->Stats->recordClient(remus::INVALID_SERVICE,
+                              this->Stats->MessageReceived);
     return; //no need to continue
     }
-  response.setServiceType(msg.serviceType());
+  response->setServiceType(msg.serviceType());
 
   //we have a valid job, determine what to do with it
   switch(msg.serviceType())
     {
     case remus::MAKE_MESH:
       // std::cout << "c MAKE_MESH" << std::endl;
-      response.setData(this->queueJob(msg));
+      response->setData(this->queueJob(msg));
       break;
     case remus::MESH_STATUS:
       // std::cout << "c MESH_STATUS" << std::endl;
-      response.setData(this->meshStatus(msg));
+      response->setData(this->meshStatus(msg));
       break;
     case remus::CAN_MESH:
       // std::cout << "c CAN_MESH" << std::endl;
-      response.setData(this->canMesh(msg));
+      response->setData(this->canMesh(msg));
       break;
     case remus::CAN_MESH_REQUIREMENTS:
       // std::cout << "c CAN_MESH_REQS" << std::endl;
-      response.setData(this->canMeshRequirements(msg));
+      response->setData(this->canMeshRequirements(msg));
       break;
     case remus::MESH_REQUIREMENTS:
-      response.setData(this->meshRequirements(msg));
+      response->setData(this->meshRequirements(msg));
       break;
     case remus::RETRIEVE_MESH:
-      response.setData(this->retrieveMesh(msg));
+      this->retrieveMesh(msg,*response);
       break;
     case remus::TERMINATE_JOB:
-      response.setData(this->terminateJob(msg));
+      response->setData(this->terminateJob(msg));
+      break;
+    case remus::SERVER_STATS:
+      response->setData(this->serverStats(msg));
+      break;
+    case remus::MAKE_MESH_BATCH:
+      response->setData(this->queueJobBatch(msg));
+      break;
+    case remus::UPLOAD_JOB:
+      response->setData(this->beginJobUpload(msg));
+      break;
+    case remus::UPLOAD_JOB_CHUNK:
+      response->setData(this->uploadJobChunk(msg));
+      break;
+    case remus::MESH_STATUS_BATCH:
+      response->setData(this->meshStatusBatch(msg));
+      break;
+    case remus::SUBSCRIBE_JOB_STATUS:
+      response->setData(this->subscribeToJobs(clientIdentity,msg));
+      break;
+    case remus::WAIT_FOR_JOB:
+      if(!this->waitForJob(clientIdentity,msg,*response))
+        {
+        //the reply is sent once the job can't change or the wait times
+        //out, so only the time to park the request is recorded
+        this->Stats->recordClient(msg.serviceType(),
+                                  this->Stats->MessageReceived);
+        return;
+        }
+      break;
+    case remus::STREAM_RESULT:
+      if(!this->streamResult(clientIdentity,msg,*response))
+        {
+        //the result is sent in chunks by SendResultChunks
+        this->Stats->recordClient(msg.serviceType(),
+                                  this->Stats->MessageReceived);
+        return;
+        }
       break;
     default:
-      response.setData( remus::to_string(remus::INVALID_STATUS) );
+      response->setData( remus::to_string(remus::INVALID_STATUS) );
+    }
+
+  //a client mustn't be told about a change to its jobs that would be lost
+  //if the server died, so once anything is waiting on the journal every
+  //reply waits for the next commit, which also keeps the replies in order
+  if(this->Journal->hasUncommitted())
+    {
+    this->Zmq->UncommittedReplies.push_back(
+          detail::ZmqManagement::PendingReply(response, msg.serviceType(),
+                                              this->Stats->MessageReceived));
+    }
+  else
+    {
+    response->send(&this->Zmq->ClientQueries);
+    this->Stats->recordClient(msg.serviceType(), this->Stats->MessageReceived);
     }
-  response.send(&this->Zmq->ClientQueries);
   return;
 }
 
@@ -557,51 +1098,340 @@ std::string Server::meshRequirements(const remus::proto::Message& msg)
 std::string Server::meshStatus(const remus::proto::Message& msg)
 {
   remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
-  remus::proto::JobStatus js(job.id(),remus::INVALID_STATUS);
-  if(this->QueuedJobs->haveUUID(job.id()))
+  //answer in the wire format the client asked with
+  return remus::proto::to_wire(this->currentStatus(job.id()),
+            remus::proto::wire_format(msg.data(),msg.dataSize()));
+}
+
+//------------------------------------------------------------------------------
+std::string Server::meshStatusBatch(const remus::proto::Message& msg)
+{
+  const remus::proto::JobBatch jobs =
+                  remus::proto::to_JobBatch(msg.data(),msg.dataSize());
+
+  remus::proto::JobStatusBatch statuses;
+  statuses.Statuses.reserve(jobs.Jobs.size());
+  for(std::size_t i=0; i < jobs.Jobs.size(); ++i)
     {
-    js = remus::proto::JobStatus(job.id(),remus::QUEUED);
+    statuses.Statuses.push_back( this->currentStatus(jobs.Jobs[i].id()) );
     }
-  else if(this->ActiveJobs->haveUUID(job.id()))
+  return remus::proto::to_wire(statuses,
+            remus::proto::wire_format(msg.data(),msg.dataSize()));
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus Server::currentStatus(const boost::uuids::uuid& id)
+{
+  remus::proto::JobStatus js(id,remus::INVALID_STATUS);
+  if(this->QueuedJobs->haveUUID(id))
+    {
+    js = remus::proto::JobStatus(id,remus::QUEUED);
+    remus::proto::JobTimestamps times;
+    times.Queued = this->QueuedJobs->queuedTime(id);
+    js.updateTimestamps(times);
+    }
+  else if(this->ActiveJobs->haveUUID(id))
     {
-    js = this->ActiveJobs->status(job.id());
+    js = this->ActiveJobs->status(id);
     }
-  return remus::proto::to_string(js);
+  return js;
 }
 
 //------------------------------------------------------------------------------
 std::string Server::queueJob(const remus::proto::Message& msg)
 {
-  //generate an UUID
+  //create a new job to place on the queue, the job content views into
+  //the received message so the mesh data isn't copied
+  const remus::proto::JobSubmission submission =
+                  remus::proto::to_JobSubmission(msg.data(),msg.dataSize(),
+                                                 msg.dataOwner());
+
+  const remus::proto::Job validJob(this->queueSubmission(submission).id(),
+                                   msg.MeshIOType());
+  return remus::proto::to_wire(validJob,
+            remus::proto::wire_format(msg.data(),msg.dataSize()));
+}
+
+//------------------------------------------------------------------------------
+std::string Server::queueJobBatch(const remus::proto::Message& msg)
+{
+  //every job content views into the one received message
+  const remus::proto::JobSubmissionBatch submissions =
+        remus::proto::to_JobSubmissionBatch(msg.data(),msg.dataSize(),
+                                            msg.dataOwner());
+
+  remus::proto::JobBatch jobs;
+  jobs.Jobs.reserve(submissions.Submissions.size());
+  for(std::size_t i=0; i < submissions.Submissions.size(); ++i)
+    {
+    jobs.Jobs.push_back(
+                  this->queueSubmission(submissions.Submissions[i]) );
+    }
+  return remus::proto::to_wire(jobs,
+            remus::proto::wire_format(msg.data(),msg.dataSize()));
+}
+
+//------------------------------------------------------------------------------
+std::string Server::beginJobUpload(const remus::proto::Message& msg)
+{
+  const remus::proto::JobUpload upload =
+                  remus::proto::to_JobUpload(msg.data(),msg.dataSize());
+
+  //the job gets its id now, so the chunks can say which upload they
+  //belong to, but it is only queued once all of its data has arrived
   const boost::uuids::uuid jobUUID = (*this->UUIDGenerator)();
+  const std::vector<std::string> missing = this->Uploads->begin(jobUUID,
+                      upload, boost::posix_time::microsec_clock::local_time());
+  if(!this->Uploads->have(jobUUID))
+    {
+    //the upload describes more data than we accept
+    return remus::proto::to_wire(remus::proto::JobUploadReply(),
+              remus::proto::wire_format(msg.data(),msg.dataSize()));
+    }
+  if(this->Uploads->complete(jobUUID))
+    {
+    this->queueSubmission(jobUUID, this->Uploads->take(jobUUID));
+    }
 
-  //create a new job to place on the queue
-  const remus::proto::JobSubmission submission =
-                  remus::proto::to_JobSubmission(msg.data(),msg.dataSize());
+  remus::proto::JobUploadReply reply(
+                            remus::proto::Job(jobUUID, upload.type()));
+  for(std::size_t i=0; i < missing.size(); ++i)
+    {
+    reply.addMissing(missing[i]);
+    }
+  return remus::proto::to_wire(reply,
+            remus::proto::wire_format(msg.data(),msg.dataSize()));
+}
+
+//------------------------------------------------------------------------------
+std::string Server::uploadJobChunk(const remus::proto::Message& msg)
+{
+  //the chunk views into the received message, and is copied once into
+  //the data being assembled
+  const remus::proto::JobUploadChunk chunk =
+        remus::proto::to_JobUploadChunk(msg.data(),msg.dataSize(),
+                                        msg.dataOwner());
+
+  const bool accepted = this->Uploads->write(chunk,
+                              boost::posix_time::microsec_clock::local_time());
+  if(accepted && this->Uploads->complete(chunk.id()))
+    {
+    this->queueSubmission(chunk.id(), this->Uploads->take(chunk.id()));
+    }
+
+  std::ostringstream buffer;
+  buffer << accepted;
+  return buffer.str();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job
+Server::queueSubmission(const remus::proto::JobSubmission& submission)
+{
+  //generate an UUID
+  return this->queueSubmission((*this->UUIDGenerator)(), submission);
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job
+Server::queueSubmission(const boost::uuids::uuid& jobUUID,
+                        const remus::proto::JobSubmission& submission)
+{
+  this->Journal->queued(jobUUID,submission);
+
+  const std::string digest = this->Memoized->digest(submission);
+  if(!digest.empty())
+    {
+    const detail::EncodedResult cached = this->Memoized->find(digest);
+    if(cached.Size > 0)
+      {
+      //an identical job has finished, so this one is finished as well
+      this->ActiveJobs->add(zmq::SocketIdentity(), jobUUID,
+                            remus::proto::JobTimestamps::now());
+      this->finishWithResult(jobUUID, cached);
+      return remus::proto::Job(jobUUID,submission.type());
+      }
+
+    if(!this->Memoized->leader(digest).is_nil())
+      {
+      //an identical job is running, so wait on it without a worker, the
+      //same as a job recovered from the journal
+      this->ActiveJobs->add(zmq::SocketIdentity(), jobUUID,
+                            remus::proto::JobTimestamps::now());
+      this->Memoized->follow(jobUUID, digest);
+      return remus::proto::Job(jobUUID,submission.type());
+      }
+
+    this->Memoized->lead(jobUUID, digest, submission);
+    }
 
   this->QueuedJobs->addJob(jobUUID,submission);
-  //return the UUID
+  return remus::proto::Job(jobUUID,submission.type());
+}
+
+//------------------------------------------------------------------------------
+void Server::updateFollowers(const boost::uuids::uuid& id)
+{
+  if(!this->Memoized->leading(id))
+    {
+    return;
+    }
+
+  const remus::proto::JobStatus status = this->currentStatus(id);
+  if(status.status() == remus::QUEUED)
+    {
+    return;
+    }
+
+  if(status.inProgress())
+    {
+    const std::vector<boost::uuids::uuid> followers =
+                                              this->Memoized->followers(id);
+    for(std::size_t i=0; i < followers.size(); ++i)
+      {
+      this->ActiveJobs->updateStatus(
+                    remus::proto::JobStatus(followers[i], status.progress()));
+      }
+    return;
+    }
+
+  const detail::ResultCache::Execution execution = this->Memoized->finish(id);
+  const std::vector<boost::uuids::uuid>& followers = execution.Followers;
+  if(status.finished() && this->ActiveJobs->haveResult(id))
+    {
+    const detail::EncodedResult result = this->ActiveJobs->encodedResult(id);
+    this->Memoized->add(execution.Digest, result);
+    for(std::size_t i=0; i < followers.size(); ++i)
+      {
+      this->finishWithResult(followers[i], result);
+      }
+    }
+  else if(status.valid())
+    {
+    //the job failed or expired
+    for(std::size_t i=0; i < followers.size(); ++i)
+      {
+      remus::proto::JobStatus failed(followers[i], status.status());
+      if(status.status() == remus::FAILED)
+        {
+        failed = remus::proto::make_FailedJobStatus(followers[i],
+                                          status.progress().message());
+        }
+      this->ActiveJobs->updateStatus(failed);
+      this->Journal->failed(followers[i], status.status());
+      }
+    }
+  else if(!followers.empty())
+    {
+    //the job was removed before it finished, so the first follower is
+    //queued in its place and the rest follow it instead
+    const boost::uuids::uuid next = followers.front();
+    const bool watched = this->ActiveJobs->watched(next);
+    this->ActiveJobs->remove(next);
+    if(watched)
+      {
+      this->ActiveJobs->watch(next);
+      }
+    this->Memoized->lead(next, execution.Digest, execution.Submission);
+    for(std::size_t i=1; i < followers.size(); ++i)
+      {
+      this->Memoized->follow(followers[i], execution.Digest);
+      }
+    this->QueuedJobs->addJob(next, execution.Submission);
+    }
+}
 
-  const remus::proto::Job validJob(jobUUID,msg.MeshIOType());
-  return remus::proto::to_string(validJob);
+//------------------------------------------------------------------------------
+void Server::finishWithResult(const boost::uuids::uuid& id,
+                              const detail::EncodedResult& result)
+{
+  //the bytes are shared with every job that has the result, the journal
+  //only records which job's result this is
+  this->ActiveJobs->updateResult(id, detail::share_result(result, id));
+  this->Journal->finished(id, result.Data, result.Size);
 }
 
 //------------------------------------------------------------------------------
-std::string Server::retrieveMesh(const remus::proto::Message& msg)
+void Server::retrieveMesh(const remus::proto::Message& msg,
+                          remus::proto::Response& response)
 {
   //go to the active jobs list and grab the mesh result if it exists
   remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
 
-  remus::proto::JobResult result(job.id());
-  if( this->ActiveJobs->haveUUID(job.id()) &&
-      this->ActiveJobs->haveResult(job.id()))
+  zmq::message_t data;
+  this->takeResult(job.id(),
+                   remus::proto::wire_format(msg.data(),msg.dataSize()),
+                   data);
+  response.setData(data);
+}
+
+//------------------------------------------------------------------------------
+void Server::takeResult(const boost::uuids::uuid& id,
+                        remus::proto::WireFormat::Type format,
+                        zmq::message_t& data)
+{
+  if(this->encodeResult(id, format, data))
+    {
+    this->releaseResult(id);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool Server::encodeResult(const boost::uuids::uuid& id,
+                          remus::proto::WireFormat::Type format,
+                          zmq::message_t& data)
+{
+  if( this->ActiveJobs->haveUUID(id) &&
+      this->ActiveJobs->haveResult(id))
     {
-    result = this->ActiveJobs->result(job.id());
-    //for now we remove all references from this job being active
-    this->ActiveJobs->remove(job.id());
+    const detail::ActiveJobs::EncodedResult result =
+                                  this->ActiveJobs->encodedResult(id);
+    const remus::proto::WireFormat::Type resultFormat =
+                      remus::proto::wire_format(result.Data,result.Size);
+    if(!result.Id.is_nil() && resultFormat == format &&
+       format == remus::proto::WireFormat::Binary)
+      {
+      //the bytes are shared with the job they were sent for, so only the
+      //job id that follows the header is replaced
+      data.rebuild(result.Size);
+      char* bytes = static_cast<char*>(data.data());
+      std::memcpy(bytes, result.Data, result.Size);
+      std::memcpy(bytes + remus::internal::BinaryHeaderSize,
+                  result.Id.data, result.Id.size());
+      }
+    else if(!result.Id.is_nil())
+      {
+      zmq::to_wire(this->ActiveJobs->result(id), format, data);
+      }
+    else if(resultFormat == format)
+      {
+      //send the bytes the worker sent us, the message keeps them alive
+      //until zmq is done sending them
+      zmq::view_message(data, result.Data, result.Size, result.Owner);
+      }
+    else
+      {
+      //the client and worker use different encodings
+      zmq::to_wire(remus::proto::to_JobResult(result.Data,result.Size),
+                   format, data);
+      }
+    return true;
     }
+
   //return an empty result
-  return remus::proto::to_string(result);
+  zmq::to_wire(remus::proto::JobResult(id), format, data);
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void Server::releaseResult(const boost::uuids::uuid& id)
+{
+  detail::StatsManagement::recordSince(this->Stats->JobRetrievalWaitTimes,
+                this->ActiveJobs->status(id).timestamps().Finished);
+
+  //for now we remove all references from this job being active
+  this->ActiveJobs->remove(id);
+  this->Journal->removed(id);
 }
 
 //------------------------------------------------------------------------------
@@ -627,9 +1457,215 @@ std::string Server::terminateJob(const remus::proto::Message& msg)
       response.send(&this->Zmq->WorkerQueries);
       }
     }
+  if(removed)
+    {
+    this->Journal->removed(job.id());
+    this->Memoized->unfollow(job.id());
+    this->updateFollowers(job.id());
+    }
 
   remus::STATUS_TYPE status = (removed) ? remus::FAILED : remus::INVALID_STATUS;
-  return remus::proto::to_string(remus::proto::JobStatus(job.id(),status));
+  const remus::proto::JobStatus terminated(job.id(),status);
+
+  //the job is gone, so tell its subscribers and waiting clients it failed
+  if(removed && (this->Subscriptions->have(job.id()) ||
+                 this->Waiters->have(job.id())))
+    {
+    this->ActiveJobs->unwatch(job.id());
+    this->Zmq->StatusNotifications.push_back(terminated);
+    }
+  return remus::proto::to_wire(terminated,
+            remus::proto::wire_format(msg.data(),msg.dataSize()));
+}
+
+//------------------------------------------------------------------------------
+std::string Server::subscribeToJobs(const zmq::SocketIdentity& clientIdentity,
+                                    const remus::proto::Message& msg)
+{
+  const remus::proto::JobBatch jobs =
+                  remus::proto::to_JobBatch(msg.data(),msg.dataSize());
+  const remus::proto::WireFormat::Type format =
+                  remus::proto::wire_format(msg.data(),msg.dataSize());
+
+  //statuses are pushed tagged with the id of this request, a client that
+  //didn't send one couldn't tell them apart from replies
+  const bool canPush = !msg.requestId().empty();
+  const detail::JobSubscriptions::Subscriber subscriber(clientIdentity,
+                                                        msg.requestId(),
+                                                        format);
+
+  //answer with the current status of each job, only jobs that can still
+  //change are subscribed to
+  remus::proto::JobStatusBatch statuses;
+  statuses.Statuses.reserve(jobs.Jobs.size());
+  for(std::size_t i=0; i < jobs.Jobs.size(); ++i)
+    {
+    const boost::uuids::uuid& id = jobs.Jobs[i].id();
+    statuses.Statuses.push_back( this->currentStatus(id) );
+    if(canPush && statuses.Statuses.back().good())
+      {
+      this->Subscriptions->add(id, subscriber);
+      this->ActiveJobs->watch(id);
+      }
+    }
+  return remus::proto::to_wire(statuses, format);
+}
+
+//------------------------------------------------------------------------------
+bool Server::waitForJob(const zmq::SocketIdentity& clientIdentity,
+                        const remus::proto::Message& msg,
+                        remus::proto::Response& response)
+{
+  const remus::proto::JobWait wait =
+                  remus::proto::to_JobWait(msg.data(),msg.dataSize());
+  const remus::proto::WireFormat::Type format =
+                  remus::proto::wire_format(msg.data(),msg.dataSize());
+  const boost::uuids::uuid& id = wait.job().id();
+
+  //answer right away when the job can't change, or the client doesn't
+  //want to wait for it to
+  const remus::proto::JobStatus status = this->currentStatus(id);
+  if(!status.good() || wait.timeout() == 0)
+    {
+    this->answerWait(status, format, wait.withResult(), response);
+    return true;
+    }
+
+  //otherwise park the request without blocking the broker, it is answered
+  //by PublishStatusChanges
+  const boost::posix_time::ptime deadline =
+                  boost::posix_time::microsec_clock::local_time() +
+                  boost::posix_time::milliseconds(wait.timeout());
+  this->Waiters->add(id, detail::JobWaiters::Waiter(clientIdentity,
+                                                    msg.requestId(),
+                                                    format,
+                                                    wait.withResult(),
+                                                    deadline));
+  this->ActiveJobs->watch(id);
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool Server::streamResult(const zmq::SocketIdentity& clientIdentity,
+                          const remus::proto::Message& msg,
+                          remus::proto::Response& response)
+{
+  const remus::proto::ResultStreamRequest request =
+          remus::proto::to_ResultStreamRequest(msg.data(),msg.dataSize());
+  const remus::proto::WireFormat::Type format =
+          remus::proto::wire_format(msg.data(),msg.dataSize());
+  const boost::posix_time::ptime now =
+          boost::posix_time::microsec_clock::local_time();
+  const detail::ResultStreams::Key key(clientIdentity, msg.requestId());
+
+  //a request without a chunk size grants an open stream more credit. The
+  //stream can have finished or been closed since the client sent it
+  if(request.chunkSize() == 0)
+    {
+    this->ResultStreams->credit(key, request.credits(), now);
+    return false;
+    }
+
+  //stream the result data straight out of the encoded result the worker
+  //sent us, the stream keeps it alive even if the job is removed. An empty
+  //result is streamed as a single empty chunk
+  const boost::uuids::uuid& id = request.job().id();
+  remus::common::ContentFormat::Type contentFormat;
+  const char* data = NULL;
+  std::size_t size = 0;
+  if(request.credits() > 0 &&
+     this->ActiveJobs->haveUUID(id) && this->ActiveJobs->haveResult(id))
+    {
+    const detail::ActiveJobs::EncodedResult result =
+                                      this->ActiveJobs->encodedResult(id);
+    if(remus::proto::view_JobResultData(result.Data, result.Size,
+                                        contentFormat, data, size))
+      {
+      detail::StatsManagement::recordSince(this->Stats->JobRetrievalWaitTimes,
+                      this->ActiveJobs->status(id).timestamps().Finished);
+      this->ResultStreams->open(key, format, id, contentFormat, data, size,
+                                result.Owner, request.chunkSize(),
+                                request.credits(), now);
+      return false;
+      }
+    }
+
+  //nothing to stream
+  response.setData(remus::proto::to_wire(remus::proto::ResultChunk(id),
+                                         format));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void Server::answerWait(const remus::proto::JobStatus& status,
+                        remus::proto::WireFormat::Type format,
+                        bool withResult,
+                        remus::proto::Response& response)
+{
+  response.setServiceType(remus::WAIT_FOR_JOB);
+  response.setData(remus::proto::to_wire(status, format));
+  if(withResult && status.finished())
+    {
+    //the result is sent as an attachment, so it can be the bytes the
+    //worker sent us
+    zmq::message_t result;
+    this->takeResult(status.id(), format, result);
+    response.setAttachment(result);
+    }
+}
+
+//------------------------------------------------------------------------------
+std::string Server::serverStats(const remus::proto::Message& msg)
+{
+  return remus::proto::to_wire(this->CollectStats(),
+            remus::proto::wire_format(msg.data(),msg.dataSize()));
+}
+
+//------------------------------------------------------------------------------
+remus::proto::ServerStats Server::CollectStats()
+{
+  //every counter is kept up to date as jobs and workers change, so taking
+  //a snapshot never has to walk the jobs or workers
+  remus::proto::ServerStats stats;
+  stats.JobsQueued = this->QueuedJobs->numJobsJustQueued();
+  stats.JobsWaitingForWorkers = this->QueuedJobs->numJobsWaitingForWorkers();
+  stats.JobsActive = this->ActiveJobs->numJobs(remus::QUEUED) +
+                     this->ActiveJobs->numJobs(remus::IN_PROGRESS);
+  stats.JobsFinished = this->ActiveJobs->numJobs(remus::FINISHED);
+  stats.JobsFailed = this->ActiveJobs->numJobs(remus::FAILED) +
+                     this->ActiveJobs->numJobs(remus::EXPIRED);
+  stats.JobsSubmittedTotal = this->QueuedJobs->numJobsAdded();
+  stats.JobsDispatchedTotal = this->QueuedJobs->numJobsTaken();
+  stats.JobsReclaimedTotal = this->ActiveJobs->reclaimedJobs();
+
+  stats.Workers = this->WorkerPool->numWorkers();
+  stats.WaitingWorkers = this->WorkerPool->numWaitingWorkers();
+  stats.WorkerProcesses = this->WorkerFactory->currentWorkerCount();
+  stats.MaxWorkerProcesses = this->WorkerFactory->maxWorkerCount();
+
+  const remus::server::detail::ResultStoreStats& results =
+                                      this->ActiveJobs->results().stats();
+  stats.ResultBytesInMemory = results.BytesInMemory;
+  stats.ResultBytesOnDisk = results.BytesOnDisk;
+  stats.ResultBytesReclaimedTotal = this->ActiveJobs->reclaimedBytes();
+
+  const boost::int64_t uptime = (boost::posix_time::microsec_clock::local_time() -
+                                 this->Thread->startTime()).total_milliseconds();
+  stats.Uptime = static_cast<boost::uint64_t>(std::max<boost::int64_t>(0,uptime));
+
+  //stats are only collected on the broker thread, so this is its cpu time
+  const boost::int64_t cpu = remus::common::ThreadCpuTimeInMicrosec() -
+                             this->Stats->BrokerCpuStart;
+  stats.BrokerCpuTime = static_cast<boost::uint64_t>(std::max<boost::int64_t>(0,cpu));
+
+  detail::StatsManagement::copy(this->Stats->ClientLatencies,
+                                stats.ClientLatencies);
+  detail::StatsManagement::copy(this->Stats->WorkerLatencies,
+                                stats.WorkerLatencies);
+  stats.JobQueueTimes = this->Stats->JobQueueTimes;
+  stats.JobExecutionTimes = this->Stats->JobExecutionTimes;
+  stats.JobRetrievalWaitTimes = this->Stats->JobRetrievalWaitTimes;
+  return stats;
 }
 
 //------------------------------------------------------------------------------
@@ -658,6 +1694,9 @@ void Server::DetermineWorkerResponse(const zmq::SocketIdentity &workerIdentity,
       const remus::proto::JobRequirements reqs =
             remus::proto::to_JobRequirements(msg.data(),msg.dataSize());
       this->WorkerPool->readyForWork(workerIdentity,reqs);
+      //send jobs to the worker in the wire format it asked for them with
+      this->WorkerPool->wireFormat(workerIdentity,
+            remus::proto::wire_format(msg.data(),msg.dataSize()));
       }
       break;
     case remus::MESH_STATUS:
@@ -709,28 +1748,97 @@ void Server::storeMeshStatus(const remus::proto::Message& msg)
   //the string in the data is actually a job status object
   remus::proto::JobStatus js = remus::proto::to_JobStatus(msg.data(),
                                                           msg.dataSize());
+  const bool wasRunning = this->ActiveJobs->haveUUID(js.id()) &&
+                          this->ActiveJobs->status(js.id()).good();
   this->ActiveJobs->updateStatus(js);
+  if(wasRunning && !this->ActiveJobs->status(js.id()).good())
+    {
+    this->recordExecutionTime(js.id());
+    }
+  this->updateFollowers(js.id());
+
+  //jobs that haven't failed are run again after recovery, so only
+  //failures need to be journaled
+  if(js.failed() && this->ActiveJobs->haveUUID(js.id()) &&
+     this->ActiveJobs->status(js.id()).status() == js.status())
+    {
+    this->Journal->failed(js.id(),js.status());
+    }
 }
 
 //------------------------------------------------------------------------------
 void Server::storeMesh(const remus::proto::Message& msg)
 {
-  remus::proto::JobResult jr = remus::proto::to_JobResult(msg.data(),
-                                                            msg.dataSize());
-  this->ActiveJobs->updateResult(jr);
+  //only the job id is decoded, the result is kept as the bytes the
+  //worker sent so that it is never copied
+  const boost::uuids::uuid id = remus::proto::to_JobResultId(msg.data(),
+                                                             msg.dataSize());
+  const bool wasRunning = this->ActiveJobs->haveUUID(id) &&
+                          this->ActiveJobs->status(id).good();
+  this->ActiveJobs->updateResult(id,
+                    detail::ActiveJobs::EncodedResult(msg.data(),
+                                                      msg.dataSize(),
+                                                      msg.dataOwner()));
+  if(this->ActiveJobs->haveResult(id))
+    {
+    this->Journal->finished(id,msg.data(),msg.dataSize());
+    }
+  if(wasRunning)
+    {
+    this->recordExecutionTime(id);
+    }
+  this->updateFollowers(id);
+}
+
+//------------------------------------------------------------------------------
+void Server::recordExecutionTime(const boost::uuids::uuid& id)
+{
+  const remus::proto::JobTimestamps& times =
+                                  this->ActiveJobs->status(id).timestamps();
+  if(times.executionTime() > 0)
+    {
+    this->Stats->JobExecutionTimes.record(
+                  static_cast<boost::uint64_t>(times.executionTime()));
+    }
 }
 
 //------------------------------------------------------------------------------
 void Server::assignJobToWorker(const zmq::SocketIdentity &workerIdentity,
-                               const remus::worker::Job& job )
+                               const remus::worker::Job& job,
+                               boost::int64_t queuedTime)
 {
-  this->ActiveJobs->add( workerIdentity, job.id() );
+  detail::StatsManagement::recordSince(this->Stats->JobQueueTimes, queuedTime);
+  this->ActiveJobs->add( workerIdentity, job.id(), queuedTime,
+                         *this->SocketMonitor );
+  this->Journal->dispatched( job.id() );
 
   remus::proto::Response response(workerIdentity);
   response.setServiceType(remus::MAKE_MESH);
 
-  std::string tmp = remus::worker::to_string(job);
-  response.setData(tmp);
+  const remus::proto::WireFormat::Type format =
+                                this->WorkerPool->wireFormat(workerIdentity);
+  const remus::proto::JobSubmission& submission = job.submission();
+  zmq::message_t data;
+  if(format == remus::proto::WireFormat::Binary && submission.hasEncoded())
+    {
+    //workers that speak binary know to read the submission as an
+    //attachment, so we forward the bytes the client sent us without
+    //copying or encoding them again, and only encode the job id
+    zmq::to_binary(remus::proto::Job(job.id(),job.type()), data);
+
+    zmq::message_t attachment;
+    zmq::view_message(attachment,
+                      submission.encodedData(),
+                      submission.encodedSize(),
+                      submission.encodedOwner());
+    response.setAttachment(attachment);
+    }
+  else
+    {
+    //encode the job straight into the message we send
+    zmq::to_wire(job, format, data);
+    }
+  response.setData(data);
   response.send(&this->Zmq->WorkerQueries);
 }
 
@@ -744,56 +1852,252 @@ void Server::FindWorkerForQueuedJob()
   //In order to prevent allocating more workers than needed we use a set instead of a vector.
   //This results in the server only creating one worker per job type.
   //This gives the new workers the opportunity of getting assigned multiple jobs.
-  this->WorkerFactory->updateWorkerCount();
-
 
+  //only look at the requirements that have had a job added, or a worker
+  //become ready since the last time we were called. Everything else
+  //can't have changed its ability to be matched
   typedef remus::proto::JobRequirementsSet::const_iterator it;
-  remus::proto::JobRequirementsSet types;
+  remus::proto::JobRequirementsSet types =
+                                  this->QueuedJobs->changedRequirements();
+  types.insert(this->WorkerPool->changedRequirements().begin(),
+               this->WorkerPool->changedRequirements().end());
+  this->QueuedJobs->clearChangedRequirements();
+  this->WorkerPool->clearChangedRequirements();
 
-  //find all the jobs that have been marked as waiting for a worker
-  //and ask if we have a worker in the poll that can mesh that job
-  types = this->QueuedJobs->waitingJobRequirements();
   for(it type = types.begin(); type != types.end(); ++type)
     {
-    if(this->WorkerPool->haveWaitingWorker(*type))
+    //give jobs to the workers in the pool, preferring the jobs
+    //that have been marked as waiting for a worker
+    while(this->WorkerPool->haveWaitingWorker(*type) &&
+          (this->QueuedJobs->numJobsWaitingForWorkers(*type) > 0 ||
+           this->QueuedJobs->numJobsJustQueued(*type) > 0) )
       {
       //give this job to that worker
-      this->assignJobToWorker(this->WorkerPool->takeWorker(*type),
-                              this->QueuedJobs->takeJob(*type));
+      const zmq::SocketIdentity worker = this->WorkerPool->takeWorker(*type);
+      boost::int64_t queuedTime = 0;
+      const remus::worker::Job job = this->QueuedJobs->takeJob(*type,
+                                                               &queuedTime);
+      this->assignJobToWorker(worker, job, queuedTime);
+      }
+
+    //now if we have room in our worker pool for more pending workers create
+    //some make sure we ask the worker pool what its limit on number of pending
+    //workers is before creating more.
+    if(this->QueuedJobs->numJobsJustQueued(*type) > 0)
+      {
+      //check if we have a waiting worker, if we don't than try
+      //ask the factory to create a worker of that type.
+      if(this->WorkerFactory->createWorker(*type,
+                             WorkerFactory::KillOnFactoryDeletion))
+        {
+        this->QueuedJobs->workerDispatched(*type);
+
+        //we only create one worker per type each pass, so revisit
+        //this type next pass if it still has jobs without a worker
+        if(this->QueuedJobs->numJobsJustQueued(*type) > 0)
+          {
+          this->QueuedJobs->markRequirementsChanged(*type);
+          }
+        }
       }
     }
+}
 
 
-  //find all jobs that queued up and check if we can assign it to an item in
-  //the worker pool
-  types = this->QueuedJobs->queuedJobRequirements();
-  for(it type = types.begin(); type != types.end(); ++type)
+//------------------------------------------------------------------------------
+void Server::CommitJournal()
+{
+  //the replies describe changes that aren't durable until the commit
+  //succeeds, so they are held until a later commit writes the changes
+  if(!this->Journal->commit())
+    {
+    return;
+    }
+
+  typedef std::vector<detail::ZmqManagement::PendingReply>::iterator ReplyIt;
+  std::vector<detail::ZmqManagement::PendingReply>& replies =
+                                                this->Zmq->UncommittedReplies;
+  for(ReplyIt i = replies.begin(); i != replies.end(); ++i)
+    {
+    i->Reply->send(&this->Zmq->ClientQueries);
+    this->Stats->recordClient(i->Service, i->Received);
+    }
+  replies.clear();
+}
+
+//------------------------------------------------------------------------------
+void Server::PublishStatusChanges()
+{
+  std::vector<remus::proto::JobStatus> statuses =
+                                      this->ActiveJobs->takeStatusChanges();
+  statuses.insert(statuses.end(),
+                  this->Zmq->StatusNotifications.begin(),
+                  this->Zmq->StatusNotifications.end());
+  this->Zmq->StatusNotifications.clear();
+  if(statuses.empty() && this->Waiters->empty())
+    {
+    return;
+    }
+
+  //each subscriber is sent every change to its jobs in a single message
+  typedef detail::JobSubscriptions::Notifications::const_iterator NotifyIt;
+  const detail::JobSubscriptions::Notifications notifications =
+                                      this->Subscriptions->notify(statuses);
+  for(NotifyIt i = notifications.begin(); i != notifications.end(); ++i)
     {
-    if(this->WorkerPool->haveWaitingWorker(*type))
+    remus::proto::Response response(i->first.Client);
+    response.requestId(i->first.RequestId);
+    response.setServiceType(remus::SUBSCRIBE_JOB_STATUS);
+    response.setData(
+              remus::proto::to_wire(remus::proto::JobStatusBatch(i->second),
+                                    i->first.Format));
+    response.send(&this->Zmq->ClientQueries);
+    }
+
+  //answer the clients waiting on jobs that can no longer change, with
+  //the status that ended the wait since a terminated job is already gone
+  typedef detail::JobWaiters::Answers::const_iterator AnswerIt;
+  const detail::JobWaiters::Answers finished =
+                                      this->Waiters->finished(statuses);
+  std::map<boost::uuids::uuid, remus::proto::JobStatus> finalStatuses;
+  for(std::size_t i=0; i < statuses.size() && !finished.empty(); ++i)
+    {
+    if(!statuses[i].good())
       {
-      //give this job to that worker
-      this->assignJobToWorker(this->WorkerPool->takeWorker(*type),
-                              this->QueuedJobs->takeJob(*type));
+      finalStatuses.insert(std::make_pair(statuses[i].id(), statuses[i]));
+      }
+    }
+  //every client waiting on a finished job gets its result, so the job is
+  //only removed once all of them have been answered
+  std::set<boost::uuids::uuid> taken;
+  for(AnswerIt i = finished.begin(); i != finished.end(); ++i)
+    {
+    const remus::proto::JobStatus& status =
+                                    finalStatuses.find(i->first)->second;
+    remus::proto::Response response(i->second.Client);
+    response.requestId(i->second.RequestId);
+    this->answerWait(status, i->second.Format, false, response);
+    if(i->second.WithResult && status.finished())
+      {
+      zmq::message_t result;
+      if(this->encodeResult(status.id(), i->second.Format, result))
+        {
+        taken.insert(status.id());
+        }
+      response.setAttachment(result);
       }
+    response.send(&this->Zmq->ClientQueries);
+    }
+  for(std::set<boost::uuids::uuid>::const_iterator i = taken.begin();
+      i != taken.end(); ++i)
+    {
+    this->releaseResult(*i);
     }
 
-  //now if we have room in our worker pool for more pending workers create some
-  //make sure we ask the worker pool what its limit on number of pending
-  //workers is before creating more. We have to requery to get the updated
-  //job types since the worker pool might have taken some.
-  types = this->QueuedJobs->queuedJobRequirements();
-  for(it type = types.begin(); type != types.end(); ++type)
+  //and the clients whose wait has timed out, with the status the job has
+  //now. Jobs nobody else is interested in don't need to be watched
+  const detail::JobWaiters::Answers expired =
+      this->Waiters->expired(boost::posix_time::microsec_clock::local_time());
+  for(AnswerIt i = expired.begin(); i != expired.end(); ++i)
     {
-    //check if we have a waiting worker, if we don't than try
-    //ask the factory to create a worker of that type.
-    if(this->WorkerFactory->createWorker(*type,
-                           WorkerFactory::KillOnFactoryDeletion))
+    remus::proto::Response response(i->second.Client);
+    response.requestId(i->second.RequestId);
+    this->answerWait(this->currentStatus(i->first), i->second.Format,
+                     false, response);
+    response.send(&this->Zmq->ClientQueries);
+
+    if(!this->Subscriptions->have(i->first) && !this->Waiters->have(i->first))
       {
-      this->QueuedJobs->workerDispatched(*type);
+      this->ActiveJobs->unwatch(i->first);
       }
     }
 }
 
+//------------------------------------------------------------------------------
+void Server::SendResultChunks()
+{
+  if(!this->ResultStreams->ready())
+    {
+    return;
+    }
+
+  std::vector<boost::uuids::uuid> finished;
+  typedef std::vector<detail::ResultStreams::Chunk>::const_iterator ChunkIt;
+  const std::vector<detail::ResultStreams::Chunk> chunks =
+                                  this->ResultStreams->nextChunks(finished);
+  for(ChunkIt i = chunks.begin(); i != chunks.end(); ++i)
+    {
+    remus::proto::Response response(i->Stream.Client);
+    response.requestId(i->Stream.RequestId);
+    response.setServiceType(remus::STREAM_RESULT);
+    response.setData(remus::proto::to_wire(i->Header, i->Format));
+
+    //the chunk views into the result, which the message keeps alive
+    //until zmq is done sending it. Every chunk has an attachment, even the
+    //one chunk of an empty result
+    zmq::message_t data;
+    if(i->Size > 0)
+      {
+      zmq::view_message(data, i->Data, i->Size, i->Owner);
+      }
+    response.setAttachment(data);
+    response.send(&this->Zmq->ClientQueries);
+    }
+
+  //once all of a result has been sent it has been handed to the client,
+  //the same as retrieveMesh
+  for(std::size_t i=0; i < finished.size(); ++i)
+    {
+    if(this->ActiveJobs->haveUUID(finished[i]))
+      {
+      this->ActiveJobs->remove(finished[i]);
+      this->Journal->removed(finished[i]);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void Server::RecoverJournaledJobs(
+                          const remus::server::JobJournaling& journaling)
+{
+  std::vector<detail::JournaledJob> jobs;
+  this->Journal->syncOnCommit(journaling.syncOnCommit());
+  if(!this->Journal->open(journaling.directory(), jobs))
+    {
+    return;
+    }
+
+  typedef std::vector<detail::JournaledJob>::const_iterator JobIt;
+  for(JobIt job = jobs.begin(); job != jobs.end(); ++job)
+    {
+    if(job->Result)
+      {
+      //a result the job shared with another job names the other job
+      detail::EncodedResult result(job->Result->data(), job->Result->size(),
+                                   job->Result);
+      if(remus::proto::to_JobResultId(result.Data, result.Size) != job->Id)
+        {
+        result = detail::share_result(result, job->Id);
+        }
+      this->ActiveJobs->add(zmq::SocketIdentity(), job->Id);
+      this->ActiveJobs->updateResult(job->Id, result);
+      }
+    else if(job->Status == remus::FAILED || job->Status == remus::EXPIRED)
+      {
+      this->ActiveJobs->add(zmq::SocketIdentity(), job->Id);
+      this->ActiveJobs->updateStatus(
+                              remus::proto::JobStatus(job->Id,job->Status));
+      }
+    else if(job->Submission)
+      {
+      //the worker the job was given to died with the previous server
+      this->QueuedJobs->addJob(job->Id,
+                remus::proto::to_JobSubmission(job->Submission->data(),
+                                               job->Submission->size(),
+                                               job->Submission));
+      }
+    }
+}
 
 //We are crashing we need to terminate all workers
 //------------------------------------------------------------------------------
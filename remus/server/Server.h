@@ -14,8 +14,10 @@
 #define remus_server_Server_h
 
 #include <remus/common/SignalCatcher.h>
+#include <remus/proto/WireFormat.h>
 #include <remus/proto/zmqSocketIdentity.h>
 
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #ifndef _MSC_VER
@@ -33,10 +35,22 @@
 //included for export symbols
 #include <remus/server/ServerExports.h>
 
+#include <string>
+
+namespace zmq
+{
+  class message_t;
+}
+
 namespace remus {
   //forward declaration of classes only the implementation needs
   namespace proto {
+  class Job;
+  class JobStatus;
+  class JobSubmission;
   class Message;
+  class Response;
+  class ServerStats;
   }
 
   namespace worker {
@@ -50,9 +64,17 @@ namespace server{
     {
     //forward declaration of classes only the implementation needs
     class ActiveJobs;
+    class JobJournal;
     class JobQueue;
+    class JobSubscriptions;
+    class JobUploads;
+    class JobWaiters;
+    class ResultCache;
+    class ResultStreams;
     class SocketMonitor;
     class WorkerPool;
+    struct EncodedResult;
+    struct StatsManagement;
     struct ThreadManagement;
     struct UUIDManagement;
     struct ZmqManagement;
@@ -77,6 +99,154 @@ private:
   boost::int64_t MaxRateMillisec;
 };
 
+//helper class that allows users to set and get the maximum number of
+//messages a server instance reads from each of its sockets every time
+//it polls, before it tries to match queued jobs to workers
+class REMUSSERVER_EXPORT MessageBatchSize
+{
+public:
+  explicit MessageBatchSize(unsigned int max_messages):
+    MaxMessages(max_messages)
+    {
+    }
+
+  const unsigned int& maxMessages() const { return MaxMessages; }
+
+private:
+  unsigned int MaxMessages;
+};
+
+//helper class that allows users to set and get how a server instance
+//stores the results of finished jobs until clients retrieve them. Once the
+//results held in memory are over the memory budget, the least recently
+//used results are written to files in the scratch directory
+class REMUSSERVER_EXPORT ResultStorage
+{
+public:
+  ResultStorage(boost::uint64_t memory_budget,
+                const std::string& scratch_directory):
+    MemoryBudget(memory_budget),
+    ScratchDirectory(scratch_directory)
+    {
+    }
+
+  const boost::uint64_t& memoryBudget() const { return MemoryBudget; }
+  const std::string& scratchDirectory() const { return ScratchDirectory; }
+
+private:
+  boost::uint64_t MemoryBudget;
+  std::string ScratchDirectory;
+};
+
+//helper class that allows users to set and get how a server instance
+//stores the data of uploaded jobs, so that data uploaded again isn't sent
+//twice. Data no queued job uses is kept until it is over the memory
+//budget, then written to files in the scratch directory until it is over
+//the disk budget
+class REMUSSERVER_EXPORT BlobStorage
+{
+public:
+  BlobStorage(boost::uint64_t memory_budget,
+              boost::uint64_t disk_budget,
+              const std::string& scratch_directory):
+    MemoryBudget(memory_budget),
+    DiskBudget(disk_budget),
+    ScratchDirectory(scratch_directory)
+    {
+    }
+
+  const boost::uint64_t& memoryBudget() const { return MemoryBudget; }
+  const boost::uint64_t& diskBudget() const { return DiskBudget; }
+  const std::string& scratchDirectory() const { return ScratchDirectory; }
+
+private:
+  boost::uint64_t MemoryBudget;
+  boost::uint64_t DiskBudget;
+  std::string ScratchDirectory;
+};
+
+//helper class that allows users to set and get if a server instance
+//memoizes the results of jobs. Jobs submitted while an identical job is
+//running wait on its result instead of being meshed again, and jobs
+//identical to one that has finished are answered with its result, while it
+//is among the most recently used results that fit in the cache size.
+//Jobs are identical when their requirements and contents are. Jobs with
+//excluded requirements, such as those of meshers that don't give the same
+//result for the same job, are always meshed
+class REMUSSERVER_EXPORT ResultMemoization
+{
+public:
+  ResultMemoization(bool enabled, boost::uint64_t cache_size):
+    Enabled(enabled),
+    CacheSize(cache_size),
+    Excluded()
+    {
+    }
+
+  void exclude(const remus::proto::JobRequirements& reqs)
+    { Excluded.insert(reqs); }
+
+  bool enabled() const { return Enabled; }
+  const boost::uint64_t& cacheSize() const { return CacheSize; }
+  const remus::proto::JobRequirementsSet& excluded() const
+    { return Excluded; }
+
+private:
+  bool Enabled;
+  boost::uint64_t CacheSize;
+  remus::proto::JobRequirementsSet Excluded;
+};
+
+//helper class that allows users to set and get how long a server instance
+//keeps jobs, and their results, once they have finished, failed or expired.
+//Jobs that clients never retrieve are removed when their time runs out.
+//Non positive times keep the jobs until a client retrieves them.
+//
+//Note: All times are in milliseconds
+class REMUSSERVER_EXPORT JobTimeToLive
+{
+public:
+  JobTimeToLive(boost::int64_t finished_millisec,
+                boost::int64_t failed_millisec,
+                boost::int64_t expired_millisec):
+    Finished(finished_millisec),
+    Failed(failed_millisec),
+    Expired(expired_millisec)
+    {
+    }
+
+  const boost::int64_t& finished() const { return Finished; }
+  const boost::int64_t& failed() const { return Failed; }
+  const boost::int64_t& expired() const { return Expired; }
+
+private:
+  boost::int64_t Finished;
+  boost::int64_t Failed;
+  boost::int64_t Expired;
+};
+
+//helper class that holds where a server instance journals the jobs it
+//holds, so that a server constructed with the same directory after a crash
+//has the same jobs. When sync_on_commit is false the journal survives the
+//server process dying, but not the machine losing power.
+class REMUSSERVER_EXPORT JobJournaling
+{
+public:
+  explicit JobJournaling(const std::string& directory,
+                         bool sync_on_commit = true):
+    Directory(directory),
+    SyncOnCommit(sync_on_commit)
+    {
+    }
+
+  const std::string& directory() const { return Directory; }
+  bool syncOnCommit() const { return SyncOnCommit; }
+
+private:
+  std::string Directory;
+  bool SyncOnCommit;
+};
+
 
 //Server is the broker of Remus. It handles accepting client
 //connections, worker connections, and manages the life cycle of submitted jobs.
@@ -105,6 +275,16 @@ public:
   Server(const remus::server::ServerPorts& ports,
          const boost::shared_ptr<remus::server::WorkerFactory>& factory);
 
+  //construct a new server using the given loop back ports and factory,
+  //that journals its jobs to the given directory. Jobs that a previous
+  //server journaled to the directory are recovered: finished and failed
+  //jobs can be retrieved by clients, and every other job is queued again
+  //under the same id, since the workers of the previous server are gone.
+  //Use isJournaling to check if the journal could be opened
+  Server(const remus::server::ServerPorts& ports,
+         const boost::shared_ptr<remus::server::WorkerFactory>& factory,
+         const remus::server::JobJournaling& journaling);
+
   //cleanup the server
   virtual ~Server();
 
@@ -120,6 +300,71 @@ public:
   void pollingRates( const remus::server::PollingRates& rates );
   remus::server::PollingRates pollingRates() const;
 
+  //Modify the number of messages the server reads from the client and
+  //worker sockets each time it polls. Under bursty load reading multiple
+  //messages before matching jobs to workers means the server does one
+  //matching pass per batch instead of one per message.
+  //
+  //Note: changes only take effect the next time brokering is started
+  //Note: a batch size of zero is treated as one
+  void messageBatchSize( const remus::server::MessageBatchSize& size );
+  remus::server::MessageBatchSize messageBatchSize() const;
+
+  //Modify how often the server checks for workers that have missed their
+  //heartbeat, and for worker processes that have exited. Jobs of workers
+  //that have missed their heartbeat are marked as expired by this check.
+  //
+  //Note: the interval is in milliseconds
+  //Note: changes only take effect the next time brokering is started
+  //Note: non positive intervals are treated as one millisecond
+  void heartbeatCheckInterval( boost::int64_t millisec );
+  boost::int64_t heartbeatCheckInterval() const;
+
+  //Modify how many bytes of job results the server holds in memory, and
+  //the directory results beyond that are spilled to. Spilled results are
+  //memory mapped back when a client retrieves them. By default results
+  //are never spilled.
+  //
+  //Note: should be set before brokering is started
+  void resultStorage( const remus::server::ResultStorage& storage );
+  remus::server::ResultStorage resultStorage() const;
+
+  //Modify how many bytes of uploaded job data the server keeps once no
+  //queued job uses it, so clients uploading the same data again only send
+  //its hash. By default 512MB is kept in memory and nothing is spilled.
+  //
+  //Note: should be set before brokering is started
+  void blobStorage( const remus::server::BlobStorage& storage );
+  remus::server::BlobStorage blobStorage() const;
+
+  //Modify if the server memoizes the results of jobs, so identical jobs
+  //are only meshed once. By default results aren't memoized.
+  //
+  //Note: should be set before brokering is started
+  void resultMemoization( const remus::server::ResultMemoization& memo );
+  remus::server::ResultMemoization resultMemoization() const;
+
+  //Modify how long the server keeps jobs once they have finished, failed
+  //or expired. Jobs past their time are removed a few at a time each
+  //time the server polls, so clients that never retrieve their results
+  //don't grow the memory of the server. By default jobs are kept until
+  //a client retrieves them.
+  //
+  //Note: should be set before brokering is started
+  void jobTimeToLive( const remus::server::JobTimeToLive& ttl );
+  remus::server::JobTimeToLive jobTimeToLive() const;
+
+  //Returns true if the server is journaling its jobs
+  bool isJournaling() const;
+
+  //Modify the file the server writes a report of its statistics to when
+  //brokering stops, including how long it took to handle each type of
+  //client and worker message. An empty path, the default, writes no report
+  //
+  //Note: should be set before brokering is started
+  void statsReport( const std::string& path );
+  std::string statsReport() const;
+
   //when you call start brokering the server will actually start accepting
   //worker and client requests.
   bool startBrokering(SignalHandling sh = CAPTURE);
@@ -173,8 +418,74 @@ protected:
   std::string meshRequirements(const remus::proto::Message& msg);
   std::string meshStatus(const remus::proto::Message& msg);
   std::string queueJob(const remus::proto::Message& msg);
-  std::string retrieveMesh(const remus::proto::Message& msg);
+  std::string meshStatusBatch(const remus::proto::Message& msg);
+  std::string queueJobBatch(const remus::proto::Message& msg);
+  void retrieveMesh(const remus::proto::Message& msg,
+                    remus::proto::Response& response);
   std::string terminateJob(const remus::proto::Message& msg);
+  std::string serverStats(const remus::proto::Message& msg);
+  std::string subscribeToJobs(const zmq::SocketIdentity& clientIdentity,
+                              const remus::proto::Message& msg);
+  //returns false when the reply is held until the job can't change or
+  //the wait times out, in which case response must not be sent
+  bool waitForJob(const zmq::SocketIdentity& clientIdentity,
+                  const remus::proto::Message& msg,
+                  remus::proto::Response& response);
+
+  //returns false when the request opened a stream, or granted one more
+  //credit, in which case response must not be sent
+  bool streamResult(const zmq::SocketIdentity& clientIdentity,
+                    const remus::proto::Message& msg,
+                    remus::proto::Response& response);
+
+  //start assembling a job that the client uploads in chunks, returning
+  //the job it will be queued as once all of its data has arrived, and the
+  //contents whose data we don't already have
+  std::string beginJobUpload(const remus::proto::Message& msg);
+  //copy a chunk of an uploaded job into place, queueing the job when it
+  //is the last chunk. Returns if the chunk was accepted
+  std::string uploadJobChunk(const remus::proto::Message& msg);
+
+  //fill in the reply to a wait for job request with the status of the
+  //job, and its result when asked for and the job has finished
+  void answerWait(const remus::proto::JobStatus& status,
+                  remus::proto::WireFormat::Type format,
+                  bool withResult,
+                  remus::proto::Response& response);
+
+  //encode the result of a finished job and remove the job, which is how
+  //results are handed to clients, or encode an empty result if the job
+  //has none
+  void takeResult(const boost::uuids::uuid& id,
+                  remus::proto::WireFormat::Type format,
+                  zmq::message_t& data);
+
+  //the two halves of takeResult, so one result can be encoded for several
+  //clients before the job is removed. encodeResult returns false when it
+  //encoded an empty result as the job has none
+  bool encodeResult(const boost::uuids::uuid& id,
+                    remus::proto::WireFormat::Type format,
+                    zmq::message_t& data);
+  void releaseResult(const boost::uuids::uuid& id);
+
+  //the single job forms of queueJob and meshStatus, shared with the batches
+  remus::proto::Job queueSubmission(
+                          const remus::proto::JobSubmission& submission);
+  remus::proto::Job queueSubmission(const boost::uuids::uuid& id,
+                          const remus::proto::JobSubmission& submission);
+  remus::proto::JobStatus currentStatus(const boost::uuids::uuid& id);
+
+  //give the jobs following a memoized job its status, or its result once
+  //it has finished. When the job is gone without finishing or failing,
+  //such as when it is terminated, the first follower is queued in its place
+  void updateFollowers(const boost::uuids::uuid& id);
+
+  //finish a job with the result of an identical job
+  void finishWithResult(const boost::uuids::uuid& id,
+                        const detail::EncodedResult& result);
+
+  //take a snapshot of the counters and latencies of the server
+  remus::proto::ServerStats CollectStats();
 
   //Methods for processing Worker queries
   void DetermineWorkerResponse(const zmq::SocketIdentity &workerIdentity,
@@ -183,8 +494,13 @@ protected:
   //These methods are all to do with sending/recving to workers
   void storeMeshStatus(const remus::proto::Message& msg);
   void storeMesh(const remus::proto::Message& msg);
+  //queuedTime is when the job was queued, see JobTimestamps
   void assignJobToWorker(const zmq::SocketIdentity &workerIdentity,
-                         const remus::worker::Job& job);
+                         const remus::worker::Job& job,
+                         boost::int64_t queuedTime = 0);
+
+  //record how long a worker took on a job that has just finished or failed
+  void recordExecutionTime(const boost::uuids::uuid& id);
 
   //see if we have a worker in the pool for the next job in the queue,
   //otherwise ask the factory to generate a new worker to handle that job
@@ -192,11 +508,32 @@ protected:
   //of workers
   //overriding this will also allow custom servers to change the priority
   //of queued jobs and workers
+  //this is only called when a job has been queued, a worker has become
+  //ready for a job, or after the server has checked for dead workers
   virtual void FindWorkerForQueuedJob();
 
   //terminate all workers that are doing jobs or waiting for jobs
   void TerminateAllWorkers();
 
+  //make the changes to jobs since the last call durable, and then send
+  //the replies to clients that were waiting on those changes. When the
+  //commit fails the replies are held, and sent once a later commit works
+  void CommitJournal();
+
+  //push the status changes of jobs to the clients that subscribed to them,
+  //and answer the clients waiting on jobs that can no longer change or
+  //whose wait has timed out. Called after the journal is committed, so
+  //clients are never told about a change that could be lost
+  void PublishStatusChanges();
+
+  //send the next chunk of every result stream the client has granted
+  //credit for, so a large result is sent a piece at a time between the
+  //other requests the broker handles
+  void SendResultChunks();
+
+  //rebuild the jobs recorded in the journal of the given directory
+  void RecoverJournaledJobs(const remus::server::JobJournaling& journaling);
+
 private:
   //explicitly state the server doesn't support copy or move semantics
   Server(const Server&);
@@ -211,8 +548,15 @@ protected:
   boost::scoped_ptr<remus::server::detail::SocketMonitor> SocketMonitor;
   boost::scoped_ptr<remus::server::detail::WorkerPool> WorkerPool;
   boost::scoped_ptr<remus::server::detail::ActiveJobs> ActiveJobs;
+  boost::scoped_ptr<remus::server::detail::JobSubscriptions> Subscriptions;
+  boost::scoped_ptr<remus::server::detail::JobWaiters> Waiters;
+  boost::scoped_ptr<remus::server::detail::ResultStreams> ResultStreams;
+  boost::scoped_ptr<remus::server::detail::JobUploads> Uploads;
+  boost::scoped_ptr<remus::server::detail::ResultCache> Memoized;
+  boost::scoped_ptr<remus::server::detail::JobJournal> Journal;
   boost::scoped_ptr<detail::UUIDManagement> UUIDGenerator;
   boost::scoped_ptr<detail::ThreadManagement> Thread;
+  boost::scoped_ptr<detail::StatsManagement> Stats;
 
   //needs to be a shared_ptr since we can be passed in a WorkerFactory
   boost::shared_ptr<remus::server::WorkerFactory> WorkerFactory;
@@ -52,6 +52,12 @@ remus::server::PortConnection bind(zmq::socket_t &socket,
 namespace remus{
 namespace server{
 
+//------------------------------------------------------------------------------
+boost::shared_ptr<zmq::context_t> ServerPorts::make_context()
+{
+  return boost::make_shared<zmq::context_t>(2);
+}
+
 //------------------------------------------------------------------------------
 ServerPorts::ServerPorts():
   Context( boost::make_shared<zmq::context_t>(2) ),
@@ -82,6 +82,7 @@ public:
   template<typename ClientSocketType, typename WorkerSocketType>
   ServerPorts(const ClientSocketType& c,
               const WorkerSocketType& w):
+    Context(make_context()),
     Client(c),
     Worker(w)
   { }
@@ -113,6 +114,9 @@ public:
   void context(boost::shared_ptr<zmq::context_t> c) { this->Context = c; }
 
 private:
+  //the context is created out of line, as zmq isn't included here
+  static boost::shared_ptr<zmq::context_t> make_context();
+
   boost::shared_ptr<zmq::context_t> Context;
   PortConnection Client;
   PortConnection Worker;
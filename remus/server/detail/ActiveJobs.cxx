@@ -14,6 +14,12 @@
 
 #include <remus/server/detail/uuidHelper.h>
 
+#include <remus/proto/WireFormat.h>
+
+#include <boost/make_shared.hpp>
+
+#include <algorithm>
+
 namespace remus{
 namespace server{
 namespace detail{
@@ -24,8 +30,8 @@ ActiveJobs::JobState::JobState(const zmq::SocketIdentity& workerIdentity,
          remus::STATUS_TYPE stat):
   WorkerAddress(workerIdentity),
   jstatus(id,stat),
-  jresult(id),
-  haveResult(false)
+  haveResult(false),
+  RemoveAt(boost::posix_time::not_a_date_time)
 {
 
 }
@@ -42,26 +48,124 @@ bool ActiveJobs::JobState::canUpdateStatusTo(remus::proto::JobStatus s) const
   return jstatus.good() && !s.finished() && (s.failed() || s.inProgress());
 }
 
+//-----------------------------------------------------------------------------
+ActiveJobs::ActiveJobs():
+  Info(),
+  WorkerJobs(),
+  Results(),
+  Watched(),
+  StatusChanges(),
+  Removals(),
+  FinishedTimeToLive(0),
+  FailedTimeToLive(0),
+  ExpiredTimeToLive(0),
+  ReclaimedJobs(0),
+  ReclaimedBytes(0)
+{
+  std::fill(this->NumJobsWithStatus,
+            this->NumJobsWithStatus + remus::EXPIRED + 1, std::size_t(0));
+}
+
 //-----------------------------------------------------------------------------
 bool ActiveJobs::add(const zmq::SocketIdentity &workerIdentity,
-                     const boost::uuids::uuid& id)
+                     const boost::uuids::uuid& id,
+                     boost::int64_t queuedTime)
 {
   if(!this->haveUUID(id))
     {
     JobState ws(workerIdentity,id,remus::QUEUED);
+    remus::proto::JobTimestamps times;
+    times.Queued = queuedTime;
+    if(workerIdentity.size() > 0)
+      {
+      times.Dispatched = remus::proto::JobTimestamps::now();
+      }
+    ws.jstatus.updateTimestamps(times);
     InfoPair pair(id,ws);
     this->Info.insert(pair);
+    ++this->NumJobsWithStatus[remus::QUEUED];
+    if(workerIdentity.size() > 0)
+      {
+      this->WorkerJobs[workerIdentity].insert(id);
+      }
     return true;
     }
   return false;
 }
 
+//-----------------------------------------------------------------------------
+bool ActiveJobs::add(const zmq::SocketIdentity &workerIdentity,
+                     const boost::uuids::uuid& id,
+                     boost::int64_t queuedTime,
+                     remus::server::detail::SocketMonitor monitor)
+{
+  if(!this->add(workerIdentity, id, queuedTime))
+    {
+    return false;
+    }
+  if(workerIdentity.size() > 0 &&
+     monitor.wasReportedUnresponsive(workerIdentity))
+    {
+    this->markExpiredJobs(workerIdentity);
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::watch(const boost::uuids::uuid& id)
+{
+  this->Watched.insert(id);
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::unwatch(const boost::uuids::uuid& id)
+{
+  this->Watched.erase(id);
+}
+
+//-----------------------------------------------------------------------------
+bool ActiveJobs::watched(const boost::uuids::uuid& id) const
+{
+  return this->Watched.find(id) != this->Watched.end();
+}
+
+//-----------------------------------------------------------------------------
+std::vector<remus::proto::JobStatus> ActiveJobs::takeStatusChanges()
+{
+  std::vector<remus::proto::JobStatus> changes;
+  changes.reserve(this->StatusChanges.size());
+  typedef std::map<boost::uuids::uuid,
+                   remus::proto::JobStatus>::const_iterator ChangeIt;
+  for(ChangeIt i = this->StatusChanges.begin();
+      i != this->StatusChanges.end(); ++i)
+    {
+    changes.push_back(i->second);
+    }
+  this->StatusChanges.clear();
+  return changes;
+}
+
 //-----------------------------------------------------------------------------
 bool ActiveJobs::remove(const boost::uuids::uuid& id)
 {
-  if(this->haveUUID(id))
+  InfoIt item = this->Info.find(id);
+  if(item != this->Info.end())
     {
-    this->Info.erase(id);
+    WorkerJobsType::iterator worker =
+                          this->WorkerJobs.find(item->second.WorkerAddress);
+    if(worker != this->WorkerJobs.end())
+      {
+      worker->second.erase(id);
+      if(worker->second.empty())
+        {
+        this->WorkerJobs.erase(worker);
+        }
+      }
+
+    this->Results.remove(id);
+    this->Watched.erase(id);
+    --this->NumJobsWithStatus[item->second.jstatus.status()];
+    this->Info.erase(item);
     return true;
     }
   return false;
@@ -105,11 +209,28 @@ const remus::proto::JobStatus& ActiveJobs::status(
 }
 
 //-----------------------------------------------------------------------------
-const remus::proto::JobResult& ActiveJobs::result(
+remus::proto::JobResult ActiveJobs::result(const boost::uuids::uuid& id)
+{
+  const EncodedResult& r = this->encodedResult(id);
+  if(r.Size == 0)
+    {
+    return remus::proto::JobResult(id);
+    }
+  if(!r.Id.is_nil())
+    {
+    //the bytes are shared with the job they were sent for
+    const remus::proto::JobResult shared =
+                                  remus::proto::to_JobResult(r.Data,r.Size);
+    return remus::proto::JobResult(id, shared.formatType(), shared.data());
+    }
+  return remus::proto::to_JobResult(r.Data,r.Size);
+}
+
+//-----------------------------------------------------------------------------
+ActiveJobs::EncodedResult ActiveJobs::encodedResult(
     const boost::uuids::uuid& id)
 {
-  InfoConstIt item = this->Info.find(id);
-  return item->second.jresult;
+  return this->Results.get(id);
 }
 
 //-----------------------------------------------------------------------------
@@ -122,60 +243,266 @@ void ActiveJobs::updateStatus(const remus::proto::JobStatus& s)
     //we don't want the worker to ever explicitly state it has finished the
     //job. That is why we use canUpdateStatusTo, which checks the status
     //we are moving too
-    item->second.jstatus = s;
+    this->setStatus(item->second,s);
+    this->scheduleRemoval(s.id(),item->second);
     }
 }
 
 //-----------------------------------------------------------------------------
 void ActiveJobs::updateResult(const remus::proto::JobResult& r)
 {
-  InfoIt item = this->Info.find(r.id());
+  boost::shared_ptr<std::string> encoded =
+                  boost::make_shared<std::string>(remus::proto::to_binary(r));
+  this->updateResult(r.id(),
+                     EncodedResult(encoded->data(),encoded->size(),encoded));
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::updateResult(const boost::uuids::uuid& id,
+                              const EncodedResult& r)
+{
+  InfoIt item = this->Info.find(id);
   if(item != this->Info.end())
     {
     //once we get a result we can state our status is now finished,
     //since the uploading of data has finished.
     if( item->second.jstatus.good() || item->second.jstatus.finished() )
       {
-      item->second.jstatus = remus::proto::JobStatus(r.id(),remus::FINISHED);
+      this->setStatus(item->second,
+                      remus::proto::JobStatus(id,remus::FINISHED));
       }
 
     //update the client result data to equal the server data
-    item->second.jresult = r;
+    this->Results.add(id,r);
     item->second.haveResult = true;
+    this->scheduleRemoval(id,item->second);
     }
 }
 
 //-----------------------------------------------------------------------------
 void ActiveJobs::markExpiredJobs(remus::server::detail::SocketMonitor monitor)
 {
-  for(InfoIt item = this->Info.begin(); item != this->Info.end(); ++item)
+  //only query the monitor, checking its heartbeats would take the changes
+  //from whoever else is relying on them
+  std::vector<zmq::SocketIdentity> expired;
+  for(WorkerJobsType::const_iterator i = this->WorkerJobs.begin();
+      i != this->WorkerJobs.end(); ++i)
+    {
+    if(monitor.isUnresponsive(i->first))
+      {
+      expired.push_back(i->first);
+      }
+    }
+
+  for(std::size_t i=0; i < expired.size(); ++i)
+    {
+    this->markExpiredJobs(expired[i]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::markExpiredJobs(
+                  const remus::server::detail::SocketStateChanges& changes)
+{
+  typedef std::vector<zmq::SocketIdentity>::const_iterator SocketIt;
+  for(SocketIt i=changes.Dead.begin(); i != changes.Dead.end(); ++i)
     {
+    this->markExpiredJobs(*i);
+    }
+  for(SocketIt i=changes.Unresponsive.begin();
+      i != changes.Unresponsive.end(); ++i)
+    {
+    this->markExpiredJobs(*i);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::markExpiredJobs(const zmq::SocketIdentity& workerIdentity)
+{
+  WorkerJobsType::const_iterator worker = this->WorkerJobs.find(workerIdentity);
+  if(worker == this->WorkerJobs.end())
+    {
+    return;
+    }
+
+  typedef std::set<boost::uuids::uuid>::const_iterator IdIt;
+  for(IdIt id = worker->second.begin(); id != worker->second.end(); ++id)
+    {
+    JobState& state = this->Info.find(*id)->second;
+
     //we can only mark jobs that are IN_PROGRESS or QUEUED as failed.
     //FINISHED is more important than failed
-    const bool is_status_valid_to_expire = (item->second.jstatus.queued() ||
-                                           item->second.jstatus.inProgress());
-    const bool worker_is_unresponsive = monitor.isUnresponsive(
-                                                  item->second.WorkerAddress);
-    if (is_status_valid_to_expire && worker_is_unresponsive)
+    const bool is_status_valid_to_expire = (state.jstatus.queued() ||
+                                           state.jstatus.inProgress());
+    if (is_status_valid_to_expire)
       {
       //marking the job status as expired
-      item->second.jstatus =
-          remus::proto::JobStatus( item->second.jstatus.id(),remus::EXPIRED);
+      this->setStatus(state, remus::proto::JobStatus( *id, remus::EXPIRED));
+      this->scheduleRemoval(*id,state);
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::timeToLive(remus::STATUS_TYPE status, boost::int64_t millisec)
+{
+  switch(status)
+    {
+    case remus::FINISHED:
+      this->FinishedTimeToLive = millisec;
+      break;
+    case remus::FAILED:
+      this->FailedTimeToLive = millisec;
+      break;
+    case remus::EXPIRED:
+      this->ExpiredTimeToLive = millisec;
+      break;
+    default:
+      //only jobs that are done can be removed
+      return;
+    }
+
+  for(InfoIt i = this->Info.begin(); i != this->Info.end(); ++i)
+    {
+    if(i->second.jstatus.status() == status)
+      {
+      this->scheduleRemoval(i->first,i->second);
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+boost::int64_t ActiveJobs::timeToLive(remus::STATUS_TYPE status) const
+{
+  switch(status)
+    {
+    case remus::FINISHED:
+      return this->FinishedTimeToLive;
+    case remus::FAILED:
+      return this->FailedTimeToLive;
+    case remus::EXPIRED:
+      return this->ExpiredTimeToLive;
+    default:
+      return 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::scheduleRemoval(const boost::uuids::uuid& id,
+                                 JobState& state)
+{
+  //a job is only scheduled once, when it first becomes done. Jobs don't
+  //leave the done states, so the removal time never needs to move
+  const boost::int64_t ttl = this->timeToLive(state.jstatus.status());
+  if(ttl <= 0 || !state.RemoveAt.is_not_a_date_time())
+    {
+    return;
+    }
+
+  state.RemoveAt = boost::posix_time::microsec_clock::local_time() +
+                   boost::posix_time::milliseconds(ttl);
+  this->Removals.push( Removal(state.RemoveAt,id) );
+}
+
+//-----------------------------------------------------------------------------
+std::size_t ActiveJobs::collectGarbage(const boost::posix_time::ptime& now,
+                                       std::size_t maxJobs,
+                                       std::vector<boost::uuids::uuid>* removed)
+{
+  std::size_t numRemoved = 0;
+  for(std::size_t examined = 0; examined < maxJobs &&
+      !this->Removals.empty() && this->Removals.top().When <= now; ++examined)
+    {
+    const Removal next = this->Removals.top();
+    this->Removals.pop();
+
+    //skip jobs that a client already retrieved and removed
+    InfoIt item = this->Info.find(next.Id);
+    if(item != this->Info.end() && item->second.RemoveAt == next.When)
+      {
+      this->ReclaimedBytes += this->Results.resultSize(next.Id);
+      ++this->ReclaimedJobs;
+      this->remove(next.Id);
+      ++numRemoved;
+      if(removed)
+        {
+        removed->push_back(next.Id);
+        }
       }
     }
+  return numRemoved;
 }
 
 //-----------------------------------------------------------------------------
 std::set<zmq::SocketIdentity> ActiveJobs::activeWorkers() const
 {
   std::set<zmq::SocketIdentity> workerAddresses;
-  for(InfoConstIt item = this->Info.begin(); item != this->Info.end(); ++item)
+  for(WorkerJobsType::const_iterator worker = this->WorkerJobs.begin();
+      worker != this->WorkerJobs.end(); ++worker)
     {
-    workerAddresses.insert(item->second.WorkerAddress);
+    workerAddresses.insert(worker->first);
     }
   return workerAddresses;
 }
 
+//-----------------------------------------------------------------------------
+std::size_t ActiveJobs::numJobs(remus::STATUS_TYPE status) const
+{
+  if(status < remus::INVALID_STATUS || status > remus::EXPIRED)
+    {
+    return 0;
+    }
+  return this->NumJobsWithStatus[status];
+}
+
+//-----------------------------------------------------------------------------
+void ActiveJobs::setStatus(JobState& state, const remus::proto::JobStatus& s)
+{
+  //statuses from workers don't carry our timestamps, so keep the ones
+  //we have
+  remus::proto::JobTimestamps times = state.jstatus.timestamps();
+  if(s.inProgress() && times.FirstProgress == 0)
+    {
+    times.FirstProgress = remus::proto::JobTimestamps::now();
+    }
+  else if((s.finished() || s.failed()) && times.Finished == 0)
+    {
+    times.Finished = remus::proto::JobTimestamps::now();
+    }
+
+  --this->NumJobsWithStatus[state.jstatus.status()];
+  state.jstatus = s;
+  state.jstatus.updateTimestamps(times);
+  ++this->NumJobsWithStatus[state.jstatus.status()];
+
+  if(!this->Watched.empty())
+    {
+    std::set<boost::uuids::uuid>::iterator w =
+                                      this->Watched.find(state.jstatus.id());
+    if(w != this->Watched.end())
+      {
+      typedef std::map<boost::uuids::uuid,
+                       remus::proto::JobStatus>::iterator ChangeIt;
+      ChangeIt change = this->StatusChanges.find(state.jstatus.id());
+      if(change == this->StatusChanges.end())
+        {
+        this->StatusChanges.insert(std::make_pair(state.jstatus.id(),
+                                                  state.jstatus));
+        }
+      else
+        {
+        change->second = state.jstatus;
+        }
+
+      //a job that isn't queued or in progress won't change again
+      if(!state.jstatus.good())
+        {
+        this->Watched.erase(w);
+        }
+      }
+    }
+}
+
 
 }
 }
@@ -17,10 +17,18 @@
 #include <remus/proto/JobStatus.h>
 #include <remus/proto/zmqSocketIdentity.h>
 
+#include <remus/server/detail/ResultStore.h>
 #include <remus/server/detail/SocketMonitor.h>
 
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <functional>
 #include <map>
+#include <queue>
 #include <set>
+#include <vector>
 
 namespace remus{
 namespace server{
@@ -29,10 +37,25 @@ namespace detail{
 class ActiveJobs
 {
   public:
-    ActiveJobs():Info(){}
+    typedef remus::server::detail::EncodedResult EncodedResult;
+
+    ActiveJobs();
+
+    //add a job that has been given to a worker. Jobs recovered from a
+    //journal are added with an empty worker identity, as they have no worker.
+    //queuedTime is when the job was queued, see JobTimestamps, and the job
+    //is stamped as dispatched when it has a worker
+    bool add(const zmq::SocketIdentity& workerIdentity,
+             const boost::uuids::uuid& id,
+             boost::int64_t queuedTime = 0);
 
+    //add a job that has been given to a worker the monitor watches. The
+    //monitor only reports a worker once when it stops responding, so a job
+    //given to a worker it has already reported expires straight away
     bool add(const zmq::SocketIdentity& workerIdentity,
-             const boost::uuids::uuid& id);
+             const boost::uuids::uuid& id,
+             boost::int64_t queuedTime,
+             remus::server::detail::SocketMonitor monitor);
 
     bool remove(const boost::uuids::uuid& id);
 
@@ -45,8 +68,13 @@ class ActiveJobs
     //returns a worker side job status object for a job
     const remus::proto::JobStatus& status(const boost::uuids::uuid& id);
 
-    //returns a worker side job result object for a job
-    const remus::proto::JobResult& result(const boost::uuids::uuid& id);
+    //returns a worker side job result object for a job, decoded from
+    //the encoded result
+    remus::proto::JobResult result(const boost::uuids::uuid& id);
+
+    //returns the encoded worker side job result for a job, see
+    //ResultStore::get
+    EncodedResult encodedResult(const boost::uuids::uuid& id);
 
     //update the job status of a job.
     //valid values are:
@@ -60,17 +88,70 @@ class ActiveJobs
 
     void updateResult(const remus::proto::JobResult& r);
 
+    //store the result of a job as the encoded bytes the worker sent,
+    //without copying them
+    void updateResult(const boost::uuids::uuid& id, const EncodedResult& r);
+
+    //mark the jobs of every worker the monitor considers dead or
+    //unresponsive as expired. The monitor is only queried, so this can be
+    //used alongside anything else that checks its heartbeats
     void markExpiredJobs(remus::server::detail::SocketMonitor monitor);
 
+    //mark the jobs of every worker that is dead or unresponsive as expired
+    void markExpiredJobs(const remus::server::detail::SocketStateChanges& changes);
+
     std::set<zmq::SocketIdentity> activeWorkers() const;
 
+    //record every status change of a job so that it can be pushed to the
+    //clients that subscribed to it, see takeStatusChanges. Jobs can be
+    //watched before they are added, and stop being watched once they
+    //finish, fail, expire or are removed
+    void watch(const boost::uuids::uuid& id);
+    void unwatch(const boost::uuids::uuid& id);
+    bool watched(const boost::uuids::uuid& id) const;
+
+    //the latest status of every watched job whose status changed since
+    //the last call. Changes made between calls are coalesced, so only the
+    //newest status of a job is returned
+    std::vector<remus::proto::JobStatus> takeStatusChanges();
+
+    //the number of jobs, and the number of jobs with a given status
+    std::size_t numJobs() const { return this->Info.size(); }
+    std::size_t numJobs(remus::STATUS_TYPE status) const;
+
+    //how long in milliseconds jobs are kept once they become FINISHED,
+    //FAILED or EXPIRED, after which collectGarbage removes them and their
+    //results. A non positive time keeps the jobs until they are removed,
+    //which is the default. Jobs that already have the status when the time
+    //is set are given the time from when it was set
+    void timeToLive(remus::STATUS_TYPE status, boost::int64_t millisec);
+    boost::int64_t timeToLive(remus::STATUS_TYPE status) const;
+
+    //remove the jobs whose time to live has passed by the given time,
+    //looking at no more than maxJobs jobs so that removing a large number
+    //of jobs is spread over many calls. Returns the number of jobs removed,
+    //and adds their ids to removed when it isn't NULL
+    std::size_t collectGarbage(const boost::posix_time::ptime& now,
+                               std::size_t maxJobs,
+                               std::vector<boost::uuids::uuid>* removed = NULL);
+
+    //the number of jobs, and bytes of results, that collectGarbage removed
+    boost::uint64_t reclaimedJobs() const { return this->ReclaimedJobs; }
+    boost::uint64_t reclaimedBytes() const { return this->ReclaimedBytes; }
+
+    //the store holding the results of finished jobs, used to control the
+    //memory budget of results and to get statistics on them
+    remus::server::detail::ResultStore& results() { return this->Results; }
+    const remus::server::detail::ResultStore& results() const
+      { return this->Results; }
+
 private:
     struct JobState
     {
       zmq::SocketIdentity WorkerAddress;
       remus::proto::JobStatus jstatus;
-      remus::proto::JobResult jresult;
       bool haveResult;
+      boost::posix_time::ptime RemoveAt; //when the time to live runs out
 
       JobState(const zmq::SocketIdentity& workerIdentity,
                const boost::uuids::uuid& id,
@@ -79,10 +160,64 @@ private:
       bool canUpdateStatusTo(remus::proto::JobStatus s) const;
     };
 
+    //change the status of a job, keeping the status counts up to date
+    //and stamping when the job first made progress and when it finished
+    void setStatus(JobState& state, const remus::proto::JobStatus& s);
+
     typedef std::pair<boost::uuids::uuid, JobState> InfoPair;
     typedef std::map< boost::uuids::uuid, JobState>::const_iterator InfoConstIt;
     typedef std::map< boost::uuids::uuid, JobState>::iterator InfoIt;
     std::map<boost::uuids::uuid, JobState> Info;
+
+    //the jobs each worker has, so we can expire the jobs of a worker
+    //without looking at every job
+    typedef boost::unordered_map< zmq::SocketIdentity,
+                                  std::set<boost::uuids::uuid> > WorkerJobsType;
+    WorkerJobsType WorkerJobs;
+
+    ResultStore Results;
+
+    //the jobs whose status changes are recorded, and the latest status of
+    //each of them that changed since takeStatusChanges was last called
+    std::set<boost::uuids::uuid> Watched;
+    std::map<boost::uuids::uuid, remus::proto::JobStatus> StatusChanges;
+
+    //the number of jobs with each status
+    std::size_t NumJobsWithStatus[remus::EXPIRED+1];
+
+    //when jobs should be removed, ordered so the earliest removal is at the
+    //top. Jobs that are removed before their time are left in the heap and
+    //skipped when they are popped
+    struct Removal
+    {
+      Removal(const boost::posix_time::ptime& when,
+              const boost::uuids::uuid& id):
+        When(when),
+        Id(id)
+        {}
+
+      bool operator>(const Removal& other) const
+        { return this->When > other.When; }
+
+      boost::posix_time::ptime When;
+      boost::uuids::uuid Id;
+    };
+    std::priority_queue< Removal, std::vector<Removal>,
+                         std::greater<Removal> > Removals;
+
+    boost::int64_t FinishedTimeToLive;
+    boost::int64_t FailedTimeToLive;
+    boost::int64_t ExpiredTimeToLive;
+
+    boost::uint64_t ReclaimedJobs;
+    boost::uint64_t ReclaimedBytes;
+
+    //expire all the jobs of the given worker
+    void markExpiredJobs(const zmq::SocketIdentity& workerIdentity);
+
+    //start the time to live of a job that has become FINISHED, FAILED
+    //or EXPIRED
+    void scheduleRemoval(const boost::uuids::uuid& id, JobState& state);
 };
 
 }
@@ -0,0 +1,261 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/BlobStore.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/make_shared.hpp>
+
+#include <fstream>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+//a blob written to disk. The file is deleted once the store and every
+//mapping of the file are done with it
+struct BlobStore::SpillFile
+{
+  explicit SpillFile(const std::string& path): Path(path) { }
+  ~SpillFile()
+    {
+    boost::system::error_code ec;
+    boost::filesystem::remove(this->Path, ec);
+    }
+
+  std::string Path;
+};
+
+namespace
+{
+//------------------------------------------------------------------------------
+//a read only mapping of a spill file, used as the owner of the mapped bytes
+//and so as a reference to the spilled blob
+struct MappedFile
+{
+  explicit MappedFile(const boost::shared_ptr<void>& file,
+                      const std::string& path):
+    File(file),
+    Mapping(path.c_str(), boost::interprocess::read_only),
+    Region(this->Mapping, boost::interprocess::read_only)
+    {
+    }
+
+  boost::shared_ptr<void> File;
+  boost::interprocess::file_mapping Mapping;
+  boost::interprocess::mapped_region Region;
+};
+}
+
+//------------------------------------------------------------------------------
+BlobStore::BlobStore():
+  MemoryBudget( 512 * 1024 * 1024 ),
+  DiskBudget(0),
+  ScratchDirectory(),
+  Blobs(),
+  Recent(),
+  Stats()
+{
+  boost::system::error_code ec;
+  this->ScratchDirectory =
+                    boost::filesystem::temp_directory_path(ec).string();
+}
+
+//------------------------------------------------------------------------------
+void BlobStore::memoryBudget(boost::uint64_t bytes)
+{
+  this->MemoryBudget = bytes;
+  this->collect();
+}
+
+//------------------------------------------------------------------------------
+void BlobStore::diskBudget(boost::uint64_t bytes)
+{
+  this->DiskBudget = bytes;
+  this->collect();
+}
+
+//------------------------------------------------------------------------------
+void BlobStore::scratchDirectory(const std::string& path)
+{
+  this->ScratchDirectory = path;
+}
+
+//------------------------------------------------------------------------------
+void BlobStore::add(const std::string& hash, const char* data,
+                    std::size_t size,
+                    const boost::shared_ptr<const void>& owner)
+{
+  if(size == 0 || this->have(hash))
+    {
+    return;
+    }
+
+  Entry entry;
+  entry.Memory = Blob(data, size, owner);
+  entry.Size = size;
+  entry.Recent = this->Recent.insert(this->Recent.end(), hash);
+  this->Blobs.insert(std::make_pair(hash,entry));
+  this->Stats.BytesInMemory += size;
+
+  this->collect();
+}
+
+//------------------------------------------------------------------------------
+bool BlobStore::have(const std::string& hash) const
+{
+  return this->Blobs.find(hash) != this->Blobs.end();
+}
+
+//------------------------------------------------------------------------------
+Blob BlobStore::get(const std::string& hash)
+{
+  BlobMap::iterator item = this->Blobs.find(hash);
+  if(item == this->Blobs.end())
+    {
+    ++this->Stats.Misses;
+    return Blob();
+    }
+
+  //mark the blob as the most recently used
+  Entry& entry = item->second;
+  this->Recent.splice(this->Recent.end(), this->Recent, entry.Recent);
+  if(!entry.File)
+    {
+    ++this->Stats.Hits;
+    return entry.Memory;
+    }
+
+  try
+    {
+    boost::shared_ptr<MappedFile> mapped =
+        boost::make_shared<MappedFile>(entry.File, entry.File->Path);
+    ++this->Stats.Hits;
+    return Blob(static_cast<const char*>(mapped->Region.get_address()),
+                mapped->Region.get_size(),
+                mapped);
+    }
+  catch(boost::interprocess::interprocess_exception&)
+    {
+    //the spill file has gone missing, so we no longer have the blob
+    ++this->Stats.Misses;
+    this->evict(item);
+    return Blob();
+    }
+}
+
+//------------------------------------------------------------------------------
+std::size_t BlobStore::references(const std::string& hash) const
+{
+  BlobMap::const_iterator item = this->Blobs.find(hash);
+  if(item == this->Blobs.end())
+    {
+    return 0;
+    }
+  //the store holds one reference itself
+  const Entry& entry = item->second;
+  const long count = entry.File ? entry.File.use_count()
+                                : entry.Memory.Owner.use_count();
+  return static_cast<std::size_t>(count - 1);
+}
+
+//------------------------------------------------------------------------------
+void BlobStore::collect()
+{
+  //spill the least recently used blobs first, and drop them when they
+  //could never fit on disk
+  std::list<std::string>::iterator i = this->Recent.begin();
+  while(this->Stats.BytesInMemory > this->MemoryBudget &&
+        i != this->Recent.end())
+    {
+    BlobMap::iterator item = this->Blobs.find(*i);
+    ++i;
+    Entry& entry = item->second;
+    if(entry.File || this->referenced(entry))
+      {
+      continue;
+      }
+    if(entry.Size > this->DiskBudget || !this->spill(entry))
+      {
+      this->evict(item);
+      }
+    }
+
+  //then make room on disk by dropping the least recently used spills
+  i = this->Recent.begin();
+  while(this->Stats.BytesOnDisk > this->DiskBudget &&
+        i != this->Recent.end())
+    {
+    BlobMap::iterator item = this->Blobs.find(*i);
+    ++i;
+    if(item->second.File && !this->referenced(item->second))
+      {
+      this->evict(item);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+bool BlobStore::referenced(const Entry& entry) const
+{
+  return entry.File ? entry.File.use_count() > 1
+                    : entry.Memory.Owner.use_count() > 1;
+}
+
+//------------------------------------------------------------------------------
+bool BlobStore::spill(Entry& entry)
+{
+  boost::filesystem::path path(this->ScratchDirectory);
+  path /= boost::filesystem::unique_path("remus_blob_%%%%-%%%%-%%%%-%%%%");
+
+  boost::shared_ptr<SpillFile> file =
+                        boost::make_shared<SpillFile>(path.string());
+  std::ofstream out(file->Path.c_str(), std::ios::out | std::ios::binary);
+  out.write(entry.Memory.Data, static_cast<std::streamsize>(entry.Size));
+  out.close();
+  if(!out)
+    {
+    return false;
+    }
+
+  entry.File = file;
+  entry.Memory = Blob();
+
+  this->Stats.BytesInMemory -= entry.Size;
+  this->Stats.BytesOnDisk += entry.Size;
+  ++this->Stats.BlobsSpilled;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void BlobStore::evict(BlobMap::iterator item)
+{
+  Entry& entry = item->second;
+  if(entry.File)
+    {
+    this->Stats.BytesOnDisk -= entry.Size;
+    }
+  else
+    {
+    this->Stats.BytesInMemory -= entry.Size;
+    }
+  ++this->Stats.BlobsEvicted;
+  this->Recent.erase(entry.Recent);
+  this->Blobs.erase(item);
+}
+
+}
+}
+}
@@ -0,0 +1,151 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_BlobStore_h
+#define remus_server_detail_BlobStore_h
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <list>
+#include <string>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//a view of the data of a blob, Owner keeps the data alive. Every view
+//that is alive counts as a reference to the blob
+struct Blob
+{
+  Blob(): Data(NULL), Size(0), Owner() {}
+  Blob(const char* data, std::size_t size,
+       const boost::shared_ptr<const void>& owner):
+    Data(data), Size(size), Owner(owner) {}
+
+  bool valid() const { return this->Owner ? true : false; }
+
+  const char* Data;
+  std::size_t Size;
+  boost::shared_ptr<const void> Owner;
+};
+
+//statistics on how a BlobStore has been used
+struct BlobStoreStats
+{
+  BlobStoreStats():
+    Hits(0),
+    Misses(0),
+    BlobsSpilled(0),
+    BlobsEvicted(0),
+    BytesInMemory(0),
+    BytesOnDisk(0)
+    {}
+
+  //lookups of blobs that we had, and didn't have
+  boost::uint64_t Hits;
+  boost::uint64_t Misses;
+
+  //total number of blobs written to spill files, and dropped altogether
+  boost::uint64_t BlobsSpilled;
+  boost::uint64_t BlobsEvicted;
+
+  //bytes of the blobs currently held in memory and in spill files
+  boost::uint64_t BytesInMemory;
+  boost::uint64_t BytesOnDisk;
+};
+
+//Holds the data of job contents by the MD5 hash of the data, so clients
+//that submit the same data many times only have to upload it once, and
+//every job using the data shares one copy of it.
+//
+//A blob is referenced by every view of it that is alive, which the
+//contents of queued jobs hold. Blobs nothing references are kept as a
+//cache: once the blobs in memory are over the memory budget the least
+//recently used of them are written to files in the scratch directory, and
+//once the spilled blobs are over the disk budget the least recently used
+//are dropped. Referenced blobs are never dropped.
+class BlobStore
+{
+public:
+  //construct a store with a memory budget of 512MB and no disk budget
+  BlobStore();
+
+  //the number of bytes of blobs to keep in memory before spilling
+  void memoryBudget(boost::uint64_t bytes);
+  boost::uint64_t memoryBudget() const { return this->MemoryBudget; }
+
+  //the number of bytes of blobs to keep in spill files before dropping
+  //them, zero drops blobs instead of spilling them
+  void diskBudget(boost::uint64_t bytes);
+  boost::uint64_t diskBudget() const { return this->DiskBudget; }
+
+  //the directory spill files are written to, defaults to the temp directory
+  void scratchDirectory(const std::string& path);
+  const std::string& scratchDirectory() const { return this->ScratchDirectory; }
+
+  //store the data under its hash, holding owner to keep the data alive.
+  //Adding a hash we already have does nothing. Empty data isn't stored
+  void add(const std::string& hash, const char* data, std::size_t size,
+           const boost::shared_ptr<const void>& owner);
+
+  bool have(const std::string& hash) const;
+
+  //returns a view of a blob, memory mapping it if it was spilled. Returns
+  //an invalid blob if we don't have it
+  Blob get(const std::string& hash);
+
+  //the number of views of the blob that are alive
+  std::size_t references(const std::string& hash) const;
+
+  //spill and drop the blobs nothing references until we are within the
+  //budgets. Blobs stop being referenced as the jobs using them are done,
+  //so this is called regularly as well as when blobs are added
+  void collect();
+
+  std::size_t size() const { return this->Blobs.size(); }
+
+  const BlobStoreStats& stats() const { return this->Stats; }
+
+private:
+  struct SpillFile;
+  struct Entry
+  {
+    Blob Memory; //valid while the blob is in memory
+    boost::shared_ptr<SpillFile> File; //valid once the blob is spilled
+    std::size_t Size;
+    std::list<std::string>::iterator Recent;
+  };
+
+  typedef boost::unordered_map<std::string, Entry> BlobMap;
+
+  bool referenced(const Entry& entry) const;
+  bool spill(Entry& entry);
+  void evict(BlobMap::iterator item);
+
+  boost::uint64_t MemoryBudget;
+  boost::uint64_t DiskBudget;
+  std::string ScratchDirectory;
+  BlobMap Blobs;
+
+  //the hashes of every blob, least recently used first
+  std::list<std::string> Recent;
+
+  BlobStoreStats Stats;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,843 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/JobJournal.h>
+
+#include <remus/proto/JobResult.h>
+#include <remus/proto/JobUpload.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/proto/binaryHelpers.h>
+
+#include <remus/server/detail/uuidHelper.h>
+
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+  #include <io.h>
+#else
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+//The journal is a sequence of records, each written as:
+// bytes 0-7: length of the body in bytes
+// bytes 8-11: crc32 of the body
+// body byte 0: record type
+// body bytes 1-16: job uuid
+// rest of the body: payload, which depends on the record type
+//
+//Blob records hold the data of a job content, and in place of a job uuid
+//carry the 16 bytes of the MD5 hash of the data. Uploaded records describe
+//a submission whose contents are held in blob records, so data that many
+//submissions share is only written once.
+//
+//Shared result records finish a job with the result of an earlier
+//finished record, whose job uuid is their payload.
+//
+//All integers are little endian.
+
+namespace remus{
+namespace server{
+namespace detail{
+
+namespace
+{
+enum RecordType { QueuedRecord = 1, DispatchedRecord = 2, FailedRecord = 3,
+                  FinishedRecord = 4, RemovedRecord = 5, BlobRecord = 6,
+                  UploadedRecord = 7, SharedResultRecord = 8 };
+
+static const std::size_t RecordHeaderSize = 12;
+static const std::size_t RecordBodyPrefix = 17;
+
+//write records to the file once this many bytes are pending, so a large
+//batch doesn't hold every record in memory until it is committed
+static const std::size_t MaxPendingBytes = 1024 * 1024;
+
+//payloads at least this large are written to the file straight from the
+//memory of the caller, instead of being copied into the pending records
+static const std::size_t DirectPayloadBytes = 64 * 1024;
+
+//------------------------------------------------------------------------------
+boost::uint64_t record_size(std::size_t payload)
+{
+  return RecordHeaderSize + RecordBodyPrefix + payload;
+}
+
+//------------------------------------------------------------------------------
+//fill record with the header and body prefix of a record holding payload,
+//record must hold RecordHeaderSize + RecordBodyPrefix bytes
+void write_record_prefix(char* record, boost::uint8_t type,
+                         const boost::uuids::uuid& id,
+                         const char* payload, std::size_t size)
+{
+  const std::size_t bodySize = RecordBodyPrefix + size;
+
+  remus::internal::BinaryWriter body(record + RecordHeaderSize);
+  body.putUInt8(type);
+  body.putUUID(id);
+
+  boost::crc_32_type crc;
+  crc.process_bytes(record + RecordHeaderSize, RecordBodyPrefix);
+  crc.process_bytes(payload, size);
+
+  remus::internal::BinaryWriter header(record);
+  header.putUInt64(bodySize);
+  header.putUInt32(crc.checksum());
+}
+
+//------------------------------------------------------------------------------
+void write_record(std::string& buffer, boost::uint8_t type,
+                  const boost::uuids::uuid& id,
+                  const char* payload, std::size_t size)
+{
+  const std::size_t start = buffer.size();
+  buffer.resize(start + RecordHeaderSize + RecordBodyPrefix);
+  write_record_prefix(&buffer[start], type, id, payload, size);
+  if(size > 0)
+    {
+    buffer.append(payload, size);
+    }
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t read_uint(const char* data, std::size_t bytes)
+{
+  const unsigned char* d = reinterpret_cast<const unsigned char*>(data);
+  boost::uint64_t v = 0;
+  for(std::size_t i=0; i < bytes; ++i)
+    { v |= static_cast<boost::uint64_t>(d[i]) << (8*i); }
+  return v;
+}
+
+//------------------------------------------------------------------------------
+//convert a MD5 hash, as 32 hex characters, to the id of its blob record
+bool to_blob_id(const std::string& hash, boost::uuids::uuid& id)
+{
+  if(hash.size() != 2 * id.size())
+    {
+    return false;
+    }
+  for(std::size_t i=0; i < hash.size(); ++i)
+    {
+    const char c = hash[i];
+    int v = 0;
+    if(c >= '0' && c <= '9') { v = c - '0'; }
+    else if(c >= 'a' && c <= 'f') { v = c - 'a' + 10; }
+    else if(c >= 'A' && c <= 'F') { v = c - 'A' + 10; }
+    else { return false; }
+    if(i % 2 == 0) { id.data[i/2] = static_cast<boost::uint8_t>(v << 4); }
+    else { id.data[i/2] |= static_cast<boost::uint8_t>(v); }
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//rebuild the encoded submission an uploaded record describes, returns an
+//empty pointer if a blob it uses is missing
+boost::shared_ptr<std::string> to_encoded_submission(
+  const char* manifest, std::size_t size,
+  const boost::unordered_map<boost::uuids::uuid,
+                             boost::shared_ptr<std::string> >& blobs)
+{
+  const remus::proto::JobUpload upload =
+                          remus::proto::to_JobUpload(manifest, size);
+  remus::proto::JobSubmission submission(upload.requirements());
+  typedef remus::proto::JobUpload::ContainerType::const_iterator EntryIt;
+  for(EntryIt i = upload.entries().begin(); i != upload.entries().end(); ++i)
+    {
+    boost::uuids::uuid blobId;
+    if(!to_blob_id(i->Hash, blobId) || blobs.find(blobId) == blobs.end())
+      {
+      return boost::shared_ptr<std::string>();
+      }
+    const boost::shared_ptr<std::string>& blob = blobs.find(blobId)->second;
+    remus::proto::JobContent content(i->FormatType,
+                                     blob->data(), blob->size(),
+                                     blob, i->Hash);
+    content.tag(i->Tag);
+    submission[i->Key] = content;
+    }
+  return boost::make_shared<std::string>(
+                                  remus::proto::to_binary(submission));
+}
+
+//------------------------------------------------------------------------------
+bool is_failed(remus::STATUS_TYPE status)
+{
+  return status == remus::FAILED || status == remus::EXPIRED;
+}
+
+//------------------------------------------------------------------------------
+//write the records a snapshot needs to describe a job, and return the size
+//of the records. A result that an earlier job in the snapshot already holds
+//is only referred to
+boost::uint64_t snapshot_job(
+  const JournaledJob& job, std::string& buffer,
+  boost::unordered_map<boost::uuids::uuid, boost::uuids::uuid>& results)
+{
+  const std::size_t start = buffer.size();
+  if(job.Result)
+    {
+    const boost::uuids::uuid source =
+      remus::proto::to_JobResultId(job.Result->data(), job.Result->size());
+    typedef boost::unordered_map<boost::uuids::uuid,
+                                 boost::uuids::uuid>::const_iterator ResultIt;
+    const ResultIt holder = results.find(source);
+    if(holder != results.end())
+      {
+      write_record(buffer, SharedResultRecord, job.Id,
+                   reinterpret_cast<const char*>(holder->second.data),
+                   holder->second.size());
+      }
+    else
+      {
+      write_record(buffer, FinishedRecord, job.Id,
+                   job.Result->data(), job.Result->size());
+      results.insert(std::make_pair(source, job.Id));
+      }
+    }
+  else if(is_failed(job.Status))
+    {
+    const char status = static_cast<char>(job.Status);
+    write_record(buffer, FailedRecord, job.Id, &status, 1);
+    }
+  else if(job.Submission)
+    {
+    write_record(buffer, QueuedRecord, job.Id,
+                 job.Submission->data(), job.Submission->size());
+    }
+  return buffer.size() - start;
+}
+
+//------------------------------------------------------------------------------
+bool sync_file(std::FILE* file)
+{
+  if(std::fflush(file) != 0)
+    {
+    return false;
+    }
+#ifdef _WIN32
+  return _commit(_fileno(file)) == 0;
+#else
+  return ::fsync(fileno(file)) == 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//open the journal for appending. The file isn't buffered, since records are
+//already gathered into a single write, so a write that fails is seen by
+//fwrite and not by a later flush
+std::FILE* open_journal(const std::string& path)
+{
+  std::FILE* file = std::fopen(path.c_str(), "ab");
+  if(file)
+    {
+    std::setvbuf(file, NULL, _IONBF, 0);
+    }
+  return file;
+}
+
+//------------------------------------------------------------------------------
+bool truncate_file(std::FILE* file, boost::uint64_t size)
+{
+#ifdef _WIN32
+  return _chsize_s(_fileno(file), static_cast<__int64>(size)) == 0;
+#else
+  return ::ftruncate(fileno(file), static_cast<off_t>(size)) == 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//make a rename in the directory durable
+void sync_directory(const boost::filesystem::path& directory)
+{
+#ifndef _WIN32
+  const int fd = ::open(directory.string().c_str(), O_RDONLY);
+  if(fd >= 0)
+    {
+    ::fsync(fd);
+    ::close(fd);
+    }
+#else
+  (void)directory;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//read the jobs described by the journal at path. Reading stops at the first
+//record that is incomplete or fails its checksum
+void read_journal(const std::string& path, std::vector<JournaledJob>& jobs)
+{
+  std::string contents;
+  {
+  std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+  if(!file)
+    {
+    return;
+    }
+  file.seekg(0, std::ios::end);
+  contents.resize(static_cast<std::size_t>(file.tellg()));
+  file.seekg(0, std::ios::beg);
+  if(!contents.empty())
+    {
+    file.read(&contents[0], static_cast<std::streamsize>(contents.size()));
+    contents.resize(static_cast<std::size_t>(file.gcount()));
+    }
+  }
+
+  //jobs in the order they first appear, and where to find each of them
+  std::vector<JournaledJob> found;
+  std::vector<bool> alive;
+  boost::unordered_map<boost::uuids::uuid, std::size_t> index;
+  boost::unordered_map<boost::uuids::uuid,
+                       boost::shared_ptr<std::string> > blobs;
+  //every result read, including those of jobs that have been removed
+  boost::unordered_map<boost::uuids::uuid,
+                       boost::shared_ptr<std::string> > results;
+
+  std::size_t pos = 0;
+  while(contents.size() - pos >= RecordHeaderSize)
+    {
+    const char* record = contents.data() + pos;
+    const boost::uint64_t bodySize = read_uint(record, 8);
+    const boost::uint32_t checksum =
+                        static_cast<boost::uint32_t>(read_uint(record + 8, 4));
+    if(bodySize < RecordBodyPrefix ||
+       bodySize > contents.size() - pos - RecordHeaderSize)
+      {
+      break;
+      }
+
+    const char* body = record + RecordHeaderSize;
+    boost::crc_32_type crc;
+    crc.process_bytes(body, static_cast<std::size_t>(bodySize));
+    if(crc.checksum() != checksum)
+      {
+      break;
+      }
+    pos += RecordHeaderSize + static_cast<std::size_t>(bodySize);
+
+    const boost::uint8_t type = static_cast<boost::uint8_t>(body[0]);
+    boost::uuids::uuid id;
+    std::memcpy(id.data, body + 1, id.size());
+    const char* payload = body + RecordBodyPrefix;
+    const std::size_t size =
+                  static_cast<std::size_t>(bodySize) - RecordBodyPrefix;
+
+    if(type == BlobRecord)
+      {
+      blobs[id] = boost::make_shared<std::string>(payload,size);
+      continue;
+      }
+
+    typedef boost::unordered_map<boost::uuids::uuid, std::size_t>::iterator
+            IndexIt;
+    IndexIt item = index.find(id);
+    if(type == RemovedRecord)
+      {
+      if(item != index.end())
+        {
+        alive[item->second] = false;
+        index.erase(item);
+        }
+      continue;
+      }
+    if(item == index.end())
+      {
+      //snapshots describe finished and failed jobs without a queued record
+      JournaledJob job;
+      job.Id = id;
+      item = index.insert(std::make_pair(id,found.size())).first;
+      found.push_back(job);
+      alive.push_back(true);
+      }
+
+    JournaledJob& job = found[item->second];
+    if(type == QueuedRecord)
+      {
+      job.Submission = boost::make_shared<std::string>(payload,size);
+      }
+    else if(type == UploadedRecord)
+      {
+      job.Submission = to_encoded_submission(payload, size, blobs);
+      }
+    else if(type == DispatchedRecord)
+      {
+      job.Dispatched = true;
+      }
+    else if(type == FailedRecord && size == 1)
+      {
+      //a failed job won't be run again, so we don't need its submission
+      job.Status = static_cast<remus::STATUS_TYPE>(payload[0]);
+      job.Submission.reset();
+      }
+    else if(type == FinishedRecord)
+      {
+      job.Status = remus::FINISHED;
+      job.Result = boost::make_shared<std::string>(payload,size);
+      job.Submission.reset();
+      results[id] = job.Result;
+      }
+    else if(type == SharedResultRecord && size == id.size())
+      {
+      boost::uuids::uuid holder;
+      std::memcpy(holder.data, payload, holder.size());
+      if(results.find(holder) != results.end())
+        {
+        job.Status = remus::FINISHED;
+        job.Result = results[holder];
+        job.Submission.reset();
+        results[id] = job.Result;
+        }
+      }
+    }
+
+  for(std::size_t i=0; i < found.size(); ++i)
+    {
+    if(alive[i])
+      {
+      jobs.push_back(found[i]);
+      }
+    }
+}
+}
+
+//------------------------------------------------------------------------------
+JobJournal::JobJournal():
+  File(NULL),
+  Path(),
+  SyncOnCommit(true),
+  CompactionThreshold(64 * 1024 * 1024),
+  Pending(),
+  Uncommitted(false),
+  PartialRecord(false),
+  FileSize(0),
+  JournaledBlobs(),
+  JournaledResults(),
+  LiveBytes(),
+  TotalLiveBytes(0),
+  Stats()
+{
+}
+
+//------------------------------------------------------------------------------
+JobJournal::~JobJournal()
+{
+  this->close();
+}
+
+//------------------------------------------------------------------------------
+bool JobJournal::open(const std::string& directory,
+                      std::vector<JournaledJob>& jobs)
+{
+  this->close();
+
+  boost::system::error_code ec;
+  boost::filesystem::create_directories(directory, ec);
+  this->Path = (boost::filesystem::path(directory) /
+                "remus_jobs.journal").string();
+
+  //a snapshot left behind by a compaction that didn't finish
+  boost::filesystem::remove(this->Path + ".compact", ec);
+
+  read_journal(this->Path, jobs);
+
+  //start from a snapshot of the jobs we read, which also drops any partly
+  //written record at the end of the journal
+  this->File = open_journal(this->Path);
+  if(!this->File || !this->writeSnapshot(jobs))
+    {
+    if(this->File)
+      {
+      std::fclose(this->File);
+      }
+    this->File = NULL;
+    this->Path.clear();
+    jobs.clear();
+    return false;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void JobJournal::close()
+{
+  if(this->File)
+    {
+    this->commit();
+    std::fclose(this->File);
+    this->File = NULL;
+    }
+  this->Path.clear();
+  this->Pending.clear();
+  this->Uncommitted = false;
+  this->PartialRecord = false;
+  this->FileSize = 0;
+  this->JournaledBlobs.clear();
+  this->JournaledResults.clear();
+  this->LiveBytes.clear();
+  this->TotalLiveBytes = 0;
+}
+
+//------------------------------------------------------------------------------
+void JobJournal::queued(const boost::uuids::uuid& id,
+                        const remus::proto::JobSubmission& submission)
+{
+  if(!this->File)
+    {
+    return;
+    }
+
+  //journal the bytes the client sent when we still have them
+  if(submission.hasEncoded())
+    {
+    this->append(QueuedRecord, id,
+                 submission.encodedData(), submission.encodedSize());
+    this->updateLiveBytes(id, record_size(submission.encodedSize()));
+    }
+  else if(!this->queuedByHash(id, submission))
+    {
+    const std::string encoded = remus::proto::to_binary(submission);
+    this->append(QueuedRecord, id, encoded.data(), encoded.size());
+    this->updateLiveBytes(id, record_size(encoded.size()));
+    }
+}
+
+//------------------------------------------------------------------------------
+bool JobJournal::queuedByHash(const boost::uuids::uuid& id,
+                              const remus::proto::JobSubmission& submission)
+{
+  typedef remus::proto::JobSubmission::const_iterator ContentIt;
+  remus::proto::JobUpload manifest(submission.requirements());
+  std::vector<boost::uuids::uuid> blobIds;
+  for(ContentIt i = submission.begin(); i != submission.end(); ++i)
+    {
+    const remus::proto::JobContent& content = i->second;
+    boost::uuids::uuid blobId;
+    if(content.sourceType() != remus::common::ContentSource::Memory ||
+       !content.hasHash() || !to_blob_id(content.hash(), blobId))
+      {
+      return false;
+      }
+    manifest.add(remus::proto::JobUpload::Entry(i->first,
+                   content.formatType(), content.tag(), content.dataSize(),
+                   content.hash()));
+    blobIds.push_back(blobId);
+    }
+
+  //write the data we haven't journaled yet straight from the contents
+  std::size_t index = 0;
+  for(ContentIt i = submission.begin(); i != submission.end(); ++i, ++index)
+    {
+    if(this->JournaledBlobs.insert(blobIds[index]).second)
+      {
+      this->append(BlobRecord, blobIds[index],
+                   i->second.data(), i->second.dataSize());
+      }
+    }
+
+  const std::string encoded = remus::proto::to_binary(manifest);
+  this->append(UploadedRecord, id, encoded.data(), encoded.size());
+
+  //a snapshot holds the whole submission
+  this->updateLiveBytes(id,
+                record_size(remus::internal::binary_size(submission)));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void JobJournal::dispatched(const boost::uuids::uuid& id)
+{
+  this->append(DispatchedRecord, id, NULL, 0);
+}
+
+//------------------------------------------------------------------------------
+void JobJournal::failed(const boost::uuids::uuid& id,
+                        remus::STATUS_TYPE status)
+{
+  const char s = static_cast<char>(status);
+  this->append(FailedRecord, id, &s, 1);
+  this->updateLiveBytes(id, record_size(1));
+}
+
+//------------------------------------------------------------------------------
+void JobJournal::finished(const boost::uuids::uuid& id,
+                          const char* result, std::size_t size)
+{
+  if(!this->File)
+    {
+    return;
+    }
+
+  //a result that was sent for another job is shared with this one, so
+  //when the journal already holds it we only refer to it
+  const boost::uuids::uuid source = remus::proto::to_JobResultId(result,size);
+  typedef boost::unordered_map<boost::uuids::uuid,
+                               boost::uuids::uuid>::const_iterator ResultIt;
+  const ResultIt holder = this->JournaledResults.find(source);
+  if(source != id && holder != this->JournaledResults.end())
+    {
+    this->append(SharedResultRecord, id,
+                 reinterpret_cast<const char*>(holder->second.data),
+                 holder->second.size());
+    }
+  else
+    {
+    this->append(FinishedRecord, id, result, size);
+    this->JournaledResults.insert(std::make_pair(source, id));
+    }
+  //a snapshot may need to hold the whole result
+  this->updateLiveBytes(id, record_size(size));
+}
+
+//------------------------------------------------------------------------------
+void JobJournal::removed(const boost::uuids::uuid& id)
+{
+  this->append(RemovedRecord, id, NULL, 0);
+  this->updateLiveBytes(id, 0);
+}
+
+//------------------------------------------------------------------------------
+bool JobJournal::commit()
+{
+  if(!this->File || !this->Uncommitted)
+    {
+    return true;
+    }
+
+  //when the records can't be written or synced they stay uncommitted, and
+  //are written again by the next commit
+  const bool written = this->writePending() &&
+                       (this->SyncOnCommit ? sync_file(this->File)
+                                           : std::fflush(this->File) == 0);
+  if(!written)
+    {
+    return false;
+    }
+  this->Uncommitted = false;
+  ++this->Stats.Commits;
+
+  //only compact once most of the journal describes removed jobs, so the
+  //cost of compacting is spread over the records that made it necessary
+  if(this->FileSize > this->CompactionThreshold &&
+     this->FileSize > 2 * this->TotalLiveBytes)
+    {
+    this->compact();
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void JobJournal::append(boost::uint8_t type, const boost::uuids::uuid& id,
+                        const char* payload, std::size_t size)
+{
+  if(!this->File)
+    {
+    return;
+    }
+
+  ++this->Stats.Records;
+  this->Uncommitted = true;
+
+  if(size < DirectPayloadBytes)
+    {
+    write_record(this->Pending, type, id, payload, size);
+    if(this->Pending.size() >= MaxPendingBytes)
+      {
+      this->writePending();
+      }
+    return;
+    }
+
+  //write the pending records, and then the header and the payload from
+  //where it already is. If that fails the record is copied into the
+  //pending records after all, so the next commit writes it again
+  if(this->writePending())
+    {
+    char prefix[RecordHeaderSize + RecordBodyPrefix];
+    write_record_prefix(prefix, type, id, payload, size);
+    const boost::uint64_t start = this->FileSize;
+    if(this->write(prefix, sizeof(prefix)) && this->write(payload, size))
+      {
+      return;
+      }
+    this->truncate(start);
+    }
+  write_record(this->Pending, type, id, payload, size);
+}
+
+//------------------------------------------------------------------------------
+bool JobJournal::writePending()
+{
+  if(this->Pending.empty())
+    {
+    return true;
+    }
+
+  //the records are kept until they have all been written
+  const boost::uint64_t start = this->FileSize;
+  if(!this->write(this->Pending.data(), this->Pending.size()))
+    {
+    this->truncate(start);
+    return false;
+    }
+  this->Pending.clear();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool JobJournal::write(const char* data, std::size_t size)
+{
+  //never write after a partial record, recovery would stop at it
+  if(this->PartialRecord && !this->truncate(this->FileSize))
+    {
+    return false;
+    }
+
+  const std::size_t written = std::fwrite(data, 1, size, this->File);
+  this->FileSize += written;
+  this->Stats.BytesWritten += written;
+  return written == size;
+}
+
+//------------------------------------------------------------------------------
+bool JobJournal::truncate(boost::uint64_t size)
+{
+  std::clearerr(this->File);
+  this->Stats.BytesWritten -= this->FileSize - size;
+  this->FileSize = size;
+  this->PartialRecord = !truncate_file(this->File, size);
+  return !this->PartialRecord;
+}
+
+//------------------------------------------------------------------------------
+bool JobJournal::compact()
+{
+  if(!this->writePending() || std::fflush(this->File) != 0)
+    {
+    return false;
+    }
+
+  std::vector<JournaledJob> jobs;
+  read_journal(this->Path, jobs);
+  return this->writeSnapshot(jobs);
+}
+
+//------------------------------------------------------------------------------
+bool JobJournal::writeSnapshot(const std::vector<JournaledJob>& jobs)
+{
+  //write the snapshot beside the journal, and only replace the journal
+  //once the snapshot is on the disk
+  const std::string snapshotPath = this->Path + ".compact";
+  std::FILE* snapshot = std::fopen(snapshotPath.c_str(), "wb");
+  if(!snapshot)
+    {
+    return false;
+    }
+
+  boost::unordered_map<boost::uuids::uuid, boost::uint64_t> liveBytes;
+  boost::unordered_map<boost::uuids::uuid, boost::uuids::uuid> results;
+  boost::uint64_t totalLiveBytes = 0;
+  boost::uint64_t snapshotSize = 0;
+  bool written = true;
+  std::string buffer;
+  for(std::size_t i=0; i < jobs.size() && written; ++i)
+    {
+    const boost::uint64_t bytes = snapshot_job(jobs[i], buffer, results);
+    if(bytes > 0)
+      {
+      liveBytes[jobs[i].Id] = bytes;
+      totalLiveBytes += bytes;
+      }
+    if(buffer.size() >= MaxPendingBytes || i+1 == jobs.size())
+      {
+      written = std::fwrite(buffer.data(), 1, buffer.size(), snapshot) ==
+                buffer.size();
+      snapshotSize += buffer.size();
+      buffer.clear();
+      }
+    }
+  written = written && sync_file(snapshot);
+  std::fclose(snapshot);
+
+  boost::system::error_code ec;
+  if(!written)
+    {
+    boost::filesystem::remove(snapshotPath, ec);
+    return false;
+    }
+
+  std::fclose(this->File);
+  boost::filesystem::rename(snapshotPath, this->Path, ec);
+  this->File = open_journal(this->Path);
+  if(ec || !this->File)
+    {
+    //keep journaling to whichever file we still have
+    boost::filesystem::remove(snapshotPath, ec);
+    if(!this->File)
+      {
+      this->File = open_journal(this->Path);
+      }
+    return false;
+    }
+  sync_directory(boost::filesystem::path(this->Path).parent_path());
+
+  this->FileSize = snapshotSize;
+  this->Stats.BytesWritten += snapshotSize;
+  this->LiveBytes.swap(liveBytes);
+  this->TotalLiveBytes = totalLiveBytes;
+  //the snapshot holds the submissions in full, and no blob records
+  this->JournaledBlobs.clear();
+  this->JournaledResults.swap(results);
+  ++this->Stats.Compactions;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void JobJournal::updateLiveBytes(const boost::uuids::uuid& id,
+                                 boost::uint64_t bytes)
+{
+  if(!this->File)
+    {
+    return;
+    }
+
+  typedef boost::unordered_map<boost::uuids::uuid, boost::uint64_t>::iterator
+          LiveIt;
+  LiveIt item = this->LiveBytes.find(id);
+  if(item != this->LiveBytes.end())
+    {
+    this->TotalLiveBytes -= item->second;
+    if(bytes == 0)
+      {
+      this->LiveBytes.erase(item);
+      }
+    else
+      {
+      item->second = bytes;
+      }
+    }
+  else if(bytes > 0)
+    {
+    this->LiveBytes.insert(std::make_pair(id,bytes));
+    }
+  this->TotalLiveBytes += bytes;
+}
+
+}
+}
+} //namespace remus::server::detail
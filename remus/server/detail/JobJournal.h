@@ -0,0 +1,220 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_JobJournal_h
+#define remus_server_detail_JobJournal_h
+
+#include <remus/common/remusGlobals.h>
+#include <remus/proto/JobSubmission.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//a job read back from a journal
+struct JournaledJob
+{
+  JournaledJob():
+    Id(),
+    Status(remus::QUEUED),
+    Dispatched(false),
+    Submission(),
+    Result()
+    {}
+
+  boost::uuids::uuid Id;
+
+  //QUEUED until the job finishes or fails
+  remus::STATUS_TYPE Status;
+
+  //true if the job was given to a worker
+  bool Dispatched;
+
+  //the encoded submission, only kept while the job hasn't finished or failed
+  boost::shared_ptr<std::string> Submission;
+
+  //the encoded result, once the job has finished
+  boost::shared_ptr<std::string> Result;
+};
+
+//statistics on how a JobJournal has been used
+struct JobJournalStats
+{
+  JobJournalStats():
+    Records(0),
+    Commits(0),
+    BytesWritten(0),
+    Compactions(0)
+    {}
+
+  boost::uint64_t Records;
+  boost::uint64_t Commits;
+  boost::uint64_t BytesWritten;
+  boost::uint64_t Compactions;
+
+  //the average number of records made durable by each commit
+  double recordsPerCommit() const
+    {
+    return (this->Commits > 0) ?
+           static_cast<double>(this->Records) / this->Commits : 0.0;
+    }
+};
+
+//An append only log of the changes to the jobs a server holds, so that the
+//jobs can be rebuilt after the server process dies.
+//
+//Records are buffered in memory and only written when commit is called, so
+//every change made while handling a batch of messages reaches the disk with
+//a single write and sync. Each record carries a checksum so a record that
+//was only partly written when the process died is detected, and it and
+//everything after it is ignored.
+//
+//The data of submissions whose contents know their hash, such as the
+//submissions assembled from uploads, is journaled once per hash, so data
+//that is uploaded again isn't written again.
+//
+//A job finished with a result that the journal already holds for another
+//job, such as a job whose result was memoized, only refers to that record.
+//
+//Once the journal is much larger than the jobs it still describes it is
+//compacted: a snapshot holding a single record per live job is written to a
+//new file, which then replaces the journal. The same is done when the
+//journal is opened, so a recovered server starts from a snapshot.
+class JobJournal
+{
+public:
+  //construct a closed journal, which ignores every record
+  JobJournal();
+
+  //commits any pending records and closes the journal
+  ~JobJournal();
+
+  //open the journal in the given directory, filling jobs with the jobs
+  //that a previous journal in the directory recorded and never saw removed.
+  //Returns false if the journal couldn't be opened, leaving it closed
+  bool open(const std::string& directory, std::vector<JournaledJob>& jobs);
+
+  //commits any pending records and closes the journal
+  void close();
+
+  bool isOpen() const { return this->File != NULL; }
+
+  //the path of the journal file, empty when the journal is closed
+  const std::string& path() const { return this->Path; }
+
+  //when true, which is the default, commit waits until the records are on
+  //the disk and not just handed to the operating system
+  void syncOnCommit(bool sync) { this->SyncOnCommit = sync; }
+  bool syncOnCommit() const { return this->SyncOnCommit; }
+
+  //the number of bytes the journal can grow to before it is compacted,
+  //defaults to 64MB. It is only compacted when at least half of it
+  //describes jobs that have been removed
+  void compactionThreshold(boost::uint64_t bytes)
+    { this->CompactionThreshold = bytes; }
+  boost::uint64_t compactionThreshold() const
+    { return this->CompactionThreshold; }
+
+  //record changes to a job, the records are made durable by commit
+  void queued(const boost::uuids::uuid& id,
+              const remus::proto::JobSubmission& submission);
+  void dispatched(const boost::uuids::uuid& id);
+  void failed(const boost::uuids::uuid& id, remus::STATUS_TYPE status);
+  void finished(const boost::uuids::uuid& id,
+                const char* result, std::size_t size);
+  void removed(const boost::uuids::uuid& id);
+
+  //returns true if there are records that haven't been committed
+  bool hasUncommitted() const { return this->Uncommitted; }
+
+  //write and sync every record since the last commit. Returns false if
+  //the records couldn't be written or synced, in which case they stay
+  //uncommitted and the next commit tries again
+  bool commit();
+
+  const JobJournalStats& stats() const { return this->Stats; }
+
+private:
+  //journal the submission as a list of the hashes of its contents, writing
+  //the data of each hash the journal doesn't hold yet. Returns false,
+  //journaling nothing, if a content doesn't know its hash
+  bool queuedByHash(const boost::uuids::uuid& id,
+                    const remus::proto::JobSubmission& submission);
+
+  void append(boost::uint8_t type, const boost::uuids::uuid& id,
+              const char* payload, std::size_t size);
+
+  //write the pending records to the file without syncing them. When that
+  //fails the records are kept, and the file is cut back to where they start
+  bool writePending();
+
+  //write data to the end of the file, returns false if only part of it
+  //was written
+  bool write(const char* data, std::size_t size);
+
+  //drop everything past size from the file, such as a partly written record
+  bool truncate(boost::uint64_t size);
+
+  //replace the journal with a snapshot of the jobs it describes
+  bool compact();
+  bool writeSnapshot(const std::vector<JournaledJob>& jobs);
+
+  //track how many bytes of the journal are still needed
+  void updateLiveBytes(const boost::uuids::uuid& id, boost::uint64_t bytes);
+
+  std::FILE* File;
+  std::string Path;
+  bool SyncOnCommit;
+  boost::uint64_t CompactionThreshold;
+
+  //records waiting to be written. Large payloads are never copied here,
+  //see append
+  std::string Pending;
+  bool Uncommitted;
+  //true when a partly written record couldn't be cut from the file yet
+  bool PartialRecord;
+  boost::uint64_t FileSize;
+
+  //the blob records in the journal, by the hash of their data
+  boost::unordered_set<boost::uuids::uuid> JournaledBlobs;
+
+  //the job whose finished record holds a result, by the job id the
+  //result names
+  boost::unordered_map<boost::uuids::uuid, boost::uuids::uuid>
+    JournaledResults;
+
+  //the size of the records each live job would need in a snapshot
+  boost::unordered_map<boost::uuids::uuid, boost::uint64_t> LiveBytes;
+  boost::uint64_t TotalLiveBytes;
+
+  JobJournalStats Stats;
+
+  //make copying not possible
+  JobJournal(const JobJournal&);
+  void operator=(const JobJournal&);
+};
+
+}
+}
+}
+
+#endif
@@ -24,51 +24,59 @@ bool JobQueue::addJob(const boost::uuids::uuid &id,
   const bool can_add = QueuedIds.count(id) == 0;
   if(can_add)
     {
-    QueuedJob newQueuedJob(id,submission);
-    this->QueuedJobs.insert(
-          std::lower_bound( this->QueuedJobs.begin(), this->QueuedJobs.end(),
-                            newQueuedJob ),
-          newQueuedJob);
-    this->QueuedIds.insert(id);
+    //find or create the queue for the requirements of this job
+    QueueContainer::iterator queue = this->Queues.insert(
+          std::make_pair(submission.requirements(),RequirementsQueue())).first;
+    queue->second.Queued.insert(std::make_pair(id,submission));
+
+    this->QueuedIds.insert(std::make_pair(id,
+      JobLocation(queue,remus::proto::JobTimestamps::now())));
+    ++this->NumJobsQueued;
+    ++this->NumJobsAdded;
+
+    this->ChangedRequirements.insert(queue->first);
     }
   return can_add;
 }
 
 //------------------------------------------------------------------------------
-remus::worker::Job JobQueue::takeJob(const remus::proto::JobRequirements& reqs)
+remus::worker::Job JobQueue::takeJob(const remus::proto::JobRequirements& reqs,
+                                     boost::int64_t* queuedTime)
 {
-  std::vector<QueuedJob>* searched_vector = &this->QueuedJobsForWorkers;
-  typedef std::vector<QueuedJob>::iterator iter;
-
-  JobTypeMatches pred(reqs);
-  iter item = std::find_if(searched_vector->begin(), searched_vector->end(),
-                           pred);
-  if(item == searched_vector->end())
+  QueueContainer::iterator queue = this->Queues.find(reqs);
+  if(queue == this->Queues.end())
     {
-    searched_vector = &this->QueuedJobs;
-    item = std::find_if(searched_vector->begin(), searched_vector->end(),
-                        pred);
-    if(item == searched_vector->end())
-      {
-      //return an invalid job
-      return remus::worker::Job();
-      }
+    //return an invalid job
+    return remus::worker::Job();
     }
 
-  //we need to copy the id and the contents of item now into a job
-  //submission, if we use item after the remove_if it is invalid as
-  //remove_if moves the vector items around making what item
-  //is pointing too change
-  remus::worker::Job job(item->Id,item->Submission);
-
-  //again don't use item after the remove_if the iterator is invalid
-  JobIdMatches id_pred(job.id());
+  //we prioritize the jobs that have had a worker dispatched for them, and
+  //take them in the order the workers were dispatched
+  RequirementsQueue& rqueue = queue->second;
+  remus::worker::Job job;
+  if(!rqueue.WaitingForWorkers.empty())
+    {
+    const QueuedJob& item = rqueue.WaitingForWorkers.front();
+    job = remus::worker::Job(item.Id,item.Submission);
+    rqueue.WaitingForWorkers.pop_front();
+    --rqueue.NumWaitingForWorkers;
+    --this->NumJobsWaitingForWorkers;
+    }
+  else
+    {
+    SortedJobs::iterator item = rqueue.Queued.begin();
+    job = remus::worker::Job(item->first,item->second);
+    rqueue.Queued.erase(item);
+    --this->NumJobsQueued;
+    }
 
-  iter new_end = std::remove_if(searched_vector->begin(),
-                                searched_vector->end(),
-                                id_pred);
-  searched_vector->erase(new_end,searched_vector->end());
+  if(queuedTime)
+    {
+    *queuedTime = this->queuedTime(job.id());
+    }
   this->QueuedIds.erase(job.id());
+  this->eraseIfEmpty(queue);
+  ++this->NumJobsTaken;
 
   // std::cout << "JobQueue::takeJob " << job.id() << std::endl;
 
@@ -78,40 +86,103 @@ remus::worker::Job JobQueue::takeJob(const remus::proto::JobRequirements& reqs)
 //------------------------------------------------------------------------------
 remus::proto::JobRequirementsSet JobQueue::waitingJobRequirements() const
 {
-  JobQueue::CollectRequirements result =
-         std::for_each(this->QueuedJobsForWorkers.begin(),
-                       this->QueuedJobsForWorkers.end(),
-                       JobQueue::CollectRequirements());
-  return result.types;
+  remus::proto::JobRequirementsSet types;
+  for(QueueContainer::const_iterator i = this->Queues.begin();
+      i != this->Queues.end(); ++i)
+    {
+    if(!i->second.WaitingForWorkers.empty())
+      { types.insert(i->first); }
+    }
+  return types;
 }
 
 //------------------------------------------------------------------------------
 remus::proto::JobRequirementsSet JobQueue::queuedJobRequirements() const
 {
-  JobQueue::CollectRequirements result =
-          std::for_each(this->QueuedJobs.begin(),
-                        this->QueuedJobs.end(),
-                        JobQueue::CollectRequirements());
-  return result.types;
+  remus::proto::JobRequirementsSet types;
+  for(QueueContainer::const_iterator i = this->Queues.begin();
+      i != this->Queues.end(); ++i)
+    {
+    if(!i->second.Queued.empty())
+      { types.insert(i->first); }
+    }
+  return types;
+}
+
+//------------------------------------------------------------------------------
+unsigned int JobQueue::numJobsWaitingForWorkers(
+                          const remus::proto::JobRequirements& reqs) const
+{
+  QueueContainer::const_iterator queue = this->Queues.find(reqs);
+  return (queue == this->Queues.end()) ? 0 :
+         queue->second.NumWaitingForWorkers;
 }
 
 //------------------------------------------------------------------------------
-bool JobQueue::workerDispatched(const remus::proto::JobRequirements& reqs)
+unsigned int JobQueue::numJobsJustQueued(
+                          const remus::proto::JobRequirements& reqs) const
+{
+  QueueContainer::const_iterator queue = this->Queues.find(reqs);
+  return (queue == this->Queues.end()) ? 0 :
+         static_cast<unsigned int>(queue->second.Queued.size());
+}
+
+//------------------------------------------------------------------------------
+void JobQueue::markRequirementsChanged(
+                          const remus::proto::JobRequirements& reqs)
 {
-  typedef std::vector<QueuedJob>::iterator iter;
-  JobTypeMatches pred(reqs);
+  if(this->Queues.count(reqs) > 0)
+    {
+    this->ChangedRequirements.insert(reqs);
+    }
+}
 
-  iter item = std::find_if(this->QueuedJobs.begin(),
-                           this->QueuedJobs.end(), pred);
-  const bool found = this->QueuedJobs.end() != item;
+//------------------------------------------------------------------------------
+void JobQueue::markAllRequirementsChanged()
+{
+  for(QueueContainer::const_iterator i = this->Queues.begin();
+      i != this->Queues.end(); ++i)
+    {
+    this->ChangedRequirements.insert(i->first);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool JobQueue::workerDispatched(const remus::proto::JobRequirements& reqs)
+{
+  QueueContainer::iterator queue = this->Queues.find(reqs);
+  const bool found = queue != this->Queues.end() &&
+                     !queue->second.Queued.empty();
   if(found)
     {
-    this->QueuedJobsForWorkers.push_back(*item);
-    this->QueuedJobs.erase(item);
+    RequirementsQueue& rqueue = queue->second;
+    SortedJobs::iterator item = rqueue.Queued.begin();
+
+    DispatchedJobs::iterator pos = rqueue.WaitingForWorkers.insert(
+                                      rqueue.WaitingForWorkers.end(),
+                                      QueuedJob(item->first,item->second));
+
+    JobLocation& location = this->QueuedIds.find(item->first)->second;
+    location.IsWaitingForWorker = true;
+    location.Position = pos;
+
+    rqueue.Queued.erase(item);
+    ++rqueue.NumWaitingForWorkers;
+    --this->NumJobsQueued;
+    ++this->NumJobsWaitingForWorkers;
     }
   return found;
 }
 
+//------------------------------------------------------------------------------
+boost::int64_t JobQueue::queuedTime(const boost::uuids::uuid& id) const
+{
+  typedef boost::unordered_map<boost::uuids::uuid, JobLocation>::const_iterator
+          LocationIt;
+  LocationIt location = this->QueuedIds.find(id);
+  return (location != this->QueuedIds.end()) ? location->second.QueuedAt : 0;
+}
+
 //------------------------------------------------------------------------------
 bool JobQueue::haveUUID(const boost::uuids::uuid &id) const
 {
@@ -121,28 +192,49 @@ bool JobQueue::haveUUID(const boost::uuids::uuid &id) const
 //------------------------------------------------------------------------------
 bool JobQueue::remove(const boost::uuids::uuid& id)
 {
-  typedef std::vector<QueuedJob>::iterator iter;
-  JobIdMatches pred(id);
-
-  iter new_end = std::remove_if(this->QueuedJobs.begin(),
-                                this->QueuedJobs.end(),
-                                pred);
-  this->QueuedJobs.erase(new_end,this->QueuedJobs.end());
+  typedef boost::unordered_map<boost::uuids::uuid, JobLocation>::iterator
+          LocationIt;
+  LocationIt location = this->QueuedIds.find(id);
+  if(location == this->QueuedIds.end())
+    {
+    return false;
+    }
 
-  new_end = std::remove_if(this->QueuedJobsForWorkers.begin(),
-                           this->QueuedJobsForWorkers.end(),
-                           pred);
-  this->QueuedJobsForWorkers.erase(new_end,this->QueuedJobsForWorkers.end());
+  QueueContainer::iterator queue = location->second.Queue;
+  if(location->second.IsWaitingForWorker)
+    {
+    queue->second.WaitingForWorkers.erase(location->second.Position);
+    --queue->second.NumWaitingForWorkers;
+    --this->NumJobsWaitingForWorkers;
+    }
+  else
+    {
+    queue->second.Queued.erase(id);
+    --this->NumJobsQueued;
+    }
 
-  return this->QueuedIds.erase(id)==1;
+  this->QueuedIds.erase(location);
+  this->eraseIfEmpty(queue);
+  return true;
 }
 
 //------------------------------------------------------------------------------
 void JobQueue::clear()
 {
   this->QueuedIds.clear();
-  this->QueuedJobs.clear();
-  this->QueuedJobs.clear();
+  this->Queues.clear();
+  this->NumJobsQueued = 0;
+  this->NumJobsWaitingForWorkers = 0;
+  this->ChangedRequirements = remus::proto::JobRequirementsSet();
+}
+
+//------------------------------------------------------------------------------
+void JobQueue::eraseIfEmpty(QueueContainer::iterator queue)
+{
+  if(queue->second.empty())
+    {
+    this->Queues.erase(queue);
+    }
 }
 
 }
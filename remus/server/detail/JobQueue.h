@@ -14,17 +14,19 @@
 #define remus_server_detail_JobQueue_h
 
 #include <remus/proto/JobSubmission.h>
+#include <remus/proto/JobTimestamps.h>
 #include <remus/proto/Message.h>
 
 #include <remus/server/detail/uuidHelper.h>
 
 #include <remus/worker/Job.h>
 
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/uuid/uuid.hpp>
 
-#include <algorithm>
-#include <set>
-#include <vector>
+#include <list>
+#include <map>
 
 namespace remus{
 namespace server{
@@ -33,14 +35,22 @@ namespace detail{
 //A FIFO queue. each mesh type has its own queue
 //where we keep jobs. The uuid for each job
 //must be unique.
+//
+//Jobs are bucketed by their JobRequirements, and every job is also indexed
+//by its uuid, so adding, taking, dispatching and removing a job never has
+//to walk jobs that have a different set of requirements.
 
 class JobQueue
 {
 public:
   JobQueue():
-    QueuedJobs(),
-    QueuedJobsForWorkers(),
-    QueuedIds()
+    Queues(),
+    QueuedIds(),
+    NumJobsQueued(0),
+    NumJobsWaitingForWorkers(0),
+    NumJobsAdded(0),
+    NumJobsTaken(0),
+    ChangedRequirements()
   {}
 
   //Convert a Message and UUID into a WorkerMessage.
@@ -50,8 +60,14 @@ public:
 
   //Removes a job from the queue of the given mesh type.
   //Return it as a worker Job. We prioritize jobs waiting for
-  //workers, and than take jobs that are just queued.
-  remus::worker::Job takeJob(const remus::proto::JobRequirements& reqs);
+  //workers, and than take jobs that are just queued. When given
+  //queuedTime is set to when the job was added, see JobTimestamps
+  remus::worker::Job takeJob(const remus::proto::JobRequirements& reqs,
+                             boost::int64_t* queuedTime = NULL);
+
+  //returns when a job was added to the queue, see JobTimestamps.
+  //returns zero if we don't contain the UUID
+  boost::int64_t queuedTime(const boost::uuids::uuid& id) const;
 
   //returns the types of jobs that are waiting for a worker
   remus::proto::JobRequirementsSet waitingJobRequirements() const;
@@ -61,11 +77,43 @@ public:
 
   //return the number of jobs waiting for workers
   unsigned int numJobsWaitingForWorkers() const
-    { return QueuedJobsForWorkers.size(); }
+    { return NumJobsWaitingForWorkers; }
 
   //return the number of jobs queued but not waiting for a worker
   unsigned int numJobsJustQueued() const
-    { return QueuedJobs.size(); }
+    { return NumJobsQueued; }
+
+  //return the number of jobs that have been added to, and taken from,
+  //the queue over its lifetime
+  boost::uint64_t numJobsAdded() const { return NumJobsAdded; }
+  boost::uint64_t numJobsTaken() const { return NumJobsTaken; }
+
+  //return the number of jobs with the given requirements that are
+  //waiting for workers
+  unsigned int numJobsWaitingForWorkers(
+                          const remus::proto::JobRequirements& reqs) const;
+
+  //return the number of jobs with the given requirements that are
+  //queued but not waiting for a worker
+  unsigned int numJobsJustQueued(
+                          const remus::proto::JobRequirements& reqs) const;
+
+  //returns the requirements of all jobs that have been added since the
+  //last call to clearChangedRequirements. This allows the server to only
+  //look at the requirements whose jobs have changed.
+  const remus::proto::JobRequirementsSet& changedRequirements() const
+    { return ChangedRequirements; }
+
+  //forget all the requirements that have been marked as changed
+  void clearChangedRequirements()
+    { ChangedRequirements = remus::proto::JobRequirementsSet(); }
+
+  //mark the given requirements as changed, if we hold any jobs with them
+  void markRequirementsChanged(const remus::proto::JobRequirements& reqs);
+
+  //mark the requirements of every job we hold as changed, used when
+  //something outside the queue means every job needs to be reconsidered
+  void markAllRequirementsChanged();
 
   //marks the first job with the given type as having
   //a worker dispatched for it.
@@ -91,53 +139,71 @@ private:
 
     boost::uuids::uuid Id;
     remus::proto::JobSubmission Submission;
+  };
 
-    bool operator<(const QueuedJob& other) const
-      { return this->Id < other.Id; }
+  //job queue info, sorted by id when items are added so that we can get
+  //a really rough load balancing when we have multiple clients. This
+  //way jobs that come up for new workers are roughly round robin when
+  //the number of jobs per client is similar.
+  typedef std::map<boost::uuids::uuid,
+                   remus::proto::JobSubmission> SortedJobs;
 
-  };
+  //kept in the order that the jobs are added since this is a real queue
+  //we want the priority of queued jobs that have a working incoming to
+  //match the dispatch order
+  typedef std::list<QueuedJob> DispatchedJobs;
 
-  struct CollectRequirements
+  //all the jobs that share a single set of requirements
+  struct RequirementsQueue
   {
-    void operator()( const QueuedJob& job )
-      { types.insert(job.Submission.requirements()); }
-    remus::proto::JobRequirementsSet types;
-  };
+    RequirementsQueue():
+      Queued(),
+      WaitingForWorkers(),
+      NumWaitingForWorkers(0)
+      {}
 
-  struct JobIdMatches
-  {
-    JobIdMatches(boost::uuids::uuid id):
-    UUID(id) {}
+    bool empty() const
+      { return Queued.empty() && WaitingForWorkers.empty(); }
 
-    bool operator()(const QueuedJob& job) const
-      { return job.Id == UUID; }
+    SortedJobs Queued;
+    DispatchedJobs WaitingForWorkers;
 
-    boost::uuids::uuid UUID;
+    //std::list::size isn't guaranteed to be constant time
+    unsigned int NumWaitingForWorkers;
   };
 
-  struct JobTypeMatches
-  {
-    JobTypeMatches(const remus::proto::JobRequirements& r):
-    Reqs(r) {}
-
-    bool operator()(const QueuedJob& job) const
-      { return Reqs == job.Submission.requirements(); }
+  typedef std::map<remus::proto::JobRequirements,
+                   RequirementsQueue> QueueContainer;
 
-    const remus::proto::JobRequirements& Reqs;
+  //where a job lives, so we can remove it without searching
+  struct JobLocation
+  {
+    JobLocation(QueueContainer::iterator q, boost::int64_t queuedAt):
+      Queue(q),
+      IsWaitingForWorker(false),
+      Position(),
+      QueuedAt(queuedAt)
+      {}
+
+    QueueContainer::iterator Queue;
+    bool IsWaitingForWorker;
+    DispatchedJobs::iterator Position;
+    boost::int64_t QueuedAt;
   };
 
-  //job queue info, sorted by id when items are added so that we can get
-  //a really rough load balancing when we have multiple clients. This
-  //way jobs that come up for new workers are roughly round robin when
-  //the number of jobs per client is similar.
-  std::vector<QueuedJob> QueuedJobs;
+  //remove the queue for a set of requirements once it holds no jobs,
+  //so that iterating the requirements only visits ones that have jobs
+  void eraseIfEmpty(QueueContainer::iterator queue);
 
-  //kept in the order that the jobs are added since this is a real queue
-  //we want the priority of queued jobs that have a working incoming to
-  //match the dispatch order
-  std::vector<QueuedJob> QueuedJobsForWorkers;
+  QueueContainer Queues;
+  boost::unordered_map<boost::uuids::uuid, JobLocation> QueuedIds;
+
+  unsigned int NumJobsQueued;
+  unsigned int NumJobsWaitingForWorkers;
+  boost::uint64_t NumJobsAdded;
+  boost::uint64_t NumJobsTaken;
 
-  std::set<boost::uuids::uuid> QueuedIds;
+  remus::proto::JobRequirementsSet ChangedRequirements;
 
   //make copying not possible
   JobQueue (const JobQueue&);
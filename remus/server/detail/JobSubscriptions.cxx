@@ -0,0 +1,74 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/JobSubscriptions.h>
+
+#include <algorithm>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+JobSubscriptions::JobSubscriptions():
+  Jobs()
+{
+}
+
+//------------------------------------------------------------------------------
+void JobSubscriptions::add(const boost::uuids::uuid& id,
+                           const Subscriber& subscriber)
+{
+  std::vector<Subscriber>& subscribers = this->Jobs[id];
+  if(std::find(subscribers.begin(), subscribers.end(), subscriber) ==
+     subscribers.end())
+    {
+    subscribers.push_back(subscriber);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool JobSubscriptions::have(const boost::uuids::uuid& id) const
+{
+  return this->Jobs.find(id) != this->Jobs.end();
+}
+
+//------------------------------------------------------------------------------
+JobSubscriptions::Notifications
+JobSubscriptions::notify(const std::vector<remus::proto::JobStatus>& statuses)
+{
+  Notifications notifications;
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    JobsType::iterator job = this->Jobs.find(statuses[i].id());
+    if(job == this->Jobs.end())
+      {
+      continue;
+      }
+
+    for(std::size_t j=0; j < job->second.size(); ++j)
+      {
+      notifications[job->second[j]].push_back(statuses[i]);
+      }
+
+    //queued and in progress are the only statuses that can still change
+    if(!statuses[i].good())
+      {
+      this->Jobs.erase(job);
+      }
+    }
+  return notifications;
+}
+
+}
+}
+}
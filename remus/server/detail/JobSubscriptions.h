@@ -0,0 +1,91 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_JobSubscriptions_h
+#define remus_server_detail_JobSubscriptions_h
+
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/proto/zmqSocketIdentity.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//The clients that have asked to be told when the status of a job changes.
+//Each subscription is tagged with the id of the request that made it, so
+//the client can match the statuses we push to the subscription.
+class JobSubscriptions
+{
+public:
+  struct Subscriber
+  {
+    Subscriber(const zmq::SocketIdentity& client,
+               const std::string& requestId,
+               remus::proto::WireFormat::Type format):
+      Client(client),
+      RequestId(requestId),
+      Format(format)
+      {}
+
+    bool operator<(const Subscriber& other) const
+    {
+      if(this->Client == other.Client)
+        { return this->RequestId < other.RequestId; }
+      return this->Client < other.Client;
+    }
+
+    bool operator==(const Subscriber& other) const
+      { return this->Client == other.Client &&
+               this->RequestId == other.RequestId; }
+
+    zmq::SocketIdentity Client;
+    std::string RequestId;
+    //the encoding the client subscribed with, and wants statuses in
+    remus::proto::WireFormat::Type Format;
+  };
+
+  //the statuses to push to each subscriber
+  typedef std::map< Subscriber,
+                    std::vector<remus::proto::JobStatus> > Notifications;
+
+  JobSubscriptions();
+
+  //subscribe to the status changes of a job, subscribing twice with the
+  //same subscriber does nothing
+  void add(const boost::uuids::uuid& id, const Subscriber& subscriber);
+
+  //returns true if anyone is subscribed to the job
+  bool have(const boost::uuids::uuid& id) const;
+
+  //the number of jobs that have subscribers
+  std::size_t numJobs() const { return this->Jobs.size(); }
+
+  //group the statuses by the subscribers that should be told about them.
+  //Once a job has finished, failed or expired its status can't change
+  //again, so its subscriptions are removed
+  Notifications notify(const std::vector<remus::proto::JobStatus>& statuses);
+
+private:
+  typedef std::map< boost::uuids::uuid, std::vector<Subscriber> > JobsType;
+  JobsType Jobs;
+};
+
+}
+}
+}
+
+#endif
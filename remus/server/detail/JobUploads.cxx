@@ -0,0 +1,217 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/JobUploads.h>
+
+#include <remus/common/MD5Hash.h>
+
+#include <boost/make_shared.hpp>
+
+#include <algorithm>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+JobUploads::JobUploads():
+  Uploads(),
+  ReceivedBytes(0),
+  MaximumSize(16ULL * 1024 * 1024 * 1024),
+  Blobs()
+{
+  //the data of a content is held in a single vector
+  this->MaximumSize = std::min<boost::uint64_t>(this->MaximumSize,
+                        std::vector<char>().max_size());
+}
+
+//------------------------------------------------------------------------------
+std::vector<std::string>
+JobUploads::begin(const boost::uuids::uuid& id,
+                  const remus::proto::JobUpload& upload,
+                  const boost::posix_time::ptime& now)
+{
+  UploadsType::iterator existing = this->Uploads.find(id);
+  if(existing != this->Uploads.end())
+    {
+    this->remove(existing);
+    }
+
+  //sizes are checked one at a time so their sum can't wrap
+  const remus::proto::JobUpload::ContainerType& entries = upload.entries();
+  boost::uint64_t declared = 0;
+  for(std::size_t i=0; i < entries.size(); ++i)
+    {
+    if(entries[i].Size > this->MaximumSize - declared)
+      {
+      return std::vector<std::string>();
+      }
+    declared += entries[i].Size;
+    }
+
+  Upload& u = this->Uploads[id];
+  u.Requirements = upload.requirements();
+  u.Remaining = 0;
+  u.LastWrite = now;
+
+  //the space for each content grows as its chunks arrive, so describing
+  //data costs nothing until it is sent. A key that is described twice
+  //keeps the last description
+  for(std::size_t i=0; i < entries.size(); ++i)
+    {
+    Content& content = u.Contents[entries[i].Key];
+    content.Info = entries[i];
+    content.Data = boost::make_shared< std::vector<char> >();
+    content.Stored = Blob();
+    if(!content.Info.Hash.empty() && this->Blobs.have(content.Info.Hash))
+      {
+      Blob blob = this->Blobs.get(content.Info.Hash);
+      if(blob.valid() && blob.Size == content.Info.Size)
+        {
+        content.Stored = blob;
+        }
+      }
+    }
+
+  std::vector<std::string> missing;
+  typedef std::map<std::string, Content>::const_iterator ContentIterator;
+  for(ContentIterator i = u.Contents.begin(); i != u.Contents.end(); ++i)
+    {
+    if(!i->second.Stored.valid() && i->second.Info.Size > 0)
+      {
+      u.Remaining += i->second.Info.Size;
+      missing.push_back(i->first);
+      }
+    }
+  return missing;
+}
+
+//------------------------------------------------------------------------------
+bool JobUploads::write(const remus::proto::JobUploadChunk& chunk,
+                       const boost::posix_time::ptime& now)
+{
+  UploadsType::iterator upload = this->Uploads.find(chunk.id());
+  if(upload == this->Uploads.end())
+    {
+    return false;
+    }
+
+  std::map<std::string, Content>::iterator content =
+                              upload->second.Contents.find(chunk.key());
+  if(content == upload->second.Contents.end() ||
+     content->second.Stored.valid() ||
+     chunk.offset() != content->second.Data->size() ||
+     chunk.dataSize() > content->second.Info.Size - chunk.offset())
+    {
+    this->remove(upload);
+    return false;
+    }
+
+  std::vector<char>& data = *content->second.Data;
+  data.insert(data.end(), chunk.data(), chunk.data() + chunk.dataSize());
+
+  const remus::proto::JobUpload::Entry& info = content->second.Info;
+  if(data.size() == info.Size && !info.Hash.empty())
+    {
+    if(remus::common::MD5Hash(&data[0], data.size()) != info.Hash)
+      {
+      this->remove(upload);
+      return false;
+      }
+    this->Blobs.add(info.Hash, &data[0], data.size(), content->second.Data);
+    }
+
+  upload->second.Remaining -= chunk.dataSize();
+  upload->second.LastWrite = now;
+  this->ReceivedBytes += chunk.dataSize();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool JobUploads::complete(const boost::uuids::uuid& id) const
+{
+  UploadsType::const_iterator upload = this->Uploads.find(id);
+  return upload != this->Uploads.end() && upload->second.Remaining == 0;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission JobUploads::take(const boost::uuids::uuid& id)
+{
+  UploadsType::iterator upload = this->Uploads.find(id);
+  if(upload == this->Uploads.end())
+    {
+    return remus::proto::JobSubmission();
+    }
+
+  //the contents view into the assembled data, which they keep alive
+  remus::proto::JobSubmission submission(upload->second.Requirements);
+  typedef std::map<std::string, Content>::const_iterator ContentIterator;
+  for(ContentIterator i = upload->second.Contents.begin();
+      i != upload->second.Contents.end(); ++i)
+    {
+    const boost::shared_ptr< std::vector<char> >& data = i->second.Data;
+    const Blob& stored = i->second.Stored;
+    //the hash of a described content has been checked, so the content
+    //doesn't need to compute it again
+    remus::proto::JobContent content = stored.valid() ?
+      remus::proto::JobContent(i->second.Info.FormatType,
+                               stored.Data, stored.Size, stored.Owner,
+                               i->second.Info.Hash) :
+      remus::proto::JobContent(i->second.Info.FormatType,
+                               data->empty() ? NULL : &(*data)[0],
+                               data->size(),
+                               data,
+                               i->second.Info.Hash);
+    content.tag(i->second.Info.Tag);
+    submission[i->first] = content;
+    }
+
+  this->remove(upload);
+  return submission;
+}
+
+//------------------------------------------------------------------------------
+std::vector<boost::uuids::uuid>
+JobUploads::expire(const boost::posix_time::ptime& before)
+{
+  std::vector<boost::uuids::uuid> expired;
+  UploadsType::iterator i = this->Uploads.begin();
+  while(i != this->Uploads.end())
+    {
+    if(i->second.LastWrite < before)
+      {
+      expired.push_back(i->first);
+      this->remove(i++);
+      }
+    else
+      {
+      ++i;
+      }
+    }
+  return expired;
+}
+
+//------------------------------------------------------------------------------
+void JobUploads::remove(UploadsType::iterator upload)
+{
+  typedef std::map<std::string, Content>::const_iterator ContentIterator;
+  for(ContentIterator i = upload->second.Contents.begin();
+      i != upload->second.Contents.end(); ++i)
+    {
+    this->ReceivedBytes -= i->second.Data->size();
+    }
+  this->Uploads.erase(upload);
+}
+
+}
+}
+}
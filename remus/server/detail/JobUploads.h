@@ -0,0 +1,121 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_JobUploads_h
+#define remus_server_detail_JobUploads_h
+
+#include <remus/proto/JobSubmission.h>
+#include <remus/proto/JobUpload.h>
+#include <remus/server/detail/BlobStore.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//The jobs that clients are uploading in chunks. The data of each content
+//is assembled in place as its chunks arrive, and once all of it has
+//arrived the upload is taken as a submission that views into the
+//assembled data, so it isn't copied again when the job is queued.
+//
+//Contents that are described with the hash of their data are kept in a
+//BlobStore once they have arrived, so when the same data is uploaded
+//again the client is told it doesn't need to send it.
+class JobUploads
+{
+public:
+  JobUploads();
+
+  //start assembling the job with the given id, replacing any upload
+  //already using the id. Contents whose hash and size match a blob we
+  //already have use that blob, and the keys of the contents that still
+  //need to be sent are returned. An upload that describes more than
+  //maximumSize bytes of data is rejected, and no upload is started
+  std::vector<std::string> begin(const boost::uuids::uuid& id,
+                                 const remus::proto::JobUpload& upload,
+                                 const boost::posix_time::ptime& now);
+
+  //copy the data of the chunk into place. Chunks of a content must arrive
+  //in order. Returns false, and drops the upload, when the chunk doesn't
+  //belong to an upload, isn't the next chunk of a content that needs to be
+  //sent, or holds more data than the content was described with. A
+  //content described with a hash has its data checked against the hash
+  //once the last chunk arrives, and a mismatch drops the upload as well
+  bool write(const remus::proto::JobUploadChunk& chunk,
+             const boost::posix_time::ptime& now);
+
+  //returns true when all of the data of the upload has arrived
+  bool complete(const boost::uuids::uuid& id) const;
+
+  //remove the upload, returning the submission it assembled
+  remus::proto::JobSubmission take(const boost::uuids::uuid& id);
+
+  //remove the uploads that haven't been written to since before, returning
+  //their ids
+  std::vector<boost::uuids::uuid>
+  expire(const boost::posix_time::ptime& before);
+
+  bool have(const boost::uuids::uuid& id) const
+    { return this->Uploads.find(id) != this->Uploads.end(); }
+
+  //the most data a single upload can describe, defaults to 16GB
+  void maximumSize(boost::uint64_t bytes) { this->MaximumSize = bytes; }
+  boost::uint64_t maximumSize() const { return this->MaximumSize; }
+
+  //the number of uploads in progress
+  std::size_t size() const { return this->Uploads.size(); }
+
+  //the bytes of data the uploads in progress have received
+  boost::uint64_t receivedBytes() const { return this->ReceivedBytes; }
+
+  //the data that has been uploaded, by hash
+  BlobStore& blobs() { return this->Blobs; }
+  const BlobStore& blobs() const { return this->Blobs; }
+
+private:
+  struct Content
+  {
+    remus::proto::JobUpload::Entry Info;
+    boost::shared_ptr< std::vector<char> > Data;
+    //valid when the content uses a blob we already had
+    Blob Stored;
+  };
+
+  struct Upload
+  {
+    remus::proto::JobRequirements Requirements;
+    std::map<std::string, Content> Contents;
+    boost::uint64_t Remaining;
+    boost::posix_time::ptime LastWrite;
+  };
+
+  typedef std::map< boost::uuids::uuid, Upload > UploadsType;
+  void remove(UploadsType::iterator upload);
+
+  UploadsType Uploads;
+  boost::uint64_t ReceivedBytes;
+  boost::uint64_t MaximumSize;
+  BlobStore Blobs;
+};
+
+}
+}
+}
+
+#endif
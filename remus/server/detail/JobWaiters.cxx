@@ -0,0 +1,110 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/JobWaiters.h>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+JobWaiters::JobWaiters():
+  Waiters(),
+  Deadlines()
+{
+}
+
+//------------------------------------------------------------------------------
+void JobWaiters::add(const boost::uuids::uuid& id, const Waiter& waiter)
+{
+  this->Waiters.insert( WaitersType::value_type(id, waiter) );
+  this->Deadlines.insert(waiter.Deadline);
+}
+
+//------------------------------------------------------------------------------
+bool JobWaiters::have(const boost::uuids::uuid& id) const
+{
+  return this->Waiters.find(id) != this->Waiters.end();
+}
+
+//------------------------------------------------------------------------------
+boost::posix_time::ptime JobWaiters::nextDeadline() const
+{
+  return this->Deadlines.empty() ? boost::posix_time::ptime()
+                                 : *this->Deadlines.begin();
+}
+
+//------------------------------------------------------------------------------
+JobWaiters::Answers
+JobWaiters::finished(const std::vector<remus::proto::JobStatus>& statuses)
+{
+  Answers answers;
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    //queued and in progress are the only statuses that can still change
+    if(statuses[i].good())
+      {
+      continue;
+      }
+
+    typedef std::pair<WaitersType::iterator,WaitersType::iterator> RangeType;
+    RangeType range = this->Waiters.equal_range(statuses[i].id());
+    for(WaitersType::iterator w = range.first; w != range.second; ++w)
+      {
+      answers.push_back( std::make_pair(w->first, w->second) );
+      this->removeDeadline(w->second.Deadline);
+      }
+    this->Waiters.erase(range.first, range.second);
+    }
+  return answers;
+}
+
+//------------------------------------------------------------------------------
+JobWaiters::Answers JobWaiters::expired(const boost::posix_time::ptime& now)
+{
+  Answers answers;
+  if(this->Deadlines.empty() || *this->Deadlines.begin() > now)
+    {
+    return answers;
+    }
+
+  WaitersType::iterator w = this->Waiters.begin();
+  while(w != this->Waiters.end())
+    {
+    if(w->second.Deadline <= now)
+      {
+      answers.push_back( std::make_pair(w->first, w->second) );
+      this->removeDeadline(w->second.Deadline);
+      this->Waiters.erase(w++);
+      }
+    else
+      {
+      ++w;
+      }
+    }
+  return answers;
+}
+
+//------------------------------------------------------------------------------
+void JobWaiters::removeDeadline(const boost::posix_time::ptime& deadline)
+{
+  std::multiset< boost::posix_time::ptime >::iterator d =
+                                            this->Deadlines.find(deadline);
+  if(d != this->Deadlines.end())
+    {
+    this->Deadlines.erase(d);
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,100 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_JobWaiters_h
+#define remus_server_detail_JobWaiters_h
+
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/proto/zmqSocketIdentity.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//The clients whose wait for job request we haven't answered yet. Each is
+//answered once its job finishes, fails or expires, or once its deadline
+//passes, whichever comes first.
+class JobWaiters
+{
+public:
+  struct Waiter
+  {
+    Waiter(const zmq::SocketIdentity& client,
+           const std::string& requestId,
+           remus::proto::WireFormat::Type format,
+           bool withResult,
+           const boost::posix_time::ptime& deadline):
+      Client(client),
+      RequestId(requestId),
+      Format(format),
+      WithResult(withResult),
+      Deadline(deadline)
+      {}
+
+    zmq::SocketIdentity Client;
+    std::string RequestId;
+    //the encoding the client asked with, and wants to be answered in
+    remus::proto::WireFormat::Type Format;
+    //send the result of a finished job along with its status
+    bool WithResult;
+    boost::posix_time::ptime Deadline;
+  };
+
+  //the waiters to answer, with the job each is waiting on
+  typedef std::vector< std::pair<boost::uuids::uuid, Waiter> > Answers;
+
+  JobWaiters();
+
+  //hold the reply to a client until the job can't change or the deadline
+  void add(const boost::uuids::uuid& id, const Waiter& waiter);
+
+  //returns true if any client is waiting on the job
+  bool have(const boost::uuids::uuid& id) const;
+
+  //the number of clients waiting
+  std::size_t size() const { return this->Waiters.size(); }
+  bool empty() const { return this->Waiters.empty(); }
+
+  //the earliest deadline of the clients waiting, only valid when not empty
+  boost::posix_time::ptime nextDeadline() const;
+
+  //remove and return the clients waiting on jobs that have finished,
+  //failed or expired, according to the given statuses
+  Answers finished(const std::vector<remus::proto::JobStatus>& statuses);
+
+  //remove and return the clients whose deadline is at or before now
+  Answers expired(const boost::posix_time::ptime& now);
+
+private:
+  typedef std::multimap< boost::uuids::uuid, Waiter > WaitersType;
+  WaitersType Waiters;
+
+  //the deadline of every waiter, so the next can be found quickly
+  std::multiset< boost::posix_time::ptime > Deadlines;
+
+  void removeDeadline(const boost::posix_time::ptime& deadline);
+};
+
+}
+}
+}
+
+#endif
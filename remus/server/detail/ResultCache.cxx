@@ -0,0 +1,216 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/ResultCache.h>
+
+#include <remus/common/MD5Hash.h>
+#include <remus/proto/WireFormat.h>
+
+#include <boost/uuid/nil_generator.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+ResultCache::ResultCache():
+  Enabled(false),
+  Capacity(0),
+  Excluded(),
+  Results(),
+  Recent(),
+  Executions(),
+  Leaders(),
+  Following(),
+  Stats()
+{
+}
+
+//------------------------------------------------------------------------------
+void ResultCache::capacity(boost::uint64_t bytes)
+{
+  this->Capacity = bytes;
+  this->evict();
+}
+
+//------------------------------------------------------------------------------
+std::string
+ResultCache::digest(const remus::proto::JobSubmission& submission) const
+{
+  if(!this->Enabled || this->Excluded.count(submission.requirements()) > 0)
+    {
+    return std::string();
+    }
+
+  //the contents are hashed on their own, and described with everything
+  //else the worker is given. Each string is prefixed by its length so
+  //that different submissions can't describe the same way
+  std::ostringstream description;
+  const std::string reqs = remus::proto::to_binary(submission.requirements());
+  description << reqs.size() << " " << reqs << "\n";
+  typedef remus::proto::JobSubmission::const_iterator ContentIterator;
+  for(ContentIterator i = submission.begin(); i != submission.end(); ++i)
+    {
+    //the file a content names can change between submissions
+    if(i->second.sourceType() == remus::common::ContentSource::File)
+      {
+      return std::string();
+      }
+    description << i->first.size() << " " << i->first << " "
+                << i->second.formatType() << " "
+                << i->second.tag().size() << " " << i->second.tag() << " "
+                << i->second.dataSize() << " " << i->second.hash() << "\n";
+    }
+  return remus::common::MD5Hash(description.str());
+}
+
+//------------------------------------------------------------------------------
+ResultCache::EncodedResult ResultCache::find(const std::string& digest)
+{
+  ResultMap::iterator item = this->Results.find(digest);
+  if(item == this->Results.end())
+    {
+    return EncodedResult();
+    }
+
+  ++this->Stats.Hits;
+  this->Recent.splice(this->Recent.end(), this->Recent, item->second.Recent);
+  return item->second.Result;
+}
+
+//------------------------------------------------------------------------------
+void ResultCache::add(const std::string& digest, const EncodedResult& result)
+{
+  if(result.Size == 0 || result.Size > this->Capacity ||
+     this->Results.find(digest) != this->Results.end())
+    {
+    return;
+    }
+
+  Entry entry;
+  entry.Result = result;
+  entry.Recent = this->Recent.insert(this->Recent.end(), digest);
+  this->Results.insert(std::make_pair(digest,entry));
+  this->Stats.BytesCached += result.Size;
+  this->evict();
+}
+
+//------------------------------------------------------------------------------
+boost::uuids::uuid ResultCache::leader(const std::string& digest) const
+{
+  std::map<std::string, boost::uuids::uuid>::const_iterator item =
+                                                  this->Leaders.find(digest);
+  return item != this->Leaders.end() ? item->second
+                                     : boost::uuids::nil_uuid();
+}
+
+//------------------------------------------------------------------------------
+void ResultCache::lead(const boost::uuids::uuid& id,
+                       const std::string& digest,
+                       const remus::proto::JobSubmission& submission)
+{
+  Execution& execution = this->Executions[id];
+  execution.Digest = digest;
+  execution.Submission = submission;
+  this->Leaders[digest] = id;
+  ++this->Stats.Executions;
+}
+
+//------------------------------------------------------------------------------
+void ResultCache::follow(const boost::uuids::uuid& id,
+                         const std::string& digest)
+{
+  const boost::uuids::uuid leader = this->leader(digest);
+  this->Executions[leader].Followers.push_back(id);
+  this->Following[id] = leader;
+  ++this->Stats.Coalesced;
+}
+
+//------------------------------------------------------------------------------
+bool ResultCache::unfollow(const boost::uuids::uuid& id)
+{
+  std::map<boost::uuids::uuid, boost::uuids::uuid>::iterator item =
+                                                  this->Following.find(id);
+  if(item == this->Following.end())
+    {
+    return false;
+    }
+
+  std::vector<boost::uuids::uuid>& followers =
+                                  this->Executions[item->second].Followers;
+  followers.erase(std::find(followers.begin(), followers.end(), id));
+  this->Following.erase(item);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+std::vector<boost::uuids::uuid>
+ResultCache::followers(const boost::uuids::uuid& id) const
+{
+  std::map<boost::uuids::uuid, Execution>::const_iterator item =
+                                                  this->Executions.find(id);
+  return item != this->Executions.end() ? item->second.Followers
+                                        : std::vector<boost::uuids::uuid>();
+}
+
+//------------------------------------------------------------------------------
+std::vector<boost::uuids::uuid> ResultCache::leaders() const
+{
+  std::vector<boost::uuids::uuid> ids;
+  ids.reserve(this->Executions.size());
+  std::map<boost::uuids::uuid, Execution>::const_iterator i;
+  for(i = this->Executions.begin(); i != this->Executions.end(); ++i)
+    {
+    ids.push_back(i->first);
+    }
+  return ids;
+}
+
+//------------------------------------------------------------------------------
+ResultCache::Execution ResultCache::finish(const boost::uuids::uuid& id)
+{
+  std::map<boost::uuids::uuid, Execution>::iterator item =
+                                                  this->Executions.find(id);
+  if(item == this->Executions.end())
+    {
+    return Execution();
+    }
+
+  Execution execution = item->second;
+  this->Executions.erase(item);
+  this->Leaders.erase(execution.Digest);
+  for(std::size_t i=0; i < execution.Followers.size(); ++i)
+    {
+    this->Following.erase(execution.Followers[i]);
+    }
+  return execution;
+}
+
+//------------------------------------------------------------------------------
+void ResultCache::evict()
+{
+  while(this->Stats.BytesCached > this->Capacity && !this->Recent.empty())
+    {
+    ResultMap::iterator item = this->Results.find(this->Recent.front());
+    this->Stats.BytesCached -= item->second.Result.Size;
+    ++this->Stats.ResultsEvicted;
+    this->Results.erase(item);
+    this->Recent.pop_front();
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,172 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_ResultCache_h
+#define remus_server_detail_ResultCache_h
+
+#include <remus/proto/JobRequirements.h>
+#include <remus/proto/JobSubmission.h>
+#include <remus/server/detail/ResultStore.h>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//statistics on how a ResultCache has been used
+struct ResultCacheStats
+{
+  ResultCacheStats():
+    Hits(0),
+    Coalesced(0),
+    Executions(0),
+    ResultsEvicted(0),
+    BytesCached(0)
+    {}
+
+  //submissions answered with a cached result, and submissions that waited
+  //on an identical job that was already running
+  boost::uint64_t Hits;
+  boost::uint64_t Coalesced;
+
+  //submissions that had to be meshed
+  boost::uint64_t Executions;
+
+  //results dropped to stay within the capacity
+  boost::uint64_t ResultsEvicted;
+
+  //bytes of the results currently cached
+  boost::uint64_t BytesCached;
+};
+
+//Memoizes the results of jobs by the digest of their submission, so
+//identical submissions are only meshed once.
+//
+//A memoized job that is running leads an execution, and identical jobs
+//submitted while it runs follow it instead of being queued. Once the
+//leader finishes its result is given to its followers and cached, and
+//identical jobs submitted later are answered from the cache. The cache
+//keeps the most recently used results that fit in its capacity.
+//
+//Memoization is off by default. Submissions whose requirements are
+//excluded, or that have contents naming files, are never memoized, as
+//meshing them again could give a different result.
+class ResultCache
+{
+public:
+  typedef remus::server::detail::EncodedResult EncodedResult;
+
+  //the job running a submission and the jobs waiting on its result
+  struct Execution
+  {
+    std::string Digest;
+    remus::proto::JobSubmission Submission;
+    std::vector<boost::uuids::uuid> Followers;
+  };
+
+  ResultCache();
+
+  void enabled(bool enable) { this->Enabled = enable; }
+  bool enabled() const { return this->Enabled; }
+
+  //the bytes of results to cache, zero only coalesces running jobs
+  void capacity(boost::uint64_t bytes);
+  boost::uint64_t capacity() const { return this->Capacity; }
+
+  //the requirements of meshers that don't give the same result for the
+  //same submission, whose jobs are always meshed
+  void exclude(const remus::proto::JobRequirementsSet& reqs)
+    { this->Excluded = reqs; }
+  const remus::proto::JobRequirementsSet& excluded() const
+    { return this->Excluded; }
+
+  //the digest of everything the worker is given for the submission, or an
+  //empty string when the submission can't be memoized
+  std::string digest(const remus::proto::JobSubmission& submission) const;
+
+  //returns the cached result for the digest, marking it as the most
+  //recently used. Returns an empty result when there is none
+  EncodedResult find(const std::string& digest);
+
+  //cache the result of the submission with the digest, results larger
+  //than the capacity aren't cached
+  void add(const std::string& digest, const EncodedResult& result);
+
+  //the job leading the execution of the digest, nil when there is none
+  boost::uuids::uuid leader(const std::string& digest) const;
+
+  //record that the job is running the submission with the digest
+  void lead(const boost::uuids::uuid& id, const std::string& digest,
+            const remus::proto::JobSubmission& submission);
+
+  //record that the job is waiting on the leader of the digest
+  void follow(const boost::uuids::uuid& id, const std::string& digest);
+
+  //stop the job from waiting, returns false if it wasn't following
+  bool unfollow(const boost::uuids::uuid& id);
+
+  bool leading(const boost::uuids::uuid& id) const
+    { return this->Executions.find(id) != this->Executions.end(); }
+
+  //the jobs waiting on the leader
+  std::vector<boost::uuids::uuid> followers(const boost::uuids::uuid& id) const;
+
+  //every job leading an execution
+  std::vector<boost::uuids::uuid> leaders() const;
+
+  //stop tracking the execution the job leads, returning it
+  Execution finish(const boost::uuids::uuid& id);
+
+  //the number of cached results, and of executions being tracked
+  std::size_t size() const { return this->Results.size(); }
+  std::size_t numExecutions() const { return this->Executions.size(); }
+
+  const ResultCacheStats& stats() const { return this->Stats; }
+
+private:
+  struct Entry
+  {
+    EncodedResult Result;
+    std::list<std::string>::iterator Recent;
+  };
+
+  void evict();
+
+  bool Enabled;
+  boost::uint64_t Capacity;
+  remus::proto::JobRequirementsSet Excluded;
+
+  typedef boost::unordered_map<std::string, Entry> ResultMap;
+  ResultMap Results;
+  //the digests of the cached results, least recently used first
+  std::list<std::string> Recent;
+
+  std::map<boost::uuids::uuid, Execution> Executions;
+  std::map<std::string, boost::uuids::uuid> Leaders;
+  std::map<boost::uuids::uuid, boost::uuids::uuid> Following;
+
+  ResultCacheStats Stats;
+};
+
+}
+}
+}
+
+#endif
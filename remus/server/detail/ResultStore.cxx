@@ -0,0 +1,231 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/ResultStore.h>
+
+#include <remus/server/detail/uuidHelper.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/make_shared.hpp>
+
+#include <fstream>
+#include <limits>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+//a result written to disk. The file is deleted once the store and every
+//mapping of the file are done with it
+struct ResultStore::SpillFile
+{
+  explicit SpillFile(const std::string& path): Path(path) { }
+  ~SpillFile()
+    {
+    boost::system::error_code ec;
+    boost::filesystem::remove(this->Path, ec);
+    }
+
+  std::string Path;
+};
+
+namespace
+{
+//------------------------------------------------------------------------------
+//a read only mapping of a spill file, used as the owner of the mapped bytes
+struct MappedFile
+{
+  explicit MappedFile(const boost::shared_ptr<void>& file,
+                      const std::string& path):
+    File(file),
+    Mapping(path.c_str(), boost::interprocess::read_only),
+    Region(this->Mapping, boost::interprocess::read_only)
+    {
+    }
+
+  boost::shared_ptr<void> File;
+  boost::interprocess::file_mapping Mapping;
+  boost::interprocess::mapped_region Region;
+};
+}
+
+//------------------------------------------------------------------------------
+ResultStore::ResultStore():
+  MemoryBudget( std::numeric_limits<boost::uint64_t>::max() ),
+  ScratchDirectory(),
+  Results(),
+  InMemory(),
+  Stats()
+{
+  boost::system::error_code ec;
+  this->ScratchDirectory =
+                    boost::filesystem::temp_directory_path(ec).string();
+}
+
+//------------------------------------------------------------------------------
+void ResultStore::memoryBudget(boost::uint64_t bytes)
+{
+  this->MemoryBudget = bytes;
+  this->enforceBudget();
+}
+
+//------------------------------------------------------------------------------
+void ResultStore::scratchDirectory(const std::string& path)
+{
+  this->ScratchDirectory = path;
+}
+
+//------------------------------------------------------------------------------
+void ResultStore::add(const boost::uuids::uuid& id,
+                      const EncodedResult& result)
+{
+  this->remove(id);
+
+  Entry entry;
+  entry.Memory = result;
+  entry.Size = result.Size;
+  entry.Recent = this->InMemory.insert(this->InMemory.end(), id);
+  this->Results.insert(std::make_pair(id,entry));
+  this->Stats.BytesInMemory += result.Size;
+
+  this->enforceBudget();
+}
+
+//------------------------------------------------------------------------------
+bool ResultStore::have(const boost::uuids::uuid& id) const
+{
+  return this->Results.find(id) != this->Results.end();
+}
+
+//------------------------------------------------------------------------------
+std::size_t ResultStore::resultSize(const boost::uuids::uuid& id) const
+{
+  ResultMap::const_iterator item = this->Results.find(id);
+  return (item != this->Results.end()) ? item->second.Size : 0;
+}
+
+//------------------------------------------------------------------------------
+EncodedResult ResultStore::get(const boost::uuids::uuid& id)
+{
+  ResultMap::iterator item = this->Results.find(id);
+  if(item == this->Results.end())
+    {
+    return EncodedResult();
+    }
+
+  Entry& entry = item->second;
+  if(!entry.File)
+    {
+    //mark the result as the most recently used
+    this->InMemory.splice(this->InMemory.end(), this->InMemory, entry.Recent);
+    ++this->Stats.MemoryHits;
+    return entry.Memory;
+    }
+
+  ++this->Stats.DiskHits;
+  try
+    {
+    boost::shared_ptr<MappedFile> mapped =
+        boost::make_shared<MappedFile>(entry.File, entry.File->Path);
+    EncodedResult result(static_cast<const char*>(mapped->Region.get_address()),
+                         mapped->Region.get_size(),
+                         mapped);
+    result.Id = entry.Memory.Id;
+    return result;
+    }
+  catch(boost::interprocess::interprocess_exception&)
+    {
+    //the spill file has gone missing, we have lost the result
+    return EncodedResult();
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ResultStore::remove(const boost::uuids::uuid& id)
+{
+  ResultMap::iterator item = this->Results.find(id);
+  if(item == this->Results.end())
+    {
+    return false;
+    }
+
+  Entry& entry = item->second;
+  if(entry.File)
+    {
+    this->Stats.BytesOnDisk -= entry.Size;
+    }
+  else
+    {
+    this->Stats.BytesInMemory -= entry.Size;
+    this->InMemory.erase(entry.Recent);
+    }
+  this->Results.erase(item);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void ResultStore::enforceBudget()
+{
+  //spill the least recently used results first. When a result can't be
+  //spilled we keep it in memory, over the budget, rather than lose it
+  std::list<boost::uuids::uuid>::iterator i = this->InMemory.begin();
+  while(this->Stats.BytesInMemory > this->MemoryBudget &&
+        i != this->InMemory.end())
+    {
+    const boost::uuids::uuid id = *i;
+    ++i;
+    this->spill(id, this->Results.find(id)->second);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ResultStore::spill(const boost::uuids::uuid& id, Entry& entry)
+{
+  if(entry.Size == 0)
+    {
+    //empty results can't be mapped, and don't cost us any memory
+    return false;
+    }
+
+  boost::filesystem::path path(this->ScratchDirectory);
+  path /= "remus_result_" + remus::to_string(id);
+
+  boost::shared_ptr<SpillFile> file =
+                        boost::make_shared<SpillFile>(path.string());
+  std::ofstream out(file->Path.c_str(), std::ios::out | std::ios::binary);
+  out.write(entry.Memory.Data, static_cast<std::streamsize>(entry.Size));
+  out.close();
+  if(!out)
+    {
+    return false;
+    }
+
+  //drop the bytes, but keep the job a shared result is sent for
+  entry.File = file;
+  const boost::uuids::uuid sharedWith = entry.Memory.Id;
+  entry.Memory = EncodedResult();
+  entry.Memory.Id = sharedWith;
+  this->InMemory.erase(entry.Recent);
+
+  this->Stats.BytesInMemory -= entry.Size;
+  this->Stats.BytesOnDisk += entry.Size;
+  this->Stats.BytesSpilled += entry.Size;
+  ++this->Stats.ResultsSpilled;
+  return true;
+}
+
+}
+}
+}
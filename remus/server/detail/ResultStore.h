@@ -0,0 +1,163 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_ResultStore_h
+#define remus_server_detail_ResultStore_h
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/uuid/nil_generator.hpp>
+#include <boost/uuid/uuid.hpp>
+
+#include <list>
+#include <string>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//a job result kept as the encoded bytes the worker sent, Owner keeps
+//the bytes alive so they can be sent to the client without a copy
+struct EncodedResult
+{
+  EncodedResult(): Data(NULL), Size(0), Owner(), Id(boost::uuids::nil_uuid())
+    {}
+  EncodedResult(const char* data, std::size_t size,
+                const boost::shared_ptr<const void>& owner):
+    Data(data), Size(size), Owner(owner), Id(boost::uuids::nil_uuid()) {}
+
+  const char* Data;
+  std::size_t Size;
+  boost::shared_ptr<const void> Owner;
+
+  //nil when the bytes name the job the result is for. Otherwise the bytes
+  //are the result of another job, shared with the job Id without a copy,
+  //and the result has to be sent with Id instead of the id it holds
+  boost::uuids::uuid Id;
+};
+
+//------------------------------------------------------------------------------
+//share the bytes of a result with the job id
+inline EncodedResult share_result(const EncodedResult& result,
+                                  const boost::uuids::uuid& id)
+{
+  EncodedResult shared(result);
+  shared.Id = id;
+  return shared;
+}
+
+//statistics on how a ResultStore has been used
+struct ResultStoreStats
+{
+  ResultStoreStats():
+    MemoryHits(0),
+    DiskHits(0),
+    ResultsSpilled(0),
+    BytesSpilled(0),
+    BytesInMemory(0),
+    BytesOnDisk(0)
+    {}
+
+  //results that were retrieved from memory and from spill files
+  boost::uint64_t MemoryHits;
+  boost::uint64_t DiskHits;
+
+  //total number of results and bytes that have been written to spill files
+  boost::uint64_t ResultsSpilled;
+  boost::uint64_t BytesSpilled;
+
+  //bytes of the results currently held in memory and in spill files
+  boost::uint64_t BytesInMemory;
+  boost::uint64_t BytesOnDisk;
+
+  //the fraction of retrieved results that were still in memory
+  double hitRate() const
+    {
+    const boost::uint64_t total = this->MemoryHits + this->DiskHits;
+    return (total > 0) ? static_cast<double>(this->MemoryHits) / total : 1.0;
+    }
+};
+
+//Holds the encoded results of finished jobs until a client retrieves them.
+//
+//Results are kept in memory until their total size is over the memory
+//budget, at which point the least recently used results are written to
+//files in the scratch directory and dropped from memory. Spilled results
+//are memory mapped when they are retrieved, so they are sent to the client
+//straight from the page cache.
+class ResultStore
+{
+public:
+  //construct a store with no memory budget, so nothing is ever spilled
+  ResultStore();
+
+  //the number of bytes of results to keep in memory before spilling
+  void memoryBudget(boost::uint64_t bytes);
+  boost::uint64_t memoryBudget() const { return this->MemoryBudget; }
+
+  //the directory spill files are written to, defaults to the temp directory
+  void scratchDirectory(const std::string& path);
+  const std::string& scratchDirectory() const { return this->ScratchDirectory; }
+
+  //store the result of a job, replacing any existing result for the job.
+  //This can spill the least recently used results to disk
+  void add(const boost::uuids::uuid& id, const EncodedResult& result);
+
+  bool have(const boost::uuids::uuid& id) const;
+
+  //returns the size in bytes of the result of a job, in memory or on disk
+  std::size_t resultSize(const boost::uuids::uuid& id) const;
+
+  //returns the result of a job, memory mapping it if it was spilled.
+  //Returns an empty result if we don't have a result for the job
+  EncodedResult get(const boost::uuids::uuid& id);
+
+  //remove the result of a job, deleting its spill file once nothing is
+  //using the file
+  bool remove(const boost::uuids::uuid& id);
+
+  std::size_t size() const { return this->Results.size(); }
+
+  const ResultStoreStats& stats() const { return this->Stats; }
+
+private:
+  struct SpillFile;
+  struct Entry
+  {
+    EncodedResult Memory; //valid while the result is in memory
+    boost::shared_ptr<SpillFile> File; //valid once the result is spilled
+    std::size_t Size;
+    std::list<boost::uuids::uuid>::iterator Recent;
+  };
+
+  typedef boost::unordered_map<boost::uuids::uuid, Entry> ResultMap;
+
+  //spill least recently used results until we are within the budget
+  void enforceBudget();
+  bool spill(const boost::uuids::uuid& id, Entry& entry);
+
+  boost::uint64_t MemoryBudget;
+  std::string ScratchDirectory;
+  ResultMap Results;
+
+  //the ids of results that are in memory, least recently used first
+  std::list<boost::uuids::uuid> InMemory;
+
+  ResultStoreStats Stats;
+};
+
+}
+}
+}
+
+#endif
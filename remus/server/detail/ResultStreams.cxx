@@ -0,0 +1,173 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/ResultStreams.h>
+
+#include <algorithm>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+namespace
+{
+//keep chunks large enough that the per message overhead doesn't matter,
+//and small enough that a single chunk doesn't stall the broker
+const std::size_t MinChunkSize = 4096;
+const std::size_t MaxChunkSize = 64*1024*1024;
+}
+
+//------------------------------------------------------------------------------
+ResultStreams::ResultStreams():
+  Streams(),
+  NumReady(0)
+{
+}
+
+//------------------------------------------------------------------------------
+void ResultStreams::open(const Key& key,
+                         remus::proto::WireFormat::Type format,
+                         const boost::uuids::uuid& id,
+                         remus::common::ContentFormat::Type contentFormat,
+                         const char* data, std::size_t size,
+                         const boost::shared_ptr<const void>& owner,
+                         boost::uint32_t chunkSize,
+                         boost::uint32_t credits,
+                         const boost::posix_time::ptime& now)
+{
+  //opening a stream twice restarts it
+  StreamsType::iterator i = this->Streams.find(key);
+  if(i != this->Streams.end() && i->second.Credits > 0)
+    {
+    --this->NumReady;
+    }
+
+  Stream& stream = this->Streams[key];
+  stream.Format = format;
+  stream.Id = id;
+  stream.ContentFormat = contentFormat;
+  stream.Data = data;
+  stream.Size = size;
+  stream.Offset = 0;
+  stream.Owner = owner;
+  stream.ChunkSize = std::min(std::max(static_cast<std::size_t>(chunkSize),
+                                       MinChunkSize), MaxChunkSize);
+  stream.Credits = credits;
+  stream.LastCredit = now;
+  if(credits > 0)
+    {
+    ++this->NumReady;
+    }
+  else
+    {
+    this->Streams.erase(key);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ResultStreams::credit(const Key& key,
+                           boost::uint32_t credits,
+                           const boost::posix_time::ptime& now)
+{
+  StreamsType::iterator i = this->Streams.find(key);
+  if(i == this->Streams.end())
+    {
+    return false;
+    }
+
+  if(i->second.Credits > 0)
+    {
+    --this->NumReady;
+    }
+  if(credits == 0)
+    {
+    this->Streams.erase(i);
+    return true;
+    }
+
+  //credit past what we can count is as good as unlimited
+  const boost::uint32_t unlimited = ~boost::uint32_t(0);
+  i->second.Credits += std::min(credits, unlimited - i->second.Credits);
+  i->second.LastCredit = now;
+  ++this->NumReady;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+std::vector<ResultStreams::Chunk>
+ResultStreams::nextChunks(std::vector<boost::uuids::uuid>& finished)
+{
+  std::vector<Chunk> chunks;
+  StreamsType::iterator i = this->Streams.begin();
+  while(i != this->Streams.end() && this->NumReady > 0)
+    {
+    Stream& stream = i->second;
+    if(stream.Credits == 0)
+      {
+      ++i;
+      continue;
+      }
+
+    const std::size_t size = std::min(stream.ChunkSize,
+                                      stream.Size - stream.Offset);
+    chunks.push_back( Chunk(i->first, stream.Format,
+                            remus::proto::ResultChunk(stream.Id,
+                                                      stream.ContentFormat,
+                                                      stream.Size,
+                                                      stream.Offset),
+                            stream.Data + stream.Offset, size,
+                            stream.Owner) );
+    stream.Offset += size;
+    --stream.Credits;
+
+    const bool done = stream.Offset >= stream.Size;
+    if(stream.Credits == 0 || done)
+      {
+      --this->NumReady;
+      }
+    if(done)
+      {
+      finished.push_back(stream.Id);
+      this->Streams.erase(i++);
+      }
+    else
+      {
+      ++i;
+      }
+    }
+  return chunks;
+}
+
+//------------------------------------------------------------------------------
+std::size_t ResultStreams::expire(const boost::posix_time::ptime& before)
+{
+  std::size_t expired = 0;
+  StreamsType::iterator i = this->Streams.begin();
+  while(i != this->Streams.end())
+    {
+    //streams with credit are still sending, so aren't idle
+    if(i->second.Credits == 0 && i->second.LastCredit < before)
+      {
+      this->Streams.erase(i++);
+      ++expired;
+      }
+    else
+      {
+      ++i;
+      }
+    }
+  return expired;
+}
+
+}
+}
+}
@@ -0,0 +1,144 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_ResultStreams_h
+#define remus_server_detail_ResultStreams_h
+
+#include <remus/proto/ResultStream.h>
+#include <remus/proto/WireFormat.h>
+#include <remus/proto/zmqSocketIdentity.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//The job results being streamed to clients in chunks. Each stream is
+//identified by the client and the id of the request that opened it, and
+//only sends as many chunks as the client has granted it credit for, so a
+//client is never sent more than it has asked for and the broker can serve
+//other requests between chunks.
+class ResultStreams
+{
+public:
+  struct Key
+  {
+    Key(const zmq::SocketIdentity& client, const std::string& requestId):
+      Client(client),
+      RequestId(requestId)
+      {}
+
+    bool operator<(const Key& other) const
+    {
+      if(this->Client == other.Client)
+        { return this->RequestId < other.RequestId; }
+      return this->Client < other.Client;
+    }
+
+    zmq::SocketIdentity Client;
+    std::string RequestId;
+  };
+
+  //the next piece of a stream to send, Data is kept alive by Owner
+  struct Chunk
+  {
+    Chunk(const Key& stream, remus::proto::WireFormat::Type format,
+          const remus::proto::ResultChunk& header,
+          const char* data, std::size_t size,
+          const boost::shared_ptr<const void>& owner):
+      Stream(stream),
+      Format(format),
+      Header(header),
+      Data(data),
+      Size(size),
+      Owner(owner)
+      {}
+
+    Key Stream;
+    remus::proto::WireFormat::Type Format;
+    remus::proto::ResultChunk Header;
+    const char* Data;
+    std::size_t Size;
+    boost::shared_ptr<const void> Owner;
+  };
+
+  ResultStreams();
+
+  //start streaming the size bytes of result data, which owner keeps alive.
+  //format is the encoding the client wants the chunk headers in
+  void open(const Key& stream,
+            remus::proto::WireFormat::Type format,
+            const boost::uuids::uuid& id,
+            remus::common::ContentFormat::Type contentFormat,
+            const char* data, std::size_t size,
+            const boost::shared_ptr<const void>& owner,
+            boost::uint32_t chunkSize,
+            boost::uint32_t credits,
+            const boost::posix_time::ptime& now);
+
+  //grant a stream more credit, granting none closes the stream. Returns
+  //false if there is no such stream
+  bool credit(const Key& stream,
+              boost::uint32_t credits,
+              const boost::posix_time::ptime& now);
+
+  bool have(const Key& stream) const
+    { return this->Streams.find(stream) != this->Streams.end(); }
+
+  //the number of open streams
+  std::size_t size() const { return this->Streams.size(); }
+
+  //returns true if any stream has credit for its next chunk
+  bool ready() const { return this->NumReady > 0; }
+
+  //take the next chunk of every stream that has credit for one. Streams
+  //whose last chunk is taken are closed, and the ids of their jobs added
+  //to finished
+  std::vector<Chunk> nextChunks(std::vector<boost::uuids::uuid>& finished);
+
+  //close the streams that are out of credit and haven't been granted more
+  //since before, so clients that went away don't keep results alive
+  std::size_t expire(const boost::posix_time::ptime& before);
+
+private:
+  struct Stream
+  {
+    remus::proto::WireFormat::Type Format;
+    boost::uuids::uuid Id;
+    remus::common::ContentFormat::Type ContentFormat;
+    const char* Data;
+    std::size_t Size;
+    std::size_t Offset;
+    boost::shared_ptr<const void> Owner;
+    std::size_t ChunkSize;
+    boost::uint32_t Credits;
+    boost::posix_time::ptime LastCredit;
+  };
+
+  typedef std::map< Key, Stream > StreamsType;
+  StreamsType Streams;
+
+  //the number of streams with credit
+  std::size_t NumReady;
+};
+
+}
+}
+}
+
+#endif
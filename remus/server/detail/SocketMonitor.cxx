@@ -14,7 +14,12 @@
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include <boost/unordered_map.hpp>
+
 #include <algorithm>
+#include <functional>
+#include <queue>
+#include <set>
 
 namespace remus{
 namespace server{
@@ -27,20 +32,58 @@ class SocketMonitor::WorkerTracker
 
   struct BeatInfo
     {
+    BeatInfo():
+      Duration(0),
+      LastOccurrence(),
+      ExpectedBy(),
+      IsUnresponsive(false)
+      {}
+
     boost::int64_t Duration;
     ptime LastOccurrence;
+    ptime ExpectedBy; //when we will consider the socket unresponsive
+    bool IsUnresponsive; //last reported state
     };
 
+  //when a socket is expected to heartbeat by. Sorted so that the earliest
+  //deadline is at the top of the heap
+  struct Deadline
+    {
+    Deadline(const ptime& when, const zmq::SocketIdentity& socket):
+      When(when),
+      Socket(socket)
+      {}
+
+    bool operator>(const Deadline& other) const
+      { return this->When > other.When; }
+
+    ptime When;
+    zmq::SocketIdentity Socket;
+    };
+
+  typedef std::priority_queue< Deadline, std::vector<Deadline>,
+                               std::greater<Deadline> > DeadlineHeap;
+
 public:
   remus::common::PollingMonitor PollMonitor;
+  boost::int64_t CheckInterval;
 
-  std::map< zmq::SocketIdentity, BeatInfo > HeartBeats;
+  boost::unordered_map< zmq::SocketIdentity, BeatInfo > HeartBeats;
 
   typedef std::pair< zmq::SocketIdentity, BeatInfo > InsertType;
-  typedef std::map< zmq::SocketIdentity, BeatInfo >::iterator IteratorType;
+  typedef boost::unordered_map< zmq::SocketIdentity, BeatInfo >::iterator IteratorType;
+
+  //every time a socket beats we push a new deadline and leave the old
+  //one in the heap, old deadlines are discarded when they are popped
+  DeadlineHeap Deadlines;
+
+  //sockets that have changed state since the last check
+  std::set< zmq::SocketIdentity > Revived;
+  std::set< zmq::SocketIdentity > Killed;
 
   WorkerTracker( remus::common::PollingMonitor p):
-    PollMonitor(p)
+    PollMonitor(p),
+    CheckInterval(250)
   {}
 
   //----------------------------------------------------------------------------
@@ -60,14 +103,12 @@ public:
     IteratorType iter = (this->HeartBeats.insert(key_value)).first;
     BeatInfo& beat = iter->second;
 
-    beat.LastOccurrence = boost::posix_time::microsec_clock::local_time();
-
     //look at the duration we have are currently polling at, and
     //the current duration that we last polled the worker at, take the slower
     //of the two. When the server has a really low heartbeat rate and the
     //and worker has a slow heartbeat we don't want to eliminate living workers
     const boost::int64_t polldur = (PollMonitor.hasAbnormalEvent() ? PollMonitor.maxTimeOut() : PollMonitor.current());
-    beat.Duration = std::max(beat.Duration,polldur);
+    this->beat(iter->first, beat, std::max(beat.Duration,polldur));
   }
 
   //----------------------------------------------------------------------------
@@ -79,25 +120,19 @@ public:
     IteratorType iter = (this->HeartBeats.insert(key_value)).first;
     BeatInfo& beat = iter->second;
 
-    beat.LastOccurrence = boost::posix_time::microsec_clock::local_time();
-
     //Now we choose the greatest value between the poller and the sent in duration
     //from the socket
     const boost::int64_t polldur = (PollMonitor.hasAbnormalEvent() ? PollMonitor.maxTimeOut() : PollMonitor.current());
-    beat.Duration = std::max(dur,polldur);
+    this->beat(iter->first, beat, std::max(dur,polldur));
   }
 
   //----------------------------------------------------------------------------
   boost::int64_t heartbeatInterval(const zmq::SocketIdentity& socket)
   {
-    //insert a new item if it doesn't exist, otherwise get the beatInfo already
-    //in the map
-    if(exists(socket))
+    IteratorType iter = this->HeartBeats.find(socket);
+    if(iter != this->HeartBeats.end())
       {
-      InsertType key_value(socket,BeatInfo());
-      IteratorType iter = (this->HeartBeats.insert(key_value)).first;
-      BeatInfo& beat = iter->second;
-      return beat.Duration;
+      return iter->second.Duration;
       }
     return boost::int64_t(0);
   }
@@ -105,7 +140,10 @@ public:
   //----------------------------------------------------------------------------
   void markAsDead( const zmq::SocketIdentity& socket )
   {
-    this->HeartBeats.erase(socket);
+    if(this->HeartBeats.erase(socket) > 0)
+      {
+      this->Killed.insert(socket);
+      }
   }
 
   //----------------------------------------------------------------------------
@@ -121,14 +159,94 @@ public:
 
       const BeatInfo& beat = this->HeartBeats.find(socket)->second;
       const ptime current = boost::posix_time::microsec_clock::local_time();
-      const ptime expectedHB = beat.LastOccurrence +
-                               boost::posix_time::milliseconds(beat.Duration*2);
-      return current > expectedHB;
+      return current > beat.ExpectedBy;
       }
 
     //the socket isn't contained here, this socket is dead dead
     return true;
   }
+
+  //----------------------------------------------------------------------------
+  bool wasReportedUnresponsive( const zmq::SocketIdentity& socket ) const
+  {
+    boost::unordered_map< zmq::SocketIdentity, BeatInfo >::const_iterator
+                                        iter = this->HeartBeats.find(socket);
+    return iter != this->HeartBeats.end() && iter->second.IsUnresponsive;
+  }
+
+  //----------------------------------------------------------------------------
+  SocketStateChanges changes()
+  {
+    SocketStateChanges result;
+
+    //polling has been abnormal, so give every socket a pass. The deadlines
+    //stay in the heap so they are checked once polling is normal again
+    if(!PollMonitor.hasAbnormalEvent())
+      {
+      const ptime current = boost::posix_time::microsec_clock::local_time();
+      while(!this->Deadlines.empty() && this->Deadlines.top().When < current)
+        {
+        const Deadline& deadline = this->Deadlines.top();
+        IteratorType iter = this->HeartBeats.find(deadline.Socket);
+
+        //skip deadlines of dead sockets, and deadlines that have been
+        //replaced by a newer heartbeat
+        if(iter != this->HeartBeats.end() &&
+           iter->second.ExpectedBy == deadline.When &&
+           !iter->second.IsUnresponsive)
+          {
+          iter->second.IsUnresponsive = true;
+
+          //if the socket came back and missed a heartbeat again since
+          //the last check, its state hasn't changed
+          if(this->Revived.erase(deadline.Socket) == 0)
+            {
+            result.Unresponsive.push_back(deadline.Socket);
+            }
+          }
+        this->Deadlines.pop();
+        }
+      }
+
+    typedef std::set< zmq::SocketIdentity >::const_iterator SetIt;
+    for(SetIt i = this->Killed.begin(); i != this->Killed.end(); ++i)
+      {
+      //sockets can be resurrected after being marked as dead
+      if(!this->exists(*i))
+        {
+        result.Dead.push_back(*i);
+        }
+      }
+    for(SetIt i = this->Revived.begin(); i != this->Revived.end(); ++i)
+      {
+      if(this->exists(*i))
+        {
+        result.Responsive.push_back(*i);
+        }
+      }
+
+    this->Killed.clear();
+    this->Revived.clear();
+    return result;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  void beat(const zmq::SocketIdentity& socket, BeatInfo& beat,
+            boost::int64_t duration)
+  {
+    beat.LastOccurrence = boost::posix_time::microsec_clock::local_time();
+    beat.Duration = duration;
+    beat.ExpectedBy = beat.LastOccurrence +
+                      boost::posix_time::milliseconds(beat.Duration*2);
+    this->Deadlines.push(Deadline(beat.ExpectedBy,socket));
+
+    if(beat.IsUnresponsive)
+      {
+      beat.IsUnresponsive = false;
+      this->Revived.insert(socket);
+      }
+  }
 };
 
 //------------------------------------------------------------------------------
@@ -216,6 +334,31 @@ bool SocketMonitor::isUnresponsive( const zmq::SocketIdentity& socket ) const
   return this->Tracker->isMostlyDead(socket);
 }
 
+//------------------------------------------------------------------------------
+bool SocketMonitor::wasReportedUnresponsive(
+                                    const zmq::SocketIdentity& socket ) const
+{
+  return this->Tracker->wasReportedUnresponsive(socket);
+}
+
+//------------------------------------------------------------------------------
+SocketStateChanges SocketMonitor::checkHeartbeats()
+{
+  return this->Tracker->changes();
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t SocketMonitor::heartbeatCheckInterval() const
+{
+  return this->Tracker->CheckInterval;
+}
+
+//------------------------------------------------------------------------------
+void SocketMonitor::heartbeatCheckInterval( boost::int64_t millisec )
+{
+  this->Tracker->CheckInterval = std::max(millisec, boost::int64_t(1));
+}
+
 }
 }
 }
@@ -20,10 +20,26 @@
 
 #include <remus/common/PollingMonitor.h>
 
+#include <vector>
+
 namespace remus{
 namespace server{
 namespace detail{
 
+//The sockets whose state has changed since the last time a SocketMonitor
+//was asked to check heartbeats
+struct SocketStateChanges
+{
+  //sockets that have been marked as dead
+  std::vector<zmq::SocketIdentity> Dead;
+
+  //sockets that have missed their heartbeat and are now unresponsive
+  std::vector<zmq::SocketIdentity> Unresponsive;
+
+  //sockets that were unresponsive, but have since sent a heartbeat
+  std::vector<zmq::SocketIdentity> Responsive;
+};
+
 // Provides monitoring that adjusts to the polling frequency of socket ids
 class SocketMonitor
 {
@@ -67,6 +83,21 @@ public:
   //and we should expect sockets to come back.
   bool isUnresponsive( const zmq::SocketIdentity& socket ) const;
 
+  //returns true if checkHeartbeats has reported the socket as unresponsive
+  //and it hasn't been heard from since. Unlike isUnresponsive this doesn't
+  //count a deadline that has passed until the heartbeats are checked
+  bool wasReportedUnresponsive( const zmq::SocketIdentity& socket ) const;
+
+  //returns every socket whose state has changed since the last call.
+  //Heartbeat deadlines are kept sorted, so the cost of this is
+  //proportional to the number of deadlines that have passed, not the
+  //number of sockets being monitored.
+  SocketStateChanges checkHeartbeats();
+
+  //how often in milliseconds the server should check heartbeats
+  boost::int64_t heartbeatCheckInterval() const;
+  void heartbeatCheckInterval( boost::int64_t millisec );
+
 private:
   class WorkerTracker;
   boost::shared_ptr<WorkerTracker> Tracker;
@@ -27,13 +27,20 @@ WorkerPool::WorkerInfo::WorkerInfo(const zmq::SocketIdentity& address,
   NumberOfDesiredJobs(0),
   Reqs(reqs),
   Address(address),
-  IsAlive(true)
+  IsAlive(true),
+  IsReady(false),
+  ReadyPosition()
 {
 }
 
 //------------------------------------------------------------------------------
 WorkerPool::WorkerPool():
-  Pool()
+  Workers(),
+  Addresses(),
+  ReadyWorkers(),
+  NumWaitingWorkers(0),
+  ChangedRequirements(),
+  BinaryWorkers()
 {
 
 }
@@ -44,7 +51,9 @@ bool WorkerPool::addWorker(zmq::SocketIdentity workerIdentity,
 {
   if(!this->haveWorker(workerIdentity,reqs))
     {
-    this->Pool.push_back( WorkerPool::WorkerInfo(workerIdentity,reqs) );
+    It worker = this->Workers.insert(this->Workers.end(),
+                           WorkerPool::WorkerInfo(workerIdentity,reqs));
+    this->Addresses[workerIdentity].push_back(worker);
     }
   return true;
 }
@@ -54,10 +63,11 @@ remus::proto::JobRequirementsSet WorkerPool::waitingWorkerRequirements(
                                          remus::common::MeshIOType type) const
 {
   remus::proto::JobRequirementsSet validWorkers;
-  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  for(ReadyContainer::const_iterator i=this->ReadyWorkers.begin();
+      i != this->ReadyWorkers.end(); ++i)
     {
-    if( i->Reqs.meshTypes() == type && i->isWaitingForWork() )
-      { validWorkers.insert(i->Reqs); }
+    if( i->first.meshTypes() == type )
+      { validWorkers.insert(i->first); }
     }
   return validWorkers;
 }
@@ -66,46 +76,34 @@ remus::proto::JobRequirementsSet WorkerPool::waitingWorkerRequirements(
 bool WorkerPool::haveWaitingWorker(
                            const remus::proto::JobRequirements& reqs) const
 {
-  bool found = false;
-  for(ConstIt i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
-    {
-    found = ( i->Reqs == reqs && i->isWaitingForWork() );
-    }
-  return found;
+  return this->ReadyWorkers.count(reqs) > 0;
 }
 
 //------------------------------------------------------------------------------
 bool WorkerPool::haveWorker(const zmq::SocketIdentity& address,
                             const remus::proto::JobRequirements& reqs) const
 {
-  bool found = false;
-  for(ConstIt i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
-    {
-    found = ( i->Address == address && i->Reqs == reqs );
-    }
-  return found;
+  return this->findWorker(address,reqs) != this->Workers.end();
 }
 
 //------------------------------------------------------------------------------
 bool WorkerPool::readyForWork(const zmq::SocketIdentity& address,
                               const remus::proto::JobRequirements& reqs)
 {
-  //a worker can be registered multiple times, we need to iterate
-  //over the entire vector and find the correct address and reqs that match
-  //transform every element that matches the address and reqs to be
+  //transform the worker that matches the address and reqs to be
   //waiting for work, If the worker is already waiting for work we increase
   //the number of jobs it is waiting to take.
-  int count = 0;
-   for(It i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  It worker = this->findWorker(address,reqs);
+  if(worker == this->Workers.end())
     {
-    if(i->Address == address && i->Reqs == reqs)
-      {
-      i->IsAlive = true; //mark the worker alive if it wasn't already
-      i->addJob();
-      ++count;
-      }
+    return false;
     }
-  return (count > 0);
+
+  const int before = worker->numberOfWantedJobs();
+  worker->IsAlive = true; //mark the worker alive if it wasn't already
+  worker->addJob();
+  this->updateReadyState(*worker, before);
+  return true;
 }
 
 
@@ -113,28 +111,30 @@ bool WorkerPool::readyForWork(const zmq::SocketIdentity& address,
 zmq::SocketIdentity WorkerPool::takeWorker(
                              const remus::proto::JobRequirements& reqs)
 {
-  bool found = false;
-  It i;
-  for(i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
-    {
-    found = (i->Reqs == reqs) && (i->isWaitingForWork());
-    }
-
   zmq::SocketIdentity workerIdentity;
 
-  if(found)
+  ReadyContainer::iterator ready = this->ReadyWorkers.find(reqs);
+  if(ready != this->ReadyWorkers.end())
     {
-    --i; //we have to decrement the iterator, as the forloop increments it one
-    //past the found position.
+    //the front of the ready list is the worker that has gone the longest
+    //without being given a job of this type
+    WorkerInfo* worker = ready->second.front();
+    workerIdentity = zmq::SocketIdentity(worker->Address);
+    const int before = worker->numberOfWantedJobs();
+    worker->takesJob();
 
-    //take the worker id as it matches the reqs
-    workerIdentity = zmq::SocketIdentity(i->Address);
-    i->takesJob();
-
-    //now that the worker has taken the job, we move him to the back of
-    //the vector so he is the last worker to take a job of that type again,
-    //this allows us to handle multiple workers taking jobs
-    std::rotate(this->Pool.begin(), this->Pool.begin() + 1,this->Pool.end());
+    if(worker->isWaitingForWork())
+      {
+      //now that the worker has taken the job, we move him to the back of
+      //the list so he is the last worker to take a job of that type again,
+      //this allows us to handle multiple workers taking jobs
+      ready->second.splice(ready->second.end(), ready->second,
+                           worker->ReadyPosition);
+      }
+    else
+      {
+      this->updateReadyState(*worker, before);
+      }
     }
 
   return workerIdentity;
@@ -143,29 +143,94 @@ zmq::SocketIdentity WorkerPool::takeWorker(
 //------------------------------------------------------------------------------
 void WorkerPool::purgeDeadWorkers(remus::server::detail::SocketMonitor monitor)
 {
+  //only query the monitor, checking its heartbeats would take the changes
+  //from whoever else is relying on them
+  remus::server::detail::SocketStateChanges changes;
+  for(AddressContainer::const_iterator i = this->Addresses.begin();
+      i != this->Addresses.end(); ++i)
+    {
+    if(monitor.isDead(i->first))
+      {
+      changes.Dead.push_back(i->first);
+      }
+    else if(monitor.isUnresponsive(i->first))
+      {
+      changes.Unresponsive.push_back(i->first);
+      }
+    else
+      {
+      changes.Responsive.push_back(i->first);
+      }
+    }
+  this->purgeDeadWorkers(changes);
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::purgeDeadWorkers(
+                  const remus::server::detail::SocketStateChanges& changes)
+{
+  typedef std::vector<zmq::SocketIdentity>::const_iterator SocketIt;
+
   //Remove all workers that we know are really dead
-  WorkerPool::DeadWorkers dead(monitor);
+  for(SocketIt i=changes.Dead.begin(); i != changes.Dead.end(); ++i)
+    {
+    this->BinaryWorkers.erase(*i);
 
-  //remove if moves all bad items to end of the vector and returns
-  //an iterator to the new end. Remove if is easiest way to remove from middle
-  It newEnd = std::remove_if(this->Pool.begin(),this->Pool.end(),dead);
+    AddressContainer::iterator registered = this->Addresses.find(*i);
+    if(registered != this->Addresses.end())
+      {
+      //copy the registrations, since removing a worker modifies them
+      const std::vector<It> regs = registered->second;
+      for(std::vector<It>::const_iterator j=regs.begin(); j!=regs.end(); ++j)
+        {
+        this->removeWorker(*j);
+        }
+      }
+    }
 
-  for(It i=this->Pool.begin(); i != newEnd; ++i)
+  for(SocketIt i=changes.Unresponsive.begin();
+      i != changes.Unresponsive.end(); ++i)
     {
-    i->IsAlive = !monitor.isUnresponsive(i->Address);
+    this->markAlive(*i, false);
     }
 
-  //erase all the dead workers to free up space
-  this->Pool.erase(newEnd,this->Pool.end());
+  for(SocketIt i=changes.Responsive.begin();
+      i != changes.Responsive.end(); ++i)
+    {
+    this->markAlive(*i, true);
+    }
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::wireFormat(const zmq::SocketIdentity& address,
+                            remus::proto::WireFormat::Type format)
+{
+  if(format == remus::proto::WireFormat::Binary)
+    {
+    this->BinaryWorkers.insert(address);
+    }
+  else
+    {
+    this->BinaryWorkers.erase(address);
+    }
+}
+
+//------------------------------------------------------------------------------
+remus::proto::WireFormat::Type
+WorkerPool::wireFormat(const zmq::SocketIdentity& address) const
+{
+  return (this->BinaryWorkers.count(address) > 0) ?
+                remus::proto::WireFormat::Binary : remus::proto::WireFormat::Text;
 }
 
 //------------------------------------------------------------------------------
 std::set<zmq::SocketIdentity> WorkerPool::allWorkers() const
 {
   std::set<zmq::SocketIdentity> workerAddresses;
-  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  for(AddressContainer::const_iterator i=this->Addresses.begin();
+      i != this->Addresses.end(); ++i)
     {
-    workerAddresses.insert(i->Address);
+    workerAddresses.insert(i->first);
     }
   return workerAddresses;
 }
@@ -174,18 +239,102 @@ std::set<zmq::SocketIdentity> WorkerPool::allWorkers() const
 std::set<zmq::SocketIdentity> WorkerPool::allWorkersWantingWork() const
 {
   std::set<zmq::SocketIdentity> workerAddresses;
-  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  for(ReadyContainer::const_iterator i=this->ReadyWorkers.begin();
+      i != this->ReadyWorkers.end(); ++i)
     {
-    if(i->isWaitingForWork())
+    for(ReadyList::const_iterator j=i->second.begin();
+        j != i->second.end(); ++j)
       {
-      workerAddresses.insert(i->Address);
+      workerAddresses.insert((*j)->Address);
       }
     }
   return workerAddresses;
 }
 
+//------------------------------------------------------------------------------
+WorkerPool::It WorkerPool::findWorker(
+                             const zmq::SocketIdentity& address,
+                             const remus::proto::JobRequirements& reqs) const
+{
+  //a worker can be registered multiple times with different requirements,
+  //so we have to check each registration for the address
+  AddressContainer::const_iterator registered = this->Addresses.find(address);
+  if(registered != this->Addresses.end())
+    {
+    typedef std::vector<It>::const_iterator RegIt;
+    for(RegIt i=registered->second.begin(); i != registered->second.end(); ++i)
+      {
+      if((*i)->Reqs == reqs)
+        { return *i; }
+      }
+    }
+  //cast away the const on the list so we can return an end iterator
+  return const_cast<WorkerContainer&>(this->Workers).end();
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::updateReadyState(WorkerInfo& worker, int before)
+{
+  //only mark requirements that gained a waiting worker, since those are
+  //the only ones that can now be matched to a queued job
+  if(worker.numberOfWantedJobs() > before)
+    {
+    this->ChangedRequirements.insert(worker.Reqs);
+    }
+
+  if(worker.isWaitingForWork() && !worker.IsReady)
+    {
+    ReadyList& ready = this->ReadyWorkers[worker.Reqs];
+    worker.ReadyPosition = ready.insert(ready.end(), &worker);
+    worker.IsReady = true;
+    ++this->NumWaitingWorkers;
+    }
+  else if(!worker.isWaitingForWork() && worker.IsReady)
+    {
+    ReadyContainer::iterator ready = this->ReadyWorkers.find(worker.Reqs);
+    ready->second.erase(worker.ReadyPosition);
+    if(ready->second.empty())
+      {
+      this->ReadyWorkers.erase(ready);
+      }
+    worker.IsReady = false;
+    --this->NumWaitingWorkers;
+    }
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::markAlive(const zmq::SocketIdentity& address, bool alive)
+{
+  AddressContainer::iterator registered = this->Addresses.find(address);
+  if(registered != this->Addresses.end())
+    {
+    typedef std::vector<It>::iterator RegIt;
+    for(RegIt i=registered->second.begin(); i != registered->second.end(); ++i)
+      {
+      const int before = (*i)->numberOfWantedJobs();
+      (*i)->IsAlive = alive;
+      this->updateReadyState(**i, before);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::removeWorker(It worker)
+{
+  //stop wanting jobs, so that we are removed from the ready list
+  worker->NumberOfDesiredJobs = 0;
+  this->updateReadyState(*worker, 0);
 
+  AddressContainer::iterator registered = this->Addresses.find(worker->Address);
+  std::vector<It>& regs = registered->second;
+  regs.erase(std::find(regs.begin(),regs.end(),worker));
+  if(regs.empty())
+    {
+    this->Addresses.erase(registered);
+    }
 
+  this->Workers.erase(worker);
+}
 
 }
 }
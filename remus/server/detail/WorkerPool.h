@@ -14,10 +14,16 @@
 #define remus_server_detail_WorkerPool_h
 
 #include <remus/proto/JobRequirements.h>
+#include <remus/proto/WireFormat.h>
 #include <remus/proto/zmqSocketIdentity.h>
 
 #include <remus/server/detail/SocketMonitor.h>
 
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include <list>
+#include <map>
 #include <set>
 #include <vector>
 
@@ -52,16 +58,53 @@ public:
   //returns the worker address and marks that the worker has taken a job
   zmq::SocketIdentity takeWorker(const remus::proto::JobRequirements& reqs);
 
-  //remove all workers that haven't responded based on the passed in monitor
+  //remove all workers that haven't responded based on the passed in monitor.
+  //The monitor is only queried, so this can be used alongside anything
+  //else that checks its heartbeats
   void purgeDeadWorkers(remus::server::detail::SocketMonitor monitor);
 
+  //remove all dead workers, and update which workers are responsive
+  //based on the changes reported by a SocketMonitor
+  void purgeDeadWorkers(const remus::server::detail::SocketStateChanges& changes);
+
+  //remember the wire format the worker with the given address last sent
+  //a request with, so that jobs are sent to it in that format. Dead
+  //workers are forgotten by purgeDeadWorkers
+  void wireFormat(const zmq::SocketIdentity& address,
+                  remus::proto::WireFormat::Type format);
+
+  //the wire format to send jobs to the worker with, defaults to Text
+  remus::proto::WireFormat::Type
+  wireFormat(const zmq::SocketIdentity& address) const;
+
   //return the socket identity of all workers
   std::set<zmq::SocketIdentity> allWorkers() const;
 
+  //return the number of workers, counting each address once
+  std::size_t numWorkers() const { return this->Addresses.size(); }
+
+  //return the number of workers that want a job, counting a worker once
+  //for each set of requirements it is waiting on
+  std::size_t numWaitingWorkers() const { return this->NumWaitingWorkers; }
+
   //return the socket identity of all workers that want to work on a job
   std::set<zmq::SocketIdentity> allWorkersWantingWork() const;
 
+  //returns the requirements that have had a worker become ready to take
+  //a job since the last call to clearChangedRequirements.
+  const remus::proto::JobRequirementsSet& changedRequirements() const
+    { return ChangedRequirements; }
+
+  //forget all the requirements that have been marked as changed
+  void clearChangedRequirements()
+    { ChangedRequirements = remus::proto::JobRequirementsSet(); }
+
 private:
+  struct WorkerInfo;
+
+  //workers that want a job, in the order they should be given one
+  typedef std::list<WorkerInfo*> ReadyList;
+
   struct WorkerInfo
   {
     int NumberOfDesiredJobs;
@@ -69,27 +112,61 @@ private:
     zmq::SocketIdentity Address;
     bool IsAlive; //alive as heartbeating, not alive as actively wanting jobs
 
+    //where this worker is in the ready list for its requirements
+    bool IsReady;
+    ReadyList::iterator ReadyPosition;
+
     WorkerInfo(const zmq::SocketIdentity& address,
                const remus::proto::JobRequirements& type);
 
     bool isWaitingForWork() const { return NumberOfDesiredJobs > 0 && IsAlive; }
+    int numberOfWantedJobs() const
+      { return isWaitingForWork() ? NumberOfDesiredJobs : 0; }
     void addJob() { ++NumberOfDesiredJobs; }
     void takesJob() { --NumberOfDesiredJobs; }
   };
 
-  struct DeadWorkers
-  {
-   remus::server::detail::SocketMonitor Monitor;
-   DeadWorkers(remus::server::detail::SocketMonitor monitor):
-     Monitor(monitor){}
-   inline bool operator()(const WorkerPool::WorkerInfo& worker)
-    { return Monitor.isDead(worker.Address); }
-  };
+  typedef std::list<WorkerInfo> WorkerContainer;
+  typedef WorkerContainer::const_iterator ConstIt;
+  typedef WorkerContainer::iterator It;
+
+  typedef std::map<remus::proto::JobRequirements, ReadyList> ReadyContainer;
+  typedef boost::unordered_map<zmq::SocketIdentity,
+                               std::vector<It> > AddressContainer;
+
+  //find the worker with the given address and requirements
+  It findWorker(const zmq::SocketIdentity& address,
+                const remus::proto::JobRequirements& reqs) const;
+
+  //add or remove the worker from the ready list for its requirements
+  //after the number of jobs it wants changed from before
+  void updateReadyState(WorkerInfo& worker, int before);
+
+  //remove the worker from every container
+  void removeWorker(It worker);
+
+  //mark every registration of the address as alive or not
+  void markAlive(const zmq::SocketIdentity& address, bool alive);
+
+  //all the workers, we use a list so that the iterators in the
+  //address index stay valid as workers are added and removed
+  WorkerContainer Workers;
+
+  //every registration of a worker address
+  AddressContainer Addresses;
+
+  //the workers waiting for a job for each requirements, only
+  //requirements with at least one waiting worker are stored
+  ReadyContainer ReadyWorkers;
+
+  //the number of workers in the ready lists, as std::list::size isn't
+  //guaranteed to be constant time
+  std::size_t NumWaitingWorkers;
 
+  remus::proto::JobRequirementsSet ChangedRequirements;
 
-  typedef std::vector<WorkerInfo>::const_iterator ConstIt;
-  typedef std::vector<WorkerInfo>::iterator It;
-  std::vector<WorkerInfo> Pool;
+  //the addresses of workers that talk to us with the binary wire format
+  boost::unordered_set<zmq::SocketIdentity> BinaryWorkers;
 };
 
 }
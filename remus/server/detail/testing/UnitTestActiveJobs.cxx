@@ -11,9 +11,14 @@
 //=============================================================================
 #include <remus/server/detail/ActiveJobs.h>
 
+#include <remus/proto/WireFormat.h>
+
 #include <remus/common/SleepFor.h>
 #include <remus/testing/Testing.h>
 
+#include <boost/make_shared.hpp>
+#include <boost/weak_ptr.hpp>
+
 
 namespace {
 
@@ -57,9 +62,14 @@ void verify_add_remove_jobs()
     REMUS_ASSERT( (jobs.status(uuids_used[i]).failed() == false) );
     }
 
+  REMUS_ASSERT( (jobs.numJobs() == 5) );
+  REMUS_ASSERT( (jobs.numJobs(remus::QUEUED) == 5) );
+
   REMUS_ASSERT( (jobs.remove(remus::testing::UUIDGenerator()) == false));
   REMUS_ASSERT( (jobs.remove(uuids_used[0]) == true));
   REMUS_ASSERT( (jobs.remove(uuids_used[0]) == false));
+  REMUS_ASSERT( (jobs.numJobs() == 4) );
+  REMUS_ASSERT( (jobs.numJobs(remus::QUEUED) == 4) );
 
   //verify removing the first job didn't change any of the other jobs
   for(int i=1; i < 5; ++i)
@@ -192,6 +202,13 @@ void verify_updating_status()
   REMUS_ASSERT( (jobs.status(uuids_used[3]).status() == remus::QUEUED) );
   REMUS_ASSERT( (jobs.status(uuids_used[4]).status() == remus::QUEUED) );
 
+  //the status counts followed every change
+  REMUS_ASSERT( (jobs.numJobs(remus::FINISHED) == 1) );
+  REMUS_ASSERT( (jobs.numJobs(remus::FAILED) == 1) );
+  REMUS_ASSERT( (jobs.numJobs(remus::EXPIRED) == 1) );
+  REMUS_ASSERT( (jobs.numJobs(remus::QUEUED) == 2) );
+  REMUS_ASSERT( (jobs.numJobs(remus::IN_PROGRESS) == 0) );
+
   //check for results
   REMUS_ASSERT( (jobs.haveResult(uuids_used[0]) == true) );
   REMUS_ASSERT( (jobs.haveResult(uuids_used[1]) == false) );
@@ -248,6 +265,47 @@ void verify_updating_progress()
   REMUS_ASSERT( (jobs.status(uuid_used).progress().message() == std::string() ) );
 }
 
+void verify_timestamps()
+{
+  using remus::proto::JobTimestamps;
+  boost::uuids::uuid uuid_used = remus::testing::UUIDGenerator();
+  remus::server::detail::ActiveJobs jobs;
+
+  const boost::int64_t queued = JobTimestamps::now();
+  REMUS_ASSERT( (jobs.add(make_socketId(), uuid_used, queued) == true) );
+  JobTimestamps times = jobs.status(uuid_used).timestamps();
+  REMUS_ASSERT( (times.Queued == queued) );
+  REMUS_ASSERT( (times.Dispatched >= queued) );
+  REMUS_ASSERT( (times.FirstProgress == 0) );
+  REMUS_ASSERT( (times.Finished == 0) );
+
+  //progress from the worker doesn't carry timestamps, but keeps ours
+  //and stamps the first progress only once
+  remus::proto::JobStatus wjs(uuid_used, remus::proto::JobProgress(5) );
+  jobs.updateStatus(wjs);
+  times = jobs.status(uuid_used).timestamps();
+  REMUS_ASSERT( (times.Queued == queued) );
+  REMUS_ASSERT( (times.FirstProgress >= times.Dispatched) );
+
+  const boost::int64_t firstProgress = times.FirstProgress;
+  wjs.updateProgress( remus::proto::JobProgress(50) );
+  jobs.updateStatus(wjs);
+  REMUS_ASSERT( (jobs.status(uuid_used).timestamps().FirstProgress ==
+                 firstProgress) );
+
+  //the job finishes when its result arrives
+  jobs.updateResult(remus::proto::JobResult(uuid_used));
+  times = jobs.status(uuid_used).timestamps();
+  REMUS_ASSERT( (jobs.status(uuid_used).finished() == true) );
+  REMUS_ASSERT( (times.Finished >= firstProgress) );
+  REMUS_ASSERT( (times.executionTime() >= 0) );
+
+  //jobs recovered from a journal have no worker and aren't dispatched
+  boost::uuids::uuid recovered = remus::testing::UUIDGenerator();
+  REMUS_ASSERT( (jobs.add(zmq::SocketIdentity(), recovered) == true) );
+  REMUS_ASSERT( (jobs.status(recovered).timestamps() == JobTimestamps()) );
+}
+
 void verify_refresh_jobs()
 {
   //we need to verify that the refresh and expired functions work properly
@@ -354,6 +412,162 @@ void verify_expire_jobs()
 
 }
 
+void verify_encoded_results()
+{
+  remus::server::detail::ActiveJobs jobs;
+  typedef remus::server::detail::ActiveJobs::EncodedResult EncodedResult;
+
+  for(int i=0; i < 2; ++i)
+    {
+    boost::uuids::uuid uuid_used = remus::testing::UUIDGenerator();
+    REMUS_ASSERT( (jobs.add(make_socketId(), uuid_used) == true) );
+
+    remus::proto::JobResult result =
+                          remus::proto::make_JobResult(uuid_used,"data");
+    boost::shared_ptr<std::string> encoded =
+        boost::make_shared<std::string>( (i == 0) ? remus::proto::to_string(result)
+                                                  : remus::proto::to_binary(result) );
+    REMUS_ASSERT( (remus::proto::to_JobResultId(encoded->data(),
+                                                encoded->size()) == uuid_used) );
+
+    jobs.updateResult(uuid_used,
+                      EncodedResult(encoded->data(),encoded->size(),encoded));
+    REMUS_ASSERT( (jobs.haveResult(uuid_used) == true) );
+    REMUS_ASSERT( (jobs.status(uuid_used).finished() == true) );
+
+    //the result is kept as the bytes we gave it, not a copy
+    REMUS_ASSERT( (jobs.encodedResult(uuid_used).Data == encoded->data()) );
+    REMUS_ASSERT( (jobs.encodedResult(uuid_used).Size == encoded->size()) );
+    REMUS_ASSERT( (jobs.result(uuid_used).data() == "data") );
+
+    //and the bytes stay alive until the job is removed
+    boost::weak_ptr<std::string> alive = encoded;
+    encoded.reset();
+    REMUS_ASSERT( (!alive.expired()) );
+    jobs.remove(uuid_used);
+    REMUS_ASSERT( (alive.expired()) );
+    }
+}
+
+void verify_time_to_live()
+{
+  remus::server::detail::ActiveJobs jobs;
+  REMUS_ASSERT( (jobs.timeToLive(remus::FINISHED) == 0) );
+
+  jobs.timeToLive(remus::FINISHED, 1000);
+  jobs.timeToLive(remus::FAILED, 2000);
+  REMUS_ASSERT( (jobs.timeToLive(remus::FINISHED) == 1000) );
+  REMUS_ASSERT( (jobs.timeToLive(remus::FAILED) == 2000) );
+  REMUS_ASSERT( (jobs.timeToLive(remus::EXPIRED) == 0) );
+
+  //jobs 0-3 finish, 4 fails, 5 is still in progress and 6 expires, which
+  //has no time to live so it is kept
+  std::vector< boost::uuids::uuid > uuids_used;
+  std::vector< zmq::SocketIdentity > socketIds_used;
+  std::size_t resultBytes = 0;
+  for(int i=0; i < 7; ++i)
+    {
+    uuids_used.push_back( remus::testing::UUIDGenerator() );
+    socketIds_used.push_back( make_socketId() );
+    REMUS_ASSERT( (jobs.add(socketIds_used[i], uuids_used[i]) == true) );
+    }
+  for(int i=0; i < 4; ++i)
+    {
+    remus::proto::JobResult result =
+                        remus::proto::make_JobResult(uuids_used[i],"data");
+    jobs.updateResult(result);
+    resultBytes += jobs.encodedResult(uuids_used[i]).Size;
+    }
+  jobs.updateStatus(remus::proto::JobStatus(uuids_used[4],remus::FAILED));
+  jobs.updateStatus(remus::proto::JobStatus(uuids_used[5],remus::IN_PROGRESS));
+  remus::server::detail::SocketStateChanges changes;
+  changes.Dead.push_back(socketIds_used[6]);
+  jobs.markExpiredJobs(changes);
+  REMUS_ASSERT( (jobs.status(uuids_used[6]).status() == remus::EXPIRED) );
+
+  //a client retrieving a result removes the job before its time is up
+  resultBytes -= jobs.encodedResult(uuids_used[0]).Size;
+  jobs.remove(uuids_used[0]);
+
+  //nothing is removed before its time to live has passed
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  REMUS_ASSERT( (jobs.collectGarbage(now, 10) == 0) );
+  for(int i=1; i < 7; ++i)
+    { REMUS_ASSERT( (jobs.haveUUID(uuids_used[i]) == true) ); }
+
+  //only finished jobs are past their time after a second and a half, and
+  //no more than the given number of jobs are looked at per call. The job
+  //a client already removed is skipped but still counts
+  const boost::posix_time::ptime later =
+                            now + boost::posix_time::milliseconds(1500);
+  REMUS_ASSERT( (jobs.collectGarbage(later, 2) == 1) );
+  REMUS_ASSERT( (jobs.collectGarbage(later, 2) == 2) );
+  REMUS_ASSERT( (jobs.collectGarbage(later, 2) == 0) );
+  for(int i=1; i < 4; ++i)
+    {
+    REMUS_ASSERT( (jobs.haveUUID(uuids_used[i]) == false) );
+    REMUS_ASSERT( (jobs.results().have(uuids_used[i]) == false) );
+    }
+  REMUS_ASSERT( (jobs.haveUUID(uuids_used[4]) == true) );
+  REMUS_ASSERT( (jobs.reclaimedJobs() == 3) );
+  REMUS_ASSERT( (jobs.reclaimedBytes() == resultBytes) );
+
+  //once the failed job is past its time it is removed, while jobs that are
+  //still running or have no time to live are kept
+  const boost::posix_time::ptime muchLater =
+                            now + boost::posix_time::minutes(10);
+  REMUS_ASSERT( (jobs.collectGarbage(muchLater, 10) == 1) );
+  REMUS_ASSERT( (jobs.haveUUID(uuids_used[4]) == false) );
+  REMUS_ASSERT( (jobs.haveUUID(uuids_used[5]) == true) );
+  REMUS_ASSERT( (jobs.haveUUID(uuids_used[6]) == true) );
+  REMUS_ASSERT( (jobs.reclaimedJobs() == 4) );
+  REMUS_ASSERT( (jobs.reclaimedBytes() == resultBytes) );
+}
+
+void verify_watched_jobs()
+{
+  remus::server::detail::ActiveJobs jobs;
+  const zmq::SocketIdentity worker = make_socketId();
+  const boost::uuids::uuid watched = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid unwatched = remus::testing::UUIDGenerator();
+
+  //jobs can be watched before they are added
+  jobs.watch(watched);
+  REMUS_ASSERT( (jobs.watched(watched)) );
+  jobs.add(worker, watched);
+  jobs.add(worker, unwatched);
+  REMUS_ASSERT( (jobs.takeStatusChanges().empty()) );
+
+  //only changes to the watched job are recorded, and only its newest one
+  jobs.updateStatus(remus::proto::make_JobStatus(watched, 10));
+  jobs.updateStatus(remus::proto::make_JobStatus(watched, 20));
+  jobs.updateStatus(remus::proto::make_JobStatus(unwatched, 10));
+  std::vector<remus::proto::JobStatus> changes = jobs.takeStatusChanges();
+  REMUS_ASSERT( (changes.size() == 1) );
+  REMUS_ASSERT( (changes[0] == remus::proto::make_JobStatus(watched, 20)) );
+  REMUS_ASSERT( (jobs.takeStatusChanges().empty()) );
+
+  //a job that finishes can't change again, so it is no longer watched,
+  //but the change is still returned after the job is removed
+  jobs.updateResult(remus::proto::make_JobResult(watched, "result"));
+  REMUS_ASSERT( (!jobs.watched(watched)) );
+  jobs.remove(watched);
+  changes = jobs.takeStatusChanges();
+  REMUS_ASSERT( (changes.size() == 1) );
+  REMUS_ASSERT( (changes[0].finished()) );
+  REMUS_ASSERT( (changes[0].timestamps().Finished > 0) );
+
+  //removing or unwatching a job stops recording its changes
+  jobs.watch(unwatched);
+  jobs.unwatch(unwatched);
+  jobs.updateStatus(remus::proto::make_JobStatus(unwatched, 30));
+  REMUS_ASSERT( (jobs.takeStatusChanges().empty()) );
+  jobs.watch(unwatched);
+  jobs.remove(unwatched);
+  REMUS_ASSERT( (!jobs.watched(unwatched)) );
+}
+
 } //namespace
 
 int UnitTestActiveJobs(int, char *[])
@@ -364,9 +578,17 @@ int UnitTestActiveJobs(int, char *[])
 
   verify_updating_progress();
 
+  verify_timestamps();
+
   verify_refresh_jobs();
 
   verify_expire_jobs();
 
+  verify_encoded_results();
+
+  verify_time_to_live();
+
+  verify_watched_jobs();
+
   return 0;
 }
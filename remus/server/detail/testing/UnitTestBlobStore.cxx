@@ -0,0 +1,187 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/BlobStore.h>
+
+#include <remus/common/MD5Hash.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <vector>
+
+namespace {
+
+using remus::server::detail::Blob;
+using remus::server::detail::BlobStore;
+
+//adds the contents to the store, returning the owner of the stored data
+boost::shared_ptr<const void> add(BlobStore& store, const std::string& contents)
+{
+  boost::shared_ptr<std::string> data =
+                                boost::make_shared<std::string>(contents);
+  store.add(remus::common::MD5Hash(contents), data->data(), data->size(),
+            data);
+  return data;
+}
+
+std::string to_string(const Blob& b)
+{
+  return std::string(b.Data,b.Size);
+}
+
+std::size_t count_files(const boost::filesystem::path& dir)
+{
+  std::size_t count = 0;
+  boost::filesystem::directory_iterator end;
+  for(boost::filesystem::directory_iterator i(dir); i != end; ++i)
+    { ++count; }
+  return count;
+}
+
+void verify_references()
+{
+  BlobStore store;
+  const std::string contents = remus::testing::BinaryDataGenerator(1024);
+  const std::string hash = remus::common::MD5Hash(contents);
+
+  REMUS_ASSERT( (store.have(hash) == false) );
+  REMUS_ASSERT( (store.get(hash).valid() == false) );
+  REMUS_ASSERT( (store.references(hash) == 0) );
+
+  boost::shared_ptr<const void> owner = add(store, contents);
+  REMUS_ASSERT( (store.have(hash) == true) );
+  REMUS_ASSERT( (store.references(hash) == 1) );
+
+  //blobs are handed back as they were given to us, not copied, and every
+  //view of them counts as a reference
+  {
+  Blob view = store.get(hash);
+  REMUS_ASSERT( (view.Owner == owner) );
+  REMUS_ASSERT( (to_string(view) == contents) );
+  REMUS_ASSERT( (store.references(hash) == 2) );
+  }
+  owner.reset();
+  REMUS_ASSERT( (store.references(hash) == 0) );
+
+  //adding data we already have keeps the first copy
+  boost::shared_ptr<const void> second = add(store, contents);
+  REMUS_ASSERT( (store.size() == 1) );
+  REMUS_ASSERT( (store.references(hash) == 0) );
+
+  //empty data isn't worth storing
+  add(store, std::string());
+  REMUS_ASSERT( (store.size() == 1) );
+
+  REMUS_ASSERT( (store.stats().Hits == 1) );
+  REMUS_ASSERT( (store.stats().Misses == 1) );
+  REMUS_ASSERT( (store.stats().BytesInMemory == 1024) );
+}
+
+void verify_memory_budget()
+{
+  BlobStore store;
+  store.memoryBudget(2048);
+
+  std::vector< std::string > hashes;
+  std::vector< Blob > views;
+  for(int i=0; i < 4; ++i)
+    {
+    const std::string contents = remus::testing::BinaryDataGenerator(1024);
+    hashes.push_back(remus::common::MD5Hash(contents));
+    add(store, contents);
+    views.push_back(store.get(hashes[i]));
+    }
+
+  //referenced blobs are kept even when we are over budget
+  REMUS_ASSERT( (store.size() == 4) );
+  REMUS_ASSERT( (store.stats().BytesInMemory == 4096) );
+
+  //once the jobs using them are done the least recently used are dropped
+  REMUS_ASSERT( (store.get(hashes[0]).valid()) );
+  views.clear();
+  store.collect();
+  REMUS_ASSERT( (store.size() == 2) );
+  REMUS_ASSERT( (store.have(hashes[0]) == true) );
+  REMUS_ASSERT( (store.have(hashes[1]) == false) );
+  REMUS_ASSERT( (store.have(hashes[2]) == false) );
+  REMUS_ASSERT( (store.have(hashes[3]) == true) );
+  REMUS_ASSERT( (store.stats().BlobsEvicted == 2) );
+  REMUS_ASSERT( (store.stats().BlobsSpilled == 0) );
+  REMUS_ASSERT( (store.stats().BytesInMemory == 2048) );
+}
+
+void verify_disk_budget()
+{
+  boost::filesystem::path scratch = boost::filesystem::temp_directory_path() /
+                    boost::filesystem::unique_path("remus_%%%%-%%%%-%%%%");
+  boost::filesystem::create_directories(scratch);
+
+  {
+  BlobStore store;
+  store.scratchDirectory(scratch.string());
+  store.memoryBudget(1024);
+  store.diskBudget(2048);
+
+  std::vector< std::string > hashes;
+  std::vector< std::string > contents;
+  std::vector< boost::weak_ptr<const void> > owners;
+  for(int i=0; i < 4; ++i)
+    {
+    contents.push_back(remus::testing::BinaryDataGenerator(1024));
+    hashes.push_back(remus::common::MD5Hash(contents[i]));
+    owners.push_back(add(store, contents[i]));
+    }
+
+  //the least recently used blob is dropped once the disk is full, and
+  //the spilled blobs release their memory
+  REMUS_ASSERT( (store.size() == 3) );
+  REMUS_ASSERT( (store.have(hashes[0]) == false) );
+  REMUS_ASSERT( (store.stats().BlobsSpilled == 3) );
+  REMUS_ASSERT( (store.stats().BlobsEvicted == 1) );
+  REMUS_ASSERT( (store.stats().BytesInMemory == 1024) );
+  REMUS_ASSERT( (store.stats().BytesOnDisk == 2048) );
+  REMUS_ASSERT( (owners[1].expired() && owners[2].expired()) );
+  REMUS_ASSERT( (!owners[3].expired()) );
+  REMUS_ASSERT( (count_files(scratch) == 2) );
+
+  //spilled blobs are mapped back from disk, and a mapping is a reference
+  Blob mapped = store.get(hashes[1]);
+  REMUS_ASSERT( (to_string(mapped) == contents[1]) );
+  REMUS_ASSERT( (store.references(hashes[1]) == 1) );
+
+  //so the other spilled blob is dropped to make room on disk
+  add(store, remus::testing::BinaryDataGenerator(1024));
+  REMUS_ASSERT( (store.have(hashes[1]) == true) );
+  REMUS_ASSERT( (store.have(hashes[2]) == false) );
+  REMUS_ASSERT( (count_files(scratch) == 2) );
+
+  mapped = Blob();
+  REMUS_ASSERT( (store.references(hashes[1]) == 0) );
+  }
+
+  //destroying the store removes all the spill files
+  REMUS_ASSERT( (count_files(scratch) == 0) );
+  boost::filesystem::remove_all(scratch);
+}
+
+}
+
+int UnitTestBlobStore(int, char *[])
+{
+  verify_references();
+  verify_memory_budget();
+  verify_disk_budget();
+  return 0;
+}
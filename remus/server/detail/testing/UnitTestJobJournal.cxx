@@ -0,0 +1,467 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/JobJournal.h>
+
+#include <remus/common/MD5Hash.h>
+#include <remus/proto/JobResult.h>
+#include <remus/proto/WireFormat.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+
+#include <fstream>
+#include <vector>
+
+#ifndef _WIN32
+  #include <csignal>
+  #include <sys/resource.h>
+#endif
+
+namespace {
+
+using remus::server::detail::JobJournal;
+using remus::server::detail::JournaledJob;
+
+boost::filesystem::path make_Directory()
+{
+  return boost::filesystem::temp_directory_path() /
+         boost::filesystem::unique_path("remus_journal_%%%%-%%%%-%%%%");
+}
+
+remus::proto::JobSubmission make_Submission(const std::string& contents)
+{
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type =
+                        remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobSubmission sub(
+          remus::proto::make_JobRequirements(io_type,"JournalWorker",""));
+  sub["data"] = remus::proto::make_JobContent(contents);
+  return sub;
+}
+
+//decode a submission the same way the server does, so it keeps the bytes
+//it was decoded from
+remus::proto::JobSubmission make_EncodedSubmission(const std::string& contents)
+{
+  boost::shared_ptr<std::string> encoded = boost::make_shared<std::string>(
+                      remus::proto::to_binary(make_Submission(contents)));
+  return remus::proto::to_JobSubmission(encoded->data(),encoded->size(),
+                                        encoded);
+}
+
+remus::proto::JobSubmission to_Submission(const JournaledJob& job)
+{
+  return remus::proto::to_JobSubmission(job.Submission->data(),
+                                        job.Submission->size());
+}
+
+void verify_closed_journal()
+{
+  JobJournal journal;
+  REMUS_ASSERT( (journal.isOpen() == false) );
+
+  //a closed journal ignores every record
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  journal.queued(id, make_Submission("data"));
+  journal.finished(id, "result", 6);
+  REMUS_ASSERT( (journal.hasUncommitted() == false) );
+  REMUS_ASSERT( (journal.commit() == true) );
+  REMUS_ASSERT( (journal.stats().Records == 0) );
+}
+
+void verify_recovery()
+{
+  const boost::filesystem::path dir = make_Directory();
+  std::vector< boost::uuids::uuid > ids;
+  for(int i=0; i < 5; ++i)
+    { ids.push_back(remus::testing::UUIDGenerator()); }
+
+  {
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  REMUS_ASSERT( (jobs.size() == 0) );
+  REMUS_ASSERT( (boost::filesystem::exists(journal.path())) );
+
+  //job 0 stays queued, 1 finishes, 2 fails, 3 is removed and 4 is
+  //dispatched to a worker
+  journal.queued(ids[0], make_EncodedSubmission("zero"));
+  journal.queued(ids[1], make_Submission("one"));
+  journal.queued(ids[2], make_Submission("two"));
+  journal.queued(ids[3], make_Submission("three"));
+  journal.queued(ids[4], make_Submission("four"));
+  journal.dispatched(ids[1]);
+  journal.dispatched(ids[2]);
+  journal.dispatched(ids[4]);
+  journal.finished(ids[1], "result", 6);
+  journal.failed(ids[2], remus::FAILED);
+  journal.removed(ids[3]);
+  REMUS_ASSERT( (journal.hasUncommitted() == true) );
+
+  //every record is written by a single commit
+  REMUS_ASSERT( (journal.commit() == true) );
+  REMUS_ASSERT( (journal.hasUncommitted() == false) );
+  REMUS_ASSERT( (journal.stats().Records == 11) );
+  REMUS_ASSERT( (journal.stats().Commits == 1) );
+  REMUS_ASSERT( (journal.stats().recordsPerCommit() == 11) );
+  }
+
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  REMUS_ASSERT( (jobs.size() == 4) );
+
+  //jobs come back in the order they were queued
+  REMUS_ASSERT( (jobs[0].Id == ids[0]) );
+  REMUS_ASSERT( (jobs[0].Status == remus::QUEUED) );
+  REMUS_ASSERT( (to_Submission(jobs[0]) == make_Submission("zero")) );
+
+  REMUS_ASSERT( (jobs[1].Id == ids[1]) );
+  REMUS_ASSERT( (jobs[1].Status == remus::FINISHED) );
+  REMUS_ASSERT( (*jobs[1].Result == "result") );
+  REMUS_ASSERT( (!jobs[1].Submission) );
+
+  REMUS_ASSERT( (jobs[2].Id == ids[2]) );
+  REMUS_ASSERT( (jobs[2].Status == remus::FAILED) );
+  REMUS_ASSERT( (!jobs[2].Submission) );
+
+  REMUS_ASSERT( (jobs[3].Id == ids[4]) );
+  REMUS_ASSERT( (jobs[3].Dispatched == true) );
+  REMUS_ASSERT( (to_Submission(jobs[3]) == make_Submission("four")) );
+
+  journal.close();
+  boost::filesystem::remove_all(dir);
+}
+
+void verify_large_payloads()
+{
+  //large payloads are written straight to the file between the pending
+  //records, which must still come back in order
+  const boost::filesystem::path dir = make_Directory();
+  const std::string big(300 * 1024, 'b');
+  const std::string result(200 * 1024, 'r');
+  const boost::uuids::uuid first = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid second = remus::testing::UUIDGenerator();
+
+  {
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  journal.queued(first, make_Submission("small"));
+  journal.queued(second, make_EncodedSubmission(big));
+  journal.dispatched(first);
+  journal.finished(first, result.data(), result.size());
+  journal.dispatched(second);
+  REMUS_ASSERT( (journal.commit() == true) );
+  REMUS_ASSERT( (journal.stats().BytesWritten ==
+                 boost::filesystem::file_size(journal.path())) );
+  }
+
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  REMUS_ASSERT( (jobs.size() == 2) );
+  REMUS_ASSERT( (jobs[0].Id == first) );
+  REMUS_ASSERT( (jobs[0].Status == remus::FINISHED) );
+  REMUS_ASSERT( (*jobs[0].Result == result) );
+  REMUS_ASSERT( (jobs[1].Id == second) );
+  REMUS_ASSERT( (jobs[1].Dispatched == true) );
+  REMUS_ASSERT( (to_Submission(jobs[1]) == make_Submission(big)) );
+
+  journal.close();
+  boost::filesystem::remove_all(dir);
+}
+
+//a submission whose data knows its hash, the way the submissions that are
+//assembled from uploads do
+remus::proto::JobSubmission make_HashedSubmission(
+                                  const boost::shared_ptr<std::string>& data,
+                                  const std::string& other)
+{
+  remus::proto::JobSubmission sub(make_Submission(other).requirements());
+  sub["shared"] = remus::proto::JobContent(
+                          remus::common::ContentFormat::BSON,
+                          data->data(), data->size(), data,
+                          remus::common::MD5Hash(*data));
+  const boost::shared_ptr<std::string> otherData =
+                                    boost::make_shared<std::string>(other);
+  sub["other"] = remus::proto::JobContent(
+                          remus::common::ContentFormat::User,
+                          otherData->data(), otherData->size(), otherData,
+                          remus::common::MD5Hash(other));
+  sub["other"].tag("other");
+  return sub;
+}
+
+void verify_journal_by_hash()
+{
+  //data that several submissions share is only journaled once
+  const boost::filesystem::path dir = make_Directory();
+  const boost::shared_ptr<std::string> data =
+                        boost::make_shared<std::string>(256 * 1024, 'd');
+  const remus::proto::JobSubmission first =
+                                  make_HashedSubmission(data, "first");
+  const remus::proto::JobSubmission second =
+                                  make_HashedSubmission(data, "second");
+  const boost::uuids::uuid firstId = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid secondId = remus::testing::UUIDGenerator();
+
+  {
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  journal.queued(firstId, first);
+  journal.queued(secondId, second);
+  REMUS_ASSERT( (journal.commit() == true) );
+  REMUS_ASSERT( (boost::filesystem::file_size(journal.path()) <
+                 data->size() + 4096) );
+  }
+
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  REMUS_ASSERT( (jobs.size() == 2) );
+  REMUS_ASSERT( (jobs[0].Id == firstId) );
+  REMUS_ASSERT( (to_Submission(jobs[0]) == first) );
+  REMUS_ASSERT( (to_Submission(jobs[0]).find("other")->second.tag() ==
+                 first.find("other")->second.tag()) );
+  REMUS_ASSERT( (jobs[1].Id == secondId) );
+  REMUS_ASSERT( (to_Submission(jobs[1]) == second) );
+
+  //reopening wrote a snapshot holding the submissions in full, after which
+  //the shared data is journaled again for the next submission
+  const boost::uintmax_t snapshotSize =
+                          boost::filesystem::file_size(journal.path());
+  journal.queued(remus::testing::UUIDGenerator(),
+                 make_HashedSubmission(data, "third"));
+  REMUS_ASSERT( (journal.commit() == true) );
+  REMUS_ASSERT( (boost::filesystem::file_size(journal.path()) >
+                 snapshotSize + data->size()) );
+
+  journal.close();
+  boost::filesystem::remove_all(dir);
+}
+
+void verify_shared_results()
+{
+  //jobs that finish with the result of another job refer to its record
+  const boost::filesystem::path dir = make_Directory();
+  const boost::uuids::uuid leader = remus::testing::UUIDGenerator();
+  const std::string result = remus::proto::to_binary(
+          remus::proto::JobResult(leader, remus::common::ContentFormat::User,
+                                  std::string(128 * 1024, 'r')));
+  std::vector< boost::uuids::uuid > followers;
+  for(int i=0; i < 3; ++i)
+    { followers.push_back(remus::testing::UUIDGenerator()); }
+
+  {
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  journal.finished(leader, result.data(), result.size());
+  for(std::size_t i=0; i < followers.size(); ++i)
+    { journal.finished(followers[i], result.data(), result.size()); }
+
+  //the result is still found once the job that holds it is removed
+  journal.removed(leader);
+  REMUS_ASSERT( (journal.commit() == true) );
+  REMUS_ASSERT( (boost::filesystem::file_size(journal.path()) <
+                 result.size() + 1024) );
+  }
+
+  for(int reopen=0; reopen < 2; ++reopen)
+    {
+    //the first open reads the references, the second the snapshot the
+    //first wrote, which holds the result once as well
+    JobJournal journal;
+    std::vector<JournaledJob> jobs;
+    REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+    REMUS_ASSERT( (jobs.size() == followers.size()) );
+    for(std::size_t i=0; i < jobs.size(); ++i)
+      {
+      REMUS_ASSERT( (jobs[i].Id == followers[i]) );
+      REMUS_ASSERT( (jobs[i].Status == remus::FINISHED) );
+      REMUS_ASSERT( (*jobs[i].Result == result) );
+      }
+    REMUS_ASSERT( (boost::filesystem::file_size(journal.path()) <
+                   result.size() + 1024) );
+    }
+
+  boost::filesystem::remove_all(dir);
+}
+
+void verify_short_write()
+{
+#ifndef _WIN32
+  //limit the size of files we can write, so the writes of the journal are
+  //cut short the way they are when the disk is full
+  std::signal(SIGXFSZ, SIG_IGN);
+  const boost::filesystem::path dir = make_Directory();
+  const boost::uuids::uuid first = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid second = remus::testing::UUIDGenerator();
+  const std::string result(128 * 1024, 'r');
+
+  {
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  journal.queued(first, make_Submission("first"));
+  REMUS_ASSERT( (journal.commit() == true) );
+  const boost::uintmax_t committed =
+                          boost::filesystem::file_size(journal.path());
+
+  struct rlimit original;
+  getrlimit(RLIMIT_FSIZE, &original);
+  struct rlimit limited = original;
+  limited.rlim_cur = committed + 8192;
+  setrlimit(RLIMIT_FSIZE, &limited);
+
+  //the small record fits, the large payload after it doesn't
+  journal.queued(second, make_Submission(std::string(1024,'s')));
+  journal.finished(first, result.data(), result.size());
+  REMUS_ASSERT( (journal.commit() == false) );
+  REMUS_ASSERT( (journal.hasUncommitted() == true) );
+  REMUS_ASSERT( (boost::filesystem::file_size(journal.path()) <
+                 committed + 4096) );
+
+  //the records that were written stay, and nothing more fits
+  const boost::uintmax_t written =
+                          boost::filesystem::file_size(journal.path());
+  limited.rlim_cur = written;
+  setrlimit(RLIMIT_FSIZE, &limited);
+  REMUS_ASSERT( (journal.commit() == false) );
+  REMUS_ASSERT( (boost::filesystem::file_size(journal.path()) == written) );
+
+  //once there is room again the kept records are written
+  setrlimit(RLIMIT_FSIZE, &original);
+  REMUS_ASSERT( (journal.commit() == true) );
+  REMUS_ASSERT( (journal.hasUncommitted() == false) );
+  }
+
+  //no partial record was left for recovery to stop at
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  REMUS_ASSERT( (jobs.size() == 2) );
+  REMUS_ASSERT( (jobs[0].Id == first) );
+  REMUS_ASSERT( (jobs[0].Status == remus::FINISHED) );
+  REMUS_ASSERT( (*jobs[0].Result == result) );
+  REMUS_ASSERT( (jobs[1].Id == second) );
+  REMUS_ASSERT( (to_Submission(jobs[1]) ==
+                 make_Submission(std::string(1024,'s'))) );
+
+  journal.close();
+  boost::filesystem::remove_all(dir);
+#endif
+}
+
+void verify_partial_record()
+{
+  const boost::filesystem::path dir = make_Directory();
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  std::string path;
+  {
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  journal.queued(id, make_Submission("data"));
+  journal.commit();
+  path = journal.path();
+  }
+  const boost::uintmax_t size = boost::filesystem::file_size(path);
+
+  //a record that was being written when the process died
+  {
+  std::ofstream file(path.c_str(), std::ios::app | std::ios::binary);
+  const char partial[] = { 64, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 1 };
+  file.write(partial, sizeof(partial));
+  }
+  REMUS_ASSERT( (boost::filesystem::file_size(path) > size) );
+
+  JobJournal journal;
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  REMUS_ASSERT( (jobs.size() == 1) );
+  REMUS_ASSERT( (jobs[0].Id == id) );
+
+  //opening the journal drops the partial record
+  REMUS_ASSERT( (boost::filesystem::file_size(path) == size) );
+
+  journal.close();
+  boost::filesystem::remove_all(dir);
+}
+
+void verify_compaction()
+{
+  const boost::filesystem::path dir = make_Directory();
+  const std::string contents = remus::testing::AsciiStringGenerator(1024);
+
+  JobJournal journal;
+  journal.syncOnCommit(false);
+  journal.compactionThreshold(16 * 1024);
+  std::vector<JournaledJob> jobs;
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+
+  //every job but the first is removed, so the journal is mostly dead records
+  const boost::uuids::uuid kept = remus::testing::UUIDGenerator();
+  journal.queued(kept, make_Submission(contents));
+  for(int i=0; i < 64; ++i)
+    {
+    const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+    journal.queued(id, make_Submission(contents));
+    journal.removed(id);
+    journal.commit();
+    }
+  REMUS_ASSERT( (journal.stats().Compactions > 0) );
+  REMUS_ASSERT( (boost::filesystem::file_size(journal.path()) < 16 * 1024) );
+  journal.close();
+
+  REMUS_ASSERT( (journal.open(dir.string(), jobs) == true) );
+  REMUS_ASSERT( (jobs.size() == 1) );
+  REMUS_ASSERT( (jobs[0].Id == kept) );
+  journal.close();
+
+  //the only file is the journal, no snapshot is left behind
+  std::size_t count = 0;
+  boost::filesystem::directory_iterator end;
+  for(boost::filesystem::directory_iterator i(dir); i != end; ++i)
+    { ++count; }
+  REMUS_ASSERT( (count == 1) );
+  boost::filesystem::remove_all(dir);
+}
+
+}
+
+int UnitTestJobJournal(int, char *[])
+{
+  verify_closed_journal();
+
+  verify_recovery();
+
+  verify_large_payloads();
+
+  verify_journal_by_hash();
+
+  verify_shared_results();
+
+  verify_short_write();
+
+  verify_partial_record();
+
+  verify_compaction();
+
+  return 0;
+}
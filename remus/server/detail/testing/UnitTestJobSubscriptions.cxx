@@ -0,0 +1,113 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/JobSubscriptions.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/lexical_cast.hpp>
+
+namespace {
+
+using remus::server::detail::JobSubscriptions;
+
+//makes a random socket identity
+zmq::SocketIdentity make_socketId()
+{
+  boost::uuids::uuid new_uid = remus::testing::UUIDGenerator();
+  const std::string str_id = boost::lexical_cast<std::string>(new_uid);
+  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+}
+
+void verify_add()
+{
+  JobSubscriptions subs;
+  const zmq::SocketIdentity client = make_socketId();
+  const boost::uuids::uuid job = remus::testing::UUIDGenerator();
+
+  REMUS_ASSERT( (!subs.have(job)) );
+  REMUS_ASSERT( (subs.numJobs() == 0) );
+
+  const JobSubscriptions::Subscriber sub(client, "1",
+                                         remus::proto::WireFormat::Text);
+  subs.add(job, sub);
+  subs.add(job, sub);
+  REMUS_ASSERT( (subs.have(job)) );
+  REMUS_ASSERT( (subs.numJobs() == 1) );
+
+  //subscribing twice only notifies once
+  std::vector<remus::proto::JobStatus> statuses;
+  statuses.push_back( remus::proto::make_JobStatus(job, 10) );
+  JobSubscriptions::Notifications n = subs.notify(statuses);
+  REMUS_ASSERT( (n.size() == 1) );
+  REMUS_ASSERT( (n[sub].size() == 1) );
+
+  //a status for a job nobody subscribed to is dropped
+  statuses[0] = remus::proto::make_JobStatus(remus::testing::UUIDGenerator(),
+                                             10);
+  REMUS_ASSERT( (subs.notify(statuses).empty()) );
+}
+
+void verify_notify()
+{
+  JobSubscriptions subs;
+  const zmq::SocketIdentity client = make_socketId();
+  const zmq::SocketIdentity other_client = make_socketId();
+  const boost::uuids::uuid jobA = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid jobB = remus::testing::UUIDGenerator();
+
+  //the same client can hold more than one subscription
+  const JobSubscriptions::Subscriber first(client, "1",
+                                           remus::proto::WireFormat::Text);
+  const JobSubscriptions::Subscriber second(client, "2",
+                                            remus::proto::WireFormat::Binary);
+  const JobSubscriptions::Subscriber other(other_client, "1",
+                                           remus::proto::WireFormat::Text);
+  subs.add(jobA, first);
+  subs.add(jobB, first);
+  subs.add(jobB, second);
+  subs.add(jobA, other);
+  REMUS_ASSERT( (subs.numJobs() == 2) );
+
+  std::vector<remus::proto::JobStatus> statuses;
+  statuses.push_back( remus::proto::make_JobStatus(jobA, 50) );
+  statuses.push_back( remus::proto::JobStatus(jobB, remus::FINISHED) );
+  JobSubscriptions::Notifications n = subs.notify(statuses);
+  REMUS_ASSERT( (n.size() == 3) );
+  REMUS_ASSERT( (n[first].size() == 2) );
+  REMUS_ASSERT( (n[first][0] == statuses[0]) );
+  REMUS_ASSERT( (n[first][1] == statuses[1]) );
+  REMUS_ASSERT( (n[second].size() == 1) );
+  REMUS_ASSERT( (n[second][0].finished()) );
+  REMUS_ASSERT( (n[other].size() == 1) );
+
+  //a finished job can't change again, so its subscriptions are gone
+  REMUS_ASSERT( (!subs.have(jobB)) );
+  REMUS_ASSERT( (subs.have(jobA)) );
+  REMUS_ASSERT( (subs.numJobs() == 1) );
+
+  statuses.clear();
+  statuses.push_back( remus::proto::JobStatus(jobA, remus::FAILED) );
+  statuses.push_back( remus::proto::JobStatus(jobB, remus::FAILED) );
+  n = subs.notify(statuses);
+  REMUS_ASSERT( (n.size() == 2) );
+  REMUS_ASSERT( (n.find(second) == n.end()) );
+  REMUS_ASSERT( (subs.numJobs() == 0) );
+}
+
+} //namespace
+
+int UnitTestJobSubscriptions(int, char *[])
+{
+  verify_add();
+  verify_notify();
+  return 0;
+}
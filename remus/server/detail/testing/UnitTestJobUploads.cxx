@@ -0,0 +1,292 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/ResultStreams.h>
+
+#include <remus/server/detail/JobUploads.h>
+
+#include <remus/common/MD5Hash.h>
+#include <remus/testing/Testing.h>
+
+#include <algorithm>
+
+namespace {
+
+using remus::server::detail::JobUploads;
+
+remus::proto::JobUpload make_upload(boost::uint64_t dataSize,
+                                    const std::string& hash = std::string())
+{
+  const remus::common::MeshIOType types =
+        remus::common::make_MeshIOType(remus::meshtypes::Model(),
+                                       remus::meshtypes::Mesh3D());
+  remus::proto::JobUpload upload(
+          remus::proto::make_JobRequirements(types, "worker", "reqs"));
+  upload.add( remus::proto::JobUpload::Entry("data",
+                                    remus::common::ContentFormat::XML,
+                                    "tagged", dataSize, hash) );
+  upload.add( remus::proto::JobUpload::Entry("empty",
+                                    remus::common::ContentFormat::User,
+                                    "", 0) );
+  return upload;
+}
+
+void verify_assembly()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  const std::string data = remus::testing::BinaryDataGenerator(10000);
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const remus::proto::JobUpload upload = make_upload(data.size());
+
+  JobUploads uploads;
+  uploads.begin(id, upload, now);
+  REMUS_ASSERT( (uploads.have(id)) );
+  REMUS_ASSERT( (uploads.size() == 1) );
+  REMUS_ASSERT( (!uploads.complete(id)) );
+
+  //the chunks are copied into place in order
+  for(std::size_t offset=0; offset < data.size(); offset += 4096)
+    {
+    REMUS_ASSERT( (!uploads.complete(id)) );
+    const std::size_t size = std::min<std::size_t>(4096, data.size()-offset);
+    REMUS_ASSERT( (uploads.write(remus::proto::JobUploadChunk(id, "data",
+                                        offset, data.data()+offset, size),
+                                 now)) );
+    REMUS_ASSERT( (uploads.receivedBytes() == offset + size) );
+    }
+  REMUS_ASSERT( (uploads.complete(id)) );
+
+  remus::proto::JobSubmission submission = uploads.take(id);
+  REMUS_ASSERT( (!uploads.have(id)) );
+  REMUS_ASSERT( (uploads.receivedBytes() == 0) );
+  REMUS_ASSERT( (submission.requirements() == upload.requirements()) );
+  REMUS_ASSERT( (submission.size() == 2) );
+  REMUS_ASSERT( (std::string(submission["data"].data(),
+                             submission["data"].dataSize()) == data) );
+  REMUS_ASSERT( (submission["data"].tag() == "tagged") );
+  REMUS_ASSERT( (submission["data"].formatType() ==
+                 remus::common::ContentFormat::XML) );
+  REMUS_ASSERT( (submission["empty"].dataSize() == 0) );
+
+  //an upload without data is complete as soon as it begins, and has
+  //nothing to send
+  REMUS_ASSERT( (uploads.begin(id, make_upload(0), now).empty()) );
+  REMUS_ASSERT( (uploads.complete(id)) );
+}
+
+void write_all(JobUploads& uploads, const boost::uuids::uuid& id,
+               const std::string& data)
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  REMUS_ASSERT( (uploads.write(remus::proto::JobUploadChunk(id, "data", 0,
+                                        data.data(), data.size()), now)) );
+}
+
+void verify_hashed_contents()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  const std::string data = remus::testing::BinaryDataGenerator(10000);
+  const std::string hash = remus::common::MD5Hash(data);
+  const boost::uuids::uuid first = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid second = remus::testing::UUIDGenerator();
+
+  JobUploads uploads;
+  std::vector<std::string> missing =
+                    uploads.begin(first, make_upload(data.size(), hash), now);
+  REMUS_ASSERT( (missing.size() == 1 && missing[0] == "data") );
+  write_all(uploads, first, data);
+  REMUS_ASSERT( (uploads.blobs().have(hash)) );
+
+  //once the data has arrived, uploading it again sends nothing, and both
+  //jobs share the one copy of the data
+  missing = uploads.begin(second, make_upload(data.size(), hash), now);
+  REMUS_ASSERT( (missing.empty()) );
+  REMUS_ASSERT( (uploads.complete(second)) );
+  REMUS_ASSERT( (!uploads.write(remus::proto::JobUploadChunk(second, "data",
+                                        0, data.data(), data.size()), now)) );
+
+  missing = uploads.begin(second, make_upload(data.size(), hash), now);
+  remus::proto::JobSubmission firstSub = uploads.take(first);
+  remus::proto::JobSubmission secondSub = uploads.take(second);
+  REMUS_ASSERT( (firstSub["data"].data() == secondSub["data"].data()) );
+  REMUS_ASSERT( (std::string(secondSub["data"].data(),
+                             secondSub["data"].dataSize()) == data) );
+  REMUS_ASSERT( (uploads.blobs().references(hash) == 2) );
+
+  //a size that doesn't match the stored blob has to be sent
+  missing = uploads.begin(first, make_upload(data.size()-1, hash), now);
+  REMUS_ASSERT( (missing.size() == 1) );
+
+  //data that doesn't match its hash drops the upload
+  const std::string other = remus::testing::BinaryDataGenerator(100);
+  uploads.begin(first, make_upload(other.size(), hash), now);
+  REMUS_ASSERT( (!uploads.write(remus::proto::JobUploadChunk(first, "data",
+                                        0, other.data(), other.size()), now)) );
+  REMUS_ASSERT( (!uploads.have(first)) );
+  REMUS_ASSERT( (uploads.blobs().size() == 1) );
+}
+
+void verify_bad_chunks()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  const std::string data = remus::testing::AsciiStringGenerator(100);
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  JobUploads uploads;
+  REMUS_ASSERT( (!uploads.write(remus::proto::JobUploadChunk(id, "data", 0,
+                                        data.data(), data.size()), now)) );
+
+  //each bad chunk drops the upload
+  const remus::proto::JobUploadChunk badChunks[3] = {
+    remus::proto::JobUploadChunk(id, "missing", 0, data.data(), 10),
+    remus::proto::JobUploadChunk(id, "data", 10, data.data(), 10),
+    remus::proto::JobUploadChunk(id, "data", 0, data.data(), data.size()) };
+  for(int i=0; i < 3; ++i)
+    {
+    uploads.begin(id, make_upload(50), now);
+    REMUS_ASSERT( (!uploads.write(badChunks[i], now)) );
+    REMUS_ASSERT( (!uploads.have(id)) );
+    REMUS_ASSERT( (uploads.receivedBytes() == 0) );
+    }
+  REMUS_ASSERT( (uploads.take(id).size() == 0) );
+}
+
+void verify_expire()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  const std::string data = remus::testing::AsciiStringGenerator(100);
+  const boost::uuids::uuid idle = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid active = remus::testing::UUIDGenerator();
+
+  JobUploads uploads;
+  uploads.begin(idle, make_upload(data.size()), now);
+  uploads.begin(active, make_upload(data.size()), now);
+  REMUS_ASSERT( (uploads.write(remus::proto::JobUploadChunk(idle, "data", 0,
+                                            data.data(), 10), now)) );
+
+  //writing keeps an upload alive
+  const boost::posix_time::ptime later = now + boost::posix_time::minutes(1);
+  REMUS_ASSERT( (uploads.write(remus::proto::JobUploadChunk(active, "data", 0,
+                                            data.data(), 10), later)) );
+  const std::vector<boost::uuids::uuid> expired =
+                      uploads.expire(now + boost::posix_time::seconds(1));
+  REMUS_ASSERT( (expired.size() == 1) );
+  REMUS_ASSERT( (expired[0] == idle) );
+  REMUS_ASSERT( (!uploads.have(idle)) );
+  REMUS_ASSERT( (uploads.have(active)) );
+  REMUS_ASSERT( (uploads.receivedBytes() == 10) );
+}
+
+
+void verify_declared_sizes()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  const std::string data = remus::testing::AsciiStringGenerator(100);
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  //a size larger than we accept is rejected before anything is allocated
+  JobUploads uploads;
+  uploads.maximumSize(1000);
+  REMUS_ASSERT( (uploads.begin(id, make_upload(1001), now).empty()) );
+  REMUS_ASSERT( (!uploads.have(id)) );
+
+  remus::proto::JobUpload upload = make_upload(600);
+  upload.add( remus::proto::JobUpload::Entry("more",
+                                    remus::common::ContentFormat::User,
+                                    "", 600) );
+  REMUS_ASSERT( (uploads.begin(id, upload, now).empty()) );
+  REMUS_ASSERT( (!uploads.have(id)) );
+
+  //sizes that would wrap when summed are rejected as well
+  upload = make_upload(~static_cast<boost::uint64_t>(0));
+  upload.add( remus::proto::JobUpload::Entry("more",
+                                    remus::common::ContentFormat::User,
+                                    "", 2) );
+  REMUS_ASSERT( (uploads.begin(id, upload, now).empty()) );
+  REMUS_ASSERT( (!uploads.have(id)) );
+
+  //a declared size that is never sent costs nothing
+  uploads.maximumSize(JobUploads().maximumSize());
+  REMUS_ASSERT( (uploads.begin(id, make_upload(1ULL << 33), now).size() == 1) );
+  REMUS_ASSERT( (uploads.write(remus::proto::JobUploadChunk(id, "data", 0,
+                                            data.data(), data.size()), now)) );
+  REMUS_ASSERT( (!uploads.complete(id)) );
+}
+
+void verify_duplicate_keys()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  const std::string data = remus::testing::BinaryDataGenerator(1000);
+  const std::string hash = remus::common::MD5Hash(data);
+  const boost::uuids::uuid stored = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  JobUploads uploads;
+  uploads.begin(stored, make_upload(data.size(), hash), now);
+  write_all(uploads, stored, data);
+  REMUS_ASSERT( (uploads.blobs().have(hash)) );
+
+  //a key described twice keeps the last description, even when the first
+  //one was satisfied by a stored blob
+  remus::proto::JobUpload upload = make_upload(data.size(), hash);
+  upload.add( remus::proto::JobUpload::Entry("data",
+                                    remus::common::ContentFormat::XML,
+                                    "tagged", data.size()) );
+  std::vector<std::string> missing = uploads.begin(id, upload, now);
+  REMUS_ASSERT( (missing.size() == 1 && missing[0] == "data") );
+  REMUS_ASSERT( (!uploads.complete(id)) );
+  write_all(uploads, id, data);
+  REMUS_ASSERT( (uploads.complete(id)) );
+  remus::proto::JobSubmission submission = uploads.take(id);
+  REMUS_ASSERT( (std::string(submission["data"].data(),
+                             submission["data"].dataSize()) == data) );
+
+  //and when the last one is
+  upload = make_upload(data.size());
+  upload.add( remus::proto::JobUpload::Entry("data",
+                                    remus::common::ContentFormat::XML,
+                                    "tagged", data.size(), hash) );
+  missing = uploads.begin(id, upload, now);
+  REMUS_ASSERT( (missing.empty()) );
+  REMUS_ASSERT( (uploads.complete(id)) );
+  submission = uploads.take(id);
+  REMUS_ASSERT( (std::string(submission["data"].data(),
+                             submission["data"].dataSize()) == data) );
+
+  //sizes that differ only count the last one
+  upload = make_upload(data.size() * 2);
+  upload.add( remus::proto::JobUpload::Entry("data",
+                                    remus::common::ContentFormat::XML,
+                                    "tagged", data.size()) );
+  uploads.begin(id, upload, now);
+  write_all(uploads, id, data);
+  REMUS_ASSERT( (uploads.complete(id)) );
+}
+
+}
+
+int UnitTestJobUploads(int, char *[])
+{
+  verify_assembly();
+  verify_hashed_contents();
+  verify_bad_chunks();
+  verify_expire();
+  verify_declared_sizes();
+  verify_duplicate_keys();
+  return 0;
+}
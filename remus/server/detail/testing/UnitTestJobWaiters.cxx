@@ -0,0 +1,113 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/JobWaiters.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/lexical_cast.hpp>
+
+namespace {
+
+using remus::server::detail::JobWaiters;
+using boost::posix_time::milliseconds;
+
+//makes a random socket identity
+zmq::SocketIdentity make_socketId()
+{
+  boost::uuids::uuid new_uid = remus::testing::UUIDGenerator();
+  const std::string str_id = boost::lexical_cast<std::string>(new_uid);
+  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+}
+
+JobWaiters::Waiter make_waiter(const std::string& requestId,
+                               const boost::posix_time::ptime& deadline)
+{
+  return JobWaiters::Waiter(make_socketId(), requestId,
+                            remus::proto::WireFormat::Text, false, deadline);
+}
+
+void verify_finished()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  JobWaiters waiters;
+  const boost::uuids::uuid jobA = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid jobB = remus::testing::UUIDGenerator();
+
+  REMUS_ASSERT( (waiters.empty()) );
+  REMUS_ASSERT( (!waiters.have(jobA)) );
+
+  //many clients can wait on the same job
+  waiters.add(jobA, make_waiter("1", now + milliseconds(100)));
+  waiters.add(jobA, make_waiter("2", now + milliseconds(50)));
+  waiters.add(jobB, make_waiter("3", now + milliseconds(200)));
+  REMUS_ASSERT( (waiters.size() == 3) );
+  REMUS_ASSERT( (waiters.have(jobA)) );
+  REMUS_ASSERT( (waiters.nextDeadline() == now + milliseconds(50)) );
+
+  //a job that can still change doesn't answer anyone
+  std::vector<remus::proto::JobStatus> statuses;
+  statuses.push_back( remus::proto::make_JobStatus(jobA, 50) );
+  statuses.push_back( remus::proto::JobStatus(jobB, remus::QUEUED) );
+  REMUS_ASSERT( (waiters.finished(statuses).empty()) );
+  REMUS_ASSERT( (waiters.size() == 3) );
+
+  statuses.clear();
+  statuses.push_back( remus::proto::JobStatus(jobA, remus::FINISHED) );
+  JobWaiters::Answers answers = waiters.finished(statuses);
+  REMUS_ASSERT( (answers.size() == 2) );
+  REMUS_ASSERT( (answers[0].first == jobA && answers[1].first == jobA) );
+  REMUS_ASSERT( (!waiters.have(jobA)) );
+  REMUS_ASSERT( (waiters.size() == 1) );
+  REMUS_ASSERT( (waiters.nextDeadline() == now + milliseconds(200)) );
+
+  statuses[0] = remus::proto::JobStatus(jobB, remus::EXPIRED);
+  answers = waiters.finished(statuses);
+  REMUS_ASSERT( (answers.size() == 1) );
+  REMUS_ASSERT( (answers[0].second.RequestId == "3") );
+  REMUS_ASSERT( (waiters.empty()) );
+}
+
+void verify_expired()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  JobWaiters waiters;
+  const boost::uuids::uuid job = remus::testing::UUIDGenerator();
+  waiters.add(job, make_waiter("1", now + milliseconds(10)));
+  waiters.add(job, make_waiter("2", now + milliseconds(20)));
+  waiters.add(remus::testing::UUIDGenerator(),
+              make_waiter("3", now + milliseconds(10)));
+
+  REMUS_ASSERT( (waiters.expired(now).empty()) );
+
+  //only the waiters whose deadline has passed are answered
+  JobWaiters::Answers answers = waiters.expired(now + milliseconds(10));
+  REMUS_ASSERT( (answers.size() == 2) );
+  REMUS_ASSERT( (waiters.size() == 1) );
+  REMUS_ASSERT( (waiters.have(job)) );
+  REMUS_ASSERT( (waiters.nextDeadline() == now + milliseconds(20)) );
+
+  answers = waiters.expired(now + milliseconds(100));
+  REMUS_ASSERT( (answers.size() == 1) );
+  REMUS_ASSERT( (answers[0].second.RequestId == "2") );
+  REMUS_ASSERT( (waiters.empty()) );
+}
+
+} //namespace
+
+int UnitTestJobWaiters(int, char *[])
+{
+  verify_finished();
+  verify_expired();
+  return 0;
+}
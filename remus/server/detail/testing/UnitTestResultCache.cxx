@@ -0,0 +1,166 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/ResultCache.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/make_shared.hpp>
+
+namespace {
+
+using remus::server::detail::EncodedResult;
+using remus::server::detail::ResultCache;
+
+remus::proto::JobRequirements make_Requirements(const std::string& name)
+{
+  const remus::common::MeshIOType types =
+        remus::common::make_MeshIOType(remus::meshtypes::Model(),
+                                       remus::meshtypes::Mesh3D());
+  return remus::proto::make_JobRequirements(types, name, "");
+}
+
+remus::proto::JobSubmission make_Submission(const std::string& data,
+                                            const std::string& name = "worker")
+{
+  remus::proto::JobSubmission sub(make_Requirements(name));
+  sub["data"] = remus::proto::make_JobContent(data);
+  return sub;
+}
+
+EncodedResult make_Result(const std::string& contents)
+{
+  boost::shared_ptr<std::string> data =
+                                boost::make_shared<std::string>(contents);
+  return EncodedResult(data->data(),data->size(),data);
+}
+
+void verify_digest()
+{
+  const std::string data = remus::testing::BinaryDataGenerator(1024);
+
+  ResultCache cache;
+  REMUS_ASSERT( (cache.digest(make_Submission(data)).empty()) );
+
+  cache.enabled(true);
+  const std::string digest = cache.digest(make_Submission(data));
+  REMUS_ASSERT( (!digest.empty()) );
+
+  //identical submissions have the same digest, and anything the worker
+  //would see differently changes it
+  REMUS_ASSERT( (cache.digest(make_Submission(data)) == digest) );
+  REMUS_ASSERT( (cache.digest(make_Submission(data + "x")) != digest) );
+  REMUS_ASSERT( (cache.digest(make_Submission(data, "other")) != digest) );
+
+  remus::proto::JobSubmission tagged = make_Submission(data);
+  tagged["data"].tag("tag");
+  REMUS_ASSERT( (cache.digest(tagged) != digest) );
+
+  remus::proto::JobSubmission renamed(make_Requirements("worker"));
+  renamed["other"] = remus::proto::make_JobContent(data);
+  REMUS_ASSERT( (cache.digest(renamed) != digest) );
+
+  //files can change between submissions, and excluded meshers can
+  //give different results, so neither is memoized
+  remus::proto::JobSubmission file(make_Requirements("worker"));
+  file["data"] = remus::proto::make_JobContent(
+                                  remus::common::FileHandle("/some/file"));
+  REMUS_ASSERT( (cache.digest(file).empty()) );
+
+  remus::proto::JobRequirementsSet excluded;
+  excluded.insert(make_Requirements("worker"));
+  cache.exclude(excluded);
+  REMUS_ASSERT( (cache.digest(make_Submission(data)).empty()) );
+  REMUS_ASSERT( (!cache.digest(make_Submission(data, "other")).empty()) );
+}
+
+void verify_executions()
+{
+  ResultCache cache;
+  cache.enabled(true);
+  const remus::proto::JobSubmission sub = make_Submission("data");
+  const std::string digest = cache.digest(sub);
+  const boost::uuids::uuid leader = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid first = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid second = remus::testing::UUIDGenerator();
+
+  REMUS_ASSERT( (cache.leader(digest).is_nil()) );
+  cache.lead(leader, digest, sub);
+  REMUS_ASSERT( (cache.leader(digest) == leader) );
+  REMUS_ASSERT( (cache.leading(leader)) );
+
+  cache.follow(first, digest);
+  cache.follow(second, digest);
+  REMUS_ASSERT( (cache.followers(leader).size() == 2) );
+  REMUS_ASSERT( (cache.unfollow(first)) );
+  REMUS_ASSERT( (!cache.unfollow(first)) );
+  REMUS_ASSERT( (cache.followers(leader).size() == 1) );
+  REMUS_ASSERT( (cache.leaders().size() == 1) );
+
+  const ResultCache::Execution execution = cache.finish(leader);
+  REMUS_ASSERT( (execution.Digest == digest) );
+  REMUS_ASSERT( (execution.Submission == sub) );
+  REMUS_ASSERT( (execution.Followers.size() == 1) );
+  REMUS_ASSERT( (execution.Followers[0] == second) );
+  REMUS_ASSERT( (!cache.leading(leader)) );
+  REMUS_ASSERT( (cache.leader(digest).is_nil()) );
+  REMUS_ASSERT( (!cache.unfollow(second)) );
+  REMUS_ASSERT( (cache.numExecutions() == 0) );
+
+  REMUS_ASSERT( (cache.stats().Executions == 1) );
+  REMUS_ASSERT( (cache.stats().Coalesced == 2) );
+}
+
+void verify_lru()
+{
+  ResultCache cache;
+  cache.enabled(true);
+  cache.capacity(2048);
+
+  //results are handed back as they were given to us
+  const EncodedResult result = make_Result(
+                            remus::testing::AsciiStringGenerator(1024));
+  cache.add("a", result);
+  REMUS_ASSERT( (cache.find("a").Data == result.Data) );
+  REMUS_ASSERT( (cache.find("missing").Size == 0) );
+
+  //using a result makes it the most recently used, so it outlives
+  //results added before it
+  cache.add("b", make_Result(remus::testing::AsciiStringGenerator(1024)));
+  REMUS_ASSERT( (cache.find("a").Size == 1024) );
+  cache.add("c", make_Result(remus::testing::AsciiStringGenerator(1024)));
+  REMUS_ASSERT( (cache.size() == 2) );
+  REMUS_ASSERT( (cache.find("b").Size == 0) );
+  REMUS_ASSERT( (cache.find("a").Size == 1024) );
+  REMUS_ASSERT( (cache.stats().ResultsEvicted == 1) );
+  REMUS_ASSERT( (cache.stats().BytesCached == 2048) );
+
+  //results larger than the cache aren't cached
+  cache.add("d", make_Result(remus::testing::AsciiStringGenerator(4096)));
+  REMUS_ASSERT( (cache.find("d").Size == 0) );
+
+  //shrinking the cache evicts the least recently used
+  cache.capacity(1024);
+  REMUS_ASSERT( (cache.size() == 1) );
+  REMUS_ASSERT( (cache.find("a").Size == 1024) );
+  REMUS_ASSERT( (cache.stats().Hits == 4) );
+}
+
+}
+
+int UnitTestResultCache(int, char *[])
+{
+  verify_digest();
+  verify_executions();
+  verify_lru();
+  return 0;
+}
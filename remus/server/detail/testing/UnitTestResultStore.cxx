@@ -0,0 +1,178 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/ResultStore.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <vector>
+
+namespace {
+
+using remus::server::detail::EncodedResult;
+using remus::server::detail::ResultStore;
+
+EncodedResult make_Result(const std::string& contents)
+{
+  boost::shared_ptr<std::string> data =
+                                boost::make_shared<std::string>(contents);
+  return EncodedResult(data->data(),data->size(),data);
+}
+
+std::string to_string(const EncodedResult& r)
+{
+  return std::string(r.Data,r.Size);
+}
+
+std::size_t count_files(const boost::filesystem::path& dir)
+{
+  std::size_t count = 0;
+  boost::filesystem::directory_iterator end;
+  for(boost::filesystem::directory_iterator i(dir); i != end; ++i)
+    { ++count; }
+  return count;
+}
+
+void verify_unlimited_budget()
+{
+  ResultStore store;
+  std::vector< boost::uuids::uuid > ids;
+  for(int i=0; i < 5; ++i)
+    {
+    ids.push_back(remus::testing::UUIDGenerator());
+    store.add(ids[i], make_Result(remus::testing::AsciiStringGenerator(1024)));
+    }
+
+  REMUS_ASSERT( (store.size() == 5) );
+  REMUS_ASSERT( (store.stats().BytesInMemory == 5*1024) );
+  REMUS_ASSERT( (store.stats().ResultsSpilled == 0) );
+
+  //results are handed back as they were given to us, not copied
+  const EncodedResult first = make_Result("first");
+  store.add(ids[0], first);
+  REMUS_ASSERT( (store.get(ids[0]).Data == first.Data) );
+  REMUS_ASSERT( (store.stats().BytesInMemory == 4*1024+5) );
+
+  REMUS_ASSERT( (store.remove(ids[0]) == true) );
+  REMUS_ASSERT( (store.remove(ids[0]) == false) );
+  REMUS_ASSERT( (store.have(ids[0]) == false) );
+  REMUS_ASSERT( (store.get(ids[0]).Size == 0) );
+  REMUS_ASSERT( (store.stats().MemoryHits == 1) );
+  REMUS_ASSERT( (store.stats().hitRate() == 1.0) );
+}
+
+void verify_spilling()
+{
+  boost::filesystem::path scratch = boost::filesystem::temp_directory_path() /
+                    boost::filesystem::unique_path("remus_%%%%-%%%%-%%%%");
+  boost::filesystem::create_directories(scratch);
+
+  {
+  ResultStore store;
+  store.scratchDirectory(scratch.string());
+  store.memoryBudget(2048);
+
+  std::vector< boost::uuids::uuid > ids;
+  std::vector< std::string > contents;
+  std::vector< boost::weak_ptr<const void> > owners;
+  for(int i=0; i < 4; ++i)
+    {
+    ids.push_back(remus::testing::UUIDGenerator());
+    contents.push_back(remus::testing::BinaryDataGenerator(1024));
+    EncodedResult r = make_Result(contents[i]);
+    owners.push_back(r.Owner);
+    store.add(ids[i], r);
+    }
+
+  //the two least recently used results are spilled, and their memory
+  //is released
+  REMUS_ASSERT( (store.stats().ResultsSpilled == 2) );
+  REMUS_ASSERT( (store.stats().BytesSpilled == 2048) );
+  REMUS_ASSERT( (store.stats().BytesInMemory == 2048) );
+  REMUS_ASSERT( (store.stats().BytesOnDisk == 2048) );
+  REMUS_ASSERT( (owners[0].expired() && owners[1].expired()) );
+  REMUS_ASSERT( (!owners[2].expired() && !owners[3].expired()) );
+  REMUS_ASSERT( (count_files(scratch) == 2) );
+
+  //using a result makes it the most recently used, so the next result
+  //added spills the other one
+  REMUS_ASSERT( (to_string(store.get(ids[2])) == contents[2]) );
+  ids.push_back(remus::testing::UUIDGenerator());
+  store.add(ids[4], make_Result(remus::testing::BinaryDataGenerator(1024)));
+  REMUS_ASSERT( (store.stats().ResultsSpilled == 3) );
+  REMUS_ASSERT( (owners[3].expired()) );
+  REMUS_ASSERT( (!owners[2].expired()) );
+
+  //spilled results are mapped back from disk
+  for(int i=0; i < 4; ++i)
+    { REMUS_ASSERT( (to_string(store.get(ids[i])) == contents[i]) ); }
+  REMUS_ASSERT( (store.stats().MemoryHits == 2) );
+  REMUS_ASSERT( (store.stats().DiskHits == 3) );
+  REMUS_ASSERT( (store.stats().hitRate() == 0.4) );
+
+  //a mapping keeps the spill file around after the result is removed
+  EncodedResult mapped = store.get(ids[0]);
+  REMUS_ASSERT( (store.remove(ids[0]) == true) );
+  REMUS_ASSERT( (to_string(mapped) == contents[0]) );
+  REMUS_ASSERT( (count_files(scratch) == 3) );
+  mapped = EncodedResult();
+  REMUS_ASSERT( (count_files(scratch) == 2) );
+  REMUS_ASSERT( (store.stats().BytesOnDisk == 2048) );
+
+  //a result larger than the whole budget goes straight to disk
+  const boost::uuids::uuid big = remus::testing::UUIDGenerator();
+  store.add(big, make_Result(remus::testing::BinaryDataGenerator(4096)));
+  REMUS_ASSERT( (store.stats().BytesInMemory <= 2048) );
+  REMUS_ASSERT( (store.get(big).Size == 4096) );
+  REMUS_ASSERT( (store.get(big).Id.is_nil()) );
+
+  //a shared result is still sent for its own job once it is spilled
+  const boost::uuids::uuid shared = remus::testing::UUIDGenerator();
+  store.add(shared, remus::server::detail::share_result(
+                          make_Result(remus::testing::BinaryDataGenerator(4096)),
+                          shared));
+  REMUS_ASSERT( (store.get(shared).Size == 4096) );
+  REMUS_ASSERT( (store.get(shared).Id == shared) );
+  }
+
+  //destroying the store removes all the spill files
+  REMUS_ASSERT( (count_files(scratch) == 0) );
+  boost::filesystem::remove_all(scratch);
+}
+
+void verify_unwritable_scratch()
+{
+  //results that can't be spilled are kept in memory
+  ResultStore store;
+  store.scratchDirectory("/remus/directory/that/does/not/exist");
+  store.memoryBudget(16);
+
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  store.add(id, make_Result(remus::testing::AsciiStringGenerator(64)));
+  REMUS_ASSERT( (store.stats().ResultsSpilled == 0) );
+  REMUS_ASSERT( (store.stats().BytesInMemory == 64) );
+  REMUS_ASSERT( (store.get(id).Size == 64) );
+}
+
+}
+
+int UnitTestResultStore(int, char *[])
+{
+  verify_unlimited_budget();
+  verify_spilling();
+  verify_unwritable_scratch();
+  return 0;
+}
@@ -0,0 +1,200 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/ResultStreams.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+namespace {
+
+using remus::server::detail::ResultStreams;
+
+//makes a random socket identity
+zmq::SocketIdentity make_socketId()
+{
+  boost::uuids::uuid new_uid = remus::testing::UUIDGenerator();
+  const std::string str_id = boost::lexical_cast<std::string>(new_uid);
+  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+}
+
+void verify_credit()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  boost::shared_ptr<std::string> data = boost::make_shared<std::string>(
+                            remus::testing::BinaryDataGenerator(10000));
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const ResultStreams::Key key(make_socketId(), "1");
+
+  ResultStreams streams;
+  REMUS_ASSERT( (!streams.ready()) );
+  REMUS_ASSERT( (!streams.credit(key, 1, now)) );
+
+  //chunks are never smaller than 4096 bytes, so this takes three chunks
+  streams.open(key, remus::proto::WireFormat::Text, id,
+               remus::common::ContentFormat::User,
+               data->data(), data->size(), data, 16, 2, now);
+  REMUS_ASSERT( (streams.have(key)) );
+  REMUS_ASSERT( (streams.ready()) );
+
+  //one chunk per stream is taken at a time
+  std::vector<boost::uuids::uuid> finished;
+  std::vector<ResultStreams::Chunk> chunks = streams.nextChunks(finished);
+  REMUS_ASSERT( (chunks.size() == 1) );
+  REMUS_ASSERT( (chunks[0].Header.offset() == 0) );
+  REMUS_ASSERT( (chunks[0].Header.totalSize() == data->size()) );
+  REMUS_ASSERT( (chunks[0].Size == 4096) );
+  REMUS_ASSERT( (chunks[0].Data == data->data()) );
+
+  chunks = streams.nextChunks(finished);
+  REMUS_ASSERT( (chunks.size() == 1) );
+  REMUS_ASSERT( (chunks[0].Header.offset() == 4096) );
+
+  //out of credit, nothing is sent until the client grants more
+  REMUS_ASSERT( (!streams.ready()) );
+  REMUS_ASSERT( (streams.nextChunks(finished).empty()) );
+  REMUS_ASSERT( (streams.credit(key, 4, now)) );
+  REMUS_ASSERT( (streams.ready()) );
+
+  chunks = streams.nextChunks(finished);
+  REMUS_ASSERT( (chunks.size() == 1) );
+  REMUS_ASSERT( (chunks[0].Header.offset() == 8192) );
+  REMUS_ASSERT( (chunks[0].Size == data->size() - 8192) );
+
+  //the last chunk closes the stream
+  REMUS_ASSERT( (finished.size() == 1 && finished[0] == id) );
+  REMUS_ASSERT( (!streams.have(key)) );
+  REMUS_ASSERT( (!streams.ready()) );
+}
+
+void verify_many_streams()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  boost::shared_ptr<std::string> data = boost::make_shared<std::string>(
+                            remus::testing::BinaryDataGenerator(8192));
+  const zmq::SocketIdentity client = make_socketId();
+  const ResultStreams::Key first(client, "1");
+  const ResultStreams::Key second(client, "2");
+  const ResultStreams::Key third(make_socketId(), "1");
+
+  ResultStreams streams;
+  streams.open(first, remus::proto::WireFormat::Text,
+               remus::testing::UUIDGenerator(),
+               remus::common::ContentFormat::User,
+               data->data(), data->size(), data, 4096, 8, now);
+  streams.open(second, remus::proto::WireFormat::Binary,
+               remus::testing::UUIDGenerator(),
+               remus::common::ContentFormat::User,
+               data->data(), data->size(), data, 4096, 8, now);
+  streams.open(third, remus::proto::WireFormat::Binary,
+               remus::testing::UUIDGenerator(),
+               remus::common::ContentFormat::User,
+               data->data(), data->size(), data, 4096, 0, now);
+  REMUS_ASSERT( (streams.size() == 2) );
+
+  //every stream with credit gets a chunk each time
+  std::vector<boost::uuids::uuid> finished;
+  REMUS_ASSERT( (streams.nextChunks(finished).size() == 2) );
+  REMUS_ASSERT( (streams.nextChunks(finished).size() == 2) );
+  REMUS_ASSERT( (finished.size() == 2) );
+  REMUS_ASSERT( (streams.size() == 0) );
+
+  //granting no credit closes a stream
+  streams.open(first, remus::proto::WireFormat::Text,
+               remus::testing::UUIDGenerator(),
+               remus::common::ContentFormat::User,
+               data->data(), data->size(), data, 4096, 1, now);
+  REMUS_ASSERT( (streams.credit(first, 0, now)) );
+  REMUS_ASSERT( (!streams.have(first)) );
+  REMUS_ASSERT( (!streams.ready()) );
+
+  //only streams that are out of credit can sit idle
+  streams.open(first, remus::proto::WireFormat::Text,
+               remus::testing::UUIDGenerator(),
+               remus::common::ContentFormat::User,
+               data->data(), data->size(), data, 4096, 1, now);
+  streams.open(second, remus::proto::WireFormat::Text,
+               remus::testing::UUIDGenerator(),
+               remus::common::ContentFormat::User,
+               data->data(), data->size(), data, 4096, 2, now);
+  streams.nextChunks(finished);
+  REMUS_ASSERT( (streams.expire(now + boost::posix_time::seconds(1)) == 1) );
+  REMUS_ASSERT( (!streams.have(first)) );
+  REMUS_ASSERT( (streams.have(second)) );
+  REMUS_ASSERT( (streams.ready()) );
+}
+
+void verify_empty_result()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  boost::shared_ptr<std::string> data = boost::make_shared<std::string>();
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const ResultStreams::Key key(make_socketId(), "1");
+
+  //an empty result is sent as a single empty chunk
+  ResultStreams streams;
+  streams.open(key, remus::proto::WireFormat::Binary, id,
+               remus::common::ContentFormat::User,
+               data->data(), data->size(), data, 4096, 4, now);
+  REMUS_ASSERT( (streams.ready()) );
+
+  std::vector<boost::uuids::uuid> finished;
+  std::vector<ResultStreams::Chunk> chunks = streams.nextChunks(finished);
+  REMUS_ASSERT( (chunks.size() == 1) );
+  REMUS_ASSERT( (chunks[0].Size == 0) );
+  REMUS_ASSERT( (chunks[0].Header.totalSize() == 0) );
+  REMUS_ASSERT( (finished.size() == 1 && finished[0] == id) );
+  REMUS_ASSERT( (!streams.have(key)) );
+  REMUS_ASSERT( (!streams.ready()) );
+}
+
+void verify_credit_saturates()
+{
+  const boost::posix_time::ptime now =
+                            boost::posix_time::microsec_clock::local_time();
+  boost::shared_ptr<std::string> data = boost::make_shared<std::string>(
+                            remus::testing::BinaryDataGenerator(8192));
+  const ResultStreams::Key key(make_socketId(), "1");
+
+  //credit that would wrap around leaves the stream with all it can count,
+  //instead of none
+  const boost::uint32_t most = ~boost::uint32_t(0);
+  ResultStreams streams;
+  streams.open(key, remus::proto::WireFormat::Binary,
+               remus::testing::UUIDGenerator(),
+               remus::common::ContentFormat::User,
+               data->data(), data->size(), data, 4096, 1, now);
+  REMUS_ASSERT( (streams.credit(key, most, now)) );
+  REMUS_ASSERT( (streams.credit(key, most, now)) );
+  REMUS_ASSERT( (streams.ready()) );
+
+  std::vector<boost::uuids::uuid> finished;
+  REMUS_ASSERT( (streams.nextChunks(finished).size() == 1) );
+  REMUS_ASSERT( (streams.nextChunks(finished).size() == 1) );
+  REMUS_ASSERT( (finished.size() == 1) );
+  REMUS_ASSERT( (!streams.ready()) );
+}
+
+} //namespace
+
+int UnitTestResultStreams(int, char *[])
+{
+  verify_credit();
+  verify_many_streams();
+  verify_empty_result();
+  verify_credit_saturates();
+  return 0;
+}
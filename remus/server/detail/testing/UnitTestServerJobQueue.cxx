@@ -15,6 +15,8 @@
 #include <remus/server/detail/uuidHelper.h>
 #include <remus/testing/Testing.h>
 
+#include <algorithm>
+
 
 namespace {
 
@@ -174,9 +176,14 @@ void verify_dispatch_jobs()
 
   REMUS_ASSERT( (queue.takeJob(worker_type1D).valid() == false) );
 
-  remus::worker::Job job_2d_1 = queue.takeJob(worker_type2D);
+  //taking a job tells us when it was queued
+  boost::int64_t queuedTime = 0;
+  remus::worker::Job job_2d_1 = queue.takeJob(worker_type2D, &queuedTime);
   REMUS_ASSERT( (job_2d_1.valid() == true) );
   REMUS_ASSERT( (queue.haveUUID(job_2d_1.id()) == false) );
+  REMUS_ASSERT( (queuedTime > 0) );
+  REMUS_ASSERT( (queuedTime <= remus::proto::JobTimestamps::now()) );
+  REMUS_ASSERT( (queue.queuedTime(job_2d_1.id()) == 0) );
 
   remus::worker::Job job_2d_2 = queue.takeJob(worker_type2D);
   REMUS_ASSERT( (job_2d_2.valid() == true) );
@@ -212,6 +219,73 @@ void verify_dispatch_jobs()
   REMUS_ASSERT( (queue.waitingJobRequirements().count(worker_type3D) == 0) );
 }
 
+void verify_job_ordering()
+{
+  remus::server::detail::JobQueue queue;
+
+  std::vector< boost::uuids::uuid > ids;
+  for(int i=0; i < 5; ++i) { ids.push_back(make_id()); }
+
+  remus::proto::JobSubmission submission = make_jobSubmission(Edges(),Mesh3D());
+  for(int i=0; i < 5; ++i) { queue.addJob( ids[i], submission ); }
+
+  std::vector< boost::uuids::uuid > sorted_ids(ids);
+  std::sort(sorted_ids.begin(),sorted_ids.end());
+
+  //dispatching a worker moves the lowest uuid to be waiting for a worker
+  REMUS_ASSERT( (queue.workerDispatched(worker_type3D) == true) );
+  REMUS_ASSERT( (queue.workerDispatched(worker_type3D) == true) );
+
+  //removing a job that is waiting for a worker keeps the other waiting jobs
+  REMUS_ASSERT( (queue.remove(sorted_ids[0]) == true) );
+  REMUS_ASSERT( (queue.numJobsWaitingForWorkers() == 1) );
+  REMUS_ASSERT( (queue.numJobsJustQueued() == 3) );
+
+  //jobs waiting for workers come out first, then the rest by uuid
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).id() == sorted_ids[1]) );
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).id() == sorted_ids[2]) );
+
+  REMUS_ASSERT( (queue.remove(sorted_ids[3]) == true) );
+  REMUS_ASSERT( (queue.remove(sorted_ids[3]) == false) );
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).id() == sorted_ids[4]) );
+
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).valid() == false) );
+  REMUS_ASSERT( (queue.queuedJobRequirements().size() == 0) );
+  REMUS_ASSERT( (queue.waitingJobRequirements().size() == 0) );
+}
+
+void verify_changed_requirements()
+{
+  remus::server::detail::JobQueue queue;
+  REMUS_ASSERT( (queue.changedRequirements().size() == 0) );
+
+  queue.addJob( make_id(), make_jobSubmission(Edges(),Mesh2D()) );
+  queue.addJob( make_id(), make_jobSubmission(Edges(),Mesh2D()) );
+  queue.addJob( make_id(), make_jobSubmission(Edges(),Mesh3D()) );
+
+  REMUS_ASSERT( (queue.changedRequirements().size() == 2) );
+  REMUS_ASSERT( (queue.numJobsJustQueued(worker_type2D) == 2) );
+  REMUS_ASSERT( (queue.numJobsJustQueued(worker_type3D) == 1) );
+  REMUS_ASSERT( (queue.numJobsJustQueued(worker_type1D) == 0) );
+
+  queue.clearChangedRequirements();
+  REMUS_ASSERT( (queue.changedRequirements().size() == 0) );
+
+  //dispatching and taking jobs doesn't mark requirements as changed
+  queue.workerDispatched(worker_type2D);
+  REMUS_ASSERT( (queue.numJobsWaitingForWorkers(worker_type2D) == 1) );
+  REMUS_ASSERT( (queue.numJobsJustQueued(worker_type2D) == 1) );
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).valid() == true) );
+  REMUS_ASSERT( (queue.changedRequirements().size() == 0) );
+
+  //only requirements that still have jobs can be marked as changed
+  queue.markRequirementsChanged(worker_type3D);
+  REMUS_ASSERT( (queue.changedRequirements().size() == 0) );
+  queue.markAllRequirementsChanged();
+  REMUS_ASSERT( (queue.changedRequirements().size() == 1) );
+  REMUS_ASSERT( (queue.changedRequirements().count(worker_type2D) == 1) );
+}
+
 } //namespace
 
 int UnitTestServerJobQueue(int, char *[])
@@ -221,6 +295,10 @@ int UnitTestServerJobQueue(int, char *[])
 
   verify_dispatch_jobs();
 
+  verify_job_ordering();
+
+  verify_changed_requirements();
+
 
   return 0;
 }
@@ -225,6 +225,59 @@ void verify_responiveness()
   }
 }
 
+void verify_check_heartbeats()
+{
+  zmq::SocketIdentity sid1 = make_socketId();
+  zmq::SocketIdentity sid2 = make_socketId();
+  SocketMonitor monitor;
+
+  monitor.heartbeat(sid1, make_heartbeat(50) );
+  monitor.heartbeat(sid2, make_heartbeat(50) );
+
+  remus::server::detail::SocketStateChanges changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Dead.size() == 0) );
+  REMUS_ASSERT( (changes.Unresponsive.size() == 0) );
+  REMUS_ASSERT( (changes.Responsive.size() == 0) );
+
+  //after twice the interval only the socket that didn't beat again
+  //becomes unresponsive
+  remus::common::SleepForMillisec(70);
+  monitor.heartbeat(sid1, make_heartbeat(50) );
+  remus::common::SleepForMillisec(70);
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Unresponsive.size() == 1) );
+  REMUS_ASSERT( (changes.Unresponsive[0] == sid2) );
+  REMUS_ASSERT( (changes.Responsive.size() == 0) );
+
+  //a socket is only reported once for each missed heartbeat
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Unresponsive.size() == 0) );
+
+  //bring the socket back to being responsive
+  monitor.heartbeat(sid1, make_heartbeat(50) );
+  monitor.heartbeat(sid2, make_heartbeat(50) );
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Responsive.size() == 1) );
+  REMUS_ASSERT( (changes.Responsive[0] == sid2) );
+
+  //dead sockets are reported once, and are never unresponsive
+  monitor.markAsDead(sid2);
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Dead.size() == 1) );
+  REMUS_ASSERT( (changes.Dead[0] == sid2) );
+
+  remus::common::SleepForMillisec(150);
+  changes = monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Dead.size() == 0) );
+  REMUS_ASSERT( (changes.Unresponsive.size() == 1) );
+  REMUS_ASSERT( (changes.Unresponsive[0] == sid1) );
+
+  //verify that the check interval is kept positive
+  monitor.heartbeatCheckInterval(100);
+  REMUS_ASSERT( (monitor.heartbeatCheckInterval() == 100) );
+  monitor.heartbeatCheckInterval(-5);
+  REMUS_ASSERT( (monitor.heartbeatCheckInterval() == 1) );
+}
 
 }
 int UnitTestSocketMonitor(int, char *[])
@@ -238,6 +291,7 @@ int UnitTestSocketMonitor(int, char *[])
   verify_resurrection();
   verify_heartbeat_interval();
   verify_responiveness();
+  verify_check_heartbeats();
 
   return 0;
 }
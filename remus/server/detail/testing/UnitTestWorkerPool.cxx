@@ -11,6 +11,8 @@
 //=============================================================================
 #include <remus/server/detail/WorkerPool.h>
 
+#include <remus/server/detail/ActiveJobs.h>
+
 #include <remus/common/SleepFor.h>
 #include <remus/proto/zmqSocketIdentity.h>
 #include <remus/server/detail/uuidHelper.h>
@@ -166,6 +168,91 @@ void verify_purge_workers()
   REMUS_ASSERT( (pool.allWorkersWantingWork().size() == 1) );
 }
 
+void verify_shared_monitor(bool purgeFirst)
+{
+  //the pool and the active jobs both use the same monitor, and each has
+  //to see the workers that died no matter which asks first
+  typedef remus::server::detail::SocketMonitor MonitorType;
+  MonitorType monitor = make_Monitor( );
+  remus::server::detail::WorkerPool pool;
+  remus::server::detail::ActiveJobs jobs;
+
+  const zmq::SocketIdentity unresponsive = make_socketId();
+  const zmq::SocketIdentity dead = make_socketId();
+  const boost::uuids::uuid unresponsiveJob = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid deadJob = remus::testing::UUIDGenerator();
+
+  pool.addWorker(unresponsive, worker_type2D);
+  pool.readyForWork(unresponsive, worker_type2D);
+  pool.addWorker(dead, worker_type3D);
+  pool.readyForWork(dead, worker_type3D);
+  jobs.add(unresponsive, unresponsiveJob);
+  jobs.add(dead, deadJob);
+  monitor.refresh(unresponsive);
+  monitor.refresh(dead);
+
+  monitor.markAsDead(dead);
+  remus::common::SleepForMillisec(100);
+
+  if(purgeFirst)
+    {
+    pool.purgeDeadWorkers(monitor);
+    jobs.markExpiredJobs(monitor);
+    }
+  else
+    {
+    jobs.markExpiredJobs(monitor);
+    pool.purgeDeadWorkers(monitor);
+    }
+
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) );
+  REMUS_ASSERT( (pool.haveWorker(unresponsive, worker_type2D) == true) );
+  REMUS_ASSERT( (pool.haveWorker(dead, worker_type3D) == false) );
+  REMUS_ASSERT( (jobs.status(unresponsiveJob).status() == remus::EXPIRED) );
+  REMUS_ASSERT( (jobs.status(deadJob).status() == remus::EXPIRED) );
+
+  //the changes are still there for the server to check
+  const remus::server::detail::SocketStateChanges changes =
+                                                  monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Dead.size() == 1) );
+  REMUS_ASSERT( (changes.Unresponsive.size() == 1) );
+}
+
+void verify_assign_to_unresponsive()
+{
+  //a job given to a worker that was reported as unresponsive before it got
+  //the job expires straight away, as the monitor won't report it again
+  remus::server::detail::SocketMonitor monitor = make_Monitor( );
+  remus::server::detail::ActiveJobs jobs;
+
+  const zmq::SocketIdentity reported = make_socketId();
+  const zmq::SocketIdentity late = make_socketId();
+  monitor.refresh(reported);
+  remus::common::SleepForMillisec(100);
+  const remus::server::detail::SocketStateChanges changes =
+                                                  monitor.checkHeartbeats();
+  REMUS_ASSERT( (changes.Unresponsive.size() == 1) );
+  jobs.markExpiredJobs(changes);
+
+  //a worker whose deadline has passed since the last check can still
+  //heartbeat before the next one, so its job is left to that check
+  monitor.refresh(late);
+  remus::common::SleepForMillisec(100);
+
+  const boost::uuids::uuid reportedJob = remus::testing::UUIDGenerator();
+  const boost::uuids::uuid lateJob = remus::testing::UUIDGenerator();
+  REMUS_ASSERT( (jobs.add(reported, reportedJob, 0, monitor)) );
+  REMUS_ASSERT( (jobs.add(late, lateJob, 0, monitor)) );
+  REMUS_ASSERT( (jobs.status(reportedJob).status() == remus::EXPIRED) );
+  REMUS_ASSERT( (jobs.status(lateJob).status() == remus::QUEUED) );
+
+  //once a worker is heard from again its jobs are kept
+  monitor.refresh(reported);
+  const boost::uuids::uuid revivedJob = remus::testing::UUIDGenerator();
+  REMUS_ASSERT( (jobs.add(reported, revivedJob, 0, monitor)) );
+  REMUS_ASSERT( (jobs.status(revivedJob).status() == remus::QUEUED) );
+}
+
 void verify_taking_works()
 {
   remus::server::detail::WorkerPool pool;
@@ -178,12 +265,16 @@ void verify_taking_works()
   REMUS_ASSERT( !(bad_id == worker1_id) );
 
   //verify that we can take workers for a given job type
+  REMUS_ASSERT( (pool.numWorkers() == 1) );
+  REMUS_ASSERT( (pool.numWaitingWorkers() == 0) );
   pool.readyForWork(worker1_id, worker_type2D);
+  REMUS_ASSERT( (pool.numWaitingWorkers() == 1) );
   zmq::SocketIdentity good_id = pool.takeWorker(worker_type2D);
   REMUS_ASSERT( !(good_id == zmq::SocketIdentity()) );
   REMUS_ASSERT( (good_id == worker1_id) );
   REMUS_ASSERT( (pool.allWorkersWantingWork().size() == 0) );
   REMUS_ASSERT( (pool.allWorkers().size() == 1) );
+  REMUS_ASSERT( (pool.numWaitingWorkers() == 0) );
 
   //verify that we can take a worker that is registered for two different
   //types for one of those types and it will still be there for the other
@@ -195,6 +286,8 @@ void verify_taking_works()
   pool.readyForWork(worker1_id, worker_type3D);
 
   REMUS_ASSERT( (pool.allWorkers().size() == 1) );
+  REMUS_ASSERT( (pool.numWorkers() == 1) );
+  REMUS_ASSERT( (pool.numWaitingWorkers() == 2) );
 
   zmq::SocketIdentity good_2d_id = pool.takeWorker(worker_type2D);
   REMUS_ASSERT( !(good_2d_id == zmq::SocketIdentity()) );
@@ -241,6 +334,76 @@ void verify_taking_works()
   }
 }
 
+void verify_changed_requirements()
+{
+  remus::server::detail::WorkerPool pool;
+  REMUS_ASSERT( (pool.changedRequirements().size() == 0) );
+
+  zmq::SocketIdentity worker1_id = make_socketId();
+  zmq::SocketIdentity worker2_id = make_socketId();
+  pool.addWorker(worker1_id, worker_type2D);
+  pool.addWorker(worker2_id, worker_type3D);
+
+  //registering a worker doesn't make it ready for a job
+  REMUS_ASSERT( (pool.changedRequirements().size() == 0) );
+
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker1_id, worker_type2D);
+  REMUS_ASSERT( (pool.changedRequirements().size() == 1) );
+  REMUS_ASSERT( (pool.changedRequirements().count(worker_type2D) == 1) );
+
+  pool.clearChangedRequirements();
+  REMUS_ASSERT( (pool.changedRequirements().size() == 0) );
+
+  //taking a worker doesn't mark the requirements as changed, and the
+  //worker still wants a second job
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker1_id) );
+  REMUS_ASSERT( (pool.changedRequirements().size() == 0) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == true) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker1_id) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) );
+
+  pool.readyForWork(worker2_id, worker_type3D);
+  REMUS_ASSERT( (pool.changedRequirements().count(worker_type2D) == 0) );
+  REMUS_ASSERT( (pool.changedRequirements().count(worker_type3D) == 1) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type3D) == true) );
+}
+
+void verify_taking_order()
+{
+  remus::server::detail::WorkerPool pool;
+
+  zmq::SocketIdentity worker1_id = make_socketId();
+  zmq::SocketIdentity worker2_id = make_socketId();
+  zmq::SocketIdentity worker3_id = make_socketId();
+  pool.addWorker(worker1_id, worker_type2D);
+  pool.addWorker(worker2_id, worker_type2D);
+  pool.addWorker(worker3_id, worker_type2D);
+
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker1_id, worker_type2D);
+  pool.readyForWork(worker2_id, worker_type2D);
+  pool.readyForWork(worker2_id, worker_type2D);
+  pool.readyForWork(worker3_id, worker_type2D);
+
+  //the worker that took a job goes to the back of the line, so workers
+  //that want multiple jobs don't starve the other workers
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker1_id) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker2_id) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker3_id) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker1_id) );
+
+  //worker3 becomes ready again and is after worker2 which is still waiting
+  pool.readyForWork(worker3_id, worker_type2D);
+  REMUS_ASSERT( (pool.allWorkersWantingWork().size() == 2) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker2_id) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == worker3_id) );
+
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) );
+  REMUS_ASSERT( (pool.allWorkersWantingWork().size() == 0) );
+  REMUS_ASSERT( (pool.allWorkers().size() == 3) );
+}
+
 } //namespace
 
 int UnitTestWorkerPool(int, char *[])
@@ -251,7 +414,15 @@ int UnitTestWorkerPool(int, char *[])
 
   verify_purge_workers();
 
+  verify_shared_monitor(true);
+  verify_shared_monitor(false);
+  verify_assign_to_unresponsive();
+
   verify_taking_works();
 
+  verify_changed_requirements();
+
+  verify_taking_order();
+
   return 0;
 }
@@ -90,6 +90,45 @@ void test_server_poll_rates()
   REMUS_ASSERT( (server.pollingRates().maxRate() == original_rates.maxRate()) );
 }
 
+void test_server_message_batch_size()
+{
+  //verify that we can get and set the message batch size for a server
+  //verify that a batch size of zero becomes one
+  remus::server::Server server;
+
+  remus::server::MessageBatchSize original_size = server.messageBatchSize();
+  REMUS_ASSERT( (original_size.maxMessages() > 0) );
+
+  server.messageBatchSize(remus::server::MessageBatchSize(5));
+  REMUS_ASSERT( (server.messageBatchSize().maxMessages() == 5) );
+
+  server.messageBatchSize(remus::server::MessageBatchSize(0));
+  REMUS_ASSERT( (server.messageBatchSize().maxMessages() == 1) );
+
+  server.messageBatchSize(original_size);
+  REMUS_ASSERT( (server.messageBatchSize().maxMessages() ==
+                 original_size.maxMessages()) );
+}
+
+void test_server_heartbeat_check_interval()
+{
+  //verify that we can get and set how often the server checks heartbeats
+  //verify that we can't set non positive intervals
+  remus::server::Server server;
+
+  const boost::int64_t original_interval = server.heartbeatCheckInterval();
+  REMUS_ASSERT( (original_interval > 0) );
+
+  server.heartbeatCheckInterval(50);
+  REMUS_ASSERT( (server.heartbeatCheckInterval() == 50) );
+
+  server.heartbeatCheckInterval(-50);
+  REMUS_ASSERT( (server.heartbeatCheckInterval() == 1) );
+
+  server.heartbeatCheckInterval(original_interval);
+  REMUS_ASSERT( (server.heartbeatCheckInterval() == original_interval) );
+}
+
 void test_server_sig_catching()
 {
   void (*prev_sig_func)(int);
@@ -330,6 +369,12 @@ int UnitTestServer(int, char *[])
   //Test server rate changes
   test_server_poll_rates();
 
+  //Test server message batch size changes
+  test_server_message_batch_size();
+
+  //Test server heartbeat check interval changes
+  test_server_heartbeat_check_interval();
+
   //Test server signal catching
   test_server_sig_catching();
 
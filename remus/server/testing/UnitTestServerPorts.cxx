@@ -141,6 +141,9 @@ int UnitTestServerPorts(int, char *[])
   zmq::socketInfo<zmq::proto::inproc> wi("worker_channel");
   REMUS_ASSERT( verify_bindings(remus::server::ServerPorts(ci,wi)) );
 
+  //every way of making ports gives them a context for the server to use
+  REMUS_ASSERT( (remus::server::ServerPorts(ci,wi).context()) );
+
   //now mix ipc and tcp-ip
   zmq::socketInfo<zmq::proto::tcp> default_ctcp("127.0.0.1",
                                                remus::SERVER_CLIENT_PORT);
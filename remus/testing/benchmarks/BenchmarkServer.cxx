@@ -0,0 +1,520 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+//Reports the throughput and latency of a server over the inproc, ipc and
+//tcp transports. Clients submit jobs, wait for them to finish and retrieve
+//their results, while workers that never sleep echo the submitted data back
+//as the result. For each transport and payload size we report the jobs a
+//second, the 50th and 99th percentile of the time from submitting a job to
+//having its result, and the fraction of a cpu used by the brokering thread.
+//
+//Usage: BenchmarkServer [options]
+//  --transports t1,t2     any of inproc, ipc and tcp, defaults to all three
+//  --clients n            clients submitting at once, defaults to 4
+//  --workers n            workers connected to the server, defaults to 4
+//  --jobs n               jobs each client submits, defaults to 250
+//  --sizes s1,s2          payload sizes in bytes, defaults to 16 bytes
+//                         through 256 megabytes
+//  --repeat n             run each transport and size n times and report
+//                         the fastest, defaults to 1
+//  --quick                a short sweep of small payloads, used for testing
+//  --baseline file        fail when throughput falls too far below the
+//                         throughput stored in the file
+//  --write-baseline file  store the throughput of this run in the file
+//
+//Large payloads are run with fewer jobs, so that no more than a gigabyte
+//is submitted per transport and size.
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/proto/LatencyHistogram.h>
+#include <remus/proto/ServerStats.h>
+
+//required to use custom contexts
+#include <remus/proto/zmq.hpp>
+#include <remus/proto/zmqSocketInfo.h>
+
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include <boost/thread.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef boost::posix_time::ptime Time;
+
+Time now() { return boost::posix_time::microsec_clock::local_time(); }
+
+//the payloads submitted per transport and size are capped at this many bytes
+const boost::uint64_t MaxBytesPerRun = boost::uint64_t(1) << 30;
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirements make_requirements()
+{
+  using namespace remus::meshtypes;
+  return remus::proto::make_JobRequirements(
+        remus::common::make_MeshIOType(Mesh2D(),Mesh3D()), "BenchmarkWorker", "");
+}
+
+//------------------------------------------------------------------------------
+remus::server::ServerPorts make_ports(const std::string& transport,
+                                      const boost::filesystem::path& dir,
+                                      std::size_t run)
+{
+  //every run gets its own endpoints, so a run never sees the messages
+  //of the one before it
+  const std::string suffix = boost::lexical_cast<std::string>(run);
+  if(transport == "inproc")
+    {
+    return remus::server::ServerPorts(
+          zmq::socketInfo<zmq::proto::inproc>("bench_client_" + suffix),
+          zmq::socketInfo<zmq::proto::inproc>("bench_worker_" + suffix));
+    }
+  else if(transport == "ipc")
+    {
+    return remus::server::ServerPorts(
+          zmq::socketInfo<zmq::proto::ipc>(
+                            (dir / ("client_" + suffix)).string()),
+          zmq::socketInfo<zmq::proto::ipc>(
+                            (dir / ("worker_" + suffix)).string()));
+    }
+  //the default ports are loopback tcp
+  return remus::server::ServerPorts();
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client(
+                                    const remus::server::ServerPorts& ports)
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.context(ports.context());
+  boost::shared_ptr<remus::Client> client =
+                              boost::make_shared<remus::Client>(conn);
+  client->wireFormat(remus::proto::WireFormat::Binary);
+  return client;
+}
+
+//a worker that echoes the data of every job back as its result, until
+//the server tells it to stop
+struct EchoWorker
+{
+  EchoWorker(const remus::server::ServerPorts& ports):
+    Ports(ports)
+    {}
+
+  void operator()() const
+    {
+    remus::worker::ServerConnection conn =
+          remus::worker::make_ServerConnection(Ports.worker().endpoint());
+    conn.context(Ports.context());
+    remus::Worker worker(make_requirements(), conn);
+    worker.wireFormat(remus::proto::WireFormat::Binary);
+
+    while(true)
+      {
+      const remus::worker::Job job = worker.getJob();
+      if(!job.valid())
+        {
+        return;
+        }
+
+      const remus::proto::JobSubmission& sub = job.submission();
+      remus::proto::JobSubmission::const_iterator data = sub.find("data");
+      std::string result;
+      if(data != sub.end())
+        {
+        result.assign(data->second.data(), data->second.dataSize());
+        }
+      worker.returnMeshResults(remus::proto::make_JobResult(job.id(),result));
+      }
+    }
+
+  const remus::server::ServerPorts& Ports;
+};
+
+//a client that submits jobs one after another, waiting for each to finish
+//and retrieving its result before submitting the next
+struct SubmitJobs
+{
+  SubmitJobs(const remus::server::ServerPorts& ports,
+             const remus::proto::JobSubmission& sub,
+             std::size_t jobs,
+             remus::proto::LatencyHistogram& latencies):
+    Ports(ports),
+    Submission(sub),
+    Jobs(jobs),
+    Latencies(latencies)
+    {}
+
+  void operator()() const
+    {
+    boost::shared_ptr<remus::Client> client = make_Client(Ports);
+    for(std::size_t i=0; i < Jobs; ++i)
+      {
+      const Time start = now();
+      const remus::proto::Job job = client->submitJob(Submission);
+
+      remus::proto::JobStatus status = client->jobStatus(job);
+      while(status.good())
+        {
+        boost::this_thread::sleep(boost::posix_time::microseconds(50));
+        status = client->jobStatus(job);
+        }
+      client->retrieveResults(job);
+
+      Latencies.record(
+            static_cast<boost::uint64_t>((now() - start).total_microseconds()));
+      }
+    }
+
+  const remus::server::ServerPorts& Ports;
+  const remus::proto::JobSubmission& Submission;
+  std::size_t Jobs;
+  remus::proto::LatencyHistogram& Latencies;
+};
+
+struct Options
+{
+  Options():
+    Transports(),
+    Clients(4),
+    Workers(4),
+    Jobs(250),
+    Repeat(1),
+    Sizes(),
+    Baseline(),
+    WriteBaseline()
+    {
+    Transports.push_back("inproc");
+    Transports.push_back("ipc");
+    Transports.push_back("tcp");
+
+    const std::size_t sizes[] = { 16, 4096, 65536, 1 << 20, 16 << 20,
+                                  256 << 20 };
+    Sizes.assign(sizes, sizes + sizeof(sizes) / sizeof(std::size_t));
+    }
+
+  std::vector<std::string> Transports;
+  std::size_t Clients;
+  std::size_t Workers;
+  std::size_t Jobs;
+  std::size_t Repeat;
+  std::vector<std::size_t> Sizes;
+  std::string Baseline;
+  std::string WriteBaseline;
+};
+
+struct Measurement
+{
+  Measurement():
+    Jobs(0),
+    JobsPerSecond(0),
+    Latencies(),
+    ServerCpu(0)
+    {}
+
+  std::size_t Jobs;
+  double JobsPerSecond;
+  remus::proto::LatencyHistogram Latencies;
+  double ServerCpu;
+};
+
+//------------------------------------------------------------------------------
+Measurement run(const remus::server::ServerPorts& requestedPorts,
+                const Options& options, std::size_t payload)
+{
+  boost::shared_ptr<remus::server::WorkerFactory> factory =
+                        boost::make_shared<remus::server::WorkerFactory>();
+  factory->setMaxWorkerCount(0);
+  remus::Server server(requestedPorts, factory);
+  server.startBrokering(remus::Server::NONE);
+  server.waitForBrokeringToStart();
+  const remus::server::ServerPorts& ports = server.serverPortInfo();
+
+  boost::thread_group workers;
+  for(std::size_t i=0; i < options.Workers; ++i)
+    {
+    workers.create_thread(EchoWorker(ports));
+    }
+
+  remus::proto::JobSubmission sub(make_requirements());
+  sub["data"] = remus::proto::make_JobContent(std::string(payload, 'r'));
+
+  //large payloads are run with fewer jobs, but always at least one a client
+  const std::size_t perClient = std::max<std::size_t>(1,
+      std::min<std::size_t>(options.Jobs, static_cast<std::size_t>(
+        MaxBytesPerRun / (std::max<std::size_t>(payload,1) * options.Clients))));
+
+  boost::shared_ptr<remus::Client> statsClient = make_Client(ports);
+  const remus::proto::ServerStats before = statsClient->serverStats();
+
+  std::vector<remus::proto::LatencyHistogram> latencies(options.Clients);
+  const Time start = now();
+  boost::thread_group clients;
+  for(std::size_t i=0; i < options.Clients; ++i)
+    {
+    clients.create_thread(SubmitJobs(ports, sub, perClient, latencies[i]));
+    }
+  clients.join_all();
+  const double elapsed =
+        static_cast<double>((now() - start).total_microseconds()) / 1.0e6;
+
+  const remus::proto::ServerStats after = statsClient->serverStats();
+
+  Measurement m;
+  m.Jobs = perClient * options.Clients;
+  m.JobsPerSecond = static_cast<double>(m.Jobs) / elapsed;
+  for(std::size_t i=0; i < latencies.size(); ++i)
+    {
+    m.Latencies.merge(latencies[i]);
+    }
+  m.ServerCpu = static_cast<double>(after.BrokerCpuTime -
+                                    before.BrokerCpuTime) / (elapsed * 1.0e6);
+
+  //stopping the server tells the workers to stop
+  server.stopBrokering();
+  workers.join_all();
+  return m;
+}
+
+//------------------------------------------------------------------------------
+std::vector<std::string> split(const std::string& list)
+{
+  std::vector<std::string> items;
+  std::istringstream buffer(list);
+  std::string item;
+  while(std::getline(buffer, item, ','))
+    {
+    if(!item.empty())
+      {
+      items.push_back(item);
+      }
+    }
+  return items;
+}
+
+//------------------------------------------------------------------------------
+bool parse(int argc, char* argv[], Options& options)
+{
+  for(int i=1; i < argc; ++i)
+    {
+    const std::string arg(argv[i]);
+    const bool haveValue = (i + 1) < argc;
+    if(arg == "--quick")
+      {
+      options.Clients = 2;
+      options.Workers = 2;
+      options.Jobs = 100;
+      options.Repeat = 3;
+      options.Sizes.clear();
+      options.Sizes.push_back(16);
+      options.Sizes.push_back(65536);
+      options.Sizes.push_back(1 << 20);
+      }
+    else if(arg == "--transports" && haveValue)
+      { options.Transports = split(argv[++i]); }
+    else if(arg == "--clients" && haveValue)
+      { options.Clients = boost::lexical_cast<std::size_t>(argv[++i]); }
+    else if(arg == "--workers" && haveValue)
+      { options.Workers = boost::lexical_cast<std::size_t>(argv[++i]); }
+    else if(arg == "--jobs" && haveValue)
+      { options.Jobs = boost::lexical_cast<std::size_t>(argv[++i]); }
+    else if(arg == "--repeat" && haveValue)
+      { options.Repeat = boost::lexical_cast<std::size_t>(argv[++i]); }
+    else if(arg == "--sizes" && haveValue)
+      {
+      const std::vector<std::string> sizes = split(argv[++i]);
+      options.Sizes.clear();
+      for(std::size_t j=0; j < sizes.size(); ++j)
+        {
+        options.Sizes.push_back(boost::lexical_cast<std::size_t>(sizes[j]));
+        }
+      }
+    else if(arg == "--baseline" && haveValue)
+      { options.Baseline = argv[++i]; }
+    else if(arg == "--write-baseline" && haveValue)
+      { options.WriteBaseline = argv[++i]; }
+    else
+      {
+      std::fprintf(stderr, "unknown option %s\n", arg.c_str());
+      return false;
+      }
+    }
+  return options.Clients > 0 && options.Workers > 0 && options.Jobs > 0 &&
+         options.Repeat > 0;
+}
+
+//the throughput of each transport and payload size
+typedef std::map< std::pair<std::string, std::size_t>, double > Throughputs;
+
+//------------------------------------------------------------------------------
+//Baseline files hold a line of "<transport> <payload> <jobs/s>" for each run,
+//and a "tolerance <fraction>" line giving how much of the baseline throughput
+//a run may lose before it is a regression. Lines starting with # are ignored
+bool read_baseline(const std::string& path, Throughputs& baseline,
+                   double& tolerance)
+{
+  std::ifstream file(path.c_str());
+  if(!file)
+    {
+    return false;
+    }
+
+  std::string line;
+  while(std::getline(file, line))
+    {
+    if(line.empty() || line[0] == '#')
+      {
+      continue;
+      }
+    std::istringstream buffer(line);
+    std::string transport;
+    buffer >> transport;
+    if(transport == "tolerance")
+      {
+      buffer >> tolerance;
+      continue;
+      }
+    std::size_t payload = 0;
+    double rate = 0;
+    buffer >> payload >> rate;
+    if(buffer)
+      {
+      baseline[std::make_pair(transport, payload)] = rate;
+      }
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void write_baseline(const std::string& path, const Throughputs& rates)
+{
+  std::ofstream file(path.c_str());
+  file << "# <transport> <payload bytes> <jobs/s>, written by BenchmarkServer\n";
+  file << "tolerance 0.5\n";
+  for(Throughputs::const_iterator i=rates.begin(); i != rates.end(); ++i)
+    {
+    file << i->first.first << " " << i->first.second << " "
+         << i->second << "\n";
+    }
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+  Options options;
+  if(!parse(argc, argv, options))
+    {
+    return 1;
+    }
+
+  const boost::filesystem::path dir =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("remus_bench_%%%%-%%%%-%%%%");
+  boost::filesystem::create_directories(dir);
+
+  std::printf("%lu clients, %lu workers, up to %lu jobs a client\n",
+              static_cast<unsigned long>(options.Clients),
+              static_cast<unsigned long>(options.Workers),
+              static_cast<unsigned long>(options.Jobs));
+  std::printf("%-9s %12s %8s %12s %12s %12s %8s\n", "transport", "payload",
+              "jobs", "jobs/s", "p50 (us)", "p99 (us)", "cpu");
+
+  Throughputs rates;
+  std::size_t runs = 0;
+  for(std::size_t t=0; t < options.Transports.size(); ++t)
+    {
+    const std::string& transport = options.Transports[t];
+    for(std::size_t s=0; s < options.Sizes.size(); ++s)
+      {
+      const std::size_t payload = options.Sizes[s];
+      //the fastest run is the one least disturbed by the rest of the machine
+      Measurement m;
+      for(std::size_t r=0; r < options.Repeat; ++r)
+        {
+        const Measurement current = run(make_ports(transport, dir, runs++),
+                                        options, payload);
+        if(current.JobsPerSecond > m.JobsPerSecond)
+          {
+          m = current;
+          }
+        }
+      rates[std::make_pair(transport, payload)] = m.JobsPerSecond;
+
+      std::printf("%-9s %12lu %8lu %12.1f %12lu %12lu %7.1f%%\n",
+                  transport.c_str(),
+                  static_cast<unsigned long>(payload),
+                  static_cast<unsigned long>(m.Jobs),
+                  m.JobsPerSecond,
+                  static_cast<unsigned long>(m.Latencies.percentile(50)),
+                  static_cast<unsigned long>(m.Latencies.percentile(99)),
+                  m.ServerCpu * 100.0);
+      std::fflush(stdout);
+      }
+    }
+  boost::filesystem::remove_all(dir);
+
+  if(!options.WriteBaseline.empty())
+    {
+    write_baseline(options.WriteBaseline, rates);
+    }
+
+  int result = 0;
+  if(!options.Baseline.empty())
+    {
+    Throughputs baseline;
+    double tolerance = 0.5;
+    if(!read_baseline(options.Baseline, baseline, tolerance))
+      {
+      std::fprintf(stderr, "unable to read baseline %s\n",
+                   options.Baseline.c_str());
+      return 1;
+      }
+
+    //only the runs that are in both the baseline and this run are compared
+    for(Throughputs::const_iterator i=rates.begin(); i != rates.end(); ++i)
+      {
+      Throughputs::const_iterator b = baseline.find(i->first);
+      if(b != baseline.end() && i->second < b->second * (1.0 - tolerance))
+        {
+        std::printf("regression: %s %lu bytes ran %.1f jobs/s, "
+                    "the baseline is %.1f jobs/s\n",
+                    i->first.first.c_str(),
+                    static_cast<unsigned long>(i->first.second),
+                    i->second, b->second);
+        result = 1;
+        }
+      }
+    }
+  return result;
+}
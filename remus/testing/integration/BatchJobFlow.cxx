@@ -0,0 +1,193 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+
+#include <remus/proto/ServerStats.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/uuid/nil_generator.hpp>
+
+namespace factory
+{
+//a factory that supports every mesh type but never creates a worker,
+//so that every job we submit stays queued
+class NeverCreateFactory: public remus::server::WorkerFactory
+{
+public:
+  remus::proto::JobRequirementsSet workerRequirements(
+                                          remus::common::MeshIOType type) const
+  {
+    remus::proto::JobRequirementsSet reqSet;
+    reqSet.insert(remus::proto::make_JobRequirements(type,"BatchWorker",""));
+    return reqSet;
+  }
+
+  bool haveSupport(const remus::proto::JobRequirements&) const
+    { return true; }
+
+  bool createWorker(const remus::proto::JobRequirements&,
+                    WorkerFactory::FactoryDeletionBehavior)
+    { return false; }
+};
+}
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  boost::shared_ptr<factory::NeverCreateFactory> factory(
+                                            new factory::NeverCreateFactory());
+  factory->setMaxWorkerCount(1);
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.context(ports.context());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobSubmission> make_submissions(std::size_t count)
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  const remus::common::MeshIOType io_type =
+                            remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  std::vector<JobSubmission> submissions;
+  for(std::size_t i=0; i < count; ++i)
+    {
+    JobSubmission sub(make_JobRequirements(io_type, "BatchWorker", ""));
+    sub["data"] = make_JobContent(
+                        remus::testing::AsciiStringGenerator(1024 + i) );
+    submissions.push_back(sub);
+    }
+  return submissions;
+}
+
+//------------------------------------------------------------------------------
+void verify_batch_flow(boost::shared_ptr<remus::Client> client,
+                       std::size_t count)
+{
+  using namespace remus::proto;
+
+  const std::vector<JobSubmission> submissions = make_submissions(count);
+  const std::vector<Job> jobs = client->submitJobs(submissions);
+  REMUS_ASSERT( (jobs.size() == count) );
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    REMUS_ASSERT( (jobs[i].valid()) );
+    REMUS_ASSERT( (jobs[i].type() == submissions[i].type()) );
+    }
+
+  //ask for the submitted jobs and one the server doesn't know about,
+  //the statuses come back in the order we asked
+  std::vector<Job> query = jobs;
+  query.push_back( Job(boost::uuids::nil_uuid(), jobs.front().type()) );
+  const std::vector<JobStatus> statuses = client->jobStatus(query);
+  REMUS_ASSERT( (statuses.size() == query.size()) );
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    REMUS_ASSERT( (statuses[i].id() == jobs[i].id()) );
+    REMUS_ASSERT( (statuses[i].status() == remus::QUEUED) );
+    REMUS_ASSERT( (statuses[i].timestamps().Queued > 0) );
+    }
+  REMUS_ASSERT( (statuses.back().status() == remus::INVALID_STATUS) );
+
+  //the batch agrees with asking about each job on its own
+  REMUS_ASSERT( (client->jobStatus(jobs.front()) == statuses.front()) );
+
+  //remove the jobs so the next batch starts from an empty queue
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    REMUS_ASSERT( (client->terminate(jobs[i]).failed()) );
+    }
+  const std::vector<JobStatus> terminated = client->jobStatus(jobs);
+  for(std::size_t i=0; i < terminated.size(); ++i)
+    {
+    REMUS_ASSERT( (terminated[i].status() == remus::INVALID_STATUS) );
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_pipelined_batches(boost::shared_ptr<remus::Client> client)
+{
+  using namespace remus::proto;
+
+  //keep many batches and single requests in flight at once
+  const std::size_t numBatches = 8;
+  std::vector< remus::client::Future< std::vector<Job> > > batches;
+  for(std::size_t i=0; i < numBatches; ++i)
+    {
+    batches.push_back( client->submitJobsAsync(make_submissions(i+1)) );
+    }
+  for(std::size_t i=0; i < numBatches; ++i)
+    {
+    const std::vector<Job>& jobs = batches[i].get();
+    REMUS_ASSERT( (jobs.size() == i+1) );
+
+    std::vector< remus::client::Future<JobStatus> > statuses;
+    for(std::size_t j=0; j < jobs.size(); ++j)
+      {
+      statuses.push_back( client->jobStatusAsync(jobs[j]) );
+      }
+    for(std::size_t j=0; j < jobs.size(); ++j)
+      {
+      REMUS_ASSERT( (statuses[j].get().id() == jobs[j].id()) );
+      REMUS_ASSERT( (statuses[j].get().status() == remus::QUEUED) );
+      }
+    }
+  REMUS_ASSERT( (client->pendingRequests() == 0) );
+
+  //each batch is one request to the server
+  const ServerStats stats = client->serverStats();
+  REMUS_ASSERT( (stats.ClientLatencies.find(remus::MAKE_MESH_BATCH) !=
+                 stats.ClientLatencies.end()) );
+}
+
+}
+
+//Submits and queries jobs in batches, in both wire formats
+int BatchJobFlow(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server =
+                            make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  verify_batch_flow(client, 1);
+  verify_batch_flow(client, 100);
+
+  boost::shared_ptr<remus::Client> binaryClient = make_Client( ports );
+  binaryClient->wireFormat(remus::proto::WireFormat::Binary);
+  verify_batch_flow(binaryClient, 1);
+  verify_batch_flow(binaryClient, 100);
+
+  verify_pipelined_batches(client);
+  verify_pipelined_batches(binaryClient);
+  return 0;
+}
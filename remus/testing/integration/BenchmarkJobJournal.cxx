@@ -0,0 +1,167 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+//Reports how many jobs a second a server queues with no journal, with a
+//journal that is only flushed to the operating system, and with a journal
+//that is synced to disk on every commit. Several clients submit at once so
+//the journal can commit the jobs of a batch together.
+//
+//Usage: BenchmarkJobJournal [clients] [jobs per client] [payload size in bytes]
+
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+
+//required to use custom contexts
+#include <remus/proto/zmq.hpp>
+
+#include <remus/testing/Testing.h>
+
+#ifndef _MSC_VER
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include <boost/thread.hpp>
+#ifndef _MSC_VER
+  #pragma GCC diagnostic pop
+#endif
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+#include <cstdio>
+
+namespace {
+
+typedef boost::posix_time::ptime Time;
+
+Time now() { return boost::posix_time::microsec_clock::local_time(); }
+
+//a factory that never creates workers, so every job stays queued
+class NeverCreateFactory: public remus::server::WorkerFactory
+{
+public:
+  bool haveSupport(const remus::proto::JobRequirements&) const
+    { return true; }
+
+  bool createWorker(const remus::proto::JobRequirements&,
+                    WorkerFactory::FactoryDeletionBehavior)
+    { return false; }
+};
+
+struct SubmitJobs
+{
+  SubmitJobs(const remus::server::ServerPorts& ports,
+             const remus::proto::JobSubmission& sub,
+             std::size_t jobs):
+    Ports(ports),
+    Submission(sub),
+    Jobs(jobs)
+    {}
+
+  void operator()() const
+    {
+    remus::client::ServerConnection conn =
+          remus::client::make_ServerConnection(Ports.client().endpoint());
+    conn.context(Ports.context());
+    remus::client::Client client(conn);
+    client.wireFormat(remus::proto::WireFormat::Binary);
+    for(std::size_t i=0; i < Jobs; ++i)
+      {
+      client.submitJob(Submission);
+      }
+    }
+
+  const remus::server::ServerPorts& Ports;
+  const remus::proto::JobSubmission& Submission;
+  std::size_t Jobs;
+};
+
+double jobs_per_second(remus::Server& server,
+                       const remus::proto::JobSubmission& sub,
+                       std::size_t clients, std::size_t jobs)
+{
+  server.startBrokering(remus::Server::NONE);
+  server.waitForBrokeringToStart();
+
+  const Time start = now();
+  boost::thread_group threads;
+  for(std::size_t i=0; i < clients; ++i)
+    {
+    threads.create_thread(SubmitJobs(server.serverPortInfo(), sub, jobs));
+    }
+  threads.join_all();
+  const double elapsed =
+        static_cast<double>((now() - start).total_microseconds()) / 1.0e6;
+
+  server.stopBrokering();
+  return static_cast<double>(clients * jobs) / elapsed;
+}
+
+void report(const char* name, double rate, double baseline)
+{
+  std::printf("%-16s %12.1f %12.2f\n", name, rate, rate / baseline);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+  std::size_t clients = 4;
+  std::size_t jobs = 500;
+  std::size_t payload = 4096;
+  if(argc > 1) { clients = boost::lexical_cast<std::size_t>(argv[1]); }
+  if(argc > 2) { jobs = boost::lexical_cast<std::size_t>(argv[2]); }
+  if(argc > 3) { payload = boost::lexical_cast<std::size_t>(argv[3]); }
+
+  using namespace remus::meshtypes;
+  remus::proto::JobSubmission sub(remus::proto::make_JobRequirements(
+        remus::common::make_MeshIOType(Mesh2D(),Mesh3D()), "NoWorker", ""));
+  sub["data"] = remus::proto::make_JobContent(
+                      remus::testing::BinaryDataGenerator(payload));
+
+  const boost::filesystem::path dir =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("remus_journal_%%%%-%%%%-%%%%");
+  boost::shared_ptr<NeverCreateFactory> factory =
+                                    boost::make_shared<NeverCreateFactory>();
+
+  std::printf("%lu clients submitting %lu jobs of %lu bytes\n",
+              static_cast<unsigned long>(clients),
+              static_cast<unsigned long>(jobs),
+              static_cast<unsigned long>(payload));
+  std::printf("%-16s %12s %12s\n", "journal", "jobs/s", "vs none");
+
+  double baseline = 0;
+  {
+  remus::Server server(remus::server::ServerPorts(), factory);
+  baseline = jobs_per_second(server, sub, clients, jobs);
+  report("none", baseline, baseline);
+  }
+
+  {
+  remus::Server server(remus::server::ServerPorts(), factory,
+        remus::server::JobJournaling((dir / "flushed").string(), false));
+  report("flushed", jobs_per_second(server, sub, clients, jobs), baseline);
+  }
+
+  {
+  remus::Server server(remus::server::ServerPorts(), factory,
+        remus::server::JobJournaling((dir / "synced").string(), true));
+  report("synced", jobs_per_second(server, sub, clients, jobs), baseline);
+  }
+
+  boost::filesystem::remove_all(dir);
+  return 0;
+}
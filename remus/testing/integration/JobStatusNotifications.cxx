@@ -0,0 +1,188 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/make_shared.hpp>
+
+namespace
+{
+
+//records every status pushed to the client
+struct StatusRecorder
+{
+  StatusRecorder():
+    Statuses( boost::make_shared< std::vector<remus::proto::JobStatus> >() )
+    {}
+
+  void operator()(const remus::proto::JobStatus& status)
+    { this->Statuses->push_back(status); }
+
+  boost::shared_ptr< std::vector<remus::proto::JobStatus> > Statuses;
+};
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //a factory that can launch no workers, so we have to use workers that
+  //connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.context(ports.context());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+  conn.context(ports.context());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  JobRequirements requirements = make_JobRequirements(io_type, "PushWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission make_Submission()
+{
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobSubmission sub(
+              remus::proto::make_JobRequirements(io_type, "PushWorker", ""));
+  sub["data"] = remus::proto::make_JobContent("random data");
+  return sub;
+}
+
+//------------------------------------------------------------------------------
+//read pushed statuses until we have count of them, or we give up
+void wait_for_statuses(boost::shared_ptr<remus::Client> client,
+                       const StatusRecorder& recorder,
+                       std::size_t count)
+{
+  for(int i=0; i < 100 && recorder.Statuses->size() < count; ++i)
+    {
+    client->processReplies(50);
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_pushed_progress(boost::shared_ptr<remus::Client> client,
+                            boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  worker->askForJobs(1);
+  const Job job = client->submitJob(make_Submission());
+  REMUS_ASSERT( (job.valid()) );
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.valid()) );
+
+  StatusRecorder recorder;
+  std::vector<Job> jobs(1, job);
+  const std::vector<JobStatus> current = client->subscribe(jobs, recorder);
+  REMUS_ASSERT( (current.size() == 1) );
+  REMUS_ASSERT( (current[0].good()) );
+  REMUS_ASSERT( (client->subscribedJobs() == 1) );
+
+  //the progress is pushed to us without asking for it
+  const JobStatus progress(job.id(), JobProgress(50));
+  worker->updateStatus(progress);
+  wait_for_statuses(client, recorder, 1);
+  REMUS_ASSERT( (recorder.Statuses->size() == 1) );
+  REMUS_ASSERT( (recorder.Statuses->at(0) == progress) );
+  REMUS_ASSERT( (client->subscribedJobs() == 1) );
+
+  //once the job finishes we are told, and the subscription ends
+  worker->returnMeshResults( make_JobResult(job.id(), "result") );
+  wait_for_statuses(client, recorder, 2);
+  REMUS_ASSERT( (recorder.Statuses->size() == 2) );
+  REMUS_ASSERT( (recorder.Statuses->at(1).finished()) );
+  REMUS_ASSERT( (recorder.Statuses->at(1).timestamps().Finished > 0) );
+  REMUS_ASSERT( (client->subscribedJobs() == 0) );
+
+  //subscribing to a finished job replies with its status and nothing more
+  const std::vector<JobStatus> finished = client->subscribe(jobs, recorder);
+  REMUS_ASSERT( (finished[0].finished()) );
+  REMUS_ASSERT( (client->subscribedJobs() == 0) );
+
+  REMUS_ASSERT( (client->retrieveResults(job).valid()) );
+}
+
+//------------------------------------------------------------------------------
+void verify_pushed_termination(boost::shared_ptr<remus::Client> client)
+{
+  using namespace remus::proto;
+
+  //no worker asks for this job, so it stays queued until terminated
+  const Job job = client->submitJob(make_Submission());
+  StatusRecorder recorder;
+  std::vector<Job> jobs(1, job);
+  const std::vector<JobStatus> current = client->subscribe(jobs, recorder);
+  REMUS_ASSERT( (current[0].queued()) );
+  REMUS_ASSERT( (client->subscribedJobs() == 1) );
+
+  //terminating from another client still notifies the subscriber
+  remus::client::Client other( client->connection() );
+  REMUS_ASSERT( (other.terminate(job).failed()) );
+  wait_for_statuses(client, recorder, 1);
+  REMUS_ASSERT( (recorder.Statuses->size() == 1) );
+  REMUS_ASSERT( (recorder.Statuses->at(0).failed()) );
+  REMUS_ASSERT( (client->subscribedJobs() == 0) );
+}
+
+}
+
+//Subscribes to jobs and verifies the server pushes their status changes
+//to the client as a worker progresses and finishes them
+int JobStatusNotifications(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server =
+                            make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+  verify_pushed_progress(client, worker);
+  verify_pushed_termination(client);
+
+  boost::shared_ptr<remus::Client> binaryClient = make_Client( ports );
+  binaryClient->wireFormat(remus::proto::WireFormat::Binary);
+  verify_pushed_progress(binaryClient, worker);
+  verify_pushed_termination(binaryClient);
+  return 0;
+}
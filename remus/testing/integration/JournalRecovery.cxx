@@ -0,0 +1,178 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+//required to use custom contexts
+#include <remus/proto/zmq.hpp>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/filesystem.hpp>
+
+namespace factory
+{
+//a factory that never creates workers, so jobs stay queued unless a
+//worker connects to the server on its own
+class NeverCreateFactory: public remus::server::WorkerFactory
+{
+public:
+  bool haveSupport(const remus::proto::JobRequirements&) const
+    { return true; }
+
+  bool createWorker(const remus::proto::JobRequirements&,
+                    WorkerFactory::FactoryDeletionBehavior)
+    { return false; }
+};
+}
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server(const std::string& directory)
+{
+  boost::shared_ptr<factory::NeverCreateFactory> factory(
+                                          new factory::NeverCreateFactory());
+  factory->setMaxWorkerCount(1);
+  boost::shared_ptr<remus::Server> server(
+        new remus::Server(remus::server::ServerPorts(), factory,
+                          remus::server::JobJournaling(directory,false)) );
+  REMUS_ASSERT( server->isJournaling() );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.context(ports.context());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports,
+                                              const remus::proto::JobRequirements& reqs)
+{
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+  conn.context(ports.context());
+
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(reqs,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirements make_Requirements(const std::string& name)
+{
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type =
+                        remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  return remus::proto::make_JobRequirements(io_type, name, "");
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission make_Submission(const std::string& name,
+                                            const std::string& contents)
+{
+  remus::proto::JobSubmission sub(make_Requirements(name));
+  sub["data"] = remus::proto::make_JobContent(contents);
+  return sub;
+}
+
+//------------------------------------------------------------------------------
+void verify_job_status(const remus::proto::Job& job,
+                       boost::shared_ptr<remus::Client> client,
+                       remus::STATUS_TYPE statusType)
+{
+  remus::proto::JobStatus currentStatus = client->jobStatus(job);
+  REMUS_ASSERT( (currentStatus.status() == statusType) );
+}
+
+}
+
+int JournalRecovery(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  const boost::filesystem::path dir =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("remus_journal_%%%%-%%%%-%%%%");
+
+  const std::string contents = remus::testing::AsciiStringGenerator(65536);
+  const remus::proto::Job invalid = remus::proto::Job(boost::uuids::uuid(),
+                                              remus::common::MeshIOType());
+  remus::proto::Job queued(invalid), terminated(invalid), finished(invalid);
+
+  {
+  boost::shared_ptr<remus::Server> server = make_Server(dir.string());
+  boost::shared_ptr<remus::Client> client = make_Client(server->serverPortInfo());
+
+  //a job no worker takes, one that is terminated, and one a worker finishes
+  queued = client->submitJob(make_Submission("NoWorker",contents));
+  terminated = client->submitJob(make_Submission("NoWorker","terminated"));
+  REMUS_ASSERT( (client->terminate(terminated).failed()) );
+
+  boost::shared_ptr<remus::Worker> worker =
+      make_Worker(server->serverPortInfo(), make_Requirements("JournalWorker"));
+  worker->askForJobs(1);
+  remus::common::SleepForMillisec(50);
+
+  finished = client->submitJob(make_Submission("JournalWorker","finish me"));
+  remus::worker::Job job = worker->getJob();
+  REMUS_ASSERT( (job.id() == finished.id()) );
+  worker->returnMeshResults(remus::proto::make_JobResult(job.id(),"result"));
+  remus::common::SleepForMillisec(50);
+  verify_job_status(finished,client,remus::FINISHED);
+  }
+
+  //a new server using the same journal has the same jobs under the same ids
+  {
+  boost::shared_ptr<remus::Server> server = make_Server(dir.string());
+  boost::shared_ptr<remus::Client> client = make_Client(server->serverPortInfo());
+
+  verify_job_status(queued,client,remus::QUEUED);
+  verify_job_status(terminated,client,remus::INVALID_STATUS);
+  verify_job_status(finished,client,remus::FINISHED);
+
+  remus::proto::JobResult result = client->retrieveResults(finished);
+  REMUS_ASSERT( (result.valid()) );
+  REMUS_ASSERT( (result.data() == "result") );
+
+  //the queued job is given to a worker that connects to the new server
+  boost::shared_ptr<remus::Worker> worker =
+      make_Worker(server->serverPortInfo(), make_Requirements("NoWorker"));
+  worker->askForJobs(1);
+  remus::worker::Job job = worker->getJob();
+  REMUS_ASSERT( (job.id() == queued.id()) );
+  REMUS_ASSERT( (job.submission().find("data")->second.dataSize() ==
+                 contents.size()) );
+  }
+
+  //the retrieved result isn't recovered a second time
+  {
+  boost::shared_ptr<remus::Server> server = make_Server(dir.string());
+  boost::shared_ptr<remus::Client> client = make_Client(server->serverPortInfo());
+  verify_job_status(finished,client,remus::INVALID_STATUS);
+  }
+
+  boost::filesystem::remove_all(dir);
+  return 0;
+}
@@ -0,0 +1,210 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/testing/Testing.h>
+
+#include <boost/thread/thread.hpp>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirements make_Requirements(const std::string& name)
+{
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  return remus::proto::make_JobRequirements(io_type, name, "");
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //a factory that can launch no workers, so we have to use workers that
+  //connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+
+  remus::server::ResultMemoization memo(true, 1024*1024);
+  memo.exclude(make_Requirements("RandomWorker"));
+  server->resultMemoization(memo);
+  REMUS_ASSERT( (server->resultMemoization().enabled()) );
+  REMUS_ASSERT( (server->resultMemoization().excluded().size() == 1) );
+
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.context(ports.context());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports,
+                                              const std::string& name )
+{
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+  conn.context(ports.context());
+
+  boost::shared_ptr<remus::Worker> w(
+                      new remus::Worker(make_Requirements(name),conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission make_Submission(const std::string& name,
+                                            const std::string& data)
+{
+  remus::proto::JobSubmission sub(make_Requirements(name));
+  sub["data"] = remus::proto::make_JobContent(data);
+  return sub;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus wait_while(boost::shared_ptr<remus::Client> client,
+                                   const remus::proto::Job& job,
+                                   remus::STATUS_TYPE status)
+{
+  remus::proto::JobStatus current = client->jobStatus(job);
+  for(int i=0; i < 500 && current.status() == status; ++i)
+    {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    current = client->jobStatus(job);
+    }
+  return current;
+}
+
+//------------------------------------------------------------------------------
+void verify_coalesced(boost::shared_ptr<remus::Client> client,
+                      boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  //an identical job submitted while the first is running waits on it
+  const std::string data = remus::testing::AsciiStringGenerator(4096);
+  const Job first = client->submitJob(make_Submission("MemoWorker", data));
+  const Job second = client->submitJob(make_Submission("MemoWorker", data));
+  REMUS_ASSERT( (first.valid() && second.valid()) );
+  REMUS_ASSERT( (client->jobStatus(second).queued()) );
+
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.id() == first.id()) );
+  REMUS_ASSERT( (workerJob.details("data") == data) );
+
+  //and follows its progress
+  worker->updateStatus( make_JobStatus(first.id(), 50) );
+  const JobStatus progress = wait_while(client, second, remus::QUEUED);
+  REMUS_ASSERT( (progress.inProgress()) );
+  REMUS_ASSERT( (progress.progress().value() == 50) );
+
+  //both jobs get the one result, each under its own id
+  worker->returnMeshResults( make_JobResult(first.id(), "meshed") );
+  const JobResult firstResult = client->waitForResult(first, 5000);
+  const JobResult secondResult = client->waitForResult(second, 5000);
+  REMUS_ASSERT( (firstResult.data() == "meshed") );
+  REMUS_ASSERT( (secondResult.data() == "meshed") );
+  REMUS_ASSERT( (secondResult.id() == second.id()) );
+
+  //an identical job submitted later is finished as soon as it is queued
+  const Job third = client->submitJob(make_Submission("MemoWorker", data));
+  REMUS_ASSERT( (client->jobStatus(third).finished()) );
+  const JobResult thirdResult = client->retrieveResults(third);
+  REMUS_ASSERT( (thirdResult.data() == "meshed") );
+  REMUS_ASSERT( (thirdResult.id() == third.id()) );
+  REMUS_ASSERT( (worker->pendingJobCount() == 0) );
+}
+
+//------------------------------------------------------------------------------
+void verify_terminated_leader(boost::shared_ptr<remus::Client> client,
+                              boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  //terminating the job others wait on queues one of them in its place
+  const std::string data = remus::testing::AsciiStringGenerator(1024);
+  const Job first = client->submitJob(make_Submission("MemoWorker", data));
+  const Job second = client->submitJob(make_Submission("MemoWorker", data));
+  const Job third = client->submitJob(make_Submission("MemoWorker", data));
+  REMUS_ASSERT( (client->terminate(first).failed()) );
+  REMUS_ASSERT( (client->jobStatus(second).queued()) );
+
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.id() == second.id()) );
+
+  //a failure is shared the same as a result
+  worker->updateStatus( make_FailedJobStatus(second.id(), "bad mesh") );
+  const JobStatus failed = client->waitForJob(third, 5000);
+  REMUS_ASSERT( (failed.status() == remus::FAILED) );
+  REMUS_ASSERT( (failed.progress().message() == "bad mesh") );
+
+  //and isn't cached, so the job is run again
+  const Job fourth = client->submitJob(make_Submission("MemoWorker", data));
+  workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.id() == fourth.id()) );
+  worker->returnMeshResults( make_JobResult(fourth.id(), "meshed") );
+  REMUS_ASSERT( (client->waitForResult(fourth, 5000).data() == "meshed") );
+}
+
+//------------------------------------------------------------------------------
+void verify_excluded(boost::shared_ptr<remus::Client> client,
+                     boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  //jobs of excluded requirements are always meshed
+  const std::string data = remus::testing::AsciiStringGenerator(1024);
+  for(int i=0; i < 2; ++i)
+    {
+    const Job job = client->submitJob(make_Submission("RandomWorker", data));
+    remus::worker::Job workerJob = worker->getJob();
+    REMUS_ASSERT( (workerJob.id() == job.id()) );
+    worker->returnMeshResults( make_JobResult(job.id(), "random") );
+    REMUS_ASSERT( (client->waitForResult(job, 5000).data() == "random") );
+    }
+}
+
+}
+
+//Memoizes the results of identical jobs, so they are only meshed once
+int MemoizedResults(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server =
+                            make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports, "MemoWorker" );
+  boost::shared_ptr<remus::Worker> random = make_Worker( ports, "RandomWorker" );
+  verify_coalesced(client, worker);
+  verify_terminated_leader(client, worker);
+  verify_excluded(client, random);
+
+  boost::shared_ptr<remus::Client> binaryClient = make_Client( ports );
+  binaryClient->wireFormat(remus::proto::WireFormat::Binary);
+  verify_coalesced(binaryClient, worker);
+  return 0;
+}
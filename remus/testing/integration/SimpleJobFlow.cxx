@@ -24,19 +24,25 @@
 #include <remus/common/SleepFor.h>
 #include <remus/testing/Testing.h>
 
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <iterator>
 #include <utility>
 
 namespace
 {
 
 //------------------------------------------------------------------------------
-boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports,
+                                              const std::string& report )
 {
   //create the server and start brokering, with a factory that can launch
   //no workers, so we have to use workers that connect in only
   boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
   factory->setMaxWorkerCount(0);
   boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->statsReport(report);
   server->startBrokering();
   return server;
 }
@@ -174,6 +180,37 @@ void verify_job_processing(const remus::proto::Job& job,
   JobStatus clientStatus = client->jobStatus(job);
   REMUS_ASSERT( (clientStatus==workerStatus) )
 
+  //the server stamped each stage the job has been through, in order
+  const JobTimestamps& times = clientStatus.timestamps();
+  REMUS_ASSERT( (times.Queued > 0) );
+  REMUS_ASSERT( (times.Dispatched >= times.Queued) );
+  REMUS_ASSERT( (times.FirstProgress >= times.Dispatched) );
+  REMUS_ASSERT( (times.Finished == 0) );
+
+}
+
+//------------------------------------------------------------------------------
+void verify_server_stats(boost::shared_ptr<remus::Client> client,
+                         boost::uint64_t submitted,
+                         boost::uint64_t active)
+{
+  remus::proto::ServerStats stats = client->serverStats();
+  REMUS_ASSERT( (stats.JobsQueued == 0) );
+  REMUS_ASSERT( (stats.JobsActive == active) );
+  REMUS_ASSERT( (stats.JobsSubmittedTotal == submitted) );
+  REMUS_ASSERT( (stats.JobsDispatchedTotal == submitted) );
+  REMUS_ASSERT( (stats.Workers == 1) );
+  REMUS_ASSERT( (stats.Uptime > 0) );
+
+  //every job was submitted by a client and asked for by a worker
+  REMUS_ASSERT( (stats.ClientLatencies[remus::MAKE_MESH].count() == submitted) );
+  REMUS_ASSERT( (stats.WorkerLatencies[remus::MAKE_MESH].count() >= submitted) );
+
+  //every job has been given to a worker, and every job that isn't
+  //active has finished and had its results retrieved
+  REMUS_ASSERT( (stats.JobQueueTimes.count() == submitted) );
+  REMUS_ASSERT( (stats.JobExecutionTimes.count() == submitted - active) );
+  REMUS_ASSERT( (stats.JobRetrievalWaitTimes.count() == submitted - active) );
 }
 
 //------------------------------------------------------------------------------
@@ -194,6 +231,10 @@ void verifyt_job_result(const remus::proto::Job& job,
   //the status should be finished
   verify_job_status(job,client,remus::FINISHED);
 
+  const JobTimestamps times = client->jobStatus(job).timestamps();
+  REMUS_ASSERT( (times.Finished >= times.FirstProgress) );
+  REMUS_ASSERT( (times.FirstProgress > 0) );
+
   remus::proto::JobResult client_results = client->retrieveResults(job);
   REMUS_ASSERT( (client_results.valid()==true) )
 
@@ -213,9 +254,18 @@ int SimpleJobFlow(int argc, char* argv[])
 
   //construct a simple worker and client, we need to share the same
   //context between the server, client and worker
-  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const boost::filesystem::path report =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("remus_stats_%%%%-%%%%-%%%%.txt");
+  boost::shared_ptr<remus::Server> server =
+                  make_Server( remus::server::ServerPorts(), report.string() );
   const remus::server::ServerPorts& ports = server->serverPortInfo();
 
+  //keep so little in memory that results are spilled to disk, and mapped
+  //back when the client asks for them
+  server->resultStorage( remus::server::ResultStorage(1024,
+                          server->resultStorage().scratchDirectory()) );
+
   boost::shared_ptr<remus::Client> client = make_Client( ports );
   boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
 
@@ -224,7 +274,32 @@ int SimpleJobFlow(int argc, char* argv[])
   verify_can_mesh(client,worker);
   remus::proto::Job job = verify_job_submission(client,worker);
   verify_job_processing(job,client,worker);
+  verify_server_stats(client,1,1);
   verifyt_job_result(job,client,worker);
+  verify_server_stats(client,1,0);
+
+  //run the same flow with a client and worker that use the binary wire
+  //format, where the server forwards the submission bytes as sent
+  boost::shared_ptr<remus::Client> binaryClient = make_Client( ports );
+  binaryClient->wireFormat(remus::proto::WireFormat::Binary);
+  worker->wireFormat(remus::proto::WireFormat::Binary);
+  worker->askForJobs(1);
+  remus::common::SleepForMillisec(50);
+
+  job = verify_job_submission(binaryClient,worker);
+  verify_job_processing(job,binaryClient,worker);
+  verify_server_stats(binaryClient,2,1);
+  verifyt_job_result(job,binaryClient,worker);
+
+  //the report written when brokering stops has the latency of each service
+  server->stopBrokering();
+  std::ifstream file(report.string().c_str());
+  const std::string contents((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+  REMUS_ASSERT( (contents.find("MAKE MESH") != std::string::npos) );
+  REMUS_ASSERT( (contents.find("RETRIEVE MESH") != std::string::npos) );
+  file.close();
+  boost::filesystem::remove(report);
 
   return 0;
 }
@@ -0,0 +1,259 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/proto/ServerStats.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/uuid/nil_generator.hpp>
+
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+  #define fileno _fileno
+#endif
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //a factory that can launch no workers, so we have to use workers that
+  //connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.context(ports.context());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+  conn.context(ports.context());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  JobRequirements requirements = make_JobRequirements(io_type, "StreamWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job finish_Job(boost::shared_ptr<remus::Client> client,
+                             boost::shared_ptr<remus::Worker> worker,
+                             const std::string& data)
+{
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobSubmission sub(
+              remus::proto::make_JobRequirements(io_type, "StreamWorker", ""));
+  sub["data"] = remus::proto::make_JobContent("random data");
+
+  const remus::proto::Job job = client->submitJob(sub);
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.valid()) );
+  worker->returnMeshResults( remus::proto::make_JobResult(job.id(), data) );
+  REMUS_ASSERT( (client->waitForJob(job, 5000).finished()) );
+  return job;
+}
+
+//------------------------------------------------------------------------------
+//collects the chunks it is given, and asks another client about the job
+//while the stream is open to show the server still answers requests
+struct CollectingSink
+{
+  CollectingSink(std::string* data,
+                 std::size_t* chunks,
+                 remus::client::Client* other,
+                 const remus::proto::Job& job,
+                 std::size_t stopAfter):
+    Data(data), Chunks(chunks), Other(other), StreamedJob(job),
+    StopAfter(stopAfter)
+  {}
+
+  bool operator()(const char* data, std::size_t size) const
+  {
+    this->Data->append(data, size);
+    ++(*this->Chunks);
+    if(*this->Chunks == 2)
+      {
+      REMUS_ASSERT( (this->Other->jobStatus(this->StreamedJob).finished()) );
+      }
+    return *this->Chunks != this->StopAfter;
+  }
+
+  std::string* Data;
+  std::size_t* Chunks;
+  remus::client::Client* Other;
+  remus::proto::Job StreamedJob;
+  std::size_t StopAfter;
+};
+
+//------------------------------------------------------------------------------
+void verify_callback_sink(boost::shared_ptr<remus::Client> client,
+                          boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  const std::string data = remus::testing::AsciiStringGenerator(1048576);
+  const Job job = finish_Job(client, worker, data);
+
+  remus::client::Client other( client->connection() );
+  std::string streamed;
+  std::size_t chunks = 0;
+  REMUS_ASSERT( (client->streamResults(job,
+                      CollectingSink(&streamed, &chunks, &other, job, 0),
+                      4096, 4)) );
+  REMUS_ASSERT( (streamed == data) );
+  REMUS_ASSERT( (chunks == data.size() / 4096) );
+
+  //like retrieveResults, the job is done with once it has been sent
+  REMUS_ASSERT( (client->jobStatus(job).status() == remus::INVALID_STATUS) );
+  REMUS_ASSERT( (!client->streamResults(job,
+                      CollectingSink(&streamed, &chunks, &other, job, 0))) );
+}
+
+//------------------------------------------------------------------------------
+void verify_stopping_sink(boost::shared_ptr<remus::Client> client,
+                          boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  const std::string data = remus::testing::BinaryDataGenerator(1048576);
+  const Job job = finish_Job(client, worker, data);
+
+  //the sink stopping closes the stream, and leaves the result on the server
+  remus::client::Client other( client->connection() );
+  std::string streamed;
+  std::size_t chunks = 0;
+  REMUS_ASSERT( (!client->streamResults(job,
+                      CollectingSink(&streamed, &chunks, &other, job, 3),
+                      4096, 2)) );
+  REMUS_ASSERT( (chunks == 3) );
+  REMUS_ASSERT( (streamed == data.substr(0, streamed.size())) );
+
+  //a buffer that is too small stops the stream as well, as long as it
+  //stops before the server has sent the last chunk
+  std::vector<char> small(data.size() / 2);
+  REMUS_ASSERT( (!client->streamResults(job,
+              remus::client::make_BufferSink(&small[0], small.size()),
+              4096, 2)) );
+  REMUS_ASSERT( (client->jobStatus(job).finished()) );
+
+  //a buffer with room for it all gets the whole result
+  std::vector<char> buffer(data.size());
+  std::size_t size = 0;
+  REMUS_ASSERT( (client->streamResults(job,
+                  remus::client::make_BufferSink(&buffer[0], buffer.size(),
+                                                 &size),
+                  65536, 1)) );
+  REMUS_ASSERT( (size == data.size()) );
+  REMUS_ASSERT( (std::string(&buffer[0], size) == data) );
+  REMUS_ASSERT( (client->jobStatus(job).status() == remus::INVALID_STATUS) );
+}
+
+//------------------------------------------------------------------------------
+void verify_file_descriptor_sink(boost::shared_ptr<remus::Client> client,
+                                 boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  const std::string data = remus::testing::AsciiStringGenerator(3000000);
+  const Job job = finish_Job(client, worker, data);
+
+  std::FILE* file = std::tmpfile();
+  REMUS_ASSERT( (file != NULL) );
+  REMUS_ASSERT( (client->streamResults(job,
+                    remus::client::make_FileDescriptorSink(fileno(file)))) );
+
+  std::vector<char> written(data.size() + 1);
+  std::rewind(file);
+  const std::size_t size = std::fread(&written[0], 1, written.size(), file);
+  std::fclose(file);
+  REMUS_ASSERT( (size == data.size()) );
+  REMUS_ASSERT( (std::string(&written[0], size) == data) );
+}
+
+
+//------------------------------------------------------------------------------
+void verify_empty_result(boost::shared_ptr<remus::Client> client,
+                         boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  //a job that finished without result data streams successfully
+  const Job job = finish_Job(client, worker, std::string());
+
+  remus::client::Client other( client->connection() );
+  std::string streamed;
+  std::size_t chunks = 0;
+  REMUS_ASSERT( (client->streamResults(job,
+                      CollectingSink(&streamed, &chunks, &other, job, 0))) );
+  REMUS_ASSERT( (streamed.empty()) );
+  REMUS_ASSERT( (client->jobStatus(job).status() == remus::INVALID_STATUS) );
+}
+
+}
+
+//Streams large results to clients in chunks, in both wire formats
+int StreamResult(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server =
+                            make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+  verify_callback_sink(client, worker);
+  verify_stopping_sink(client, worker);
+  verify_file_descriptor_sink(client, worker);
+  verify_empty_result(client, worker);
+
+  boost::shared_ptr<remus::Client> binaryClient = make_Client( ports );
+  binaryClient->wireFormat(remus::proto::WireFormat::Binary);
+  verify_callback_sink(binaryClient, worker);
+  verify_stopping_sink(binaryClient, worker);
+  verify_file_descriptor_sink(binaryClient, worker);
+  verify_empty_result(binaryClient, worker);
+
+  //a job the server doesn't know about has nothing to stream
+  const remus::proto::Job unknown(boost::uuids::nil_uuid(),
+                                  remus::common::MeshIOType());
+  char buffer[16];
+  REMUS_ASSERT( (!client->streamResults(unknown,
+                      remus::client::make_BufferSink(buffer, sizeof(buffer)))) );
+  return 0;
+}
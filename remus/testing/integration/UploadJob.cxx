@@ -0,0 +1,232 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/proto/ServerStats.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //a factory that can launch no workers, so we have to use workers that
+  //connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.context(ports.context());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirements make_Requirements()
+{
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  return remus::proto::make_JobRequirements(io_type, "UploadWorker", "");
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+  conn.context(ports.context());
+
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(make_Requirements(),conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+void verify_upload(boost::shared_ptr<remus::Client> client,
+                   boost::shared_ptr<remus::Worker> worker,
+                   const boost::filesystem::path& path)
+{
+  using namespace remus::proto;
+
+  //a file bigger than a few chunks, and content in memory
+  const std::string fileData = remus::testing::BinaryDataGenerator(300000);
+  {
+  std::ofstream file(path.string().c_str(), std::ios::out | std::ios::binary);
+  file.write(fileData.data(), static_cast<std::streamsize>(fileData.size()));
+  }
+  const std::string memoryData = remus::testing::AsciiStringGenerator(100000);
+
+  JobSubmission sub(make_Requirements());
+  sub["file"] = make_JobContent( remus::common::FileHandle(path.string()),
+                                 remus::common::ContentFormat::BSON );
+  sub["memory"] = make_JobContent( memoryData );
+  sub["memory"].tag("tagged");
+  sub["empty"] = make_JobContent( std::string() );
+
+  const Job job = client->uploadJob(sub, 16384, 2);
+  REMUS_ASSERT( (job.valid()) );
+  REMUS_ASSERT( (job.type() == sub.type()) );
+  REMUS_ASSERT( (client->jobStatus(job).queued()) );
+
+  //the worker is handed the contents of the file rather than its path
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.id() == job.id()) );
+  JobContent content;
+  REMUS_ASSERT( (workerJob.details("file", content)) );
+  REMUS_ASSERT( (content.sourceType() == remus::common::ContentSource::Memory) );
+  REMUS_ASSERT( (content.formatType() == remus::common::ContentFormat::BSON) );
+  REMUS_ASSERT( (std::string(content.data(),content.dataSize()) == fileData) );
+  REMUS_ASSERT( (workerJob.details("memory") == memoryData) );
+  REMUS_ASSERT( (workerJob.details("memory", content)) );
+  REMUS_ASSERT( (content.tag() == "tagged") );
+  REMUS_ASSERT( (workerJob.details("empty").empty()) );
+
+  worker->returnMeshResults( make_JobResult(job.id(), "done") );
+  REMUS_ASSERT( (client->waitForResult(job, 5000).data() == "done") );
+}
+
+//------------------------------------------------------------------------------
+boost::uint64_t chunks_sent(boost::shared_ptr<remus::Client> client)
+{
+  const remus::proto::ServerStats stats = client->serverStats();
+  remus::proto::ServerStats::Latencies::const_iterator chunks =
+                    stats.ClientLatencies.find(remus::UPLOAD_JOB_CHUNK);
+  return chunks != stats.ClientLatencies.end() ? chunks->second.count() : 0;
+}
+
+//------------------------------------------------------------------------------
+void verify_job_data(boost::shared_ptr<remus::Client> client,
+                     boost::shared_ptr<remus::Worker> worker,
+                     const remus::proto::Job& job,
+                     const std::string& fileData,
+                     const std::string& memoryData)
+{
+  REMUS_ASSERT( (job.valid()) );
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.id() == job.id()) );
+  REMUS_ASSERT( (workerJob.details("file") == fileData) );
+  REMUS_ASSERT( (workerJob.details("memory") == memoryData) );
+
+  worker->returnMeshResults( remus::proto::make_JobResult(job.id(), "done") );
+  REMUS_ASSERT( (client->waitForResult(job, 5000).data() == "done") );
+}
+
+//------------------------------------------------------------------------------
+void verify_reupload(boost::shared_ptr<remus::Client> client,
+                     boost::shared_ptr<remus::Worker> worker,
+                     const boost::filesystem::path& path)
+{
+  using namespace remus::proto;
+
+  const std::string fileData = remus::testing::BinaryDataGenerator(100000);
+  {
+  std::ofstream file(path.string().c_str(), std::ios::out | std::ios::binary);
+  file.write(fileData.data(), static_cast<std::streamsize>(fileData.size()));
+  }
+  const std::string memoryData = remus::testing::AsciiStringGenerator(50000);
+
+  JobSubmission sub(make_Requirements());
+  sub["file"] = make_JobContent( remus::common::FileHandle(path.string()) );
+  sub["memory"] = make_JobContent( memoryData );
+
+  //the first upload sends all of the data, a chunk of 16K at a time
+  boost::uint64_t sent = chunks_sent(client);
+  verify_job_data(client, worker, client->uploadJob(sub, 16384, 2),
+                  fileData, memoryData);
+  REMUS_ASSERT( (chunks_sent(client) == sent + 7 + 4) );
+
+  //uploading the same data again only sends its hash
+  sent = chunks_sent(client);
+  verify_job_data(client, worker, client->uploadJob(sub, 16384, 2),
+                  fileData, memoryData);
+  REMUS_ASSERT( (chunks_sent(client) == sent) );
+
+  //and only the content that changed is sent
+  const std::string otherData = remus::testing::AsciiStringGenerator(20000);
+  sub["memory"] = make_JobContent( otherData );
+  verify_job_data(client, worker, client->uploadJob(sub, 16384, 2),
+                  fileData, otherData);
+  REMUS_ASSERT( (chunks_sent(client) == sent + 2) );
+}
+
+//------------------------------------------------------------------------------
+void verify_upload_failures(boost::shared_ptr<remus::Client> client,
+                            const boost::filesystem::path& path)
+{
+  using namespace remus::proto;
+
+  //a file that can't be read is never uploaded
+  JobSubmission sub(make_Requirements());
+  sub["file"] = make_JobContent(
+                  remus::common::FileHandle((path / "missing").string()) );
+  REMUS_ASSERT( (!client->uploadJob(sub).valid()) );
+
+  //a submission without data is queued as soon as it is described
+  JobSubmission empty(make_Requirements());
+  const Job job = client->uploadJob(empty);
+  REMUS_ASSERT( (job.valid()) );
+  REMUS_ASSERT( (client->jobStatus(job).queued()) );
+  REMUS_ASSERT( (client->terminate(job).failed()) );
+}
+
+}
+
+//Uploads the contents of jobs in chunks, in both wire formats, and
+//checks that data the server already has isn't uploaded again
+int UploadJob(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  const boost::filesystem::path path =
+        boost::filesystem::temp_directory_path() /
+        boost::filesystem::unique_path("remus_upload_%%%%-%%%%-%%%%");
+
+  boost::shared_ptr<remus::Server> server =
+                            make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+  verify_upload(client, worker, path);
+  verify_upload_failures(client, path);
+  verify_reupload(client, worker, path);
+
+  boost::shared_ptr<remus::Client> binaryClient = make_Client( ports );
+  binaryClient->wireFormat(remus::proto::WireFormat::Binary);
+  verify_upload(binaryClient, worker, path);
+  verify_upload_failures(binaryClient, path);
+  verify_reupload(binaryClient, worker, path);
+
+  boost::filesystem::remove(path);
+
+  const remus::proto::ServerStats stats = client->serverStats();
+  REMUS_ASSERT( (stats.ClientLatencies.find(remus::UPLOAD_JOB_CHUNK) !=
+                 stats.ClientLatencies.end()) );
+  return 0;
+}
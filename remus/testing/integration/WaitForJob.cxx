@@ -0,0 +1,232 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/proto/ServerStats.h>
+#include <remus/testing/Testing.h>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/uuid/nil_generator.hpp>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //a factory that can launch no workers, so we have to use workers that
+  //connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Client> make_Client( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.context(ports.context());
+
+  boost::shared_ptr<remus::Client> c(new remus::client::Client(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts& ports )
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+  conn.context(ports.context());
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  JobRequirements requirements = make_JobRequirements(io_type, "WaitWorker", "");
+  boost::shared_ptr<remus::Worker> w(new remus::Worker(requirements,conn));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission make_Submission()
+{
+  using namespace remus::meshtypes;
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  remus::proto::JobSubmission sub(
+              remus::proto::make_JobRequirements(io_type, "WaitWorker", ""));
+  sub["data"] = remus::proto::make_JobContent("random data");
+  return sub;
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t millisec_since(const boost::posix_time::ptime& start)
+{
+  return (boost::posix_time::microsec_clock::local_time() - start)
+                                                        .total_milliseconds();
+}
+
+//------------------------------------------------------------------------------
+void verify_wait_times_out(boost::shared_ptr<remus::Client> client)
+{
+  using namespace remus::proto;
+
+  //no worker asks for this job, so it stays queued
+  const Job job = client->submitJob(make_Submission());
+
+  //the server holds the reply until the timeout
+  const boost::posix_time::ptime start =
+                            boost::posix_time::microsec_clock::local_time();
+  const JobStatus status = client->waitForJob(job, 100);
+  REMUS_ASSERT( (status.queued()) );
+  REMUS_ASSERT( (millisec_since(start) >= 100) );
+
+  //a zero timeout answers right away
+  REMUS_ASSERT( (client->waitForJob(job, 0).queued()) );
+
+  //other requests are answered while a wait is held
+  remus::client::Future<JobStatus> waiting = client->waitForJobAsync(job, 5000);
+  REMUS_ASSERT( (client->jobStatus(job).queued()) );
+  REMUS_ASSERT( (!waiting.ready()) );
+
+  //terminating the job ends the wait
+  remus::client::Client other( client->connection() );
+  REMUS_ASSERT( (other.terminate(job).failed()) );
+  REMUS_ASSERT( (waiting.get().failed()) );
+
+  //waiting on a job the server doesn't know about answers right away
+  const Job unknown(boost::uuids::nil_uuid(), job.type());
+  REMUS_ASSERT( (client->waitForJob(unknown, 5000).status() ==
+                 remus::INVALID_STATUS) );
+  REMUS_ASSERT( (!client->waitForResult(unknown, 5000).valid()) );
+}
+
+//------------------------------------------------------------------------------
+void verify_wait_for_result(boost::shared_ptr<remus::Client> client,
+                            boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  //the worker asks for only this job, so none are left to be handed the
+  //queued jobs of the other tests
+  const Job job = client->submitJob(make_Submission());
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.valid()) );
+
+  //progress doesn't end a wait, only finishing does
+  remus::client::Future<JobStatus> status = client->waitForJobAsync(job, 5000);
+  remus::client::Future<JobResult> result =
+                                      client->waitForResultAsync(job, 5000);
+  worker->updateStatus( JobStatus(job.id(), JobProgress(50)) );
+  client->processReplies(50);
+  REMUS_ASSERT( (!status.ready()) );
+  REMUS_ASSERT( (!result.ready()) );
+
+  const std::string data = remus::testing::AsciiStringGenerator(65536);
+  worker->returnMeshResults( make_JobResult(job.id(), data) );
+  REMUS_ASSERT( (status.get().finished()) );
+  REMUS_ASSERT( (status.get().timestamps().Finished > 0) );
+
+  //the result came with the reply, so the job is done with
+  REMUS_ASSERT( (result.get().valid()) );
+  REMUS_ASSERT( (result.get().data() == data) );
+  REMUS_ASSERT( (client->jobStatus(job).status() == remus::INVALID_STATUS) );
+}
+
+//------------------------------------------------------------------------------
+void verify_finished_job_answers_now(boost::shared_ptr<remus::Client> client,
+                                     boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  const Job job = client->submitJob(make_Submission());
+  remus::worker::Job workerJob = worker->getJob();
+  worker->returnMeshResults( make_JobResult(job.id(), "result") );
+
+  //once the server has the result, waiting answers without holding
+  REMUS_ASSERT( (client->waitForJob(job, 5000).finished()) );
+  const JobResult result = client->waitForResult(job, 5000);
+  REMUS_ASSERT( (result.data() == "result") );
+}
+
+
+//------------------------------------------------------------------------------
+void verify_many_waiters(const remus::server::ServerPorts& ports,
+                         boost::shared_ptr<remus::Worker> worker)
+{
+  using namespace remus::proto;
+
+  //clients using either encoding wait on the same job
+  boost::shared_ptr<remus::Client> text = make_Client( ports );
+  boost::shared_ptr<remus::Client> binary = make_Client( ports );
+  binary->wireFormat(remus::proto::WireFormat::Binary);
+
+  const Job job = text->submitJob(make_Submission());
+  remus::worker::Job workerJob = worker->getJob();
+  REMUS_ASSERT( (workerJob.valid()) );
+
+  remus::client::Future<JobResult> first = text->waitForResultAsync(job, 5000);
+  remus::client::Future<JobResult> second = text->waitForResultAsync(job, 5000);
+  remus::client::Future<JobResult> third =
+                                      binary->waitForResultAsync(job, 5000);
+  remus::client::Future<JobStatus> status =
+                                      binary->waitForJobAsync(job, 5000);
+  text->processReplies(50);
+  binary->processReplies(50);
+
+  //every waiter gets the one result before the job is removed
+  const std::string data = remus::testing::AsciiStringGenerator(4096);
+  worker->returnMeshResults( make_JobResult(job.id(), data) );
+  REMUS_ASSERT( (first.get().data() == data) );
+  REMUS_ASSERT( (second.get().data() == data) );
+  REMUS_ASSERT( (third.get().data() == data) );
+  REMUS_ASSERT( (status.get().finished()) );
+  REMUS_ASSERT( (text->jobStatus(job).status() == remus::INVALID_STATUS) );
+}
+
+}
+
+//Waits on jobs with the server holding the reply until they finish
+int WaitForJob(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server =
+                            make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+  verify_wait_times_out(client);
+  verify_wait_for_result(client, worker);
+  verify_finished_job_answers_now(client, worker);
+
+  boost::shared_ptr<remus::Client> binaryClient = make_Client( ports );
+  binaryClient->wireFormat(remus::proto::WireFormat::Binary);
+  verify_wait_times_out(binaryClient);
+  verify_wait_for_result(binaryClient, worker);
+  verify_finished_job_answers_now(binaryClient, worker);
+
+  verify_many_waiters(ports, worker);
+
+  //parked requests are recorded when they are parked
+  const remus::proto::ServerStats stats = client->serverStats();
+  REMUS_ASSERT( (stats.ClientLatencies.find(remus::WAIT_FOR_JOB) !=
+                 stats.ClientLatencies.end()) );
+  return 0;
+}
@@ -95,6 +95,20 @@ public:
     return std::string();
   }
 
+  //binary wire encoding, see remus/proto/binaryHelpers.h
+  void serialize(remus::internal::BinaryWriter& buffer) const
+  {
+    buffer.putUUID(this->Id);
+    this->Submission.serialize(buffer);
+  }
+
+  explicit Job(remus::internal::BinaryReader& buffer):
+    Id(buffer.getUUID()),
+    Submission(buffer),
+    Validity(buffer.good() ? VALID_JOB : INVALID)
+  {
+  }
+
   //helper method to easily extract a JobContent from the job submission
   bool details(const std::string& key, remus::proto::JobContent& value)
   {
@@ -130,6 +144,16 @@ inline std::string to_string(const remus::worker::Job& job)
 //------------------------------------------------------------------------------
 inline remus::worker::Job to_Job(const std::string& msg)
 {
+  if(remus::internal::is_binary(msg.data(),msg.size()))
+    {
+    remus::internal::BinaryReader buffer(msg.data(),msg.size());
+    const remus::worker::Job decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::worker::Job();
+      }
+    return decoded;
+    }
   //convert a job detail from a string, used as a hack to serialize
   std::istringstream buffer(msg);
 
@@ -145,6 +169,16 @@ inline remus::worker::Job to_Job(const std::string& msg)
 //------------------------------------------------------------------------------
 inline remus::worker::Job to_Job(const char* data, int size)
 {
+  if(remus::internal::is_binary(data,size))
+    {
+    remus::internal::BinaryReader buffer(data,size);
+    const remus::worker::Job decoded(buffer);
+    if(!buffer.good())
+      {
+      return remus::worker::Job();
+      }
+    return decoded;
+    }
   //convert a job from a string, used as a hack to serialize
   std::string temp(size,char());
   std::copy( data, data+size, temp.begin() );
@@ -57,7 +57,8 @@ Worker::Worker(remus::common::MeshIOType mtype,
                     zmq::socketInfo<zmq::proto::inproc>("worker"),
                     zmq::socketInfo<zmq::proto::inproc>("worker_jobs"))),
   JobQueue( new remus::worker::detail::JobQueue( Zmq->InterWorkerContext,
-                    zmq::socketInfo<zmq::proto::inproc>("worker_jobs")))
+                    zmq::socketInfo<zmq::proto::inproc>("worker_jobs"))),
+  Format(remus::proto::WireFormat::Text)
 {
   this->MessageRouter->start();
 
@@ -80,7 +81,8 @@ Worker::Worker(const remus::proto::JobRequirements& requirements,
                     zmq::socketInfo<zmq::proto::inproc>("worker"),
                     zmq::socketInfo<zmq::proto::inproc>("worker_jobs")) ),
   JobQueue( new remus::worker::detail::JobQueue( Zmq->InterWorkerContext,
-                    zmq::socketInfo<zmq::proto::inproc>("worker_jobs")) )
+                    zmq::socketInfo<zmq::proto::inproc>("worker_jobs")) ),
+  Format(remus::proto::WireFormat::Text)
 {
   this->MessageRouter->start();
 
@@ -112,6 +114,18 @@ const remus::worker::ServerConnection& Worker::connection() const
   return this->ConnectionInfo;
 }
 
+//-----------------------------------------------------------------------------
+void Worker::wireFormat(remus::proto::WireFormat::Type format)
+{
+  this->Format = format;
+}
+
+//-----------------------------------------------------------------------------
+remus::proto::WireFormat::Type Worker::wireFormat() const
+{
+  return this->Format;
+}
+
 //-----------------------------------------------------------------------------
 void Worker::askForJobs( unsigned int numberOfJobs )
 {
@@ -126,12 +140,11 @@ void Worker::askForJobs( unsigned int numberOfJobs )
   lightReqs.SourceType = this->MeshRequirements.sourceType();
   lightReqs.Tag = this->MeshRequirements.tag();
 
-  std::ostringstream input_buffer;
-  input_buffer << lightReqs;
+  const std::string msg = remus::proto::to_wire(lightReqs, this->Format);
 
   proto::Message askForMesh(this->MeshRequirements.meshTypes(),
                             remus::MAKE_MESH,
-                            input_buffer.str());
+                            msg);
 
   for(unsigned int i=0; i < numberOfJobs; ++i)
     { askForMesh.send(&this->Zmq->Server); }
@@ -163,10 +176,11 @@ remus::worker::Job Worker::getJob()
 void Worker::updateStatus(const remus::proto::JobStatus& info)
 {
   //send a message that contains, the status
-  std::string msg = remus::proto::to_string(info);
+  zmq::message_t msg;
+  zmq::to_wire(info, this->Format, msg);
   remus::proto::Message message(this->MeshRequirements.meshTypes(),
                                 remus::MESH_STATUS,
-                                msg.data(),msg.size());
+                                msg);
   message.send(&this->Zmq->Server);
 }
 
@@ -174,10 +188,11 @@ void Worker::updateStatus(const remus::proto::JobStatus& info)
 void Worker::returnMeshResults(const remus::proto::JobResult& result)
 {
   //send a message that contains, the path to the resulting file
-  std::string msg = remus::proto::to_string(result);
+  zmq::message_t msg;
+  zmq::to_wire(result, this->Format, msg);
   remus::proto::Message message(this->MeshRequirements.meshTypes(),
                                 remus::RETRIEVE_MESH,
-                                msg.data(),msg.size());
+                                msg);
   message.send(&this->Zmq->Server);
 }
 
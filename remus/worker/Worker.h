@@ -18,6 +18,7 @@
 #include <remus/proto/JobRequirements.h>
 #include <remus/proto/JobResult.h>
 #include <remus/proto/JobStatus.h>
+#include <remus/proto/WireFormat.h>
 #include <remus/proto/zmqSocketIdentity.h>
 
 #include <remus/worker/Job.h>
@@ -64,6 +65,12 @@ public:
   //remus server
   const remus::worker::ServerConnection& connection() const;
 
+  //Set the encoding the worker sends its job requests, status and
+  //results with. The server sends jobs to the worker in the encoding of
+  //the workers last job request. Text is the default.
+  void wireFormat(remus::proto::WireFormat::Type format);
+  remus::proto::WireFormat::Type wireFormat() const;
+
   //send a message to the server stating how many jobs
   //that we want to be sent to process
   virtual void askForJobs( unsigned int numberOfJobs = 1 );
@@ -93,6 +100,8 @@ private:
   boost::scoped_ptr<remus::worker::detail::MessageRouter> MessageRouter;
   boost::scoped_ptr<remus::worker::detail::JobQueue> JobQueue;
 
+  remus::proto::WireFormat::Type Format;
+
   //explicitly state the worker doesn't support copy or move semantics
   Worker(const Worker&);
   void operator=(const Worker&);
@@ -12,6 +12,7 @@
 
 #include <remus/worker/detail/JobQueue.h>
 
+#include <remus/proto/Job.h>
 #include <remus/proto/Response.h>
 #include <remus/proto/JobSubmission.h>
 
@@ -34,6 +35,27 @@ namespace remus{
 namespace worker{
 namespace detail{
 
+namespace {
+//-----------------------------------------------------------------------------
+//decode a job sent by the server. Workers that speak the binary wire
+//format are sent the submission as an attachment holding the bytes the
+//client sent, which the job views into instead of copying
+remus::worker::Job make_Job(const remus::proto::Response& response)
+{
+  if(!response.hasAttachment())
+    {
+    return remus::worker::to_Job(response.data());
+    }
+
+  const std::string header = response.data();
+  const remus::proto::Job job = remus::proto::to_Job(header);
+  return remus::worker::Job(job.id(),
+          remus::proto::to_JobSubmission(response.attachmentData(),
+                                         response.attachmentSize(),
+                                         response.attachmentOwner()));
+}
+}
+
 //-----------------------------------------------------------------------------
 class JobQueue::JobQueueImplementation
 {
@@ -156,8 +178,7 @@ void clearJobs()
 void addItem(remus::proto::Response& response )
 {
   boost::lock_guard<boost::mutex> lock(this->QueueMutex);
-  remus::worker::Job j = remus::worker::to_Job(response.data());
-  this->Queue.push_back( j );
+  this->Queue.push_back( make_Job(response) );
 
   this->QueueChanged.notify_all();
 }